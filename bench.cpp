@@ -0,0 +1,465 @@
+/**
+ * @file bench.cpp
+ * @brief Набор микро- и макробенчмарков иерархии smart_devices.hpp
+ *
+ * @details
+ * Не использует windows.h и интерактивное меню, собирается отдельно:
+ *
+ *     g++ -std=c++20 -O2 -pthread bench.cpp smart_devices.cpp -o bench
+ *     g++ -std=c++20 -O2 -mavx2 -pthread bench.cpp smart_devices.cpp -o bench_avx2
+ *
+ * Без -mavx2 на x86-64 ядра fleet_kernels собираются в скалярном
+ * варианте; строки ядер помечены вариантом FLEET_KERNELS_ISA
+ * (fleet.sumCurrentPower.scalar, fleet.sumCurrentPower.avx2, ...), так
+ * что результаты двух сборок можно сравнивать построчно.
+ *
+ * Измеряет:
+ * - пропускную способность turnOn()/turnOff() и CommandBatch
+ * - стоимость getStatus()/getDeviceInfo() и appendStatus()/formatStatus(),
+ *   повторное чтение через StatusCache
+ * - dynamic_cast против deviceCast() и visit()
+ * - копирующее конструирование LightBulb/Thermostat/SmartOutlet
+ * - агрегацию по парку из 1k/100k/1M устройств: ядра fleet_kernels,
+ *   инкрементальные итоги реестра и параллельную свертку FleetExecutor
+ * - однотипную группу DeviceGroup<LightBulbTraits> против виртуальных вызовов
+ * - суточный прогноз ThermalSimulation с шагом 1 минута для 50k домов
+ * - асинхронные команды DeviceLink: 10k одновременных сопрограмм в одном
+ *   потоке DeviceEventLoop (SimulatedTransport без задержки)
+ * - активацию сцены Scene на 10k устройств и мощность набора DeviceSet
+ * - проверку правил RuleEngine после изменения температуры одного из 10k
+ *   термостатов (10k правил)
+ * - загрузку инвентаря InventoryLoader: 100k строк CSV и JSON из памяти
+ *   вместе с созданием устройств
+ *
+ * Результаты печатаются в stdout и записываются в bench_output.txt
+ * в формате CSV: name,devices,iterations,ns_per_op.
+ *
+ * @note Необязательный аргумент - множитель длительности замера
+ *       (по умолчанию 1.0, около 0.1 с на бенчмарк).
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "smart_devices.hpp"
+#include "command_batch.hpp"
+#include "device_arena.hpp"
+#include "device_visit.hpp"
+#include "fleet_executor.hpp"
+#include "device_io.hpp"
+#include "device_scene.hpp"
+#include "fleet_kernels.hpp"
+#include "inventory_loader.hpp"
+#include "rule_engine.hpp"
+#include "static_devices.hpp"
+#include "status_cache.hpp"
+#include "thermal_simulation.hpp"
+
+/**
+ * @struct BenchResult
+ * @brief Результат одного бенчмарка
+ */
+struct BenchResult {
+    std::string name;           ///< Название
+    std::size_t devices;        ///< Размер парка
+    std::size_t iterations;     ///< Количество операций в замере
+    double nsPerOp;             ///< Наносекунд на операцию
+};
+
+std::vector<BenchResult> results;
+double timeScale = 1.0;
+
+// Приемник результатов, чтобы компилятор не выбросил измеряемый код
+volatile double sink = 0.0;
+
+/**
+ * @brief Замерить операцию
+ * @param name Название бенчмарка
+ * @param devices Размер парка (для отчета)
+ * @param opsPerCall Операций за один вызов body
+ * @param body Измеряемый код
+ * @details Количество вызовов удваивается, пока замер не займет
+ *          не меньше 0.1 с * timeScale
+ */
+template <class Body>
+void bench(const std::string& name, std::size_t devices, std::size_t opsPerCall, Body body) {
+    typedef std::chrono::steady_clock Steady;
+    double target = 0.1 * timeScale;
+    std::size_t calls = 1;
+    for (;;) {
+        Steady::time_point start = Steady::now();
+        for (std::size_t i = 0; i < calls; i++) {
+            body();
+        }
+        double seconds = std::chrono::duration<double>(Steady::now() - start).count();
+        if (seconds >= target || calls >= (std::size_t(1) << 30)) {
+            std::size_t operations = calls * opsPerCall;
+            results.push_back(BenchResult{name, devices, operations, seconds * 1e9 / operations});
+            std::printf("%-40s %9zu %12zu %12.2f ns/op\n", name.c_str(), devices, operations,
+                        results.back().nsPerOp);
+            return;
+        }
+        calls *= 2;
+    }
+}
+
+void benchToggle() {
+    LightBulb lamp("BL1", "Bench lampa", 60);
+    Thermostat thermo("BT1", "Bench termostat", 1000);
+    SmartOutlet outlet("BO1", "Bench rozetka", 2000);
+
+    bench("turnOn_turnOff.LightBulb", 1, 2, [&] { lamp.turnOn(); lamp.turnOff(); });
+    bench("turnOn_turnOff.Thermostat", 1, 2, [&] { thermo.turnOn(); thermo.turnOff(); });
+    bench("turnOn_turnOff.SmartOutlet", 1, 2, [&] { outlet.turnOn(); outlet.turnOff(); });
+
+    SmartDevice* device = &lamp;
+    bench("turnOn_turnOff.virtual", 1, 2, [&] { device->turnOn(); device->turnOff(); });
+}
+
+void benchFormatting() {
+    LightBulb lamp("BL2", "Bench lampa", 60, 75, "teplyy belyy");
+    Thermostat thermo("BT2", "Bench termostat", 1000, 22.5);
+    lamp.turnOn();
+
+    bench("getStatus.LightBulb", 1, 1, [&] { sink = sink + lamp.getStatus().size(); });
+    bench("getDeviceInfo.LightBulb", 1, 1, [&] { sink = sink + lamp.getDeviceInfo().size(); });
+    bench("getStatus.Thermostat", 1, 1, [&] { sink = sink + thermo.getStatus().size(); });
+    bench("getDeviceInfo.Thermostat", 1, 1, [&] { sink = sink + thermo.getDeviceInfo().size(); });
+
+    std::string reused;
+    reused.reserve(256);
+    bench("appendStatus.LightBulb", 1, 1, [&] {
+        reused.clear();
+        lamp.appendStatus(reused);
+        sink = sink + reused.size();
+    });
+
+    char buffer[256];
+    bench("formatDeviceInfo.Thermostat", 1, 1, [&] {
+        sink = sink + thermo.formatDeviceInfo(buffer, sizeof(buffer));
+    });
+
+    StatusCache cache;
+    bench("StatusCache.status_LightBulb", 1, 1, [&] { sink = sink + cache.status(lamp).size(); });
+    bench("StatusCache.info_Thermostat", 1, 1, [&] { sink = sink + cache.info(thermo).size(); });
+}
+
+void benchTypeProbing() {
+    LightBulb lamp("BL3", "Bench lampa", 60);
+    Thermostat thermo("BT3", "Bench termostat", 1000);
+    SmartOutlet outlet("BO3", "Bench rozetka", 2000);
+    SmartDevice* devices[] = {&lamp, &thermo, &outlet};
+    const std::size_t count = sizeof(devices) / sizeof(devices[0]);
+
+    bench("probe.dynamic_cast", count, count, [&] {
+        double total = 0.0;
+        for (SmartDevice* device : devices) {
+            if (LightBulb* bulb = dynamic_cast<LightBulb*>(device)) {
+                total += bulb->getBrightness();
+            } else if (Thermostat* t = dynamic_cast<Thermostat*>(device)) {
+                total += t->getCurrentTemperature();
+            } else if (SmartOutlet* o = dynamic_cast<SmartOutlet*>(device)) {
+                total += o->getCurrentPower();
+            }
+        }
+        sink = sink + total;
+    });
+
+    bench("probe.deviceCast", count, count, [&] {
+        double total = 0.0;
+        for (SmartDevice* device : devices) {
+            if (LightBulb* bulb = deviceCast<LightBulb>(device)) {
+                total += bulb->getBrightness();
+            } else if (Thermostat* t = deviceCast<Thermostat>(device)) {
+                total += t->getCurrentTemperature();
+            } else if (SmartOutlet* o = deviceCast<SmartOutlet>(device)) {
+                total += o->getCurrentPower();
+            }
+        }
+        sink = sink + total;
+    });
+
+    bench("probe.visit", count, count, [&] {
+        double total = 0.0;
+        for (SmartDevice* device : devices) {
+            total += visit(*device, overloaded{
+                [](LightBulb& bulb) { return static_cast<double>(bulb.getBrightness()); },
+                [](Thermostat& t) { return t.getCurrentTemperature(); },
+                [](SmartOutlet& o) { return o.getCurrentPower(); },
+                [](SmartDevice&) { return 0.0; }
+            });
+        }
+        sink = sink + total;
+    });
+}
+
+void benchCopy() {
+    LightBulb lamp("BL4", "Bench lampa", 60, 75, "belyy");
+    Thermostat thermo("BT4", "Bench termostat", 1000, 21.0);
+    SmartOutlet outlet("BO4", "Bench rozetka", 2000);
+
+    bench("copy.LightBulb", 1, 1, [&] { LightBulb copy(lamp); sink = sink + copy.getBrightness(); });
+    bench("copy.Thermostat", 1, 1, [&] { Thermostat copy(thermo); sink = sink + copy.getCurrentTemperature(); });
+    bench("copy.SmartOutlet", 1, 1, [&] { SmartOutlet copy(outlet); sink = sink + copy.getPowerConsumption(); });
+}
+
+void benchFleet(std::size_t size, FleetExecutor& executor) {
+    DeviceArena arena(1 << 20);
+    std::vector<SmartDevice*> fleet;
+    fleet.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        std::string id = "F" + std::to_string(i);
+        switch (i % 3) {
+            case 0: fleet.push_back(arena.make<LightBulb>(id, "Lampa", 10.0 + i % 50)); break;
+            case 1: fleet.push_back(arena.make<Thermostat>(id, "Termostat", 500.0 + i % 100)); break;
+            default: fleet.push_back(arena.make<SmartOutlet>(id, "Rozetka", 100.0 + i % 20)); break;
+        }
+        if (i % 2 == 0) {
+            fleet.back()->turnOn();
+        }
+    }
+
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    DeviceTime now = DeviceClock::now();
+
+    bench("fleet.loop_virtual_getCurrentPower", size, size, [&] {
+        double total = 0.0;
+        for (SmartDevice* device : fleet) {
+            total += device->getCurrentPower();
+        }
+        sink = sink + total;
+    });
+    const std::string isa = std::string(".") + FLEET_KERNELS_ISA;
+    bench("fleet.sumCurrentPower" + isa, size, size, [&] { sink = sink + sumCurrentPower(reg); });
+    bench("fleet.sumEnergyConsumed" + isa, size, size, [&] { sink = sink + sumEnergyConsumed(reg, now); });
+    bench("fleet.countOn", size, size, [&] { sink = sink + static_cast<double>(countOn(reg)); });
+    bench("fleet.registry_currentPower", size, 1, [&] { sink = sink + reg.currentPower(); });
+    bench("fleet.parallelSumEnergyConsumed", size, size, [&] {
+        sink = sink + parallelSumEnergyConsumed(executor, now);
+    });
+
+    CommandBatch batch;
+    batch.reserve(size * 2);
+    bench("fleet.CommandBatch_on_off", size, size * 2, [&] {
+        batch.clear();
+        for (SmartDevice* device : fleet) {
+            batch.turnOn(*device);
+        }
+        for (SmartDevice* device : fleet) {
+            batch.turnOff(*device);
+        }
+        batch.apply();
+    });
+    bench("fleet.loop_turnOn_turnOff", size, size * 2, [&] {
+        for (SmartDevice* device : fleet) {
+            device->turnOn();
+        }
+        for (SmartDevice* device : fleet) {
+            device->turnOff();
+        }
+    });
+}
+
+void benchStaticGroup(std::size_t size) {
+    DeviceArena arena(1 << 20);
+    std::vector<LightBulb*> bulbs;
+    DeviceGroup<LightBulbTraits> lights;
+    bulbs.reserve(size);
+    lights.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        bulbs.push_back(arena.make<LightBulb>("G" + std::to_string(i), "Lampa", 10.0 + i % 50));
+        lights.add(*bulbs.back());
+    }
+    lights.turnOnAll();
+
+    bench("group.loop_virtual_getCurrentPower", size, size, [&] {
+        double total = 0.0;
+        for (SmartDevice* bulb : bulbs) {
+            total += bulb->getCurrentPower();
+        }
+        sink = sink + total;
+    });
+    bench("group.DeviceGroup_sumCurrentPower", size, size, [&] { sink = sink + lights.sumCurrentPower(); });
+    bench("group.DeviceGroup_on_off", size, size * 2, [&] {
+        lights.turnOffAll();
+        lights.turnOnAll();
+    });
+}
+
+void benchThermal(std::size_t homes) {
+    DeviceArena arena(1 << 20);
+    for (std::size_t i = 0; i < homes; i++) {
+        Thermostat* thermostat = arena.make<Thermostat>("H" + std::to_string(i), "Dom", 1000.0 + i % 500,
+                                                        15.0 + i % 5);
+        thermostat->setTargetTemperature(21.0 + i % 3);
+    }
+    ThermalSimulation simulation;
+    simulation.capture();
+
+    const std::size_t steps = 24 * 60;
+    bench("thermal.forecast_24h_1min", homes, homes * steps, [&] {
+        sink = sink + simulation.forecast(steps, 1.0 / 60).energy;
+    });
+    bench("thermal.advance_1min", homes, homes, [&] { sink = sink + simulation.advance(1.0 / 60); });
+}
+
+DeviceTask<void> asyncOnOff(DeviceLink& link, SmartDevice& device) {
+    co_await link.turnOn(device);
+    co_await link.turnOff(device);
+}
+
+void benchAsync(std::size_t size) {
+    DeviceArena arena(1 << 20);
+    std::vector<LightBulb*> bulbs;
+    bulbs.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        bulbs.push_back(arena.make<LightBulb>("A" + std::to_string(i), "Lampa", 10.0 + i % 50));
+    }
+    DeviceEventLoop loop;
+    SimulatedTransport transport(loop, std::chrono::nanoseconds(0));
+    DeviceLink link(loop, transport);
+
+    bench("io.coroutine_on_off_inflight", size, size * 2, [&] {
+        for (LightBulb* bulb : bulbs) {
+            loop.spawn(asyncOnOff(link, *bulb));
+        }
+        loop.run();
+    });
+}
+
+void benchScene(std::size_t size) {
+    DeviceArena arena(1 << 20);
+    DeviceSet home;
+    for (std::size_t i = 0; i < size; i++) {
+        std::string id = "S" + std::to_string(i);
+        SmartDevice* device;
+        if (i % 2 == 0) {
+            device = arena.make<LightBulb>(id, "Lampa", 10.0 + i % 50);
+        } else if (i % 4 == 1) {
+            device = arena.make<SmartOutlet>(id, "Rozetka", 100.0 + i % 20, 16.0, "Komnata");
+        } else {
+            device = arena.make<Thermostat>(id, "Termostat", 1000.0, 20.0);
+        }
+        home.add(*device);
+    }
+
+    SceneAction evening;
+    evening.on = true;
+    evening.brightness = 20;
+    evening.color = "teplyy belyy";
+    evening.outlet = false;
+    evening.mode = ThermostatMode::DISPLAY;
+    SceneAction day;
+    day.brightness = 100;
+    day.color = "belyy";
+    day.outlet = true;
+    day.mode = ThermostatMode::MONITORING;
+    Scene movieNight("vecher kino");
+    movieNight.add(home, evening);
+    Scene daylight("den'");
+    daylight.add(home, day);
+
+    bench("scene.activate_evening_day", size, size * 2, [&] {
+        sink = sink + static_cast<double>(movieNight.activate() + daylight.activate());
+    });
+    bench(std::string("scene.DeviceSet_sumCurrentPower.") + FLEET_KERNELS_ISA, size, size, [&] { sink = sink + home.sumCurrentPower(); });
+    home.turnOffAll();
+}
+
+void benchRules(std::size_t size) {
+    DeviceArena arena(1 << 20);
+    std::vector<Thermostat*> thermostats;
+    thermostats.reserve(size);
+    RuleEngine rules;
+    for (std::size_t i = 0; i < size; i++) {
+        std::string id = "R" + std::to_string(i);
+        thermostats.push_back(arena.make<Thermostat>(id, "Termostat", 1000.0, 20.0));
+        SmartOutlet* outlet = arena.make<SmartOutlet>(id + "o", "Rozetka", 100.0, 16.0, "Komnata");
+        rules.add(Rule(id)
+                      .when(RuleCondition::temperature(*thermostats.back(), RuleCompare::GREATER, 25.0))
+                      .then(RuleAction(CommandType::TURN_OFF, *outlet)));
+    }
+    DeviceJournal::attach(rules);
+    rules.evaluate();
+
+    std::size_t next = 0;
+    bench("rules.update_evaluate_of_10k", size, 1, [&] {
+        thermostats[next % size]->updateTemperature(20.0 + next % 10);
+        next++;
+        sink = sink + static_cast<double>(rules.evaluate());
+    });
+    DeviceJournal::detach();
+}
+
+void benchInventory(std::size_t size, FleetExecutor& executor) {
+    std::string csv = "kind,id,name,power,brightness,color,temperature,maxCurrent,location\n";
+    std::string json = "[\n";
+    for (std::size_t i = 0; i < size; i++) {
+        std::string id = "I" + std::to_string(i);
+        if (i % 3 == 0) {
+            csv += "LightBulb," + id + ",Lampa," + std::to_string(10 + i % 50) + ",80,belyy,,,\n";
+            json += "{\"kind\":\"LightBulb\",\"id\":\"" + id + "\",\"name\":\"Lampa\",\"power\":" +
+                    std::to_string(10 + i % 50) + ",\"brightness\":80,\"color\":\"belyy\"}";
+        } else if (i % 3 == 1) {
+            csv += "Thermostat," + id + ",\"Termostat, zal\",1000,,,21.5,,\n";
+            json += "{\"kind\":\"Thermostat\",\"id\":\"" + id +
+                    "\",\"name\":\"Termostat\",\"power\":1000,\"temperature\":21.5}";
+        } else {
+            csv += "SmartOutlet," + id + ",Rozetka,2000,,,,16,kukhnya\n";
+            json += "{\"kind\":\"SmartOutlet\",\"id\":\"" + id +
+                    "\",\"name\":\"Rozetka\",\"power\":2000,\"maxCurrent\":16,\"location\":\"kukhnya\"}";
+        }
+        json += i + 1 < size ? ",\n" : "\n]\n";
+    }
+
+    InventoryLoader loader(executor);
+    bench("inventory.load_csv", size, size, [&] {
+        DeviceArena arena(1 << 20);
+        sink = sink + static_cast<double>(loader.loadText(csv, arena).loaded);
+    });
+    bench("inventory.load_json", size, size, [&] {
+        DeviceArena arena(1 << 20);
+        sink = sink + static_cast<double>(loader.loadText(json, arena).loaded);
+    });
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        timeScale = std::atof(argv[1]);
+        if (timeScale <= 0.0) {
+            timeScale = 1.0;
+        }
+    }
+
+    std::printf("fleet_kernels: %s\n", FLEET_KERNELS_ISA);
+    std::printf("%-40s %9s %12s %12s\n", "name", "devices", "iterations", "time");
+    benchToggle();
+    benchFormatting();
+    benchTypeProbing();
+    benchCopy();
+
+    FleetExecutor executor;
+    benchFleet(1000, executor);
+    benchFleet(100000, executor);
+    benchFleet(1000000, executor);
+    benchStaticGroup(200000);
+    benchThermal(50000);
+    benchAsync(10000);
+    benchScene(10000);
+    benchRules(10000);
+    benchInventory(100000, executor);
+
+    std::ofstream out("bench_output.txt");
+    out << "name,devices,iterations,ns_per_op\n";
+    for (const BenchResult& result : results) {
+        out << result.name << "," << result.devices << "," << result.iterations << ","
+            << result.nsPerOp << "\n";
+    }
+    std::cout << "Rezul'taty zapisany v bench_output.txt\n";
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file color_palette.hpp
+ * @brief Палитра цветов лампочек: 16-битный индекс вместо строки
+ *
+ * @details
+ * На площадке обычно встречается несколько десятков разных цветов, поэтому
+ * LightBulb хранит не InternedString (16 байт), а номер цвета в палитре
+ * (2 байта). Палитра - плоский массив ссылок на строки StringPool и
+ * обратная таблица "номер интернированной строки -> номер цвета", так что
+ * повторное добавление цвета - один поиск в StringPool без сравнения строк.
+ *
+ * @note Цвета не удаляются из палитры до завершения процесса.
+ * @note Добавление не потокобезопасно (как и интернирование строк).
+ */
+
+#ifndef COLOR_PALETTE_HPP
+#define COLOR_PALETTE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "string_pool.hpp"
+
+/**
+ * @class ColorPalette
+ * @brief Таблица цветов с 16-битными номерами
+ */
+class ColorPalette {
+public:
+    static constexpr std::size_t CAPACITY = 65535;              ///< Максимум цветов в палитре
+    static constexpr std::uint16_t NONE = 0xFFFF;               ///< Нет цвета в обратной таблице
+
+private:
+    std::vector<InternedString> colors;         ///< Номер цвета -> строка
+    std::vector<std::uint16_t> byString;        ///< Номер строки StringPool -> номер цвета
+
+public:
+    ColorPalette() { colors.reserve(64); }
+
+    ColorPalette(const ColorPalette&) = delete;
+    ColorPalette& operator=(const ColorPalette&) = delete;
+
+    /**
+     * @brief Получить общую палитру процесса
+     */
+    static ColorPalette& instance() {
+        static ColorPalette palette;
+        return palette;
+    }
+
+    /**
+     * @brief Добавить цвет или найти уже добавленный
+     * @param color Название цвета
+     * @return Номер цвета в палитре
+     * @throws std::invalid_argument если палитра заполнена
+     */
+    std::uint16_t add(std::string_view color) {
+        InternedString text = StringPool::instance().intern(color);
+        if (text.id() < byString.size() && byString[text.id()] != NONE) {
+            return byString[text.id()];
+        }
+        if (colors.size() >= CAPACITY) {
+            throw std::invalid_argument("Palitra tsvetov zapolnena");
+        }
+        if (text.id() >= byString.size()) {
+            byString.resize(text.id() + 1, NONE);
+        }
+        std::uint16_t index = static_cast<std::uint16_t>(colors.size());
+        colors.push_back(text);
+        byString[text.id()] = index;
+        return index;
+    }
+
+    /**
+     * @brief Проверить без исключений, что add(color) не переполнит палитру
+     * @return true если цвет уже в палитре или для него есть место
+     * @note Не интернирует color: проверка не меняет StringPool
+     */
+    bool canAdd(std::string_view color) const {
+        return contains(color) || colors.size() < CAPACITY;
+    }
+
+    /**
+     * @brief Проверить, добавлен ли цвет в палитру
+     */
+    bool contains(std::string_view color) const {
+        InternedString text;
+        return StringPool::instance().find(color, text) && text.id() < byString.size() &&
+               byString[text.id()] != NONE;
+    }
+
+    /**
+     * @brief Цвет по номеру
+     * @param index Номер из add()
+     */
+    InternedString get(std::uint16_t index) const { return colors[index]; }
+
+    /**
+     * @brief Количество цветов в палитре
+     */
+    std::size_t size() const { return colors.size(); }
+};
+
+#endif // COLOR_PALETTE_HPP
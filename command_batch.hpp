@@ -0,0 +1,407 @@
+/**
+ * @file command_batch.hpp
+ * @brief Пакетное применение команд к устройствам
+ *
+ * @details
+ * CommandBatch накапливает команды (включить, выключить, переключить
+ * розетку, яркость, режим) и применяет их за один проход:
+ * - команды группируются по типу команды и типу устройства (DeviceKind),
+ *   внутри группы - по возрастанию дескриптора, поэтому каждая группа -
+ *   это цикл с постоянными масками флагов без виртуальных вызовов;
+ *   группы раскладываются сортировкой подсчетом за O(N), группа с
+ *   дескрипторами не по возрастанию досортировывается отдельно;
+ * - время снимается с DeviceClock один раз на весь пакет;
+ * - результат - компактный вектор CommandResult в порядке постановки
+ *   команд, ошибки ввода возвращаются кодом, а не исключением;
+ * - строки статуса (необязательно) собираются в один буфер и выводятся
+ *   в поток одной записью с одним сбросом.
+ *
+ * @note Команды одного устройства в одном пакете применяются в порядке
+ *       фаз CommandType (включение, яркость, режим, розетка, выключение),
+ *       а не в порядке постановки. Зависимые цепочки команд следует
+ *       разносить по разным пакетам.
+ * @note Устройства с DeviceKind::NONE (типы вне библиотеки) включаются и
+ *       выключаются через виртуальные turnOn()/turnOff().
+ */
+
+#ifndef COMMAND_BATCH_HPP
+#define COMMAND_BATCH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "device_clock.hpp"
+#include "device_journal.hpp"
+#include "device_metrics.hpp"
+#include "device_registry.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @brief Тип команды; значение задает фазу применения внутри пакета
+ */
+enum class CommandType : std::uint8_t {
+    TURN_ON = 0,                ///< Включить устройство
+    SET_BRIGHTNESS = 1,         ///< Установить яркость лампочки (argument 0-100)
+    SET_MODE = 2,               ///< Режим термостата (argument 1 monitoring, 0 display)
+    TOGGLE_OUTLET = 3,          ///< Переключить розетку включенного устройства
+    TURN_OFF = 4                ///< Выключить устройство
+};
+
+/**
+ * @brief Результат применения одной команды
+ */
+enum class CommandResult : std::uint8_t {
+    APPLIED = 0,                ///< Состояние изменено
+    UNCHANGED = 1,              ///< Устройство уже было в нужном состоянии
+    INVALID_DEVICE = 2,         ///< Дескриптор не указывает на устройство
+    UNSUPPORTED = 3,            ///< Команда не применима к типу устройства
+    INVALID_ARGUMENT = 4,       ///< Аргумент вне допустимого диапазона
+    DEVICE_REJECTED = 5,        ///< Устройство отклонило команду (только device_io.hpp)
+    DEVICE_TIMEOUT = 6          ///< Нет ответа устройства (только device_io.hpp)
+};
+
+/**
+ * @struct DeviceCommand
+ * @brief Команда в очереди пакета
+ */
+struct DeviceCommand {
+    DeviceHandle handle;        ///< Дескриптор устройства
+    CommandType type;           ///< Тип команды
+    std::int32_t argument;      ///< Аргумент (яркость или режим)
+};
+
+/**
+ * @class CommandBatch
+ * @brief Очередь команд с пакетным применением
+ */
+class CommandBatch {
+private:
+    std::vector<DeviceCommand> commands;            ///< Команды в порядке постановки
+    std::vector<CommandResult> results;             ///< Результаты в порядке постановки
+    std::vector<std::uint8_t> groups;               ///< Группа каждой команды (или NO_GROUP)
+    std::vector<std::uint32_t> order;               ///< Номера команд, разложенные по группам
+    std::vector<std::uint32_t> printed;             ///< Отметки вывода статуса по дескриптору
+    std::uint32_t printStamp;                       ///< Текущая отметка вывода
+    std::string status;                             ///< Буфер строк статуса
+
+    static constexpr std::size_t KIND_COUNT = 4;                    ///< Значений DeviceKind
+    static constexpr std::size_t GROUP_COUNT = 5 * KIND_COUNT;      ///< Фаз CommandType * типов
+    static constexpr std::uint8_t NO_GROUP = 0xFF;                  ///< Команда без устройства
+
+    /**
+     * @brief Номер группы: фаза команды, затем тип устройства
+     */
+    static std::uint8_t groupOf(CommandType type, DeviceKind kind) {
+        return static_cast<std::uint8_t>(static_cast<std::size_t>(type) * KIND_COUNT +
+                                         static_cast<std::size_t>(kind));
+    }
+
+    // Флаги, которые turnOn()/turnOff() конкретных классов меняют вместе с ON
+    static std::uint64_t onFlags(DeviceKind kind) {
+        return kind == DeviceKind::THERMOSTAT ? DeviceState::MONITORING : 0;
+    }
+
+    static std::uint64_t offFlags(DeviceKind kind) {
+        switch (kind) {
+            case DeviceKind::THERMOSTAT: return DeviceState::MONITORING;
+            case DeviceKind::SMART_OUTLET: return DeviceState::OUTLET;
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief Применить группу однотипных команд
+     * @param begin Первый элемент группы в order
+     * @param end Элемент за последним в группе
+     */
+    void applyGroup(DeviceRegistry& reg, std::size_t begin, std::size_t end,
+                    CommandType type, DeviceKind kind, DeviceTime now) {
+        switch (type) {
+            case CommandType::TURN_ON:
+            case CommandType::TURN_OFF: {
+                bool on = type == CommandType::TURN_ON;
+                if (kind == DeviceKind::NONE) {
+                    for (std::size_t i = begin; i < end; i++) {
+                        SmartDevice* device = reg.owner(commands[order[i]].handle);
+                        on ? device->turnOn() : device->turnOff();
+                        results[order[i]] = CommandResult::APPLIED;
+                    }
+                    return;
+                }
+                std::uint64_t flags = on ? onFlags(kind) : offFlags(kind);
+                for (std::size_t i = begin; i < end; i++) {
+                    DeviceHandle handle = commands[order[i]].handle;
+                    bool changed = on ? PoweredDevice::switchOnAt(handle, flags, now)
+                                      : PoweredDevice::switchOffAt(handle, flags, now);
+                    results[order[i]] = changed ? CommandResult::APPLIED : CommandResult::UNCHANGED;
+                }
+                return;
+            }
+
+            case CommandType::SET_BRIGHTNESS:
+                for (std::size_t i = begin; i < end; i++) {
+                    const DeviceCommand& command = commands[order[i]];
+                    CommandResult& result = results[order[i]];
+                    if (kind != DeviceKind::LIGHT_BULB) {
+                        result = CommandResult::UNSUPPORTED;
+                    } else if (LightBulb::checkBrightness(command.argument) != DeviceError::NONE) {
+                        result = CommandResult::INVALID_ARGUMENT;
+                    } else if (reg.bright(command.handle) == command.argument) {
+                        result = CommandResult::UNCHANGED;
+                    } else {
+                        reg.bright(command.handle) = static_cast<std::uint8_t>(command.argument);
+                        DeviceJournal::record(command.handle, JournalOp::SET_BRIGHTNESS,
+                                              reg.loadState(command.handle), command.argument, now);
+                        result = CommandResult::APPLIED;
+                    }
+                }
+                return;
+
+            case CommandType::SET_MODE:
+                for (std::size_t i = begin; i < end; i++) {
+                    const DeviceCommand& command = commands[order[i]];
+                    CommandResult& result = results[order[i]];
+                    if (kind != DeviceKind::THERMOSTAT) {
+                        result = CommandResult::UNSUPPORTED;
+                    } else if (command.argument != 0 && command.argument != 1) {
+                        result = CommandResult::INVALID_ARGUMENT;
+                    } else {
+                        std::atomic_ref<std::uint64_t> state = reg.stateRef(command.handle);
+                        std::uint64_t current = state.load(std::memory_order_relaxed);
+                        std::uint64_t desired;
+                        do {
+                            desired = command.argument ? (current | DeviceState::MONITORING)
+                                                       : (current & ~DeviceState::MONITORING);
+                        } while (desired != current &&
+                                 !state.compare_exchange_weak(current, desired, std::memory_order_acq_rel,
+                                                              std::memory_order_relaxed));
+                        if (desired == current) {
+                            result = CommandResult::UNCHANGED;
+                        } else {
+                            DeviceJournal::record(command.handle, JournalOp::SET_MODE, desired,
+                                                  command.argument, now);
+                            result = CommandResult::APPLIED;
+                        }
+                    }
+                }
+                return;
+
+            case CommandType::TOGGLE_OUTLET:
+                for (std::size_t i = begin; i < end; i++) {
+                    const DeviceCommand& command = commands[order[i]];
+                    CommandResult& result = results[order[i]];
+                    if (kind != DeviceKind::SMART_OUTLET) {
+                        result = CommandResult::UNSUPPORTED;
+                        continue;
+                    }
+                    // Как SmartOutlet::toggleOutlet(): только при включенном устройстве
+                    std::atomic_ref<std::uint64_t> state = reg.stateRef(command.handle);
+                    std::uint64_t current = state.load(std::memory_order_relaxed);
+                    result = CommandResult::APPLIED;
+                    do {
+                        if (!(current & DeviceState::ON)) {
+                            result = CommandResult::UNCHANGED;
+                            break;
+                        }
+                    } while (!state.compare_exchange_weak(current, current ^ DeviceState::OUTLET,
+                                                          std::memory_order_acq_rel,
+                                                          std::memory_order_relaxed));
+                    if (result == CommandResult::APPLIED) {
+                        std::uint64_t toggled = current ^ DeviceState::OUTLET;
+                        reg.noteTransition(command.handle, current, toggled);
+                        DeviceJournal::record(command.handle, JournalOp::TOGGLE_OUTLET, toggled,
+                                              (toggled & DeviceState::OUTLET) ? 1.0 : 0.0, now);
+                    }
+                }
+                return;
+        }
+    }
+
+    /**
+     * @brief Вывести статус каждого затронутого устройства одной записью
+     */
+    void writeStatus(const DeviceRegistry& reg, std::ostream& out) {
+        status.clear();
+        if (printed.size() < reg.capacity()) {
+            printed.resize(reg.capacity(), 0);
+        }
+        printStamp++;
+        for (std::size_t i = 0; i < commands.size(); i++) {
+            DeviceHandle handle = commands[i].handle;
+            if (results[i] == CommandResult::INVALID_DEVICE || printed[handle] == printStamp) {
+                continue;
+            }
+            printed[handle] = printStamp;
+            const SmartDevice* device = reg.owner(handle);
+            status.append(device->getName());
+            status.append(": ");
+            device->appendStatus(status);
+            status.push_back('\n');
+        }
+        out.write(status.data(), static_cast<std::streamsize>(status.size()));
+        out.flush();
+    }
+
+public:
+    CommandBatch() : printStamp(0) {}
+
+    /**
+     * @brief Зарезервировать место под команды
+     * @param count Ожидаемое количество команд
+     */
+    void reserve(std::size_t count) {
+        commands.reserve(count);
+        results.reserve(count);
+        groups.reserve(count);
+        order.reserve(count);
+    }
+
+    /**
+     * @brief Очистить очередь (память сохраняется)
+     */
+    void clear() {
+        commands.clear();
+        results.clear();
+    }
+
+    /**
+     * @brief Количество команд в очереди
+     */
+    std::size_t size() const { return commands.size(); }
+
+    /**
+     * @brief Поставить команду в очередь
+     * @param command Команда
+     * @return Ссылка на пакет для цепочки вызовов
+     */
+    CommandBatch& add(const DeviceCommand& command) {
+        commands.push_back(command);
+        return *this;
+    }
+
+    CommandBatch& turnOn(DeviceHandle handle) {
+        return add(DeviceCommand{handle, CommandType::TURN_ON, 0});
+    }
+
+    CommandBatch& turnOff(DeviceHandle handle) {
+        return add(DeviceCommand{handle, CommandType::TURN_OFF, 0});
+    }
+
+    CommandBatch& toggleOutlet(DeviceHandle handle) {
+        return add(DeviceCommand{handle, CommandType::TOGGLE_OUTLET, 0});
+    }
+
+    CommandBatch& setBrightness(DeviceHandle handle, int level) {
+        return add(DeviceCommand{handle, CommandType::SET_BRIGHTNESS, level});
+    }
+
+    /**
+     * @brief Поставить в очередь смену режима термостата
+     * @param monitoring true - "monitoring", false - "display"
+     */
+    CommandBatch& setMode(DeviceHandle handle, bool monitoring) {
+        return add(DeviceCommand{handle, CommandType::SET_MODE, monitoring ? 1 : 0});
+    }
+
+    CommandBatch& turnOn(const SmartDevice& device) { return turnOn(device.getHandle()); }
+    CommandBatch& turnOff(const SmartDevice& device) { return turnOff(device.getHandle()); }
+    CommandBatch& toggleOutlet(const SmartDevice& device) { return toggleOutlet(device.getHandle()); }
+    CommandBatch& setBrightness(const SmartDevice& device, int level) {
+        return setBrightness(device.getHandle(), level);
+    }
+    CommandBatch& setMode(const SmartDevice& device, bool monitoring) {
+        return setMode(device.getHandle(), monitoring);
+    }
+
+    /**
+     * @brief Применить все команды очереди
+     * @param statusOut Поток для строк "имя: статус" или nullptr
+     * @return Результаты в порядке постановки команд
+     * @post Очередь сохраняется до вызова clear()
+     */
+    const std::vector<CommandResult>& apply(std::ostream* statusOut = nullptr) {
+        DEVICE_METRICS_TIME(DeviceKind::NONE, BATCH_APPLY);
+        DeviceRegistry& reg = DeviceRegistry::instance();
+        DeviceTime now = DeviceClock::now();
+
+        results.assign(commands.size(), CommandResult::INVALID_DEVICE);
+        groups.resize(commands.size());
+
+        // Сортировка подсчетом по группам: размер группы, затем смещения
+        std::size_t groupStart[GROUP_COUNT + 1] = {};
+        for (std::size_t i = 0; i < commands.size(); i++) {
+            DeviceHandle handle = commands[i].handle;
+            if (handle >= reg.capacity() || !reg.owner(handle)) {
+                groups[i] = NO_GROUP;
+                continue;
+            }
+            groups[i] = groupOf(commands[i].type, reg.kind(handle));
+            groupStart[groups[i] + 1]++;
+        }
+        for (std::size_t g = 0; g < GROUP_COUNT; g++) {
+            groupStart[g + 1] += groupStart[g];
+        }
+        order.resize(groupStart[GROUP_COUNT]);
+        std::size_t fill[GROUP_COUNT];
+        std::copy(groupStart, groupStart + GROUP_COUNT, fill);
+        DeviceHandle last[GROUP_COUNT] = {};
+        bool unsorted[GROUP_COUNT] = {};
+        for (std::size_t i = 0; i < commands.size(); i++) {
+            std::uint8_t g = groups[i];
+            if (g != NO_GROUP) {
+                DeviceHandle handle = commands[i].handle;
+                unsorted[g] |= fill[g] > groupStart[g] && handle < last[g];
+                last[g] = handle;
+                order[fill[g]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        // Обычно команды ставятся по возрастанию дескриптора и группа уже
+        // упорядочена; устойчивость сохраняет порядок постановки для
+        // команд одного устройства
+        for (std::size_t g = 0; g < GROUP_COUNT; g++) {
+            if (unsorted[g]) {
+                std::stable_sort(order.begin() + groupStart[g], order.begin() + groupStart[g + 1],
+                                 [&](std::uint32_t a, std::uint32_t b) {
+                                     return commands[a].handle < commands[b].handle;
+                                 });
+            }
+        }
+
+        for (std::size_t g = 0; g < GROUP_COUNT; g++) {
+            if (groupStart[g] < groupStart[g + 1]) {
+                applyGroup(reg, groupStart[g], groupStart[g + 1],
+                           static_cast<CommandType>(g / KIND_COUNT),
+                           static_cast<DeviceKind>(g % KIND_COUNT), now);
+#ifdef SMART_DEVICES_METRICS
+                for (std::size_t i = groupStart[g]; i < groupStart[g + 1]; i++) {
+                    CommandResult result = results[order[i]];
+                    if (result == CommandResult::APPLIED || result == CommandResult::UNCHANGED) {
+                        DEVICE_METRICS_COUNT(static_cast<DeviceKind>(g % KIND_COUNT), BATCH_COMMAND);
+                    } else {
+                        DEVICE_METRICS_COUNT(static_cast<DeviceKind>(g % KIND_COUNT), BATCH_COMMAND_REJECTED);
+                    }
+                }
+#endif
+            }
+        }
+
+        if (statusOut) {
+            writeStatus(reg, *statusOut);
+        }
+        return results;
+    }
+
+    /**
+     * @brief Количество команд с заданным результатом после apply()
+     */
+    std::size_t count(CommandResult result) const {
+        return static_cast<std::size_t>(std::count(results.begin(), results.end(), result));
+    }
+};
+
+#endif // COMMAND_BATCH_HPP
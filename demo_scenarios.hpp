@@ -0,0 +1,352 @@
+/**
+ * @file demo_scenarios.hpp
+ * @brief Демонстрационные сценарии: функции бывшего меню main.cpp по именам
+ *
+ * @details
+ * Каждый сценарий - функция без аргументов, печатающая результат в
+ * std::cout. Таблица demoScenarios() сопоставляет имя сценария (имя
+ * функции) и пункт меню, поэтому одни и те же сценарии запускаются из
+ * интерактивного меню main.cpp и из нагрузочного генератора loadgen.cpp
+ * (loadgen scenario=polymorphism,staticMembers).
+ *
+ * Сценарии createDevices, turnOnAll, turnOffAll, showStatistics и
+ * clearDevices работают с общим домом из 3 устройств (DemoHome).
+ */
+
+#ifndef DEMO_SCENARIOS_HPP
+#define DEMO_SCENARIOS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "smart_devices.hpp"
+#include "command_batch.hpp"
+#include "device_arena.hpp"
+#include "device_io.hpp"
+#include "device_visit.hpp"
+#include "fleet_kernels.hpp"
+
+inline void polymorphism() {
+    std::cout << "\nPolimorfnyy vyzov\n";
+    
+    LightBulb lamp("LB2", "Lampochka", 20000);
+    Thermostat thermo("TH2", "Termostat", 20000);
+    SmartOutlet outlet("SO2", "Rozetka", 20000);
+    
+    SmartDevice* devices[] = {&lamp, &thermo, &outlet};
+    
+    for (int i = 0; i < 3; i++) {
+        SmartDevice* device = devices[i];
+        device->turnOn();
+        std::cout << device->getStatus() << std::endl;
+    }
+    
+    for (int i = 0; i < 3; i++) {
+        SmartDevice* device = devices[i];
+        device->turnOff();
+        std::cout << device->getStatus() << std::endl;
+    }
+}
+
+inline DeviceTask<void> switchFor(DeviceLink& link, SmartDevice& device, std::chrono::milliseconds duration) {
+    co_await link.turnOn(device);
+    co_await link.loop().sleepFor(duration);
+    co_await link.turnOff(device);
+}
+
+inline void staticMembers() {
+    std::cout << "\nRabota staticheskikh chlenov\n";
+    
+    int initialDeviceCount = SmartDevice::getTotalDevicesCreated();
+    double initialEnergy = PoweredDevice::getTotalEnergyConsumedAll();
+    
+    {
+        LightBulb lamp("LB3", "Test lampa", 20000);
+        Thermostat thermo("TH3", "Test termostat", 20000);
+        SmartOutlet outlet("SO3", "Test rozetka", 20000);
+        
+        DeviceEventLoop loop;
+        SimulatedTransport transport(loop, std::chrono::milliseconds(20));
+        DeviceLink link(loop, transport);
+        
+        loop.spawn(switchFor(link, lamp, std::chrono::milliseconds(500)));
+        loop.spawn(switchFor(link, thermo, std::chrono::milliseconds(500)));
+        loop.spawn(switchFor(link, outlet, std::chrono::milliseconds(500)));
+        loop.run();
+        
+        std::cout << "Sozdano ustroystv v teste: " << (SmartDevice::getTotalDevicesCreated() - initialDeviceCount) << "\n";
+        std::cout << "Potrebleno energii v teste: " << (PoweredDevice::getTotalEnergyConsumedAll() - initialEnergy) << " Vt*ch\n";
+    }
+}
+
+inline void copyAndAssignment() {
+    std::cout << "\nKopirovanie i prisvaivanie\n";
+    
+    LightBulb lamp1("LB4", "Lampochka 1", 20000, 75, "belyy");
+    lamp1.turnOn();
+    
+    LightBulb lamp2 = lamp1;
+    LightBulb lamp3("LB4_temp", "Temp", 20000);
+    lamp3 = lamp1;
+    
+    std::cout << "Original ID: " << lamp1.getId() << "\n";
+    std::cout << "Kopiya ID: " << lamp2.getId() << "\n";
+    std::cout << "Prisvoennaya ID: " << lamp3.getId() << "\n";
+}
+
+inline void exceptions() {
+    std::cout << "\nObrabotka isklyucheniy\n";
+    
+    std::cout << "1. Sozdayu lampochku s yarkost'yu 150% (dopustimo 0-100%):\n";
+    try {
+        LightBulb lamp("LB5", "Test lampa", 20000, 150, "belyy");
+        std::cout << "  Lampochka sozdana, yarkost: " << lamp.getBrightness() << "%\n";
+    } catch (const std::invalid_argument& e) {
+        std::cout << "  Vozniklo isklyuchenie: " << e.what() << "\n";
+    }
+    
+    std::cout << "\n2. Sozdayu lampochku s yarkost'yu 50%, zatem pytayus' ustanovit' 150%:\n";
+    LightBulb lamp("LB5", "Test lampa", 20000, 50);
+    std::cout << "  Nachal'naya yarkost': " << lamp.getBrightness() << "%\n";
+    
+    try {
+        std::cout << "  Pytaemsya ustanovit' yarkost' 150%...\n";
+        lamp.setBrightness(150);
+        std::cout << "  Yarkost' ustanovlena: " << lamp.getBrightness() << "%\n";
+    } catch (const std::invalid_argument& e) {
+        std::cout << "  Vozniklo isklyuchenie: " << e.what() << "\n";
+    }
+}
+
+inline void multipleInheritance() {
+    std::cout << "\nMnozhestvennoe nasledovanie\n";
+    
+    SmartOutlet outlet("SO6", "Rozetka s datchikom protechki", 20000);
+    outlet.turnOn();
+    
+    ISensor* sensor = &outlet;
+    std::cout << "Tip datchika: " << sensor->getSensorType() << "\n";
+    std::cout << "Moshchnost: " << sensor->getCurrentPower() << " Vt\n";
+}
+
+/**
+ * @class DemoHome
+ * @brief Дом из 3 устройств для сценариев меню
+ */
+class DemoHome {
+private:
+    DeviceArena deviceArena;
+    CommandBatch commandBatch;
+    SmartDevice* devices[3] = {nullptr, nullptr, nullptr};
+    int deviceCount = 3;
+    bool devicesCreated = false;
+
+public:
+    /**
+     * @brief Общий дом процесса
+     * @details Реестр создается раньше дома, поэтому переживает его
+     *          при завершении процесса
+     */
+    static DemoHome& instance() {
+        DeviceRegistry::instance();
+        static DemoHome home;
+        return home;
+    }
+
+    void createDevices() {
+        std::cout << "Sozdanie 3 ustroystv...\n";
+    
+        if (devicesCreated) {
+            deviceArena.reset();
+            for (int i = 0; i < deviceCount; i++) {
+                devices[i] = nullptr;
+            }
+        }
+    
+        devices[0] = deviceArena.make<LightBulb>("LB1", "Lampochka", 20000, 75, "teplyy belyy");
+        devices[1] = deviceArena.make<Thermostat>("TH1", "Termostat", 20000, 22.5);
+        devices[2] = deviceArena.make<SmartOutlet>("SO1", "Rozetka s datchikom protechki", 20000);
+    
+        devicesCreated = true;
+    
+        std::cout << "Sozdano 3 ustroystva:\n";
+        for (int i = 0; i < deviceCount; i++) {
+            if (devices[i]) {
+                std::cout << i+1 << ". " << devices[i]->getDeviceInfo() << "\n";
+            
+                if (Thermostat* thermo = deviceCast<Thermostat>(devices[i])) {
+                    std::cout << "   Rezhim: " << thermo->getMode() << "\n";
+                }
+            }
+        }
+    }
+
+    void turnOnAll() {
+        if (!devicesCreated) {
+            std::cout << "Net ustroystv! Sozdayte ustroystva snachala (vyberite punkt 2 v menu).\n";
+            return;
+        }
+    
+        std::cout << "\n=== Vklyuchenie vsekh ustroystv ===\n";
+        int count = 0;
+        commandBatch.clear();
+        for (int i = 0; i < deviceCount; i++) {
+            if (devices[i]) {
+                commandBatch.turnOn(*devices[i]);
+                if (devices[i]->getKind() == DeviceKind::SMART_OUTLET) {
+                    commandBatch.toggleOutlet(*devices[i]);
+                }
+                count++;
+            }
+        }
+        commandBatch.apply(&std::cout);
+        std::cout << "Vsego vklyucheno: " << count << " ustroystv\n";
+    }
+
+    void turnOffAll() {
+        if (!devicesCreated) {
+            std::cout << "Net ustroystv! Sozdayte ustroystva snachala (vyberite punkt 2 v menu).\n";
+            return;
+        }
+    
+        std::cout << "\n=== Viklyuchenie vsekh ustroystv ===\n";
+        int count = 0;
+        commandBatch.clear();
+        for (int i = 0; i < deviceCount; i++) {
+            if (devices[i]) {
+                commandBatch.turnOff(*devices[i]);
+                count++;
+            }
+        }
+        commandBatch.apply(&std::cout);
+        std::cout << "Vsego viklyucheno: " << count << " ustroystv\n";
+    }
+
+    void showStatistics() {
+        if (!devicesCreated) {
+            std::cout << "Net ustroystv! Sozdayte ustroystva snachala (vyberite punkt 2 v menu).\n";
+            return;
+        }
+    
+        std::cout << "\n=== Statistika potrebleniya energii ===\n";
+    
+        const DeviceRegistry& registry = DeviceRegistry::instance();
+        DeviceTime now = DeviceClock::now();
+        std::size_t onDevices = registry.devicesOn();
+        double totalCurrentPower = registry.currentPower();
+        double totalEnergyNow = sumFleetEnergy(registry, now);
+    
+        std::cout << "\n=== Potreblenie vklyuchennykh ustroystv ===\n";
+        bool hasOnPoweredDevices = false;
+    
+        for (int i = 0; i < deviceCount; i++) {
+            if (devices[i] && devices[i]->getIsOn()) {
+                PoweredDevice* poweredDevice = deviceCast<PoweredDevice>(devices[i]);
+                if (poweredDevice) {
+                    hasOnPoweredDevices = true;
+                    double energyConsumed = poweredDevice->getDeviceEnergyConsumed();
+                    double currentPower = poweredDevice->getCurrentPower();  // С учетом реле, как итог реестра
+                
+                    std::cout << devices[i]->getName() 
+                              << ": Potrebleno energii = " << std::fixed << std::setprecision(3) << energyConsumed << " Vt*ch";
+                    std::cout << ", Tekushchaya moshchnost = " << currentPower << " Vt";
+                
+                    visit(*devices[i], overloaded{
+                        [](const LightBulb& lamp) {
+                            std::cout << ", Yarkost: " << lamp.getBrightness() << "%";
+                        },
+                        [](const Thermostat& thermo) {
+                            std::cout << ", Temp: " << thermo.getCurrentTemperature() << "°C";
+                        },
+                        [](const SmartDevice&) {}
+                    });
+                
+                    std::cout << std::endl;
+                }
+            }
+        }
+    
+        if (!hasOnPoweredDevices) {
+            std::cout << "Net vklyuchennykh ustroystv s uchetom energii\n";
+        }
+    
+        std::cout << "\n=== Obshchaya statistika ===\n";
+        std::cout << "Vsego sozdano ustroystv: " << SmartDevice::getTotalDevicesCreated() << "\n";
+        std::cout << "Vklyucheno ustroystv: " << onDevices << " iz " << registry.size() << "\n";
+        std::cout << "Obshchee potreblenie energii vsemi ustroystvami: " 
+                  << std::fixed << std::setprecision(3) << PoweredDevice::getTotalEnergyConsumedAll() << " Vt*ch\n";
+        std::cout << "Energiya s uchetom tekushchikh sessiy: " << totalEnergyNow << " Vt*ch\n";
+        std::cout << "Obshchaya tekushchaya moshchnost: " << totalCurrentPower << " Vt" << std::endl;
+    }
+
+    void clearDevices() {
+        if (devicesCreated) {
+            deviceArena.reset();
+            for (int i = 0; i < deviceCount; i++) {
+                devices[i] = nullptr;
+            }
+            devicesCreated = false;
+            std::cout << "Vse ustroystva udaleny!\n";
+        } else {
+            std::cout << "Net ustroystv dlya udaleniya!\n";
+        }
+    }
+};
+
+inline void createDevices() { DemoHome::instance().createDevices(); }
+inline void turnOnAll() { DemoHome::instance().turnOnAll(); }
+inline void turnOffAll() { DemoHome::instance().turnOffAll(); }
+inline void showStatistics() { DemoHome::instance().showStatistics(); }
+inline void clearDevices() { DemoHome::instance().clearDevices(); }
+
+/**
+ * @struct DemoScenario
+ * @brief Именованный сценарий
+ */
+struct DemoScenario {
+    const char* name;           ///< Имя для loadgen (имя функции)
+    const char* title;          ///< Пункт меню
+    void (*run)();              ///< Сценарий
+};
+
+/**
+ * @brief Все сценарии в порядке пунктов меню
+ */
+inline const DemoScenario* demoScenarios(std::size_t& count) {
+    static const DemoScenario scenarios[] = {
+        {"createDevices", "Sozdat 3 ustroystva", createDevices},
+        {"turnOnAll", "Vklyuchit VSE ustroystva", turnOnAll},
+        {"turnOffAll", "Viklyuchit VSE ustroystva", turnOffAll},
+        {"showStatistics", "Pokazat statistiku", showStatistics},
+        {"polymorphism", "Polimorfizm", polymorphism},
+        {"staticMembers", "Staticheskie chleny", staticMembers},
+        {"copyAndAssignment", "Kopirovanie", copyAndAssignment},
+        {"exceptions", "Isklyucheniya", exceptions},
+        {"multipleInheritance", "Mnozhestvennoe nasledovanie", multipleInheritance},
+        {"clearDevices", "Udalit' vse ustroystva", clearDevices},
+    };
+    count = sizeof(scenarios) / sizeof(scenarios[0]);
+    return scenarios;
+}
+
+/**
+ * @brief Найти сценарий по имени
+ * @throws std::invalid_argument если сценария нет
+ */
+inline const DemoScenario& findDemoScenario(std::string_view name) {
+    std::size_t count;
+    const DemoScenario* scenarios = demoScenarios(count);
+    for (std::size_t i = 0; i < count; i++) {
+        if (name == scenarios[i].name) {
+            return scenarios[i];
+        }
+    }
+    throw std::invalid_argument("Neizvestnyy stsenariy: " + std::string(name));
+}
+
+#endif // DEMO_SCENARIOS_HPP
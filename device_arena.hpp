@@ -0,0 +1,206 @@
+/**
+ * @file device_arena.hpp
+ * @brief Арена для размещения устройств и их строк в непрерывных блоках
+ *
+ * @details
+ * DeviceArena выделяет память последовательно из крупных блоков (slab).
+ * Фабрика make<T>() размещает объекты устройств в блоках подряд; их
+ * строки (ID, имя, цвет) интернированы в StringPool, который тоже хранит
+ * символы непрерывными блоками и переиспользует их при пересоздании
+ * той же конфигурации. reset() уничтожает все объекты поколения и
+ * возвращает указатель выделения в начало первого блока: память не
+ * освобождается и переиспользуется следующим поколением.
+ *
+ * @note Деструкторы устройств при reset() все равно вызываются (в обратном
+ *       порядке создания), чтобы освободить ячейки DeviceRegistry и
+ *       корректно закрыть статистику. Освобождение памяти - O(1).
+ * @note Арена не потокобезопасна.
+ */
+
+#ifndef DEVICE_ARENA_HPP
+#define DEVICE_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "device_error.hpp"
+#include "device_metrics.hpp"
+#include "device_registry.hpp"
+
+/**
+ * @class DeviceArena
+ * @brief Блочная арена памяти с типизированной фабрикой устройств
+ */
+class DeviceArena {
+private:
+    /**
+     * @brief Непрерывный блок памяти арены
+     */
+    struct Slab {
+        std::unique_ptr<std::byte[]> data;  ///< Память блока
+        std::size_t size;                   ///< Размер блока в байтах
+    };
+
+    /**
+     * @brief Запись о созданном объекте для вызова деструктора при reset()
+     */
+    struct Entry {
+        void* object;                       ///< Адрес объекта в блоке
+        void (*destroy)(void*);             ///< Деструктор конкретного типа
+    };
+
+    std::vector<Slab> slabs;                ///< Все выделенные блоки
+    std::vector<Entry> objects;             ///< Объекты текущего поколения
+    std::size_t slabSize;                   ///< Размер нового блока по умолчанию
+    std::size_t currentSlab;                ///< Индекс блока, из которого идет выделение
+    std::size_t offset;                     ///< Смещение в текущем блоке
+    std::size_t generationNumber;           ///< Номер текущего поколения
+
+    /**
+     * @brief Отрезать выровненный участок от текущего блока
+     * @return Адрес участка или nullptr, если в блоке не хватает места
+     */
+    void* carve(Slab& slab, std::size_t bytes, std::size_t alignment) {
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(slab.data.get());
+        std::uintptr_t start = (base + offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+        if (start + bytes > base + slab.size) {
+            return nullptr;
+        }
+        offset = static_cast<std::size_t>(start + bytes - base);
+        return reinterpret_cast<void*>(start);
+    }
+
+    /**
+     * @brief Выделить участок в текущем или новом блоке
+     * @details Память возвращается только целым поколением через reset()
+     */
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        while (currentSlab < slabs.size()) {
+            void* result = carve(slabs[currentSlab], bytes, alignment);
+            if (result) {
+                return result;
+            }
+            currentSlab++;
+            offset = 0;
+        }
+        std::size_t size = bytes + alignment > slabSize ? bytes + alignment : slabSize;
+        slabs.push_back(Slab{std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+        currentSlab = slabs.size() - 1;
+        offset = 0;
+        return carve(slabs.back(), bytes, alignment);
+    }
+
+    template <class T>
+    static void destroyObject(void* object) {
+        static_cast<T*>(object)->~T();
+    }
+
+public:
+    /**
+     * @brief Конструктор арены
+     * @param slabSize Размер одного блока в байтах
+     * @post Реестр устройств гарантированно переживает арену
+     */
+    explicit DeviceArena(std::size_t slabSize = 64 * 1024)
+        : slabSize(slabSize), currentSlab(0), offset(0), generationNumber(0) {
+        // Деструкторы устройств обращаются к реестру, поэтому он должен
+        // быть создан раньше арены и уничтожен позже нее
+        DeviceRegistry::instance();
+    }
+
+    ~DeviceArena() {
+        reset();
+    }
+
+    DeviceArena(const DeviceArena&) = delete;
+    DeviceArena& operator=(const DeviceArena&) = delete;
+
+    /**
+     * @brief Создать устройство в арене
+     * @tparam T Тип устройства (LightBulb, Thermostat, SmartOutlet, ...)
+     * @param args Аргументы конструктора T
+     * @return Указатель на объект; владеет им арена
+     * @throws Исключения конструктора T (память неудачной попытки не возвращается)
+     */
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        // Место под запись резервируется заранее, чтобы push_back после
+        // конструирования не мог бросить; рост геометрический
+        if (objects.size() == objects.capacity()) {
+            objects.reserve(objects.empty() ? 64 : objects.capacity() * 2);
+        }
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = ::new (memory) T(std::forward<Args>(args)...);
+        objects.push_back(Entry{object, &destroyObject<T>});
+        return object;
+    }
+
+    /**
+     * @brief Создать устройство в арене, проверив параметры без исключений
+     * @tparam T Тип устройства с T::validate() по сигнатуре конструктора
+     * @param args Аргументы конструктора T
+     * @return Указатель на объект или код ошибки; при ошибке память не расходуется
+     */
+    template <class T, class... Args>
+    DeviceExpected<T*> tryMake(Args&&... args) {
+        DeviceError error = T::validate(args...);
+        if (error != DeviceError::NONE) {
+            DEVICE_METRICS_COUNT(T::KIND, CREATE_REJECTED);
+            return error;
+        }
+        return make<T>(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Создать в арене клон устройства с новым ID
+     * @param source Образец (LightBulb, Thermostat, SmartOutlet)
+     * @param newId ID нового устройства
+     * @return Указатель на клон; владеет им арена
+     */
+    template <class T>
+    T* clone(const T& source, std::string_view newId) {
+        return make<T>(source.clone(newId));
+    }
+
+    /**
+     * @brief Уничтожить все объекты поколения и переиспользовать память
+     * @post Блоки сохранены, указатель выделения в начале первого блока
+     */
+    void reset() {
+        for (std::size_t i = objects.size(); i > 0; i--) {
+            objects[i - 1].destroy(objects[i - 1].object);
+        }
+        objects.clear();
+        currentSlab = 0;
+        offset = 0;
+        generationNumber++;
+    }
+
+    /**
+     * @brief Количество объектов текущего поколения
+     */
+    std::size_t size() const { return objects.size(); }
+
+    /**
+     * @brief Номер текущего поколения (увеличивается при reset())
+     */
+    std::size_t generation() const { return generationNumber; }
+
+    /**
+     * @brief Суммарный размер выделенных блоков в байтах
+     */
+    std::size_t reservedBytes() const {
+        std::size_t total = 0;
+        for (const Slab& slab : slabs) {
+            total += slab.size;
+        }
+        return total;
+    }
+};
+
+#endif // DEVICE_ARENA_HPP
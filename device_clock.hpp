@@ -0,0 +1,196 @@
+/**
+ * @file device_clock.hpp
+ * @brief Подключаемые монотонные часы для учета времени работы устройств
+ *
+ * @details
+ * Учет сессий PoweredDevice ведется в наносекундах (DeviceTime) по
+ * часам, которые можно подменить через DeviceClock::set():
+ * - SteadyClock - std::chrono::steady_clock, используется по умолчанию
+ * - CoarseClock - кэшированное значение, обновляемое вызовом tick(),
+ *   чтение сводится к одной атомарной загрузке
+ * - ManualClock - время задается вручную, для моделирования и проверок
+ */
+
+#ifndef DEVICE_CLOCK_HPP
+#define DEVICE_CLOCK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Момент или длительность времени в наносекундах
+ */
+typedef std::int64_t DeviceTime;
+
+/**
+ * @brief Количество наносекунд в секунде
+ */
+const DeviceTime NANOS_PER_SECOND = 1000000000LL;
+
+/**
+ * @brief Количество наносекунд в часе (для перевода Вт*нс в Вт*ч)
+ */
+const DeviceTime NANOS_PER_HOUR = 3600LL * NANOS_PER_SECOND;
+
+/**
+ * @brief Перевести длительность DeviceTime в секунды
+ * @param time Длительность в наносекундах
+ * @return Длительность в секундах
+ */
+inline double toSeconds(DeviceTime time) {
+    return static_cast<double>(time) / static_cast<double>(NANOS_PER_SECOND);
+}
+
+/**
+ * @class Clock
+ * @brief Интерфейс монотонных часов
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * @brief Текущее время
+     * @return Наносекунды от начала отсчета часов
+     * @pure
+     */
+    virtual DeviceTime now() const = 0;
+};
+
+/**
+ * @class SteadyClock
+ * @brief Часы на основе std::chrono::steady_clock с наносекундным разрешением
+ */
+class SteadyClock : public Clock {
+public:
+    virtual DeviceTime now() const override {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+/**
+ * @class CoarseClock
+ * @brief Грубые часы с кэшированным значением для горячих путей
+ *
+ * @details
+ * now() возвращает значение, сохраненное последним вызовом tick().
+ * Обновлять его должен вызывающий код: таймер, цикл обработки
+ * команд или начало каждого пакета операций.
+ */
+class CoarseClock : public Clock {
+private:
+    const Clock& source;                ///< Точные часы, с которых снимается значение
+    std::atomic<DeviceTime> cached;     ///< Последнее снятое значение
+
+public:
+    /**
+     * @brief Конструктор грубых часов
+     * @param source Источник точного времени
+     * @post Значение снято с источника один раз
+     */
+    explicit CoarseClock(const Clock& source)
+        : source(source), cached(source.now()) {}
+
+    /**
+     * @brief Обновить кэшированное значение по источнику
+     */
+    void tick() {
+        cached.store(source.now(), std::memory_order_relaxed);
+    }
+
+    virtual DeviceTime now() const override {
+        return cached.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @class ManualClock
+ * @brief Часы с ручным управлением временем для моделирования
+ */
+class ManualClock : public Clock {
+private:
+    std::atomic<DeviceTime> current;    ///< Текущее модельное время
+
+public:
+    /**
+     * @brief Конструктор
+     * @param start Начальное время в наносекундах
+     */
+    explicit ManualClock(DeviceTime start = 0) : current(start) {}
+
+    /**
+     * @brief Установить текущее время
+     * @param time Новое время в наносекундах
+     */
+    void set(DeviceTime time) {
+        current.store(time, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Сдвинуть время вперед
+     * @param delta Сдвиг в наносекундах
+     */
+    void advance(DeviceTime delta) {
+        current.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    virtual DeviceTime now() const override {
+        return current.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @class DeviceClock
+ * @brief Точка подключения часов, используемых иерархией устройств
+ *
+ * @note Часы следует менять, пока ни одно устройство не включено:
+ *       сессии, начатые по одним часам, нельзя закрыть по другим.
+ */
+class DeviceClock {
+private:
+    static const Clock& defaultClock() {
+        static SteadyClock steady;
+        return steady;
+    }
+
+    static std::atomic<const Clock*>& slot() {
+        static std::atomic<const Clock*> current(&defaultClock());
+        return current;
+    }
+
+public:
+    /**
+     * @brief Получить текущие часы
+     * @return Ссылка на подключенные часы
+     */
+    static const Clock& get() {
+        return *slot().load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Подключить часы
+     * @param clock Часы, которые должны пережить все устройства
+     */
+    static void set(const Clock& clock) {
+        slot().store(&clock, std::memory_order_release);
+    }
+
+    /**
+     * @brief Вернуть часы по умолчанию (SteadyClock)
+     */
+    static void reset() {
+        set(defaultClock());
+    }
+
+    /**
+     * @brief Текущее время по подключенным часам
+     * @return Наносекунды
+     */
+    static DeviceTime now() {
+        return get().now();
+    }
+};
+
+#endif // DEVICE_CLOCK_HPP
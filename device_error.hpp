@@ -0,0 +1,74 @@
+/**
+ * @file device_error.hpp
+ * @brief Коды ошибок проверки параметров устройств без исключений
+ *
+ * @details
+ * Методы try*() и фабрика tryCreate<T>() возвращают DeviceError или
+ * DeviceExpected<T> вместо выброса std::invalid_argument: отклонение
+ * некорректной команды стоит столько же, сколько ее проверка.
+ * Бросающие методы (setBrightness(), setMode(), конструкторы) остаются
+ * обертками над той же проверкой с прежними текстами исключений.
+ */
+
+#ifndef DEVICE_ERROR_HPP
+#define DEVICE_ERROR_HPP
+
+#include <cstdint>
+#include <utility>
+
+/**
+ * @brief Результат проверки параметров устройства
+ */
+enum class DeviceError : std::uint8_t {
+    NONE = 0,                   ///< Параметры допустимы
+    INVALID_POWER,              ///< Мощность не положительна
+    INVALID_BRIGHTNESS,         ///< Яркость вне диапазона 0-100
+    INVALID_MODE,               ///< Режим не "display" и не "monitoring"
+    PALETTE_FULL                ///< Нового цвета нет в заполненной ColorPalette
+};
+
+/**
+ * @brief Текст ошибки (совпадает с текстом std::invalid_argument)
+ */
+inline const char* deviceErrorMessage(DeviceError error) {
+    switch (error) {
+        case DeviceError::NONE: return "";
+        case DeviceError::INVALID_POWER: return "Moschnost' dolznha byt' polozhitel'noy";
+        case DeviceError::INVALID_BRIGHTNESS: return "Yarkost' dolznha bit 0-100";
+        case DeviceError::INVALID_MODE: return "Rezhim dolzhen byt' ili monitoring ili display";
+        case DeviceError::PALETTE_FULL: return "Palitra tsvetov zapolnena";
+    }
+    return "";
+}
+
+/**
+ * @class DeviceExpected
+ * @brief Значение либо код ошибки (по образцу std::expected)
+ * @tparam T Тип значения; должен иметь конструктор по умолчанию
+ */
+template <class T>
+class DeviceExpected {
+private:
+    T stored;                   ///< Значение (по умолчанию при ошибке)
+    DeviceError failure;        ///< Код ошибки или NONE
+
+public:
+    DeviceExpected(T value) : stored(std::move(value)), failure(DeviceError::NONE) {}
+    DeviceExpected(DeviceError error) : stored(), failure(error) {}
+
+    bool hasValue() const { return failure == DeviceError::NONE; }
+    explicit operator bool() const { return hasValue(); }
+
+    DeviceError error() const { return failure; }
+
+    T& value() { return stored; }
+    const T& value() const { return stored; }
+
+    T& operator*() { return stored; }
+    const T& operator*() const { return stored; }
+
+    T& operator->() { return stored; }
+    const T& operator->() const { return stored; }
+};
+
+#endif // DEVICE_ERROR_HPP
@@ -0,0 +1,1185 @@
+/**
+ * @file device_io.hpp
+ * @brief Асинхронные команды устройствам: сопрограммы C++20 и цикл событий
+ *
+ * @details
+ * Команда физическому устройству - это обмен с оборудованием по сети.
+ * DeviceLink отправляет команду через DeviceTransport и возвращает
+ * ожидаемый объект: сопрограмма приостанавливается на co_await до
+ * подтверждения (ack), отказа устройства или истечения тайм-аута. Один
+ * поток DeviceEventLoop ведет тысячи таких команд одновременно.
+ *
+ * Состояние в DeviceRegistry меняется только по подтверждению: команды,
+ * подтвержденные за один оборот цикла, применяются одним CommandBatch
+ * (один снимок времени, группировка по типу), затем сопрограммы
+ * возобновляются с CommandResult. Отказ и тайм-аут состояние не меняют и
+ * возвращают CommandResult::DEVICE_REJECTED и DEVICE_TIMEOUT.
+ *
+ * Цикл событий:
+ * - Linux - epoll: дескрипторы транспортов (watch()), eventfd для post()
+ *   из других потоков, тайм-аут epoll_wait по ближайшему таймеру
+ * - другие платформы - ожидание condition_variable до ближайшего таймера;
+ *   watch() и StreamTransport недоступны
+ *
+ * @code
+ * DeviceTask<void> session(DeviceLink& link, LightBulb& lamp) {
+ *     if (co_await link.turnOn(lamp) == CommandResult::APPLIED) {
+ *         co_await link.setBrightness(lamp, 40);
+ *     }
+ * }
+ *
+ * DeviceEventLoop loop;
+ * SimulatedTransport transport(loop, std::chrono::milliseconds(20));
+ * DeviceLink link(loop, transport);
+ * loop.run(session(link, lamp));
+ * @endcode
+ *
+ * @note Сопрограммы, таймеры и транспорты обслуживает один поток - тот,
+ *       что вызывает run(); из других потоков допустим только post().
+ * @note Команды одного устройства, подтвержденные в одном обороте цикла,
+ *       применяются в порядке фаз CommandType, как в CommandBatch.
+ * @note Транспорт должен жить, пока в цикле есть его команды и таймеры.
+ */
+
+#ifndef DEVICE_IO_HPP
+#define DEVICE_IO_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <unordered_map>
+#else
+#include <condition_variable>
+#endif
+
+#include "command_batch.hpp"
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+#include "smart_devices.hpp"
+
+class DeviceEventLoop;
+
+/**
+ * @brief Ответ устройства на команду
+ */
+enum class DeviceAck : std::uint8_t {
+    OK = 0,                     ///< Команда выполнена, состояние можно фиксировать
+    REJECTED = 1                ///< Устройство отказалось выполнять команду
+};
+
+/**
+ * @struct DeviceRequest
+ * @brief Команда, переданная транспорту
+ */
+struct DeviceRequest {
+    std::uint64_t token;        ///< Номер команды для DeviceEventLoop::acknowledge()
+    DeviceCommand command;      ///< Команда (формат CommandBatch)
+};
+
+/**
+ * @class DeviceTransport
+ * @brief Канал связи с оборудованием
+ */
+class DeviceTransport {
+public:
+    virtual ~DeviceTransport() = default;
+
+    /**
+     * @brief Отправить команду без ожидания ответа
+     * @param request Команда и ее номер
+     * @details Ответ передается вызовом DeviceEventLoop::acknowledge(request.token, ...)
+     *          в потоке цикла; без ответа команда завершается по тайм-ауту
+     * @pure
+     */
+    virtual void send(const DeviceRequest& request) = 0;
+};
+
+/**
+ * @class DeviceTaskPromiseBase
+ * @brief Общая часть обещания DeviceTask: продолжение, исключение, владелец кадра
+ */
+class DeviceTaskPromiseBase {
+public:
+    std::coroutine_handle<> continuation;       ///< Сопрограмма, ожидающая результат
+    DeviceEventLoop* detached = nullptr;         ///< Цикл, владеющий кадром после spawn()
+    std::exception_ptr error;                    ///< Исключение тела сопрограммы
+
+    /**
+     * @brief Завершение: передать управление ожидающему или вернуть кадр циклу
+     */
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept;
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+/**
+ * @class DeviceTaskPromise
+ * @brief Обещание с результатом типа T
+ */
+template <class T>
+class DeviceTaskPromise : public DeviceTaskPromiseBase {
+public:
+    std::optional<T> value;     ///< Результат co_return
+
+    template <class U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+class DeviceTaskPromise<void> : public DeviceTaskPromiseBase {
+public:
+    void return_void() {}
+
+    void take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+/**
+ * @class DeviceTask
+ * @brief Ленивая сопрограмма: начинает выполняться при co_await или в DeviceEventLoop
+ * @tparam T Тип результата co_return (void - без результата)
+ */
+template <class T>
+class DeviceTask {
+public:
+    struct promise_type : DeviceTaskPromise<T> {
+        DeviceTask get_return_object() {
+            return DeviceTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> coroutine;  ///< Кадр сопрограммы (владеет)
+
+    explicit DeviceTask(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine) {}
+
+    friend class DeviceEventLoop;
+
+public:
+    DeviceTask(DeviceTask&& other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+
+    DeviceTask& operator=(DeviceTask&& other) noexcept {
+        if (this != &other) {
+            if (coroutine) {
+                coroutine.destroy();
+            }
+            coroutine = std::exchange(other.coroutine, nullptr);
+        }
+        return *this;
+    }
+
+    DeviceTask(const DeviceTask&) = delete;
+    DeviceTask& operator=(const DeviceTask&) = delete;
+
+    ~DeviceTask() {
+        if (coroutine) {
+            coroutine.destroy();
+        }
+    }
+
+    /**
+     * @brief Завершилась ли сопрограмма
+     */
+    bool done() const { return !coroutine || coroutine.done(); }
+
+    bool await_ready() const noexcept { return done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiter) noexcept {
+        coroutine.promise().continuation = waiter;
+        return coroutine;
+    }
+
+    T await_resume() { return coroutine.promise().take(); }
+};
+
+/**
+ * @struct DeviceIoStats
+ * @brief Счетчики команд DeviceEventLoop
+ */
+struct DeviceIoStats {
+    std::uint64_t sent = 0;             ///< Отправлено транспортам
+    std::uint64_t acknowledged = 0;     ///< Подтверждено и применено
+    std::uint64_t rejected = 0;         ///< Отклонено устройствами
+    std::uint64_t timedOut = 0;         ///< Завершено по тайм-ауту
+    std::uint64_t lateAcks = 0;         ///< Ответы на уже завершенные команды
+};
+
+/**
+ * @class DeviceEventLoop
+ * @brief Однопоточный цикл событий: сопрограммы, таймеры, ввод-вывод, подтверждения команд
+ */
+class DeviceEventLoop {
+public:
+    /**
+     * @brief Обработчик таймера или события дескриптора
+     * @param context Указатель, переданный при регистрации
+     * @param argument Аргумент таймера или маска событий epoll
+     */
+    typedef void (*Callback)(void* context, std::uint64_t argument);
+
+private:
+    /**
+     * @brief Отложенный вызов; порядок - по сроку, затем по постановке
+     */
+    struct Timer {
+        DeviceTime deadline;        ///< Срок (нс, steady_clock)
+        std::uint64_t sequence;     ///< Номер постановки
+        Callback callback;
+        void* context;
+        std::uint64_t argument;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    enum class SlotState : std::uint8_t {
+        FREE = 0,                   ///< Ячейка свободна
+        WAITING = 1,                ///< Команда отправлена, ответа нет
+        ACKED = 2                   ///< Подтверждена, ждет применения в конце оборота
+    };
+
+    /**
+     * @brief Команда в полете
+     */
+    struct Slot {
+        std::coroutine_handle<> waiter;     ///< Ожидающая сопрограмма
+        CommandResult* result;              ///< Куда записать результат
+        DeviceCommand command;              ///< Команда для применения по подтверждению
+        std::uint32_t generation;           ///< Поколение ячейки (старшая половина номера)
+        SlotState state;
+        DeviceTime deadline;                ///< Срок ответа (нс, steady_clock)
+        std::uint64_t sequence;             ///< Номер постановки срока (общий с Timer)
+        std::uint32_t expiryPosition;       ///< Место в куче expiries (NO_EXPIRY - нет)
+    };
+
+    static constexpr std::uint32_t NO_EXPIRY = 0xFFFFFFFFu;
+
+    std::vector<Slot> slots;                        ///< Команды в полете по номеру ячейки
+    std::vector<std::uint32_t> freeSlots;           ///< Свободные ячейки
+    std::size_t commandsInFlight;                   ///< Занятые ячейки
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::uint64_t timerSequence;                    ///< Счетчик постановки таймеров
+    std::vector<std::uint32_t> expiries;            ///< Куча ячеек WAITING по сроку ответа
+
+    std::vector<std::coroutine_handle<>> ready;     ///< Сопрограммы к возобновлению
+    std::vector<std::coroutine_handle<>> resuming;  ///< Возобновляемые в текущем обороте
+    std::vector<std::coroutine_handle<>> finished;  ///< Завершенные кадры spawn()
+    std::unordered_set<void*> roots;                ///< Незавершенные кадры spawn()
+    std::exception_ptr rootError;                   ///< Исключение задачи spawn()
+
+    CommandBatch commits;                           ///< Подтвержденные в обороте команды
+    std::vector<std::uint32_t> committing;          ///< Их ячейки в порядке commits
+
+    std::mutex postLock;                            ///< Защищает posted
+    std::vector<std::function<void()>> posted;      ///< Вызовы из других потоков
+    std::vector<std::function<void()>> running;     ///< Выполняемые в текущем обороте
+    bool stopping;                                  ///< Запрошен stop()
+    DeviceIoStats stats;
+
+#if defined(__linux__)
+    /**
+     * @brief Обработчик событий дескриптора
+     */
+    struct Watch {
+        Callback callback;
+        void* context;
+    };
+
+    int epollFd;                                    ///< Дескриптор epoll
+    int wakeFd;                                     ///< eventfd для post()
+    std::unordered_map<int, Watch> watches;         ///< Обработчики по дескриптору
+#else
+    std::condition_variable postSignal;             ///< Сигнал post()
+#endif
+
+    friend struct DeviceTaskPromiseBase::FinalAwaiter;
+    friend class DeviceCommandAwaiter;
+
+    /**
+     * @brief Последний шаг задачи spawn(): кадр уничтожается в конце оборота
+     */
+    void finish(std::coroutine_handle<> root, std::exception_ptr error) {
+        roots.erase(root.address());
+        finished.push_back(root);
+        if (error && !rootError) {
+            rootError = error;
+        }
+    }
+
+    static void resumeLater(void* context, std::uint64_t address) {
+        static_cast<DeviceEventLoop*>(context)->ready.push_back(
+            std::coroutine_handle<>::from_address(reinterpret_cast<void*>(address)));
+    }
+
+    /**
+     * @name Сроки ответа команд в полете
+     * @details Двоичная куча номеров ячеек с местом в куче внутри ячейки:
+     *          ответ или отказ снимает срок сразу, и в куче не копятся
+     *          таймеры завершенных команд
+     * @{
+     */
+    bool expiresBefore(std::uint32_t a, std::uint32_t b) const {
+        const Slot& first = slots[a];
+        const Slot& second = slots[b];
+        return first.deadline != second.deadline ? first.deadline < second.deadline
+                                                 : first.sequence < second.sequence;
+    }
+
+    void placeExpiry(std::size_t position, std::uint32_t index) {
+        expiries[position] = index;
+        slots[index].expiryPosition = static_cast<std::uint32_t>(position);
+    }
+
+    void siftExpiry(std::size_t position) {
+        std::uint32_t index = expiries[position];
+        while (position > 0 && expiresBefore(index, expiries[(position - 1) / 2])) {
+            placeExpiry(position, expiries[(position - 1) / 2]);
+            position = (position - 1) / 2;
+        }
+        for (;;) {
+            std::size_t child = 2 * position + 1;
+            if (child >= expiries.size()) {
+                break;
+            }
+            if (child + 1 < expiries.size() && expiresBefore(expiries[child + 1], expiries[child])) {
+                child++;
+            }
+            if (!expiresBefore(expiries[child], index)) {
+                break;
+            }
+            placeExpiry(position, expiries[child]);
+            position = child;
+        }
+        placeExpiry(position, index);
+    }
+
+    void addExpiry(std::uint32_t index) {
+        expiries.push_back(index);
+        siftExpiry(expiries.size() - 1);
+    }
+
+    void removeExpiry(std::uint32_t index) {
+        std::uint32_t position = slots[index].expiryPosition;
+        if (position == NO_EXPIRY) {
+            return;
+        }
+        slots[index].expiryPosition = NO_EXPIRY;
+        std::uint32_t last = expiries.back();
+        expiries.pop_back();
+        if (last != index) {
+            placeExpiry(position, last);
+            siftExpiry(position);
+        }
+    }
+    /** @} */
+
+    void expire(std::uint32_t index) {
+        Slot& slot = slots[index];
+        *slot.result = CommandResult::DEVICE_TIMEOUT;
+        ready.push_back(slot.waiter);
+        release(index);
+        stats.timedOut++;
+    }
+
+    /**
+     * @brief Занять ячейку под отправляемую команду
+     * @return Номер команды: поколение в старших 32 битах, ячейка в младших
+     */
+    std::uint64_t beginCommand(std::coroutine_handle<> waiter, CommandResult* result,
+                               const DeviceCommand& command, std::chrono::nanoseconds timeout) {
+        std::uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = static_cast<std::uint32_t>(slots.size());
+            slots.push_back(Slot{nullptr, nullptr, DeviceCommand{}, 0, SlotState::FREE, 0, 0, NO_EXPIRY});
+        }
+        Slot& slot = slots[index];
+        slot.waiter = waiter;
+        slot.result = result;
+        slot.command = command;
+        slot.state = SlotState::WAITING;
+        slot.deadline = now() + timeout.count();
+        slot.sequence = timerSequence++;
+        addExpiry(index);
+        commandsInFlight++;
+        stats.sent++;
+        return (static_cast<std::uint64_t>(slot.generation) << 32) | index;
+    }
+
+    Slot* lookup(std::uint64_t token) {
+        std::uint32_t index = static_cast<std::uint32_t>(token);
+        if (index >= slots.size()) {
+            return nullptr;
+        }
+        Slot& slot = slots[index];
+        if (slot.state == SlotState::FREE || slot.generation != static_cast<std::uint32_t>(token >> 32)) {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    void release(std::uint32_t index) {
+        removeExpiry(index);
+        Slot& slot = slots[index];
+        slot.state = SlotState::FREE;
+        slot.waiter = nullptr;
+        slot.generation++;
+        freeSlots.push_back(index);
+        commandsInFlight--;
+    }
+
+    /**
+     * @brief Снять команду, которую транспорт не смог отправить
+     */
+    void cancel(std::uint64_t token) {
+        if (lookup(token)) {
+            release(static_cast<std::uint32_t>(token));
+        }
+    }
+
+    void runPosted() {
+        {
+            std::lock_guard<std::mutex> guard(postLock);
+            running.swap(posted);
+        }
+        for (std::function<void()>& function : running) {
+            function();
+        }
+        running.clear();
+    }
+
+    /**
+     * @brief Ждать событий не дольше timeout (нс, отрицательное - без ограничения)
+     */
+    void waitEvents(DeviceTime timeout) {
+#if defined(__linux__)
+        int milliseconds = -1;
+        if (timeout >= 0) {
+            DeviceTime rounded = (timeout + 999999) / 1000000;
+            milliseconds = rounded > INT_MAX ? INT_MAX : static_cast<int>(rounded);
+        }
+        epoll_event events[64];
+        int count = epoll_wait(epollFd, events, 64, milliseconds);
+        if (count < 0) {
+            if (errno == EINTR) {
+                return;
+            }
+            throw std::runtime_error("Tsikl sobytiy: oshibka epoll_wait");
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                std::uint64_t value;
+                while (::read(wakeFd, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+            // Обработчик мог снять дескриптор, пока разбирались предыдущие события
+            auto found = watches.find(fd);
+            if (found != watches.end()) {
+                found->second.callback(found->second.context, events[i].events);
+            }
+        }
+#else
+        std::unique_lock<std::mutex> guard(postLock);
+        if (timeout < 0) {
+            postSignal.wait(guard, [this] { return !posted.empty(); });
+        } else {
+            postSignal.wait_for(guard, std::chrono::nanoseconds(timeout), [this] { return !posted.empty(); });
+        }
+#endif
+    }
+
+    /**
+     * @brief Ближайший срок среди таймеров и ответов команд (-1 - нет)
+     */
+    DeviceTime nextDeadline() const {
+        DeviceTime next = timers.empty() ? -1 : timers.top().deadline;
+        if (!expiries.empty() && (next < 0 || slots[expiries.front()].deadline < next)) {
+            next = slots[expiries.front()].deadline;
+        }
+        return next;
+    }
+
+    /**
+     * @brief Истекшие таймеры и сроки ответа - по сроку, затем по постановке
+     */
+    void fireTimers() {
+        DeviceTime current = now();
+        for (;;) {
+            bool timerDue = !timers.empty() && timers.top().deadline <= current;
+            bool expiryDue = !expiries.empty() && slots[expiries.front()].deadline <= current;
+            if (expiryDue && timerDue) {
+                const Slot& slot = slots[expiries.front()];
+                const Timer& timer = timers.top();
+                expiryDue = slot.deadline != timer.deadline ? slot.deadline < timer.deadline
+                                                            : slot.sequence < timer.sequence;
+            }
+            if (expiryDue) {
+                expire(expiries.front());
+            } else if (timerDue) {
+                Timer timer = timers.top();
+                timers.pop();
+                timer.callback(timer.context, timer.argument);
+            } else {
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Применить подтвержденные в обороте команды одним пакетом
+     */
+    void commitAcknowledged() {
+        if (committing.empty()) {
+            return;
+        }
+        const std::vector<CommandResult>& results = commits.apply();
+        for (std::size_t i = 0; i < committing.size(); i++) {
+            Slot& slot = slots[committing[i]];
+            *slot.result = results[i];
+            ready.push_back(slot.waiter);
+            release(committing[i]);
+        }
+        commits.clear();
+        committing.clear();
+    }
+
+    void resumeReady() {
+        resuming.swap(ready);
+        for (std::coroutine_handle<> coroutine : resuming) {
+            if (coroutine) {
+                coroutine.resume();
+            }
+        }
+        resuming.clear();
+        for (std::coroutine_handle<> root : finished) {
+            root.destroy();
+        }
+        finished.clear();
+        if (rootError) {
+            std::exception_ptr error = std::exchange(rootError, nullptr);
+            std::rethrow_exception(error);
+        }
+    }
+
+public:
+    /**
+     * @brief Создать цикл событий
+     * @throws std::runtime_error если не удалось создать epoll или eventfd (Linux)
+     */
+    DeviceEventLoop() : commandsInFlight(0), timerSequence(0), stopping(false) {
+#if defined(__linux__)
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            if (epollFd >= 0) ::close(epollFd);
+            if (wakeFd >= 0) ::close(wakeFd);
+            throw std::runtime_error("Tsikl sobytiy: ne udalos' sozdat' epoll/eventfd");
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+#endif
+    }
+
+    DeviceEventLoop(const DeviceEventLoop&) = delete;
+    DeviceEventLoop& operator=(const DeviceEventLoop&) = delete;
+
+    /**
+     * @brief Уничтожить незавершенные задачи spawn() и закрыть epoll
+     */
+    ~DeviceEventLoop() {
+        for (void* root : roots) {
+            std::coroutine_handle<>::from_address(root).destroy();
+        }
+#if defined(__linux__)
+        ::close(wakeFd);
+        ::close(epollFd);
+#endif
+    }
+
+    /**
+     * @brief Время цикла для таймеров (нс, steady_clock; не зависит от DeviceClock)
+     */
+    static DeviceTime now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Вызвать callback(context, argument) в потоке цикла не раньше deadline
+     */
+    void callAt(DeviceTime deadline, Callback callback, void* context, std::uint64_t argument = 0) {
+        timers.push(Timer{deadline, timerSequence++, callback, context, argument});
+    }
+
+    void callAfter(std::chrono::nanoseconds delay, Callback callback, void* context,
+                   std::uint64_t argument = 0) {
+        callAt(now() + delay.count(), callback, context, argument);
+    }
+
+    /**
+     * @brief Ожидаемый объект паузы: co_await loop.sleepFor(...) не блокирует поток
+     */
+    class SleepAwaiter {
+    private:
+        DeviceEventLoop& loop;
+        std::chrono::nanoseconds delay;
+
+    public:
+        SleepAwaiter(DeviceEventLoop& loop, std::chrono::nanoseconds delay) : loop(loop), delay(delay) {}
+
+        bool await_ready() const noexcept { return delay.count() <= 0; }
+
+        void await_suspend(std::coroutine_handle<> waiter) {
+            loop.callAfter(delay, &DeviceEventLoop::resumeLater, &loop,
+                           reinterpret_cast<std::uint64_t>(waiter.address()));
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    SleepAwaiter sleepFor(std::chrono::nanoseconds delay) { return SleepAwaiter(*this, delay); }
+
+    /**
+     * @brief Передать ответ устройства на команду
+     * @param token Номер из DeviceRequest
+     * @param ack Ответ
+     * @details Подтвержденная команда применяется в конце оборота цикла;
+     *          ответ на уже завершенную (тайм-аут) команду только считается
+     */
+    void acknowledge(std::uint64_t token, DeviceAck ack) {
+        Slot* slot = lookup(token);
+        if (!slot || slot->state != SlotState::WAITING) {
+            stats.lateAcks++;
+            return;
+        }
+        std::uint32_t index = static_cast<std::uint32_t>(token);
+        if (ack == DeviceAck::OK) {
+            slot->state = SlotState::ACKED;
+            removeExpiry(index);
+            commits.add(slot->command);
+            committing.push_back(index);
+            stats.acknowledged++;
+        } else {
+            *slot->result = CommandResult::DEVICE_REJECTED;
+            ready.push_back(slot->waiter);
+            release(index);
+            stats.rejected++;
+        }
+    }
+
+    /**
+     * @brief Выполнить function в потоке цикла (можно вызывать из любого потока)
+     */
+    void post(std::function<void()> function) {
+        {
+            std::lock_guard<std::mutex> guard(postLock);
+            posted.push_back(std::move(function));
+        }
+#if defined(__linux__)
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(wakeFd, &one, sizeof(one));
+#else
+        postSignal.notify_one();
+#endif
+    }
+
+    /**
+     * @brief Запустить задачу без ожидания результата
+     * @details Кадр принадлежит циклу; исключение задачи выбрасывается из run()/runOnce()
+     */
+    void spawn(DeviceTask<void> task) {
+        std::coroutine_handle<DeviceTask<void>::promise_type> root = std::exchange(task.coroutine, nullptr);
+        root.promise().detached = this;
+        roots.insert(root.address());
+        ready.push_back(root);
+    }
+
+    /**
+     * @brief Один оборот цикла
+     * @param wait Ждать событий, если сопрограммам нечего делать
+     * @details Вызовы post(), события дескрипторов, истекшие таймеры,
+     *          применение подтвержденных команд, возобновление сопрограмм
+     */
+    void runOnce(bool wait = true) {
+        runPosted();
+        DeviceTime timeout = -1;
+        if (!wait || !ready.empty() || !committing.empty()) {
+            timeout = 0;
+        } else if (DeviceTime next = nextDeadline(); next >= 0) {
+            timeout = next - now();
+            timeout = timeout < 0 ? 0 : timeout;
+        }
+        waitEvents(timeout);
+        runPosted();
+        fireTimers();
+        commitAcknowledged();
+        resumeReady();
+    }
+
+    /**
+     * @brief Выполнять цикл, пока есть задачи spawn() или команды в полете, или до stop()
+     */
+    void run() {
+        while (!stopping && (!roots.empty() || commandsInFlight > 0 || !ready.empty())) {
+            runOnce();
+        }
+        stopping = false;
+    }
+
+    /**
+     * @brief Выполнять цикл до завершения задачи
+     * @return Результат задачи
+     * @details Задачи spawn() и другие команды обслуживаются попутно
+     */
+    template <class T>
+    T run(DeviceTask<T> task) {
+        ready.push_back(task.coroutine);
+        while (!task.done()) {
+            runOnce();
+        }
+        return task.coroutine.promise().take();
+    }
+
+    /**
+     * @brief Завершить run() после текущего оборота (только из потока цикла)
+     */
+    void stop() { stopping = true; }
+
+    /**
+     * @brief Количество команд, ожидающих ответа
+     */
+    std::size_t inFlight() const { return commandsInFlight; }
+
+    /**
+     * @brief Количество ожидающих таймеров и сроков ответа
+     */
+    std::size_t pendingTimers() const { return timers.size() + expiries.size(); }
+
+    const DeviceIoStats& getStats() const { return stats; }
+
+#if defined(__linux__)
+    /**
+     * @brief Следить за дескриптором
+     * @param fd Неблокирующий дескриптор
+     * @param events Маска событий epoll (EPOLLIN, EPOLLOUT)
+     * @param callback Вызывается в потоке цикла с маской наступивших событий
+     * @throws std::runtime_error если epoll_ctl не принял дескриптор
+     */
+    void watch(int fd, std::uint32_t events, Callback callback, void* context) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw std::runtime_error("Tsikl sobytiy: epoll_ctl ne prinyal deskriptor");
+        }
+        watches[fd] = Watch{callback, context};
+    }
+
+    /**
+     * @brief Сменить маску событий дескриптора
+     */
+    void rewatch(int fd, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    /**
+     * @brief Перестать следить за дескриптором
+     */
+    void unwatch(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        watches.erase(fd);
+    }
+#endif
+};
+
+template <class Promise>
+std::coroutine_handle<> DeviceTaskPromiseBase::FinalAwaiter::await_suspend(
+    std::coroutine_handle<Promise> self) noexcept {
+    DeviceTaskPromiseBase& promise = self.promise();
+    if (promise.continuation) {
+        return promise.continuation;
+    }
+    if (promise.detached) {
+        promise.detached->finish(self, promise.error);
+    }
+    return std::noop_coroutine();
+}
+
+/**
+ * @class DeviceCommandAwaiter
+ * @brief Ожидаемый объект команды: co_await возвращает CommandResult после ответа устройства
+ */
+class DeviceCommandAwaiter {
+private:
+    DeviceEventLoop& loop;
+    DeviceTransport& transport;
+    DeviceCommand command;
+    std::chrono::nanoseconds timeout;
+    CommandResult result;
+
+    /**
+     * @brief Проверки CommandBatch, не требующие оборудования
+     * @return APPLIED если команду стоит отправлять
+     */
+    static CommandResult precheck(const DeviceCommand& command) {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        if (command.handle >= reg.capacity() || !reg.owner(command.handle)) {
+            return CommandResult::INVALID_DEVICE;
+        }
+        DeviceKind kind = reg.kind(command.handle);
+        switch (command.type) {
+            case CommandType::SET_BRIGHTNESS:
+                if (kind != DeviceKind::LIGHT_BULB) {
+                    return CommandResult::UNSUPPORTED;
+                }
+                return LightBulb::checkBrightness(command.argument) == DeviceError::NONE
+                           ? CommandResult::APPLIED : CommandResult::INVALID_ARGUMENT;
+            case CommandType::SET_MODE:
+                if (kind != DeviceKind::THERMOSTAT) {
+                    return CommandResult::UNSUPPORTED;
+                }
+                return command.argument == 0 || command.argument == 1
+                           ? CommandResult::APPLIED : CommandResult::INVALID_ARGUMENT;
+            case CommandType::TOGGLE_OUTLET:
+                return kind == DeviceKind::SMART_OUTLET ? CommandResult::APPLIED : CommandResult::UNSUPPORTED;
+            default:
+                return CommandResult::APPLIED;
+        }
+    }
+
+public:
+    DeviceCommandAwaiter(DeviceEventLoop& loop, DeviceTransport& transport,
+                         const DeviceCommand& command, std::chrono::nanoseconds timeout)
+        : loop(loop), transport(transport), command(command), timeout(timeout),
+          result(CommandResult::APPLIED) {}
+
+    /**
+     * @brief Некорректная команда завершается сразу, без отправки
+     */
+    bool await_ready() {
+        result = precheck(command);
+        return result != CommandResult::APPLIED;
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+        std::uint64_t token = loop.beginCommand(waiter, &result, command, timeout);
+        try {
+            transport.send(DeviceRequest{token, command});
+        } catch (...) {
+            loop.cancel(token);
+            throw;
+        }
+    }
+
+    CommandResult await_resume() const noexcept { return result; }
+};
+
+/**
+ * @class DeviceLink
+ * @brief Асинхронные команды устройствам через транспорт и цикл событий
+ */
+class DeviceLink {
+private:
+    DeviceEventLoop& eventLoop;
+    DeviceTransport& transport;
+    std::chrono::nanoseconds timeout;   ///< Ожидание ответа на команду
+
+public:
+    /**
+     * @brief Связать цикл событий и транспорт
+     * @param timeout Время ожидания ответа устройства
+     */
+    DeviceLink(DeviceEventLoop& loop, DeviceTransport& transport,
+               std::chrono::nanoseconds timeout = std::chrono::seconds(2))
+        : eventLoop(loop), transport(transport), timeout(timeout) {}
+
+    DeviceEventLoop& loop() const { return eventLoop; }
+
+    /**
+     * @brief Отправить команду
+     * @return Ожидаемый объект; состояние меняется только после подтверждения
+     */
+    DeviceCommandAwaiter send(const DeviceCommand& command) {
+        return DeviceCommandAwaiter(eventLoop, transport, command, timeout);
+    }
+
+    DeviceCommandAwaiter turnOn(const SmartDevice& device) {
+        return send(DeviceCommand{device.getHandle(), CommandType::TURN_ON, 0});
+    }
+
+    DeviceCommandAwaiter turnOff(const SmartDevice& device) {
+        return send(DeviceCommand{device.getHandle(), CommandType::TURN_OFF, 0});
+    }
+
+    DeviceCommandAwaiter toggleOutlet(const SmartDevice& device) {
+        return send(DeviceCommand{device.getHandle(), CommandType::TOGGLE_OUTLET, 0});
+    }
+
+    DeviceCommandAwaiter setBrightness(const SmartDevice& device, int level) {
+        return send(DeviceCommand{device.getHandle(), CommandType::SET_BRIGHTNESS, level});
+    }
+
+    DeviceCommandAwaiter setMode(const SmartDevice& device, ThermostatMode mode) {
+        return send(DeviceCommand{device.getHandle(), CommandType::SET_MODE,
+                                  mode == ThermostatMode::MONITORING ? 1 : 0});
+    }
+};
+
+/**
+ * @class SimulatedTransport
+ * @brief Транспорт без оборудования: ответ через заданную задержку на таймере цикла
+ */
+class SimulatedTransport : public DeviceTransport {
+private:
+    DeviceEventLoop& loop;
+    std::chrono::nanoseconds latency;   ///< Задержка ответа
+    std::uint32_t rejectEvery;          ///< Каждая N-я команда отклоняется (0 - никогда)
+    std::uint32_t dropEvery;            ///< На каждую N-ю команду нет ответа (0 - никогда)
+    std::uint64_t sent;                 ///< Отправлено команд
+
+    static void deliver(void* context, std::uint64_t token) {
+        static_cast<SimulatedTransport*>(context)->loop.acknowledge(token, DeviceAck::OK);
+    }
+
+    static void deliverRejected(void* context, std::uint64_t token) {
+        static_cast<SimulatedTransport*>(context)->loop.acknowledge(token, DeviceAck::REJECTED);
+    }
+
+public:
+    SimulatedTransport(DeviceEventLoop& loop, std::chrono::nanoseconds latency,
+                       std::uint32_t rejectEvery = 0, std::uint32_t dropEvery = 0)
+        : loop(loop), latency(latency), rejectEvery(rejectEvery), dropEvery(dropEvery), sent(0) {}
+
+    virtual void send(const DeviceRequest& request) override {
+        sent++;
+        if (dropEvery && sent % dropEvery == 0) {
+            return;
+        }
+        bool reject = rejectEvery && sent % rejectEvery == 0;
+        loop.callAfter(latency, reject ? &SimulatedTransport::deliverRejected : &SimulatedTransport::deliver,
+                       this, request.token);
+    }
+};
+
+/**
+ * @struct DeviceRequestFrame
+ * @brief Кадр команды в потоковом протоколе (24 байта, порядок байтов хоста)
+ */
+struct DeviceRequestFrame {
+    std::uint64_t token;        ///< Номер команды, возвращается в DeviceAckFrame
+    std::uint32_t handle;       ///< Дескриптор устройства
+    std::uint8_t type;          ///< CommandType
+    std::uint8_t reserved[3];
+    std::int32_t argument;      ///< Аргумент команды
+    std::uint32_t padding;
+};
+
+/**
+ * @struct DeviceAckFrame
+ * @brief Кадр ответа в потоковом протоколе (16 байт)
+ */
+struct DeviceAckFrame {
+    std::uint64_t token;        ///< Номер команды из DeviceRequestFrame
+    std::uint8_t status;        ///< DeviceAck
+    std::uint8_t reserved[7];
+};
+
+static_assert(sizeof(DeviceRequestFrame) == 24, "DeviceRequestFrame - 24 bayta");
+static_assert(sizeof(DeviceAckFrame) == 16, "DeviceAckFrame - 16 bayt");
+
+#if defined(__linux__)
+/**
+ * @class StreamTransport
+ * @brief Транспорт поверх потокового сокета шлюза устройств (Linux, epoll)
+ *
+ * @details
+ * Команды, отправленные за один оборот цикла, копятся в буфере и уходят
+ * одним write() в начале следующего оборота; при заполнении сокета
+ * запись продолжается по EPOLLOUT. Ответы читаются по EPOLLIN до EAGAIN.
+ * После закрытия соединения новые команды не отправляются и завершаются
+ * по тайм-ауту.
+ *
+ * @note Дескриптор переводится в неблокирующий режим и не закрывается транспортом.
+ */
+class StreamTransport : public DeviceTransport {
+private:
+    DeviceEventLoop& loop;
+    int fd;
+    std::vector<unsigned char> outbox;      ///< Кадры к отправке
+    std::size_t outboxSent;                 ///< Уже отправленная часть outbox
+    std::vector<unsigned char> inbox;       ///< Принятые байты
+    std::size_t inboxFill;                  ///< Заполненная часть inbox
+    bool flushScheduled;                    ///< Запись запланирована на следующий оборот
+    bool waitingWritable;                   ///< Ждем EPOLLOUT
+    bool open;                              ///< Соединение не закрыто
+
+    static void flushLater(void* context, std::uint64_t) {
+        StreamTransport* self = static_cast<StreamTransport*>(context);
+        self->flushScheduled = false;
+        self->flush();
+    }
+
+    static void onEvents(void* context, std::uint64_t events) {
+        StreamTransport* self = static_cast<StreamTransport*>(context);
+        if (events & EPOLLOUT) {
+            self->flush();
+        }
+        if (self->open && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+            self->receive();
+        }
+    }
+
+    void close() {
+        if (open) {
+            open = false;
+            loop.unwatch(fd);
+            outbox.clear();
+            outboxSent = 0;
+        }
+    }
+
+    void flush() {
+        while (open && outboxSent < outbox.size()) {
+            ssize_t written = ::write(fd, outbox.data() + outboxSent, outbox.size() - outboxSent);
+            if (written > 0) {
+                outboxSent += static_cast<std::size_t>(written);
+            } else if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (!waitingWritable) {
+                    waitingWritable = true;
+                    loop.rewatch(fd, EPOLLIN | EPOLLOUT);
+                }
+                return;
+            } else {
+                close();
+                return;
+            }
+        }
+        outbox.clear();
+        outboxSent = 0;
+        if (open && waitingWritable) {
+            waitingWritable = false;
+            loop.rewatch(fd, EPOLLIN);
+        }
+    }
+
+    void receive() {
+        while (open) {
+            ssize_t count = ::read(fd, inbox.data() + inboxFill, inbox.size() - inboxFill);
+            if (count > 0) {
+                inboxFill += static_cast<std::size_t>(count);
+                std::size_t offset = 0;
+                for (; offset + sizeof(DeviceAckFrame) <= inboxFill; offset += sizeof(DeviceAckFrame)) {
+                    DeviceAckFrame frame;
+                    std::memcpy(&frame, inbox.data() + offset, sizeof(frame));
+                    loop.acknowledge(frame.token, frame.status == static_cast<std::uint8_t>(DeviceAck::OK)
+                                                      ? DeviceAck::OK : DeviceAck::REJECTED);
+                }
+                std::memmove(inbox.data(), inbox.data() + offset, inboxFill - offset);
+                inboxFill -= offset;
+            } else if (count < 0 && errno == EINTR) {
+                continue;
+            } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            } else {
+                close();
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Подключить транспорт к соединению со шлюзом
+     * @param fd Подключенный потоковый сокет
+     * @throws std::runtime_error если дескриптор нельзя перевести в неблокирующий режим
+     */
+    StreamTransport(DeviceEventLoop& loop, int fd)
+        : loop(loop), fd(fd), outboxSent(0), inbox(1 << 16), inboxFill(0),
+          flushScheduled(false), waitingWritable(false), open(true) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+            throw std::runtime_error("StreamTransport: ne udalos' vklyuchit' O_NONBLOCK");
+        }
+        loop.watch(fd, EPOLLIN, &StreamTransport::onEvents, this);
+    }
+
+    StreamTransport(const StreamTransport&) = delete;
+    StreamTransport& operator=(const StreamTransport&) = delete;
+
+    virtual ~StreamTransport() override { close(); }
+
+    virtual void send(const DeviceRequest& request) override {
+        if (!open) {
+            return;
+        }
+        DeviceRequestFrame frame{};
+        frame.token = request.token;
+        frame.handle = request.command.handle;
+        frame.type = static_cast<std::uint8_t>(request.command.type);
+        frame.argument = request.command.argument;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&frame);
+        outbox.insert(outbox.end(), bytes, bytes + sizeof(frame));
+        if (!flushScheduled && !waitingWritable) {
+            flushScheduled = true;
+            loop.callAt(DeviceEventLoop::now(), &StreamTransport::flushLater, this);
+        }
+    }
+
+    /**
+     * @brief Открыто ли соединение
+     */
+    bool isOpen() const { return open; }
+};
+#endif
+
+#endif // DEVICE_IO_HPP
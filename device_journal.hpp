@@ -0,0 +1,146 @@
+/**
+ * @file device_journal.hpp
+ * @brief Формат записей журнала событий устройств и точка подключения журнала
+ *
+ * @details
+ * Каждое изменение состояния устройства (turnOn, turnOff, setBrightness,
+ * updateTemperature, toggleOutlet, setMode) может быть записано в журнал
+ * как запись фиксированного размера JournalRecord. Устройства передают
+ * записи через DeviceJournal::record(); пока журнал не подключен, это
+ * одна атомарная загрузка указателя без обращения к часам.
+ *
+ * Приемник записей реализует интерфейс JournalSink. Файловая реализация
+ * с отображением в память и восстановлением - MappedJournal
+ * (mapped_journal.hpp).
+ *
+ * @note Записи самодостаточны: поле flags хранит флаги DeviceState после
+ *       операции, а записи TURN_OFF и LOAD_CHANGE - длительность и мощность
+ *       закрытого отрезка работы, поэтому восстановление не зависит от часов
+ *       и нагрузки предыдущего запуска.
+ */
+
+#ifndef DEVICE_JOURNAL_HPP
+#define DEVICE_JOURNAL_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+
+/**
+ * @brief Код операции в записи журнала
+ */
+enum class JournalOp : std::uint16_t {
+    TURN_ON = 1,                ///< Включение (value не используется)
+    TURN_OFF = 2,               ///< Выключение (value - длительность сессии в нс)
+    SET_BRIGHTNESS = 3,         ///< Яркость лампочки (value - уровень 0-100)
+    UPDATE_TEMPERATURE = 4,     ///< Температура термостата (value - °C)
+    TOGGLE_OUTLET = 5,          ///< Переключение розетки (value - 1 вкл, 0 выкл)
+    SET_MODE = 6,               ///< Режим термостата (value - 1 monitoring, 0 display)
+    SET_TARGET_TEMPERATURE = 7, ///< Целевая температура термостата (value - °C)
+    LOAD_CHANGE = 8             ///< Смена нагрузки включенного устройства (value - длительность отрезка в нс)
+};
+
+/**
+ * @struct JournalRecord
+ * @brief Запись журнала фиксированного размера (32 байта)
+ */
+struct JournalRecord {
+    DeviceTime timestamp;       ///< Время операции по DeviceClock (нс)
+    double value;               ///< Значение операции (см. JournalOp)
+    DeviceHandle handle;        ///< Дескриптор устройства в DeviceRegistry
+    std::uint16_t opcode;       ///< Код операции (JournalOp)
+    std::uint16_t flags;        ///< Флаги DeviceState после операции
+    double power;               ///< Мощность закрытого отрезка (Вт) для TURN_OFF и LOAD_CHANGE
+};
+
+static_assert(sizeof(JournalRecord) == 32, "JournalRecord must stay 32 bytes");
+
+/**
+ * @class JournalSink
+ * @brief Интерфейс приемника записей журнала
+ */
+class JournalSink {
+public:
+    virtual ~JournalSink() = default;
+
+    /**
+     * @brief Принять запись
+     * @param record Запись журнала
+     * @note Может вызываться из разных потоков одновременно
+     * @pure
+     */
+    virtual void append(const JournalRecord& record) = 0;
+};
+
+/**
+ * @class DeviceJournal
+ * @brief Точка подключения журнала, используемая иерархией устройств
+ *
+ * @note Порядок записей соответствует порядку вызовов append(): при
+ *       одновременном переключении одного устройства из разных потоков
+ *       он может отличаться от порядка CAS-переходов.
+ */
+class DeviceJournal {
+private:
+    static std::atomic<JournalSink*>& slot() {
+        static std::atomic<JournalSink*> current(nullptr);
+        return current;
+    }
+
+public:
+    /**
+     * @brief Подключить журнал
+     * @param sink Приемник, который должен пережить все устройства
+     */
+    static void attach(JournalSink& sink) {
+        slot().store(&sink, std::memory_order_release);
+    }
+
+    /**
+     * @brief Отключить журнал
+     */
+    static void detach() {
+        slot().store(nullptr, std::memory_order_release);
+    }
+
+    /**
+     * @brief Подключен ли журнал
+     */
+    static bool attached() {
+        return slot().load(std::memory_order_relaxed) != nullptr;
+    }
+
+    /**
+     * @brief Записать операцию с известным временем
+     * @param handle Дескриптор устройства
+     * @param op Код операции
+     * @param word Слово состояния после операции
+     * @param value Значение операции
+     * @param time Время операции
+     * @param power Мощность закрытого отрезка (Вт)
+     */
+    static void record(DeviceHandle handle, JournalOp op, std::uint64_t word,
+                       double value, DeviceTime time, double power = 0.0) {
+        JournalSink* sink = slot().load(std::memory_order_acquire);
+        if (sink) {
+            sink->append(JournalRecord{time, value, handle, static_cast<std::uint16_t>(op),
+                                       static_cast<std::uint16_t>(word & DeviceState::FLAG_MASK), power});
+        }
+    }
+
+    /**
+     * @brief Записать операцию; время снимается только при подключенном журнале
+     */
+    static void record(DeviceHandle handle, JournalOp op, std::uint64_t word, double value) {
+        JournalSink* sink = slot().load(std::memory_order_acquire);
+        if (sink) {
+            sink->append(JournalRecord{DeviceClock::now(), value, handle,
+                                       static_cast<std::uint16_t>(op),
+                                       static_cast<std::uint16_t>(word & DeviceState::FLAG_MASK), 0.0});
+        }
+    }
+};
+
+#endif // DEVICE_JOURNAL_HPP
@@ -0,0 +1,347 @@
+/**
+ * @file device_metrics.hpp
+ * @brief Счетчики и гистограммы задержек горячих путей по классам устройств
+ *
+ * @details
+ * Слой инструментирования включается при сборке макросом
+ * SMART_DEVICES_METRICS (например, -DSMART_DEVICES_METRICS). Без него
+ * макросы DEVICE_METRICS_COUNT и DEVICE_METRICS_TIME раскрываются в
+ * пустоту, их аргументы не вычисляются, и горячие пути не меняются.
+ *
+ * При включенном слое каждый поток пишет в свой блок ThreadMetrics,
+ * выровненный по кэш-линии: у счетчика один писатель, поэтому
+ * приращение - это обычные load/store без атомарного RMW и без
+ * разделения кэш-линий между потоками. Гистограммы задержек имеют
+ * логарифмически-линейные корзины (как HDR Histogram): 4 корзины на
+ * каждую степень двойки наносекунд, относительная ошибка не более 25%.
+ *
+ * writePrometheus() сводит блоки всех потоков и выводит текст в
+ * формате Prometheus exposition для сбора по запросу.
+ *
+ * @note Блоки потоков не освобождаются до завершения процесса, чтобы
+ *       счетчики завершившихся потоков оставались в сводке.
+ */
+
+#ifndef DEVICE_METRICS_HPP
+#define DEVICE_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "device_registry.hpp"
+#include "status_writer.hpp"
+
+/**
+ * @brief Счетчик операций
+ */
+enum class DeviceCounter : std::uint8_t {
+    TURN_ON = 0,                ///< Успешное включение
+    TURN_OFF,                   ///< Успешное выключение
+    TURN_ON_REJECTED,           ///< Включение уже включенного устройства
+    TURN_OFF_REJECTED,          ///< Выключение уже выключенного устройства
+    OUTLET_TOGGLE,              ///< Переключение розетки
+    OUTLET_TOGGLE_REJECTED,     ///< Переключение розетки выключенного устройства
+    BRIGHTNESS_REJECTED,        ///< Недопустимая яркость
+    MODE_REJECTED,              ///< Недопустимый режим термостата
+    CREATE_REJECTED,            ///< Конструктор отклонил параметры
+    BATCH_COMMAND,              ///< Команда, примененная CommandBatch
+    BATCH_COMMAND_REJECTED,     ///< Команда CommandBatch с ошибкой
+    COUNT                       ///< Количество счетчиков
+};
+
+/**
+ * @brief Измеряемая задержка
+ */
+enum class DeviceLatency : std::uint8_t {
+    TURN_ON = 0,                ///< PoweredDevice::turnOn() и наследники
+    TURN_OFF,                   ///< PoweredDevice::turnOff() и наследники
+    BATCH_APPLY,                ///< CommandBatch::apply() целиком
+    COUNT                       ///< Количество гистограмм
+};
+
+/**
+ * @class DeviceMetrics
+ * @brief Сбор и экспорт метрик по потокам
+ */
+class DeviceMetrics {
+public:
+    static constexpr std::size_t KIND_COUNT = 4;                ///< Значений DeviceKind
+    static constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(DeviceCounter::COUNT);
+    static constexpr std::size_t LATENCY_COUNT = static_cast<std::size_t>(DeviceLatency::COUNT);
+    static constexpr std::size_t BUCKET_COUNT = 256;            ///< Корзин гистограммы
+
+#ifdef SMART_DEVICES_METRICS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+private:
+    /**
+     * @brief Метрики одного потока (единственный писатель)
+     */
+    struct alignas(64) ThreadMetrics {
+        std::atomic<std::uint64_t> counters[KIND_COUNT][COUNTER_COUNT];
+        std::atomic<std::uint64_t> buckets[KIND_COUNT][LATENCY_COUNT][BUCKET_COUNT];
+        std::atomic<std::uint64_t> sums[KIND_COUNT][LATENCY_COUNT];
+
+        ThreadMetrics() {
+            for (std::size_t k = 0; k < KIND_COUNT; k++) {
+                for (std::size_t c = 0; c < COUNTER_COUNT; c++) {
+                    counters[k][c].store(0, std::memory_order_relaxed);
+                }
+                for (std::size_t l = 0; l < LATENCY_COUNT; l++) {
+                    sums[k][l].store(0, std::memory_order_relaxed);
+                    for (std::size_t b = 0; b < BUCKET_COUNT; b++) {
+                        buckets[k][l][b].store(0, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+    };
+
+    static std::mutex& blocksLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::vector<ThreadMetrics*>& blocks() {
+        // Не разрушается при выходе: потоки могут писать до самого конца
+        static std::vector<ThreadMetrics*>* all = new std::vector<ThreadMetrics*>();
+        return *all;
+    }
+
+    static ThreadMetrics& local() {
+        thread_local ThreadMetrics* own = [] {
+            ThreadMetrics* created = new ThreadMetrics();
+            std::lock_guard<std::mutex> guard(blocksLock());
+            blocks().push_back(created);
+            return created;
+        }();
+        return *own;
+    }
+
+    static void bump(std::atomic<std::uint64_t>& cell, std::uint64_t delta) {
+        cell.store(cell.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static const char* kindName(std::size_t kind) {
+        static const char* const names[KIND_COUNT] = {"other", "light_bulb", "thermostat", "smart_outlet"};
+        return names[kind];
+    }
+
+    static const char* counterName(std::size_t counter) {
+        static const char* const names[COUNTER_COUNT] = {
+            "turn_on", "turn_off", "turn_on_rejected", "turn_off_rejected",
+            "outlet_toggle", "outlet_toggle_rejected", "brightness_rejected",
+            "mode_rejected", "create_rejected", "batch_command", "batch_command_rejected"
+        };
+        return names[counter];
+    }
+
+    static const char* latencyName(std::size_t latency) {
+        static const char* const names[LATENCY_COUNT] = {"turn_on", "turn_off", "batch_apply"};
+        return names[latency];
+    }
+
+public:
+    /**
+     * @brief Номер корзины для задержки
+     * @param nanos Задержка в наносекундах
+     */
+    static std::size_t bucketOf(std::uint64_t nanos) {
+        if (nanos < 4) {
+            return static_cast<std::size_t>(nanos);
+        }
+        int top = 63;
+        while (!(nanos >> top)) {
+            top--;
+        }
+        int shift = top - 2;
+        return static_cast<std::size_t>(shift + 1) * 4 + static_cast<std::size_t>((nanos >> shift) & 3);
+    }
+
+    /**
+     * @brief Верхняя граница корзины (включительно), нс
+     */
+    static std::uint64_t bucketUpperBound(std::size_t bucket) {
+        if (bucket < 4) {
+            return bucket;
+        }
+        std::size_t shift = bucket / 4 - 1;
+        std::uint64_t next = static_cast<std::uint64_t>(4 + bucket % 4 + 1);
+        if (shift == 61 && next == 8) {
+            return ~std::uint64_t(0);
+        }
+        return (next << shift) - 1;
+    }
+
+    /**
+     * @brief Увеличить счетчик
+     * @param kind Класс устройства
+     * @param counter Счетчик
+     * @param delta Приращение
+     */
+    static void count(DeviceKind kind, DeviceCounter counter, std::uint64_t delta = 1) {
+        bump(local().counters[static_cast<std::size_t>(kind)][static_cast<std::size_t>(counter)], delta);
+    }
+
+    /**
+     * @brief Записать задержку в гистограмму
+     * @param kind Класс устройства
+     * @param latency Гистограмма
+     * @param nanos Задержка в наносекундах
+     */
+    static void record(DeviceKind kind, DeviceLatency latency, std::uint64_t nanos) {
+        ThreadMetrics& own = local();
+        std::size_t k = static_cast<std::size_t>(kind);
+        std::size_t l = static_cast<std::size_t>(latency);
+        bump(own.buckets[k][l][bucketOf(nanos)], 1);
+        bump(own.sums[k][l], nanos);
+    }
+
+    /**
+     * @class ScopeTimer
+     * @brief Замер задержки области видимости по std::chrono::steady_clock
+     */
+    class ScopeTimer {
+    private:
+        DeviceKind kind;
+        DeviceLatency latency;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        ScopeTimer(DeviceKind kind, DeviceLatency latency)
+            : kind(kind), latency(latency), start(std::chrono::steady_clock::now()) {}
+
+        ~ScopeTimer() {
+            record(kind, latency, static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+        }
+
+        ScopeTimer(const ScopeTimer&) = delete;
+        ScopeTimer& operator=(const ScopeTimer&) = delete;
+    };
+
+    /**
+     * @brief Суммарное значение счетчика по всем потокам
+     */
+    static std::uint64_t total(DeviceKind kind, DeviceCounter counter) {
+        std::lock_guard<std::mutex> guard(blocksLock());
+        std::uint64_t sum = 0;
+        for (const ThreadMetrics* block : blocks()) {
+            sum += block->counters[static_cast<std::size_t>(kind)][static_cast<std::size_t>(counter)]
+                       .load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Вывести сводку всех потоков в формате Prometheus
+     * @param out Строка-приемник (дописывается)
+     * @details Выводятся только ненулевые счетчики и гистограммы
+     */
+    static void writePrometheus(std::string& out) {
+        std::lock_guard<std::mutex> guard(blocksLock());
+        const std::vector<ThreadMetrics*>& all = blocks();
+        StatusWriter writer(out);
+
+        writer.append("# TYPE smart_device_operations_total counter\n");
+        for (std::size_t k = 0; k < KIND_COUNT; k++) {
+            for (std::size_t c = 0; c < COUNTER_COUNT; c++) {
+                std::uint64_t sum = 0;
+                for (const ThreadMetrics* block : all) {
+                    sum += block->counters[k][c].load(std::memory_order_relaxed);
+                }
+                if (sum == 0) {
+                    continue;
+                }
+                writer.append("smart_device_operations_total{kind=\"");
+                writer.append(kindName(k));
+                writer.append("\",op=\"");
+                writer.append(counterName(c));
+                writer.append("\"} ");
+                writer.appendInt(static_cast<long long>(sum));
+                writer.append("\n");
+            }
+        }
+
+        writer.append("# TYPE smart_device_latency_ns histogram\n");
+        std::uint64_t merged[BUCKET_COUNT];
+        for (std::size_t k = 0; k < KIND_COUNT; k++) {
+            for (std::size_t l = 0; l < LATENCY_COUNT; l++) {
+                std::uint64_t count = 0;
+                std::uint64_t sum = 0;
+                for (std::size_t b = 0; b < BUCKET_COUNT; b++) {
+                    merged[b] = 0;
+                    for (const ThreadMetrics* block : all) {
+                        merged[b] += block->buckets[k][l][b].load(std::memory_order_relaxed);
+                    }
+                    count += merged[b];
+                }
+                if (count == 0) {
+                    continue;
+                }
+                for (const ThreadMetrics* block : all) {
+                    sum += block->sums[k][l].load(std::memory_order_relaxed);
+                }
+                std::uint64_t cumulative = 0;
+                for (std::size_t b = 0; b < BUCKET_COUNT && cumulative < count; b++) {
+                    if (merged[b] == 0) {
+                        continue;
+                    }
+                    cumulative += merged[b];
+                    writer.append("smart_device_latency_ns_bucket{kind=\"");
+                    writer.append(kindName(k));
+                    writer.append("\",op=\"");
+                    writer.append(latencyName(l));
+                    writer.append("\",le=\"");
+                    writer.appendInt(static_cast<long long>(bucketUpperBound(b)));
+                    writer.append("\"} ");
+                    writer.appendInt(static_cast<long long>(cumulative));
+                    writer.append("\n");
+                }
+                const char* labels[] = {"_bucket{kind=\"", "_sum{kind=\"", "_count{kind=\""};
+                std::uint64_t values[] = {count, sum, count};
+                for (std::size_t i = 0; i < 3; i++) {
+                    writer.append("smart_device_latency_ns");
+                    writer.append(labels[i]);
+                    writer.append(kindName(k));
+                    writer.append("\",op=\"");
+                    writer.append(latencyName(l));
+                    writer.append(i == 0 ? "\",le=\"+Inf\"} " : "\"} ");
+                    writer.appendInt(static_cast<long long>(values[i]));
+                    writer.append("\n");
+                }
+            }
+        }
+    }
+};
+
+#define DEVICE_METRICS_JOIN_IMPL(a, b) a##b
+#define DEVICE_METRICS_JOIN(a, b) DEVICE_METRICS_JOIN_IMPL(a, b)
+
+#ifdef SMART_DEVICES_METRICS
+/**
+ * @brief Увеличить счетчик DeviceCounter::counter для класса kind
+ */
+#define DEVICE_METRICS_COUNT(kind, counter) \
+    DeviceMetrics::count((kind), DeviceCounter::counter)
+
+/**
+ * @brief Замерить задержку до конца текущей области видимости
+ */
+#define DEVICE_METRICS_TIME(kind, latency) \
+    DeviceMetrics::ScopeTimer DEVICE_METRICS_JOIN(deviceMetricsTimer, __LINE__)((kind), DeviceLatency::latency)
+#else
+#define DEVICE_METRICS_COUNT(kind, counter) ((void)0)
+#define DEVICE_METRICS_TIME(kind, latency) ((void)0)
+#endif
+
+#endif // DEVICE_METRICS_HPP
@@ -0,0 +1,586 @@
+/**
+ * @file device_registry.hpp
+ * @brief Колоночное хранилище состояния умных устройств
+ *
+ * @details
+ * DeviceRegistry хранит "горячие" числовые поля всех устройств
+ * (слово состояния, powerConsumption, totalOnTime, учтенная энергия,
+ * brightness, temperature, targetTemperature, тип устройства) в виде
+ * структуры массивов (SoA). Каждое устройство получает плотный
+ * дескриптор DeviceHandle - индекс в колонках.
+ * Классы иерархии SmartDevice являются тонкими представлениями
+ * над этими колонками, поэтому агрегирующие проходы по парку
+ * устройств читают память линейно, без виртуальных вызовов.
+ *
+ * Для разрешения входящих команд по идентификатору реестр ведет индекс
+ * "интернированный ID -> дескриптор": findById() - это один поиск в
+ * StringPool и одно чтение плоского массива, без перебора устройств.
+ *
+ * Итоги по парку - текущая мощность потребляющих устройств (включенных,
+ * у розеток - еще и с питанием на реле), количество включенных и
+ * учтенная энергия - ведутся приращениями при каждом переходе слова
+ * состояния и смене мощности, поэтому currentPower() и devicesOn() -
+ * это одна атомарная загрузка, а не проход по колонкам.
+ *
+ * Флаги ON и OUTLET дополнительно ведутся битовыми картами по парку
+ * (бит на дескриптор): каждый переход флага инвертирует бит атомарным
+ * XOR, поэтому параллельные переходы коммутируют и карта совпадает со
+ * словами состояния. countOnBits() и countOutletsPowered() - popcount
+ * по 64 устройства за слово.
+ *
+ * Горячее состояние одного устройства - слово состояния, мощность,
+ * время работы и учтенная энергия (по 8 байт), номер цвета в
+ * ColorPalette (2 байта), яркость и тип (по 1 байту) и 2 бита карт,
+ * около 36 байт. Это больше цели в 32 байта (без колонки энергии было
+ * около 28): энергия устройства должна совпадать с суммой его отрезков
+ * по фактической мощности, а сузить мощность, время или энергию
+ * до 32 бит нельзя без потери точности учета. Агрегирующие ядра читают
+ * не больше трех колонок (около 24 байт на устройство). Температуры
+ * термостатов, владелец и номер ID читаются только по дескриптору.
+ *
+ * @note Освобожденные ячейки обнуляются и попадают в список свободных,
+ *       поэтому дескрипторы живых устройств стабильны, а "дырки"
+ *       не влияют на сумму мощности и число включенных устройств.
+ * @note Добавление и удаление устройств не потокобезопасно. Включение,
+ *       выключение и смена флагов выполняются атомарным CAS над словом
+ *       состояния (см. DeviceState) и могут идти из разных потоков.
+ */
+
+#ifndef DEVICE_REGISTRY_HPP
+#define DEVICE_REGISTRY_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "device_clock.hpp"
+#include "sharded_accumulator.hpp"
+#include "string_pool.hpp"
+
+class SmartDevice;
+
+/**
+ * @brief Плотный дескриптор устройства - индекс в колонках DeviceRegistry
+ */
+typedef std::uint32_t DeviceHandle;
+
+/**
+ * @brief Значение дескриптора, не указывающее ни на одно устройство
+ */
+const DeviceHandle INVALID_DEVICE_HANDLE = static_cast<DeviceHandle>(-1);
+
+/**
+ * @struct DeviceState
+ * @brief Раскладка упакованного 64-битного слова состояния устройства
+ *
+ * @details
+ * Младшие биты - флаги, старшие - время последнего включения
+ * в наносекундах DeviceClock (61 бит, около 73 лет от начала отсчета).
+ * Состояние и время начала сессии меняются одной CAS-операцией,
+ * поэтому параллельные turnOn()/turnOff() не теряют сессии.
+ */
+struct DeviceState {
+    static constexpr std::uint64_t ON = 1u << 0;          ///< Устройство включено
+    static constexpr std::uint64_t OUTLET = 1u << 1;      ///< Розетка подает питание
+    static constexpr std::uint64_t MONITORING = 1u << 2;  ///< Термостат в режиме мониторинга
+    static constexpr std::uint64_t FLAG_MASK = (1u << 3) - 1;  ///< Все флаговые биты
+    static constexpr int TIME_SHIFT = 3;                  ///< Сдвиг поля времени включения
+
+    /**
+     * @brief Время последнего включения из слова состояния
+     */
+    static DeviceTime onSince(std::uint64_t word) {
+        return static_cast<DeviceTime>(word >> TIME_SHIFT);
+    }
+
+    /**
+     * @brief Упаковать флаги и время включения в слово состояния
+     */
+    static std::uint64_t pack(std::uint64_t flags, DeviceTime since) {
+        return (flags & FLAG_MASK) | (static_cast<std::uint64_t>(since) << TIME_SHIFT);
+    }
+};
+
+/**
+ * @brief Конкретный тип устройства в ячейке реестра
+ * @details Позволяет обрабатывать однотипные устройства пакетно, без
+ *          виртуальных вызовов и dynamic_cast
+ */
+enum class DeviceKind : std::uint8_t {
+    NONE = 0,                   ///< Свободная ячейка или тип вне библиотеки
+    LIGHT_BULB = 1,             ///< LightBulb
+    THERMOSTAT = 2,             ///< Thermostat
+    SMART_OUTLET = 3            ///< SmartOutlet
+};
+
+/**
+ * @class DeviceRegistry
+ * @brief Реестр устройств со структурой массивов для горячих полей
+ *
+ * @details
+ * Все устройства процесса регистрируются в едином экземпляре
+ * DeviceRegistry::instance(). Колонки доступны только для чтения
+ * через методы *Column(), а поэлементный доступ по дескриптору
+ * используется представлениями (SmartDevice и наследниками).
+ */
+class DeviceRegistry {
+private:
+    std::vector<std::uint64_t> state;       ///< Упакованные флаги и время включения (DeviceState)
+    std::vector<double> powerConsumption;   ///< Номинальная мощность (Вт)
+    std::vector<DeviceTime> totalOnTime;    ///< Накопленное время работы (нс)
+    std::vector<double> energyUsed;         ///< Энергия закрытых отрезков работы (Вт*ч)
+    std::vector<std::uint8_t> brightness;   ///< Яркость лампочек (0-100%)
+    std::vector<std::uint16_t> colors;      ///< Номер цвета лампочек в ColorPalette
+    std::vector<double> temperature;        ///< Текущая температура (°C)
+    std::vector<double> targetTemperature;  ///< Целевая температура термостатов (°C)
+    std::vector<DeviceKind> kinds;          ///< Конкретный тип устройства
+    std::vector<SmartDevice*> owners;       ///< Владелец ячейки (nullptr = свободна)
+    std::vector<std::uint32_t> idNumbers;   ///< Номер интернированного ID устройства
+    std::vector<DeviceHandle> handlesById;  ///< Индекс: номер строки ID -> дескриптор
+    std::vector<DeviceHandle> freeHandles;  ///< Освобожденные ячейки для повторного использования
+    std::vector<std::uint64_t> onBits;      ///< Битовая карта флага ON (бит handle % 64 слова handle / 64)
+    std::vector<std::uint64_t> outletBits;  ///< Битовая карта флага OUTLET
+    std::size_t liveCount;                  ///< Количество зарегистрированных устройств
+
+    /**
+     * @brief Итоги по включенным устройствам на отдельной кэш-линии
+     * @details Мощность хранится в микроваттах целым числом: приращения
+     *          при включении и выключении взаимно уничтожаются точно
+     */
+    struct alignas(64) FleetLoad {
+        std::atomic<std::int64_t> microwatts{0};    ///< Суммарная мощность включенных (мкВт)
+        std::atomic<std::int64_t> devicesOn{0};     ///< Количество включенных устройств
+    };
+
+    FleetLoad load;                         ///< Текущая нагрузка парка
+    ShardedAccumulator energy;              ///< Учтенная энергия закрытых сессий (Вт*ч)
+
+    static std::int64_t toMicrowatts(double watts) {
+        return static_cast<std::int64_t>(watts * 1e6 + (watts < 0 ? -0.5 : 0.5));
+    }
+
+    static void flipBit(std::vector<std::uint64_t>& bits, DeviceHandle handle) {
+        std::atomic_ref<std::uint64_t>(bits[handle >> 6]).fetch_xor(std::uint64_t(1) << (handle & 63),
+                                                                  std::memory_order_relaxed);
+    }
+
+    static std::uint64_t loadBits(const std::vector<std::uint64_t>& bits, std::size_t word) {
+        return std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t&>(bits[word]))
+            .load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Учесть переход слова состояния previous -> next в итогах и картах
+     */
+    void applyTransition(DeviceHandle handle, std::uint64_t previous, std::uint64_t next) {
+        std::uint64_t changed = previous ^ next;
+        if (changed & DeviceState::ON) {
+            load.devicesOn.fetch_add((next & DeviceState::ON) ? 1 : -1, std::memory_order_relaxed);
+            flipBit(onBits, handle);
+        }
+        if (changed & DeviceState::OUTLET) {
+            flipBit(outletBits, handle);
+        }
+        bool was = drawsPower(previous, kinds[handle]);
+        bool is = drawsPower(next, kinds[handle]);
+        if (was != is) {
+            std::int64_t microwatts = toMicrowatts(powerConsumption[handle]);
+            load.microwatts.fetch_add(is ? microwatts : -microwatts, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    DeviceRegistry() : liveCount(0) {
+        // Индекс ID опирается на таблицу строк: она должна пережить реестр
+        StringPool::instance();
+    }
+
+    DeviceRegistry(const DeviceRegistry&) = delete;
+    DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+    /**
+     * @brief Получить общий реестр процесса
+     * @return Ссылка на единственный экземпляр реестра
+     */
+    static DeviceRegistry& instance() {
+        static DeviceRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Зарегистрировать устройство
+     * @param owner Объект-представление, владеющий ячейкой
+     * @return Дескриптор выделенной ячейки
+     * @post Все поля ячейки обнулены
+     */
+    DeviceHandle acquire(SmartDevice* owner) {
+        DeviceHandle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+            owners[handle] = owner;
+        } else {
+            handle = static_cast<DeviceHandle>(owners.size());
+            state.push_back(0);
+            powerConsumption.push_back(0.0);
+            totalOnTime.push_back(0);
+            energyUsed.push_back(0.0);
+            brightness.push_back(0);
+            colors.push_back(0);
+            temperature.push_back(0.0);
+            targetTemperature.push_back(0.0);
+            kinds.push_back(DeviceKind::NONE);
+            owners.push_back(owner);
+            idNumbers.push_back(InternedString::INVALID);
+            if ((handle & 63) == 0) {
+                onBits.push_back(0);
+                outletBits.push_back(0);
+            }
+        }
+        liveCount++;
+        return handle;
+    }
+
+    /**
+     * @brief Зарезервировать колонки под массовую регистрацию
+     * @param count Ожидаемое общее количество ячеек
+     */
+    void reserve(std::size_t count) {
+        state.reserve(count);
+        powerConsumption.reserve(count);
+        totalOnTime.reserve(count);
+        energyUsed.reserve(count);
+        brightness.reserve(count);
+        colors.reserve(count);
+        temperature.reserve(count);
+        targetTemperature.reserve(count);
+        kinds.reserve(count);
+        owners.reserve(count);
+        idNumbers.reserve(count);
+        onBits.reserve((count + 63) / 64);
+        outletBits.reserve((count + 63) / 64);
+    }
+
+    /**
+     * @brief Передать ячейку другому объекту-представлению
+     * @param handle Дескриптор ячейки
+     * @param owner Новый владелец (объект, в который переместили устройство)
+     */
+    void adopt(DeviceHandle handle, SmartDevice* owner) noexcept {
+        owners[handle] = owner;
+    }
+
+    /**
+     * @brief Освободить ячейку устройства
+     * @param handle Дескриптор освобождаемой ячейки
+     * @post Ячейка обнулена и может быть выдана повторно
+     */
+    void release(DeviceHandle handle) {
+        unbindId(handle);
+        applyTransition(handle, state[handle], 0);
+        state[handle] = 0;
+        powerConsumption[handle] = 0.0;
+        totalOnTime[handle] = 0;
+        energyUsed[handle] = 0.0;
+        brightness[handle] = 0;
+        colors[handle] = 0;
+        temperature[handle] = 0.0;
+        targetTemperature[handle] = 0.0;
+        kinds[handle] = DeviceKind::NONE;
+        owners[handle] = nullptr;
+        freeHandles.push_back(handle);
+        liveCount--;
+    }
+
+    /**
+     * @brief Связать устройство с его идентификатором в индексе
+     * @param handle Дескриптор устройства
+     * @param id Интернированный идентификатор
+     * @return false если ID уже связан с другим живым устройством: индекс
+     *         по-прежнему указывает на него, а это устройство не связано
+     */
+    bool bindId(DeviceHandle handle, InternedString id) {
+        unbindId(handle);
+        if (id.id() == InternedString::INVALID) {
+            return true;
+        }
+        if (handlesById.size() <= id.id()) {
+            handlesById.resize(id.id() + 1, INVALID_DEVICE_HANDLE);
+        }
+        if (handlesById[id.id()] != INVALID_DEVICE_HANDLE) {
+            return false;
+        }
+        handlesById[id.id()] = handle;
+        idNumbers[handle] = id.id();
+        return true;
+    }
+
+    /**
+     * @brief Убрать устройство из индекса идентификаторов
+     * @param handle Дескриптор устройства
+     * @note Запись индекса стирается, только если она указывает на handle
+     */
+    void unbindId(DeviceHandle handle) {
+        std::uint32_t number = idNumbers[handle];
+        if (number != InternedString::INVALID && handlesById[number] == handle) {
+            handlesById[number] = INVALID_DEVICE_HANDLE;
+        }
+        idNumbers[handle] = InternedString::INVALID;
+    }
+
+    /**
+     * @brief Найти дескриптор устройства по идентификатору
+     * @param id Идентификатор (например, из входящей команды)
+     * @return Дескриптор или INVALID_DEVICE_HANDLE
+     */
+    DeviceHandle findHandle(std::string_view id) const {
+        InternedString interned;
+        if (!StringPool::instance().find(id, interned) || interned.id() >= handlesById.size()) {
+            return INVALID_DEVICE_HANDLE;
+        }
+        return handlesById[interned.id()];
+    }
+
+    /**
+     * @brief Найти устройство по идентификатору
+     * @param id Идентификатор
+     * @return Указатель на устройство или nullptr
+     */
+    SmartDevice* findById(std::string_view id) const {
+        DeviceHandle handle = findHandle(id);
+        return handle == INVALID_DEVICE_HANDLE ? nullptr : owners[handle];
+    }
+
+    /**
+     * @brief Потребляет ли устройство мощность при слове состояния word
+     * @details Включено, а у розетки еще и подано питание на реле
+     *          (DeviceState::OUTLET) - как getCurrentPower()
+     */
+    static bool drawsPower(std::uint64_t word, DeviceKind kind) {
+        return (word & DeviceState::ON) &&
+               (kind != DeviceKind::SMART_OUTLET || (word & DeviceState::OUTLET));
+    }
+
+    /**
+     * @brief Учесть CAS-переход слова состояния
+     * @param handle Дескриптор устройства
+     * @param previous Слово до перехода
+     * @param next Слово после перехода
+     * @details Обновляет число включенных, битовые карты ON и OUTLET и
+     *          текущую нагрузку (с учетом реле розетки). Приращения
+     *          последовательных переходов складываются точно, поэтому
+     *          параллельные переходы из разных потоков коммутируют.
+     * @note Вызывается ровно один раз на переход (победителем CAS)
+     */
+    void noteTransition(DeviceHandle handle, std::uint64_t previous, std::uint64_t next) {
+        applyTransition(handle, previous, next);
+    }
+
+    /**
+     * @brief Установить мощность устройства
+     * @param handle Дескриптор устройства
+     * @param watts Новая мощность (Вт)
+     * @post Для потребляющего устройства текущая нагрузка изменена на разницу
+     */
+    void setPower(DeviceHandle handle, double watts) {
+        if (drawsPower(loadState(handle), kinds[handle])) {
+            load.microwatts.fetch_add(toMicrowatts(watts) - toMicrowatts(powerConsumption[handle]),
+                                      std::memory_order_relaxed);
+        }
+        powerConsumption[handle] = watts;
+    }
+
+    /**
+     * @brief Записать слово состояния целиком (восстановление, копирование)
+     * @param handle Дескриптор устройства
+     * @param word Новое слово состояния
+     * @post Итоги по нагрузке учитывают смену флагов ON и OUTLET
+     */
+    void restoreState(DeviceHandle handle, std::uint64_t word) {
+        std::uint64_t previous = stateRef(handle).exchange(word, std::memory_order_acq_rel);
+        applyTransition(handle, previous, word);
+    }
+
+    /**
+     * @brief Добавить энергию закрытой сессии к итогам парка
+     * @param wattHours Энергия в ватт-часах
+     * @note Энергия без устройства (восстановленная из снимка или извне);
+     *       закрытые отрезки работы учитывает bookSegment()
+     */
+    void bookEnergy(double wattHours) { energy.add(wattHours); }
+
+    /**
+     * @brief Учесть закрытый отрезок работы устройства
+     * @param handle Дескриптор устройства
+     * @param watts Мощность на отрезке (Вт)
+     * @param nanos Длина отрезка (нс)
+     * @return Энергия отрезка (Вт*ч)
+     * @post Отрезок добавлен к totalOnTime, энергии устройства и итогам парка
+     */
+    double bookSegment(DeviceHandle handle, double watts, DeviceTime nanos) {
+        double wattHours = (watts * static_cast<double>(nanos)) / static_cast<double>(NANOS_PER_HOUR);
+        std::atomic_ref<DeviceTime>(totalOnTime[handle]).fetch_add(nanos, std::memory_order_relaxed);
+        std::atomic_ref<double>(energyUsed[handle]).fetch_add(wattHours, std::memory_order_relaxed);
+        energy.add(wattHours);
+        return wattHours;
+    }
+
+    /**
+     * @brief Обнулить учтенную энергию парка и устройств
+     */
+    void resetEnergy() {
+        energy.reset();
+        for (double& used : energyUsed) {
+            std::atomic_ref<double>(used).store(0.0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Учтенная энергия закрытых сессий всех устройств (Вт*ч)
+     */
+    double energyBooked() const { return energy.sum(); }
+
+    /**
+     * @brief Текущая мощность всех потребляющих устройств (Вт)
+     * @details O(1): одна атомарная загрузка. Розетка учитывается, только
+     *          пока на реле подано питание, как в getCurrentPower()
+     */
+    double currentPower() const {
+        return static_cast<double>(load.microwatts.load(std::memory_order_relaxed)) / 1e6;
+    }
+
+    /**
+     * @brief Количество включенных устройств
+     * @details O(1): одна атомарная загрузка
+     */
+    std::size_t devicesOn() const {
+        return static_cast<std::size_t>(load.devicesOn.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Количество включенных устройств с дескрипторами [begin, end)
+     * @details popcount по битовой карте ON: 64 устройства за слово
+     */
+    std::size_t countOnBits(DeviceHandle begin, DeviceHandle end) const {
+        return countBits(onBits, nullptr, begin, end);
+    }
+
+    /**
+     * @brief Количество включенных розеток, подающих питание (ON и OUTLET)
+     */
+    std::size_t countOutletsPowered() const {
+        return countBits(onBits, &outletBits, 0, static_cast<DeviceHandle>(capacity()));
+    }
+
+    /**
+     * @brief Количество ячеек в колонках (включая свободные)
+     * @return Верхняя граница дескрипторов для линейного прохода
+     */
+    std::size_t capacity() const { return owners.size(); }
+
+    /**
+     * @brief Количество зарегистрированных устройств
+     */
+    std::size_t size() const { return liveCount; }
+
+    /**
+     * @brief Получить устройство по дескриптору
+     * @return Указатель на устройство или nullptr для свободной ячейки
+     */
+    SmartDevice* owner(DeviceHandle handle) const { return owners[handle]; }
+
+    /**
+     * @brief Атомарный доступ к слову состояния устройства
+     * @details Используется для CAS-переходов и чтения из разных потоков
+     */
+    std::atomic_ref<std::uint64_t> stateRef(DeviceHandle handle) {
+        return std::atomic_ref<std::uint64_t>(state[handle]);
+    }
+
+    /**
+     * @brief Атомарно прочитать слово состояния устройства
+     */
+    std::uint64_t loadState(DeviceHandle handle) const {
+        // Элементы колонки не константны: const относится только к реестру
+        return std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t&>(state[handle]))
+            .load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Атомарный доступ к накопленному времени работы
+     */
+    std::atomic_ref<DeviceTime> onTimeRef(DeviceHandle handle) {
+        return std::atomic_ref<DeviceTime>(totalOnTime[handle]);
+    }
+
+    // Поэлементный доступ для представлений (без синхронизации)
+    double& power(DeviceHandle handle) { return powerConsumption[handle]; }
+    double power(DeviceHandle handle) const { return powerConsumption[handle]; }
+    DeviceTime& onTime(DeviceHandle handle) { return totalOnTime[handle]; }
+    DeviceTime onTime(DeviceHandle handle) const {
+        return std::atomic_ref<DeviceTime>(const_cast<DeviceTime&>(totalOnTime[handle]))
+            .load(std::memory_order_relaxed);
+    }
+    double& deviceEnergy(DeviceHandle handle) { return energyUsed[handle]; }
+    double deviceEnergy(DeviceHandle handle) const {
+        return std::atomic_ref<double>(const_cast<double&>(energyUsed[handle])).load(std::memory_order_relaxed);
+    }
+    std::uint8_t& bright(DeviceHandle handle) { return brightness[handle]; }
+    int bright(DeviceHandle handle) const { return brightness[handle]; }
+    std::uint16_t& color(DeviceHandle handle) { return colors[handle]; }
+    std::uint16_t color(DeviceHandle handle) const { return colors[handle]; }
+    double& temp(DeviceHandle handle) { return temperature[handle]; }
+    double temp(DeviceHandle handle) const { return temperature[handle]; }
+    double& target(DeviceHandle handle) { return targetTemperature[handle]; }
+    double target(DeviceHandle handle) const { return targetTemperature[handle]; }
+    DeviceKind& kind(DeviceHandle handle) { return kinds[handle]; }
+    DeviceKind kind(DeviceHandle handle) const { return kinds[handle]; }
+
+    // Колонки целиком для линейных проходов
+    const std::vector<std::uint64_t>& stateColumn() const { return state; }
+    const std::vector<double>& powerColumn() const { return powerConsumption; }
+    const std::vector<DeviceTime>& totalOnTimeColumn() const { return totalOnTime; }
+    const std::vector<double>& deviceEnergyColumn() const { return energyUsed; }
+    const std::vector<std::uint8_t>& brightnessColumn() const { return brightness; }
+    const std::vector<std::uint16_t>& colorColumn() const { return colors; }
+    const std::vector<double>& temperatureColumn() const { return temperature; }
+    const std::vector<double>& targetTemperatureColumn() const { return targetTemperature; }
+    const std::vector<DeviceKind>& kindColumn() const { return kinds; }
+    const std::vector<std::uint64_t>& onBitColumn() const { return onBits; }
+
+    /**
+     * @brief Слово карты ON для дескрипторов [64 * word, 64 * word + 64) (атомарное чтение)
+     */
+    std::uint64_t onWord(std::size_t word) const { return loadBits(onBits, word); }
+    std::uint64_t outletWord(std::size_t word) const { return loadBits(outletBits, word); }
+
+    const std::vector<std::uint64_t>& outletBitColumn() const { return outletBits; }
+
+private:
+    /**
+     * @brief popcount битовой карты (или пересечения двух карт) по [begin, end)
+     */
+    static std::size_t countBits(const std::vector<std::uint64_t>& bits, const std::vector<std::uint64_t>* with,
+                                 DeviceHandle begin, DeviceHandle end) {
+        std::size_t total = 0;
+        for (std::size_t word = begin >> 6; begin < end && word <= ((end - 1) >> 6); word++) {
+            std::uint64_t value = loadBits(bits, word);
+            if (with) {
+                value &= loadBits(*with, word);
+            }
+            if (word == (begin >> 6)) {
+                value &= ~std::uint64_t(0) << (begin & 63);
+            }
+            if (word == ((end - 1) >> 6) && (end & 63) != 0) {
+                value &= ~std::uint64_t(0) >> (64 - (end & 63));
+            }
+            total += static_cast<std::size_t>(std::popcount(value));
+        }
+        return total;
+    }
+};
+
+#endif // DEVICE_REGISTRY_HPP
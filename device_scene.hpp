@@ -0,0 +1,350 @@
+/**
+ * @file device_scene.hpp
+ * @brief Комнаты, этажи и сцены над битовыми картами дескрипторов
+ *
+ * @details
+ * DeviceSet - набор устройств (комната, этаж, дом): по одной HandleBitmap
+ * на каждый DeviceKind, так что проходы по набору не проверяют тип.
+ * Этаж собирается объединением комнат (operator|=). Мощность набора -
+ * одно AND слова набора с картами ON/OUTLET реестра на 64 устройства и
+ * маскированная сумма колонки мощности (sumMaskedPower()); число
+ * включенных - popcount того же AND.
+ *
+ * Scene - список шагов "набор + действие" ("вечер кино": лампочки на 20%
+ * теплый белый, розетки выключить). Активация - один проход по словам
+ * карт каждого шага с одним снимком времени, без виртуальных вызовов:
+ * включение, яркость и цвет лампочек, режим термостатов, питание розеток,
+ * затем выключение. Изменения пишутся в DeviceJournal, как у одиночных
+ * методов.
+ *
+ * @code
+ * DeviceSet livingRoom;
+ * livingRoom.add(lamp);
+ * livingRoom.add(outlet);
+ *
+ * SceneAction movie;
+ * movie.brightness = 20;
+ * movie.color = "teplyy belyy";
+ * movie.outlet = false;
+ *
+ * Scene movieNight("vecher kino");
+ * movieNight.add(livingRoom, movie);
+ * movieNight.activate();
+ * @endcode
+ *
+ * @note Состав набора копируется в сцену при Scene::add(); устройства
+ *       нужно убирать из наборов до их уничтожения.
+ * @note Активация сцены не потокобезопасна относительно добавления и
+ *       удаления устройств; переключения из других потоков допустимы.
+ */
+
+#ifndef DEVICE_SCENE_HPP
+#define DEVICE_SCENE_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "color_palette.hpp"
+#include "device_clock.hpp"
+#include "device_journal.hpp"
+#include "device_registry.hpp"
+#include "fleet_kernels.hpp"
+#include "handle_bitmap.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @class DeviceSet
+ * @brief Набор устройств с битовой картой на каждый тип
+ */
+class DeviceSet {
+private:
+    static constexpr std::size_t KIND_COUNT = 4;            ///< Значений DeviceKind
+    std::array<HandleBitmap, KIND_COUNT> byKind;            ///< Дескрипторы по DeviceKind
+
+    // Флаги, которые turnOn()/turnOff() конкретных классов меняют вместе с ON
+    static std::uint64_t onFlags(DeviceKind kind) {
+        return kind == DeviceKind::THERMOSTAT ? DeviceState::MONITORING : 0;
+    }
+
+    static std::uint64_t offFlags(DeviceKind kind) {
+        switch (kind) {
+            case DeviceKind::THERMOSTAT: return DeviceState::MONITORING;
+            case DeviceKind::SMART_OUTLET: return DeviceState::OUTLET;
+            default: return 0;
+        }
+    }
+
+    std::size_t switchAll(bool on, DeviceTime now) const {
+        std::size_t changed = 0;
+        for (std::size_t k = 0; k < KIND_COUNT; k++) {
+            DeviceKind kind = static_cast<DeviceKind>(k);
+            std::uint64_t flags = on ? onFlags(kind) : offFlags(kind);
+            byKind[k].forEach([&](DeviceHandle h) {
+                if (kind == DeviceKind::NONE) {
+                    SmartDevice* device = DeviceRegistry::instance().owner(h);
+                    on ? device->turnOn() : device->turnOff();
+                    changed++;
+                } else {
+                    changed += (on ? PoweredDevice::switchOnAt(h, flags, now)
+                                   : PoweredDevice::switchOffAt(h, flags, now)) ? 1 : 0;
+                }
+            });
+        }
+        return changed;
+    }
+
+public:
+    /**
+     * @brief Добавить устройство
+     * @return true если устройства еще не было в наборе
+     */
+    bool add(const SmartDevice& device) {
+        DeviceHandle h = device.getHandle();
+        return byKind[static_cast<std::size_t>(DeviceRegistry::instance().kind(h))].add(h);
+    }
+
+    /**
+     * @brief Убрать устройство
+     * @return true если устройство было в наборе
+     */
+    bool remove(const SmartDevice& device) {
+        DeviceHandle h = device.getHandle();
+        return byKind[static_cast<std::size_t>(DeviceRegistry::instance().kind(h))].remove(h);
+    }
+
+    bool contains(const SmartDevice& device) const {
+        DeviceHandle h = device.getHandle();
+        return byKind[static_cast<std::size_t>(DeviceRegistry::instance().kind(h))].contains(h);
+    }
+
+    /**
+     * @brief Дескрипторы устройств одного типа
+     */
+    const HandleBitmap& ofKind(DeviceKind kind) const { return byKind[static_cast<std::size_t>(kind)]; }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const HandleBitmap& bitmap : byKind) {
+            total += bitmap.size();
+        }
+        return total;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        for (HandleBitmap& bitmap : byKind) {
+            bitmap.clear();
+        }
+    }
+
+    /**
+     * @brief Объединить с другим набором (этаж из комнат)
+     */
+    DeviceSet& operator|=(const DeviceSet& other) {
+        for (std::size_t k = 0; k < KIND_COUNT; k++) {
+            byKind[k] |= other.byKind[k];
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Суммарная текущая мощность набора (Вт), как сумма getCurrentPower()
+     * @details Розетка потребляет только при поданном питании (ON и OUTLET)
+     */
+    double sumCurrentPower() const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        const double* power = reg.powerColumn().data();
+        double total = 0.0;
+        for (std::size_t k = 0; k < KIND_COUNT; k++) {
+            bool outlet = static_cast<DeviceKind>(k) == DeviceKind::SMART_OUTLET;
+            byKind[k].forEachWord([&](std::size_t index, std::uint64_t bits) {
+                std::uint64_t active = bits & reg.onWord(index);
+                if (outlet) {
+                    active &= reg.outletWord(index);
+                }
+                if (active) {
+                    total += sumMaskedPower(power + index * 64, active);
+                }
+            });
+        }
+        return total;
+    }
+
+    /**
+     * @brief Количество включенных устройств набора
+     */
+    std::size_t countOn() const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        std::size_t total = 0;
+        for (const HandleBitmap& bitmap : byKind) {
+            bitmap.forEachWord([&](std::size_t index, std::uint64_t bits) {
+                total += static_cast<std::size_t>(std::popcount(bits & reg.onWord(index)));
+            });
+        }
+        return total;
+    }
+
+    /**
+     * @brief Включить все устройства набора с одним снимком времени
+     * @return Количество устройств, включенных этим вызовом
+     */
+    std::size_t turnOnAll(DeviceTime now = DeviceClock::now()) const { return switchAll(true, now); }
+
+    /**
+     * @brief Выключить все устройства набора с одним снимком времени
+     * @return Количество устройств, выключенных этим вызовом
+     */
+    std::size_t turnOffAll(DeviceTime now = DeviceClock::now()) const { return switchAll(false, now); }
+};
+
+/**
+ * @struct SceneAction
+ * @brief Действие шага сцены; незаданные поля не меняются
+ */
+struct SceneAction {
+    std::optional<bool> on;                     ///< Включить (true) или выключить (false) все устройства
+    std::optional<int> brightness;              ///< Яркость лампочек (0-100%)
+    std::optional<std::string> color;           ///< Цвет лампочек
+    std::optional<ThermostatMode> mode;         ///< Режим термостатов
+    std::optional<bool> outlet;                 ///< Питание розеток (только включенных)
+};
+
+/**
+ * @class Scene
+ * @brief Именованный список шагов "набор устройств + действие"
+ */
+class Scene {
+private:
+    /**
+     * @brief Шаг сцены с заранее разобранным действием
+     */
+    struct Step {
+        DeviceSet devices;                      ///< Копия состава набора
+        SceneAction action;
+        std::uint16_t colorIndex;               ///< Номер цвета в ColorPalette (если задан)
+    };
+
+    std::string name;
+    std::vector<Step> steps;
+
+    /**
+     * @brief Установить или снять флаг у всех включенных устройств карты
+     * @return Количество устройств, у которых флаг изменился
+     */
+    static std::size_t setFlag(const HandleBitmap& handles, std::uint64_t flag, bool value,
+                               JournalOp op, DeviceTime now) {
+        DeviceRegistry& reg = DeviceRegistry::instance();
+        std::size_t changed = 0;
+        handles.forEachWord([&](std::size_t index, std::uint64_t bits) {
+            // Розетка переключается только у включенного устройства
+            std::uint64_t candidates = flag == DeviceState::OUTLET ? bits & reg.onWord(index) : bits;
+            for (; candidates; candidates &= candidates - 1) {
+                DeviceHandle h = static_cast<DeviceHandle>(index * 64 + std::countr_zero(candidates));
+                std::atomic_ref<std::uint64_t> state = reg.stateRef(h);
+                std::uint64_t current = state.load(std::memory_order_relaxed);
+                std::uint64_t desired;
+                bool applicable;
+                do {
+                    applicable = flag != DeviceState::OUTLET || (current & DeviceState::ON);
+                    desired = value ? (current | flag) : (current & ~flag);
+                } while (applicable && desired != current &&
+                         !state.compare_exchange_weak(current, desired, std::memory_order_acq_rel,
+                                                      std::memory_order_relaxed));
+                if (!applicable || desired == current) {
+                    continue;
+                }
+                if (flag == DeviceState::OUTLET) {
+                    reg.noteTransition(h, current, desired);
+                }
+                DeviceJournal::record(h, op, desired, value ? 1.0 : 0.0, now);
+                changed++;
+            }
+        });
+        return changed;
+    }
+
+    static std::size_t applyStep(const Step& step, DeviceTime now) {
+        DeviceRegistry& reg = DeviceRegistry::instance();
+        const SceneAction& action = step.action;
+        const HandleBitmap& lights = step.devices.ofKind(DeviceKind::LIGHT_BULB);
+        std::size_t changed = 0;
+
+        if (action.on && *action.on) {
+            changed += step.devices.turnOnAll(now);
+        }
+        if (action.brightness) {
+            std::uint8_t level = static_cast<std::uint8_t>(*action.brightness);
+            lights.forEach([&](DeviceHandle h) {
+                std::uint8_t& current = reg.bright(h);
+                if (current != level) {
+                    current = level;
+                    DeviceJournal::record(h, JournalOp::SET_BRIGHTNESS, reg.loadState(h), level, now);
+                    changed++;
+                }
+            });
+        }
+        if (action.color) {
+            lights.forEach([&](DeviceHandle h) { reg.color(h) = step.colorIndex; });
+        }
+        if (action.mode) {
+            changed += setFlag(step.devices.ofKind(DeviceKind::THERMOSTAT), DeviceState::MONITORING,
+                               *action.mode == ThermostatMode::MONITORING, JournalOp::SET_MODE, now);
+        }
+        if (action.outlet) {
+            changed += setFlag(step.devices.ofKind(DeviceKind::SMART_OUTLET), DeviceState::OUTLET,
+                               *action.outlet, JournalOp::TOGGLE_OUTLET, now);
+        }
+        if (action.on && !*action.on) {
+            changed += step.devices.turnOffAll(now);
+        }
+        return changed;
+    }
+
+public:
+    explicit Scene(std::string name = "") : name(std::move(name)) {}
+
+    /**
+     * @brief Добавить шаг
+     * @param devices Набор устройств (состав копируется)
+     * @param action Действие
+     * @return Ссылка на сцену для цепочки вызовов
+     * @throws std::invalid_argument если яркость вне 0-100 или палитра заполнена
+     */
+    Scene& add(const DeviceSet& devices, const SceneAction& action) {
+        if (action.brightness && LightBulb::checkBrightness(*action.brightness) != DeviceError::NONE) {
+            throw std::invalid_argument(deviceErrorMessage(DeviceError::INVALID_BRIGHTNESS));
+        }
+        std::uint16_t colorIndex = action.color ? ColorPalette::instance().add(*action.color) : 0;
+        steps.push_back(Step{devices, action, colorIndex});
+        return *this;
+    }
+
+    /**
+     * @brief Активировать сцену: шаги по порядку, один снимок времени
+     * @return Количество изменений состояния (включений, яркостей, режимов, розеток)
+     * @note Смена цвета не считается изменением и не пишется в журнал,
+     *       как и LightBulb::setColor()
+     */
+    std::size_t activate() const {
+        DeviceTime now = DeviceClock::now();
+        std::size_t changed = 0;
+        for (const Step& step : steps) {
+            changed += applyStep(step, now);
+        }
+        return changed;
+    }
+
+    const std::string& getName() const { return name; }
+    std::size_t size() const { return steps.size(); }
+};
+
+#endif // DEVICE_SCENE_HPP
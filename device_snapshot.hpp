@@ -0,0 +1,517 @@
+/**
+ * @file device_snapshot.hpp
+ * @brief Двоичный снимок парка устройств с загрузкой через отображение в память
+ *
+ * @details
+ * Формат (версия 3, little-endian, все секции выровнены по 64 байтам):
+ * - Header (64 байта): сигнатура, версия, количество устройств,
+ *   размер таблицы строк, момент сохранения и учтенная энергия парка
+ * - SnapshotRecord[count]: тег типа, ссылки на ID, имя и метку
+ *   (цвет лампочки, расположение розетки) и параметр типа
+ *   (номинальная мощность термостата, предельный ток розетки)
+ * - колонки state (uint64), power (double), totalOnTime (int64),
+ *   energy (double, Вт*ч закрытых отрезков), temperature (double),
+ *   targetTemperature (double), brightness (int32)
+ *   в раскладке DeviceRegistry
+ * - таблица строк (байты без разделителей)
+ *
+ * SnapshotView отображает файл только для чтения и отдает колонки как
+ * есть: ядра fleet_kernels.hpp (sumCurrentPower(), sumEnergyConsumed(),
+ * countOn()) считают по снимку без десериализации. restore() создает
+ * по снимку живые устройства в DeviceArena и переносит колонки в реестр.
+ *
+ * @note Сохраняются только устройства известных типов (DeviceKind не NONE).
+ * @note Сессии, открытые в момент сохранения, продолжаются с момента
+ *       restore(): время между сохранением и загрузкой не учитывается.
+ */
+
+#ifndef DEVICE_SNAPSHOT_HPP
+#define DEVICE_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "device_arena.hpp"
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+#include "device_visit.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @brief Запись устройства в снимке (фиксированный размер)
+ * @details Смещения строк отсчитываются от начала таблицы строк
+ */
+struct SnapshotRecord {
+    std::uint8_t kind;          ///< DeviceKind
+    std::uint8_t reserved[3];   ///< Выравнивание
+    std::uint32_t idOffset;     ///< Начало ID
+    std::uint32_t idLength;     ///< Длина ID
+    std::uint32_t nameOffset;   ///< Начало имени
+    std::uint32_t nameLength;   ///< Длина имени
+    std::uint32_t labelOffset;  ///< Начало метки (цвет LightBulb, расположение SmartOutlet)
+    std::uint32_t labelLength;  ///< Длина метки
+    double parameter;           ///< Номинальная мощность Thermostat, предельный ток SmartOutlet
+};
+
+static_assert(sizeof(SnapshotRecord) == 40, "SnapshotRecord must stay 40 bytes");
+
+/**
+ * @class DeviceSnapshot
+ * @brief Раскладка файла снимка и сохранение реестра
+ */
+class DeviceSnapshot {
+public:
+    static constexpr std::uint64_t MAGIC = 0x5350414E53564544ULL;  ///< "DEVSNAPS"
+    static constexpr std::uint32_t VERSION = 3;                   ///< Версия формата
+    static constexpr std::uint32_t ENDIAN_MARK = 0x01020304;      ///< Проверка порядка байт
+
+    /**
+     * @brief Заголовок файла снимка
+     */
+    struct Header {
+        std::uint64_t magic;        ///< Сигнатура формата
+        std::uint32_t version;      ///< Версия формата
+        std::uint32_t recordSize;   ///< sizeof(SnapshotRecord)
+        std::uint64_t count;        ///< Количество устройств
+        std::uint64_t stringBytes;  ///< Размер таблицы строк
+        DeviceTime savedAt;         ///< DeviceClock::now() в момент сохранения
+        double energyBooked;        ///< DeviceRegistry::energyBooked() в момент сохранения
+        std::uint32_t endianMark;   ///< ENDIAN_MARK в порядке байт писателя
+        std::uint32_t reserved;     ///< Резерв
+        std::uint64_t reserved2;    ///< Резерв до 64 байт
+    };
+
+    static_assert(sizeof(Header) == 64, "Header must stay 64 bytes");
+
+    /**
+     * @brief Смещения секций для count устройств
+     */
+    struct Layout {
+        std::size_t records;
+        std::size_t state;
+        std::size_t power;
+        std::size_t onTime;
+        std::size_t energy;
+        std::size_t temperature;
+        std::size_t target;
+        std::size_t brightness;
+        std::size_t strings;
+
+        explicit Layout(std::size_t count) {
+            records = sizeof(Header);
+            state = align(records + count * sizeof(SnapshotRecord));
+            power = align(state + count * sizeof(std::uint64_t));
+            onTime = align(power + count * sizeof(double));
+            energy = align(onTime + count * sizeof(DeviceTime));
+            temperature = align(energy + count * sizeof(double));
+            target = align(temperature + count * sizeof(double));
+            brightness = align(target + count * sizeof(double));
+            strings = align(brightness + count * sizeof(std::int32_t));
+        }
+
+        static std::size_t align(std::size_t offset) {
+            return (offset + 63) & ~static_cast<std::size_t>(63);
+        }
+    };
+
+    /**
+     * @brief Сохранить все устройства реестра в файл
+     * @param path Путь к файлу снимка
+     * @return Количество сохраненных устройств
+     * @throws std::runtime_error при ошибке записи или на big-endian платформе
+     * @details Файл пишется во временный path + ".tmp" и затем
+     *          переименовывается, поэтому читатель видит либо старый,
+     *          либо новый снимок целиком
+     */
+    static std::size_t save(const std::string& path) {
+        if (std::endian::native != std::endian::little) {
+            throw std::runtime_error("Format snimka podderzhivaetsya tol'ko na little-endian");
+        }
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        std::vector<DeviceHandle> handles;
+        handles.reserve(reg.size());
+        for (DeviceHandle h = 0; h < reg.capacity(); h++) {
+            if (reg.owner(h) && reg.kind(h) != DeviceKind::NONE) {
+                handles.push_back(h);
+            }
+        }
+
+        std::size_t count = handles.size();
+        std::string strings;
+        std::vector<SnapshotRecord> records(count);
+        for (std::size_t i = 0; i < count; i++) {
+            const SmartDevice& device = *reg.owner(handles[i]);
+            SnapshotRecord& record = records[i];
+            std::memset(&record, 0, sizeof(record));
+            record.kind = static_cast<std::uint8_t>(reg.kind(handles[i]));
+            addString(strings, device.getId(), record.idOffset, record.idLength);
+            addString(strings, device.getName(), record.nameOffset, record.nameLength);
+            if (const LightBulb* bulb = deviceCast<LightBulb>(&device)) {
+                addString(strings, bulb->getColor(), record.labelOffset, record.labelLength);
+            } else if (const Thermostat* thermostat = deviceCast<Thermostat>(&device)) {
+                record.parameter = thermostat->getRatedPower();
+            } else if (const SmartOutlet* outlet = deviceCast<SmartOutlet>(&device)) {
+                addString(strings, outlet->getLocation(), record.labelOffset, record.labelLength);
+                record.parameter = outlet->getMaxCurrent();
+            }
+        }
+
+        Layout layout(count);
+        std::vector<unsigned char> image(layout.strings + strings.size(), 0);
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.recordSize = sizeof(SnapshotRecord);
+        header.count = count;
+        header.stringBytes = strings.size();
+        header.savedAt = DeviceClock::now();
+        header.energyBooked = reg.energyBooked();
+        header.endianMark = ENDIAN_MARK;
+        std::memcpy(image.data(), &header, sizeof(header));
+        if (count > 0) {
+            std::memcpy(image.data() + layout.records, records.data(), count * sizeof(SnapshotRecord));
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            DeviceHandle h = handles[i];
+            std::uint64_t state = reg.loadState(h);
+            double power = reg.power(h);
+            DeviceTime onTime = reg.onTime(h);
+            double energy = reg.deviceEnergy(h);
+            double temperature = reg.temp(h);
+            double target = reg.target(h);
+            std::int32_t brightness = reg.bright(h);
+            std::memcpy(image.data() + layout.state + i * sizeof(state), &state, sizeof(state));
+            std::memcpy(image.data() + layout.power + i * sizeof(power), &power, sizeof(power));
+            std::memcpy(image.data() + layout.onTime + i * sizeof(onTime), &onTime, sizeof(onTime));
+            std::memcpy(image.data() + layout.energy + i * sizeof(energy), &energy, sizeof(energy));
+            std::memcpy(image.data() + layout.temperature + i * sizeof(temperature), &temperature, sizeof(temperature));
+            std::memcpy(image.data() + layout.target + i * sizeof(target), &target, sizeof(target));
+            std::memcpy(image.data() + layout.brightness + i * sizeof(brightness), &brightness, sizeof(brightness));
+        }
+        std::memcpy(image.data() + layout.strings, strings.data(), strings.size());
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Ne udalos' zapisat' snimok: " + temporary);
+            }
+        }
+#ifdef _WIN32
+        if (!MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+#endif
+            throw std::runtime_error("Ne udalos' zamenit' snimok: " + path);
+        }
+        return count;
+    }
+
+private:
+    static void addString(std::string& strings, std::string_view text,
+                          std::uint32_t& offset, std::uint32_t& length) {
+        if (strings.size() + text.size() > 0xFFFFFFFFu) {
+            throw std::runtime_error("Tablitsa strok snimka prevyshaet 4 GiB");
+        }
+        offset = static_cast<std::uint32_t>(strings.size());
+        length = static_cast<std::uint32_t>(text.size());
+        strings.append(text);
+    }
+};
+
+/**
+ * @class SnapshotView
+ * @brief Снимок, отображенный в память только для чтения
+ */
+class SnapshotView {
+private:
+#ifdef _WIN32
+    HANDLE file;                    ///< Файл снимка
+    HANDLE mapping;                 ///< Объект отображения
+#else
+    int file;                       ///< Дескриптор файла снимка
+#endif
+    const unsigned char* view;      ///< Начало отображения
+    std::size_t viewSize;           ///< Размер отображения в байтах
+    std::size_t deviceCount;        ///< Количество устройств
+
+    const DeviceSnapshot::Header& header() const {
+        return *reinterpret_cast<const DeviceSnapshot::Header*>(view);
+    }
+
+    template <class T>
+    const T* section(std::size_t offset) const {
+        return reinterpret_cast<const T*>(view + offset);
+    }
+
+    void close() {
+        if (!view) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        munmap(const_cast<unsigned char*>(view), viewSize);
+        ::close(file);
+#endif
+        view = nullptr;
+    }
+
+    void fail(const std::string& path) {
+        close();
+        throw std::runtime_error("Povrezhdennyy ili neizvestnyy snimok: " + path);
+    }
+
+    /**
+     * @brief Проверить заголовок, размеры секций и ссылки на строки
+     */
+    void validate(const std::string& path) {
+        if (viewSize < sizeof(DeviceSnapshot::Header)) {
+            fail(path);
+        }
+        const DeviceSnapshot::Header& head = header();
+        if (head.magic != DeviceSnapshot::MAGIC || head.version != DeviceSnapshot::VERSION ||
+            head.recordSize != sizeof(SnapshotRecord) || head.endianMark != DeviceSnapshot::ENDIAN_MARK ||
+            head.count > viewSize / sizeof(SnapshotRecord)) {
+            fail(path);
+        }
+        deviceCount = static_cast<std::size_t>(head.count);
+        DeviceSnapshot::Layout layout(deviceCount);
+        if (head.stringBytes > viewSize || layout.strings + head.stringBytes > viewSize) {
+            fail(path);
+        }
+        const SnapshotRecord* records = section<SnapshotRecord>(layout.records);
+        for (std::size_t i = 0; i < deviceCount; i++) {
+            const SnapshotRecord& record = records[i];
+            if (record.kind == static_cast<std::uint8_t>(DeviceKind::NONE) ||
+                record.kind > static_cast<std::uint8_t>(DeviceKind::SMART_OUTLET) ||
+                std::uint64_t(record.idOffset) + record.idLength > head.stringBytes ||
+                std::uint64_t(record.nameOffset) + record.nameLength > head.stringBytes ||
+                std::uint64_t(record.labelOffset) + record.labelLength > head.stringBytes) {
+                fail(path);
+            }
+        }
+    }
+
+    std::string_view text(std::uint32_t offset, std::uint32_t length) const {
+        const char* strings = section<char>(DeviceSnapshot::Layout(deviceCount).strings);
+        return std::string_view(strings + offset, length);
+    }
+
+public:
+    /**
+     * @brief Отобразить файл снимка
+     * @param path Путь к файлу снимка
+     * @throws std::runtime_error при ошибке ввода-вывода или поврежденном файле
+     */
+    explicit SnapshotView(const std::string& path) : view(nullptr), viewSize(0), deviceCount(0) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Ne udalos' otkryt' snimok: " + path);
+        }
+        LARGE_INTEGER existing;
+        GetFileSizeEx(file, &existing);
+        viewSize = static_cast<std::size_t>(existing.QuadPart);
+        mapping = viewSize ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        if (!mapping) {
+            CloseHandle(file);
+            throw std::runtime_error("Ne udalos' otobrazit' snimok: " + path);
+        }
+        view = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, viewSize));
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Ne udalos' otobrazit' snimok: " + path);
+        }
+#else
+        file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            throw std::runtime_error("Ne udalos' otkryt' snimok: " + path);
+        }
+        struct stat info;
+        fstat(file, &info);
+        viewSize = static_cast<std::size_t>(info.st_size);
+        void* address = viewSize ? mmap(nullptr, viewSize, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+        if (address == MAP_FAILED) {
+            ::close(file);
+            throw std::runtime_error("Ne udalos' otobrazit' snimok: " + path);
+        }
+        view = static_cast<const unsigned char*>(address);
+#endif
+        validate(path);
+    }
+
+    ~SnapshotView() {
+        close();
+    }
+
+    SnapshotView(const SnapshotView&) = delete;
+    SnapshotView& operator=(const SnapshotView&) = delete;
+
+    /**
+     * @brief Количество устройств в снимке
+     */
+    std::size_t size() const { return deviceCount; }
+
+    /**
+     * @brief Момент сохранения по DeviceClock записавшего процесса
+     */
+    DeviceTime savedAt() const { return header().savedAt; }
+
+    /**
+     * @brief Учтенная энергия парка в момент сохранения (Вт*ч)
+     */
+    double energyBooked() const { return header().energyBooked; }
+
+    /**
+     * @name Колонки снимка в раскладке DeviceRegistry (size() элементов)
+     * @{
+     */
+    const std::uint64_t* stateColumn() const {
+        return section<std::uint64_t>(DeviceSnapshot::Layout(deviceCount).state);
+    }
+    const double* powerColumn() const {
+        return section<double>(DeviceSnapshot::Layout(deviceCount).power);
+    }
+    const DeviceTime* totalOnTimeColumn() const {
+        return section<DeviceTime>(DeviceSnapshot::Layout(deviceCount).onTime);
+    }
+    const double* deviceEnergyColumn() const {
+        return section<double>(DeviceSnapshot::Layout(deviceCount).energy);
+    }
+    const double* temperatureColumn() const {
+        return section<double>(DeviceSnapshot::Layout(deviceCount).temperature);
+    }
+    const double* targetTemperatureColumn() const {
+        return section<double>(DeviceSnapshot::Layout(deviceCount).target);
+    }
+    const std::int32_t* brightnessColumn() const {
+        return section<std::int32_t>(DeviceSnapshot::Layout(deviceCount).brightness);
+    }
+    /** @} */
+
+    /**
+     * @brief Запись устройства по номеру в снимке
+     */
+    const SnapshotRecord& record(std::size_t index) const {
+        return section<SnapshotRecord>(DeviceSnapshot::Layout(deviceCount).records)[index];
+    }
+
+    DeviceKind kind(std::size_t index) const { return static_cast<DeviceKind>(record(index).kind); }
+
+    std::string_view id(std::size_t index) const {
+        return text(record(index).idOffset, record(index).idLength);
+    }
+
+    std::string_view name(std::size_t index) const {
+        return text(record(index).nameOffset, record(index).nameLength);
+    }
+
+    std::string_view label(std::size_t index) const {
+        return text(record(index).labelOffset, record(index).labelLength);
+    }
+
+    double parameter(std::size_t index) const { return record(index).parameter; }
+
+    /**
+     * @brief Создать устройства снимка в арене и перенести их состояние в реестр
+     * @param arena Арена, которая будет владеть устройствами
+     * @return Количество созданных устройств
+     * @throws std::runtime_error если параметры устройства в снимке недопустимы
+     * @post Учтенная энергия снимка добавлена к DeviceRegistry::energyBooked()
+     */
+    std::size_t restore(DeviceArena& arena) const {
+        DeviceRegistry& reg = DeviceRegistry::instance();
+        DeviceTime now = DeviceClock::now();
+        DeviceTime saved = savedAt();
+        const std::uint64_t* state = stateColumn();
+        const double* power = powerColumn();
+        const DeviceTime* onTime = totalOnTimeColumn();
+        const double* energy = deviceEnergyColumn();
+        const double* temperature = temperatureColumn();
+        const double* target = targetTemperatureColumn();
+        const std::int32_t* brightness = brightnessColumn();
+
+        std::string idText;
+        std::string nameText;
+        for (std::size_t i = 0; i < deviceCount; i++) {
+            idText.assign(id(i));
+            nameText.assign(name(i));
+            DeviceExpected<PoweredDevice*> device = static_cast<PoweredDevice*>(nullptr);
+            switch (kind(i)) {
+                case DeviceKind::LIGHT_BULB:
+                    device = as(arena.tryMake<LightBulb>(idText, nameText, power[i], brightness[i],
+                                                         std::string(label(i))));
+                    break;
+                case DeviceKind::THERMOSTAT: {
+                    DeviceExpected<Thermostat*> thermostat =
+                        arena.tryMake<Thermostat>(idText, nameText, parameter(i), temperature[i]);
+                    if (thermostat) {
+                        // Нагрузка пересчитывается до восстановления флага ON
+                        reg.target((*thermostat)->getHandle()) = target[i];
+                        (*thermostat)->refreshLoad();
+                    }
+                    device = as(thermostat);
+                    break;
+                }
+                default:
+                    device = as(arena.tryMake<SmartOutlet>(idText, nameText, power[i], parameter(i),
+                                                           std::string(label(i))));
+                    break;
+            }
+            if (!device) {
+                throw std::runtime_error(std::string("Nedopustimoe ustroystvo v snimke: ") +
+                                         deviceErrorMessage(device.error()));
+            }
+
+            DeviceHandle h = (*device)->getHandle();
+            std::uint64_t word = state[i];
+            // Открытая сессия продолжается с момента загрузки; сессия длиннее
+            // времени работы нового процесса начинается с нуля его часов,
+            // а сессия "из будущего" (часы записавшего ушли назад) - с now
+            DeviceTime since = (word & DeviceState::ON) ? now - (saved - DeviceState::onSince(word)) : 0;
+            since = std::clamp<DeviceTime>(since, 0, now);
+            reg.restoreState(h, DeviceState::pack(word & DeviceState::FLAG_MASK, since));
+            reg.onTime(h) = onTime[i];
+            reg.deviceEnergy(h) = energy[i];
+        }
+        reg.bookEnergy(energyBooked());
+        return deviceCount;
+    }
+
+private:
+    template <class T>
+    static DeviceExpected<PoweredDevice*> as(const DeviceExpected<T*>& made) {
+        if (!made) {
+            return made.error();
+        }
+        return static_cast<PoweredDevice*>(*made);
+    }
+};
+
+#endif // DEVICE_SNAPSHOT_HPP
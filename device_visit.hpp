@@ -0,0 +1,113 @@
+/**
+ * @file device_visit.hpp
+ * @brief Диспетчеризация по тегу типа устройства вместо dynamic_cast
+ *
+ * @details
+ * Каждый конкретный класс библиотеки объявляет тег T::KIND, а SmartDevice
+ * хранит его в поле kind. visit() выбирает обработчик оператором switch
+ * по тегу (таблица переходов) и вызывает его со ссылкой на конкретный тип:
+ *
+ * @code
+ * visit(*device, overloaded{
+ *     [](LightBulb& lamp) { lamp.setBrightness(50); },
+ *     [](Thermostat& thermo) { thermo.setMode("monitoring"); },
+ *     [](SmartDevice&) {}     // розетка и типы вне библиотеки
+ * });
+ * @endcode
+ *
+ * deviceCast<T>() - замена dynamic_cast<T*>() для типов библиотеки:
+ * сравнение тега и static_cast без обращения к RTTI.
+ *
+ * @note Для устройств с DeviceKind::NONE (наследники вне библиотеки)
+ *       visit() передает обработчику SmartDevice&, а deviceCast()
+ *       использует dynamic_cast.
+ */
+
+#ifndef DEVICE_VISIT_HPP
+#define DEVICE_VISIT_HPP
+
+#include <type_traits>
+
+#include "smart_devices.hpp"
+
+/**
+ * @brief Набор лямбд как один перегруженный обработчик
+ */
+template <class... Handlers>
+struct overloaded : Handlers... {
+    using Handlers::operator()...;
+};
+
+template <class... Handlers>
+overloaded(Handlers...) -> overloaded<Handlers...>;
+
+/**
+ * @brief Вызвать обработчик для конкретного типа устройства
+ * @param device Устройство
+ * @param visitor Обработчик, принимающий LightBulb&, Thermostat&,
+ *        SmartOutlet& и SmartDevice& (напрямую или через базовый класс)
+ * @return Результат обработчика
+ */
+template <class Visitor>
+decltype(auto) visit(SmartDevice& device, Visitor&& visitor) {
+    switch (device.getKind()) {
+        case DeviceKind::LIGHT_BULB: return visitor(static_cast<LightBulb&>(device));
+        case DeviceKind::THERMOSTAT: return visitor(static_cast<Thermostat&>(device));
+        case DeviceKind::SMART_OUTLET: return visitor(static_cast<SmartOutlet&>(device));
+        default: return visitor(device);
+    }
+}
+
+/**
+ * @brief Вызвать обработчик для конкретного типа неизменяемого устройства
+ */
+template <class Visitor>
+decltype(auto) visit(const SmartDevice& device, Visitor&& visitor) {
+    switch (device.getKind()) {
+        case DeviceKind::LIGHT_BULB: return visitor(static_cast<const LightBulb&>(device));
+        case DeviceKind::THERMOSTAT: return visitor(static_cast<const Thermostat&>(device));
+        case DeviceKind::SMART_OUTLET: return visitor(static_cast<const SmartOutlet&>(device));
+        default: return visitor(device);
+    }
+}
+
+/**
+ * @brief Проверить, является ли устройство экземпляром T
+ * @tparam T LightBulb, Thermostat, SmartOutlet или PoweredDevice
+ */
+template <class T>
+bool isDevice(const SmartDevice& device) {
+    if constexpr (std::is_same_v<T, PoweredDevice>) {
+        // Все типы библиотеки - устройства с питанием
+        return device.getKind() != DeviceKind::NONE ||
+               dynamic_cast<const PoweredDevice*>(&device) != nullptr;
+    } else {
+        return device.getKind() == T::KIND;
+    }
+}
+
+/**
+ * @brief Приведение по тегу типа вместо dynamic_cast<T*>()
+ * @tparam T LightBulb, Thermostat, SmartOutlet или PoweredDevice
+ * @param device Устройство (может быть nullptr)
+ * @return Указатель на T или nullptr, если устройство другого типа
+ */
+template <class T>
+T* deviceCast(SmartDevice* device) {
+    if (!device || !isDevice<T>(*device)) {
+        return nullptr;
+    }
+    if constexpr (std::is_same_v<T, PoweredDevice>) {
+        if (device->getKind() == DeviceKind::NONE) {
+            return dynamic_cast<PoweredDevice*>(device);
+        }
+    }
+    return static_cast<T*>(device);
+}
+
+template <class T>
+const T* deviceCast(const SmartDevice* device) {
+    return deviceCast<T>(const_cast<SmartDevice*>(device));
+}
+
+#endif // DEVICE_VISIT_HPP
@@ -0,0 +1,372 @@
+/**
+ * @file energy_history.hpp
+ * @brief История энергии устройств по интервалам времени с уровнями детализации
+ *
+ * @details
+ * EnergyHistory хранит энергию каждого устройства в колонках
+ * фиксированных интервалов трех уровней: минута, час и сутки. Каждый
+ * уровень - кольцо из заданного числа интервалов на устройство
+ * (float, Вт*ч), поэтому память ограничена: по умолчанию 2 часа
+ * поминутно, 8 суток по часам и 400 суток по дням.
+ *
+ * Заполнение - в момент закрытия отрезка сессии: switchOffAt() и смена
+ * нагрузки PoweredDevice::changeLoad() передают отрезок [onSince, now)
+ * и мощность в EnergyHistory::book(), и энергия раскладывается по
+ * интервалам каждого уровня пропорционально перекрытию. Пока история
+ * не подключена, book() - одна атомарная загрузка указателя.
+ *
+ * energy() раскладывает запрос на целые интервалы самого крупного
+ * уровня и края, которые уточняются более мелким уровнем, пока тот
+ * хранит нужное время; иначе край берется долей крупного интервала
+ * (энергия внутри интервала считается равномерной, для текущего
+ * интервала - по его прошедшей части).
+ * Стоимость запроса - O(числа интервалов), порядка сотни чтений,
+ * без перебора журнала. Открытая сессия добавляется по колонкам реестра.
+ *
+ * @note Границы интервалов считаются от DeviceClock со сдвигом
+ *       alignment; wallClockAlignment() совмещает их с минутами, часами
+ *       и сутками UTC, а fromSystemTime() переводит время UTC в DeviceTime.
+ * @note Устройства с дескриптором не меньше емкости истории не учитываются.
+ */
+
+#ifndef ENERGY_HISTORY_HPP
+#define ENERGY_HISTORY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+
+/**
+ * @struct EnergyRetention
+ * @brief Глубина хранения каждого уровня EnergyHistory (количество интервалов)
+ */
+struct EnergyRetention {
+    std::uint32_t minutes = 120;    ///< Минутных интервалов (2 часа)
+    std::uint32_t hours = 192;      ///< Часовых интервалов (8 суток)
+    std::uint32_t days = 400;       ///< Суточных интервалов
+};
+
+/**
+ * @class EnergyHistory
+ * @brief Колонки энергии устройств по минутам, часам и суткам
+ */
+class EnergyHistory {
+public:
+    static constexpr std::size_t TIERS = 3;         ///< Количество уровней детализации
+    static constexpr std::size_t STRIPES = 64;      ///< Количество блокировок по дескрипторам
+
+private:
+    /**
+     * @brief Уровень детализации: кольцо интервалов на каждое устройство
+     */
+    struct Tier {
+        DeviceTime width;                   ///< Длина интервала (нс)
+        std::size_t buckets;                ///< Интервалов на устройство
+        std::vector<float> energy;          ///< [handle * buckets + slot] - энергия (Вт*ч)
+        std::vector<std::int64_t> latest;   ///< Номер последнего открытого интервала (-1 - нет)
+    };
+
+    Tier tiers[TIERS];                      ///< Минуты, часы, сутки
+    std::size_t deviceCapacity;             ///< Количество дескрипторов
+    DeviceTime alignment;                   ///< Сдвиг DeviceClock до начала отсчета интервалов
+    mutable std::mutex stripes[STRIPES];    ///< Блокировки колонок устройств (handle % STRIPES)
+
+    static std::atomic<EnergyHistory*>& slot() {
+        static std::atomic<EnergyHistory*> current(nullptr);
+        return current;
+    }
+
+    std::mutex& stripe(DeviceHandle handle) const { return stripes[handle % STRIPES]; }
+
+    static DeviceTime floorDiv(DeviceTime value, DeviceTime width) {
+        DeviceTime quotient = value / width;
+        return (value % width != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+
+    /**
+     * @brief Хранит ли уровень интервал, содержащий момент time
+     */
+    bool retains(const Tier& tier, DeviceHandle handle, DeviceTime time) const {
+        return floorDiv(time, tier.width) > tier.latest[handle] - static_cast<std::int64_t>(tier.buckets);
+    }
+
+    /**
+     * @brief Энергия интервала index уровня (0 для не записанных и вытесненных)
+     */
+    double bucket(const Tier& tier, DeviceHandle handle, std::int64_t index) const {
+        std::int64_t latest = tier.latest[handle];
+        if (index > latest || index <= latest - static_cast<std::int64_t>(tier.buckets)) {
+            return 0.0;
+        }
+        return tier.energy[handle * tier.buckets + static_cast<std::size_t>(index) % tier.buckets];
+    }
+
+    /**
+     * @brief Сумма уровня по [from, to) с долями крайних интервалов
+     * @param now Текущее время: энергия текущего интервала распределена по его прошедшей части
+     */
+    double partial(const Tier& tier, DeviceHandle handle, DeviceTime from, DeviceTime to, DeviceTime now) const {
+        double total = 0.0;
+        for (std::int64_t index = floorDiv(from, tier.width); index * tier.width < to; index++) {
+            DeviceTime start = index * tier.width;
+            DeviceTime begin = std::max(from, start);
+            DeviceTime end = std::min(to, start + tier.width);
+            DeviceTime span = std::min(start + tier.width, now) - start;
+            if (end > begin && span > 0) {
+                total += bucket(tier, handle, index) * static_cast<double>(std::min(end - begin, span)) /
+                         static_cast<double>(span);
+            }
+        }
+        return total;
+    }
+
+    /**
+     * @brief Сумма по [from, to): целые интервалы уровня level, края - уровнями ниже
+     */
+    double sum(std::size_t level, DeviceHandle handle, DeviceTime from, DeviceTime to, DeviceTime now) const {
+        if (from >= to) {
+            return 0.0;
+        }
+        const Tier& tier = tiers[level];
+        if (level == 0) {
+            return partial(tier, handle, from, to, now);
+        }
+        const Tier& finer = tiers[level - 1];
+        DeviceTime first = -floorDiv(-from, tier.width) * tier.width;
+        DeviceTime last = floorDiv(to, tier.width) * tier.width;
+        if (first >= last) {
+            return retains(finer, handle, from) ? sum(level - 1, handle, from, to, now)
+                                                : partial(tier, handle, from, to, now);
+        }
+        double total = partial(tier, handle, first, last, now);
+        total += retains(finer, handle, from) ? sum(level - 1, handle, from, first, now)
+                                              : partial(tier, handle, from, first, now);
+        total += retains(finer, handle, last) ? sum(level - 1, handle, last, to, now)
+                                              : partial(tier, handle, last, to, now);
+        return total;
+    }
+
+    /**
+     * @brief Разложить энергию отрезка [from, to) по интервалам уровня
+     */
+    void add(Tier& tier, DeviceHandle handle, DeviceTime from, DeviceTime to, double watts) {
+        std::int64_t first = floorDiv(from, tier.width);
+        std::int64_t last = floorDiv(to - 1, tier.width);
+        std::int64_t& latest = tier.latest[handle];
+        float* column = tier.energy.data() + handle * tier.buckets;
+        std::int64_t depth = static_cast<std::int64_t>(tier.buckets);
+        if (last > latest) {
+            // Открываем новые интервалы, вытесняя самые старые
+            for (std::int64_t index = std::max(latest + 1, last - depth + 1); index <= last; index++) {
+                column[static_cast<std::size_t>(index) % tier.buckets] = 0.0f;
+            }
+            latest = last;
+        }
+        for (std::int64_t index = std::max(first, latest - depth + 1); index <= last; index++) {
+            DeviceTime begin = std::max(from, index * tier.width);
+            DeviceTime end = std::min(to, (index + 1) * tier.width);
+            column[static_cast<std::size_t>(index) % tier.buckets] +=
+                static_cast<float>(watts * static_cast<double>(end - begin) / static_cast<double>(NANOS_PER_HOUR));
+        }
+    }
+
+public:
+    /**
+     * @brief Создать историю для дескрипторов 0..capacity-1
+     * @param capacity Емкость по дескрипторам (обычно не меньше DeviceRegistry::capacity())
+     * @param retention Глубина хранения уровней
+     * @param alignment Сдвиг DeviceClock до начала отсчета интервалов (см. wallClockAlignment())
+     * @throws std::invalid_argument если глубина какого-либо уровня нулевая
+     */
+    explicit EnergyHistory(std::size_t capacity, const EnergyRetention& retention = EnergyRetention(),
+                           DeviceTime alignment = 0)
+        : deviceCapacity(capacity), alignment(alignment) {
+        if (retention.minutes == 0 || retention.hours == 0 || retention.days == 0) {
+            throw std::invalid_argument("Glubina istorii dolzhna byt' polozhitel'noy");
+        }
+        const DeviceTime widths[TIERS] = {60 * NANOS_PER_SECOND, 3600 * NANOS_PER_SECOND, 86400 * NANOS_PER_SECOND};
+        const std::uint32_t depths[TIERS] = {retention.minutes, retention.hours, retention.days};
+        for (std::size_t level = 0; level < TIERS; level++) {
+            tiers[level].width = widths[level];
+            tiers[level].buckets = depths[level];
+            tiers[level].energy.assign(capacity * depths[level], 0.0f);
+            tiers[level].latest.assign(capacity, -1);
+        }
+    }
+
+    /**
+     * @brief Уничтожить историю, отключив ее, если она была подключена
+     */
+    ~EnergyHistory() {
+        EnergyHistory* self = this;
+        slot().compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+    }
+
+    EnergyHistory(const EnergyHistory&) = delete;
+    EnergyHistory& operator=(const EnergyHistory&) = delete;
+
+    /**
+     * @brief Сдвиг, совмещающий границы интервалов с минутами, часами и сутками UTC
+     */
+    static DeviceTime wallClockAlignment() {
+        DeviceTime wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return wall - DeviceClock::now();
+    }
+
+    /**
+     * @brief Перевести момент системного времени в DeviceTime
+     * @param time Момент системных часов (UTC)
+     * @return Соответствующее время DeviceClock по текущему расхождению часов
+     */
+    static DeviceTime fromSystemTime(std::chrono::system_clock::time_point time) {
+        return DeviceClock::now() - std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now() - time).count();
+    }
+
+    /**
+     * @brief Подключить историю к иерархии устройств
+     * @param history История, которая должна пережить все устройства
+     */
+    static void attach(EnergyHistory& history) {
+        slot().store(&history, std::memory_order_release);
+    }
+
+    /**
+     * @brief Отключить историю
+     */
+    static void detach() {
+        slot().store(nullptr, std::memory_order_release);
+    }
+
+    /**
+     * @brief Подключенная история или nullptr
+     */
+    static EnergyHistory* attached() {
+        return slot().load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Учесть закрытый отрезок сессии в подключенной истории
+     * @param handle Дескриптор устройства
+     * @param from Начало отрезка (DeviceClock)
+     * @param to Конец отрезка (DeviceClock)
+     * @param watts Мощность на отрезке (Вт)
+     */
+    static void book(DeviceHandle handle, DeviceTime from, DeviceTime to, double watts) {
+        EnergyHistory* history = slot().load(std::memory_order_acquire);
+        if (history) {
+            history->record(handle, from, to, watts);
+        }
+    }
+
+    /**
+     * @brief Стереть историю освобождаемого дескриптора в подключенной истории
+     */
+    static void forgetDevice(DeviceHandle handle) {
+        EnergyHistory* history = slot().load(std::memory_order_acquire);
+        if (history) {
+            history->clear(handle);
+        }
+    }
+
+    /**
+     * @brief Разложить энергию отрезка [from, to) при мощности watts по интервалам
+     * @note Потокобезопасно; отрезки одного устройства могут приходить не по порядку
+     */
+    void record(DeviceHandle handle, DeviceTime from, DeviceTime to, double watts) {
+        if (handle >= deviceCapacity || to <= from) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(stripe(handle));
+        for (Tier& tier : tiers) {
+            add(tier, handle, from + alignment, to + alignment, watts);
+        }
+    }
+
+    /**
+     * @brief Стереть историю устройства
+     */
+    void clear(DeviceHandle handle) {
+        if (handle >= deviceCapacity) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(stripe(handle));
+        for (Tier& tier : tiers) {
+            std::fill_n(tier.energy.begin() + handle * tier.buckets, tier.buckets, 0.0f);
+            tier.latest[handle] = -1;
+        }
+    }
+
+    /**
+     * @brief Энергия устройства за [from, to) (Вт*ч)
+     * @param handle Дескриптор устройства
+     * @param from Начало (DeviceClock)
+     * @param to Конец (DeviceClock)
+     * @param registry Реестр для учета открытой сессии
+     * @details Время старше глубины всех уровней дает 0; открытая сессия
+     *          учитывается по текущей мощности до DeviceClock::now()
+     */
+    double energy(DeviceHandle handle, DeviceTime from, DeviceTime to,
+                  const DeviceRegistry& registry = DeviceRegistry::instance()) const {
+        if (handle >= deviceCapacity || to <= from) {
+            return 0.0;
+        }
+        DeviceTime now = DeviceClock::now();
+        double total;
+        {
+            std::lock_guard<std::mutex> lock(stripe(handle));
+            total = sum(TIERS - 1, handle, from + alignment, to + alignment, now + alignment);
+        }
+        if (handle < registry.capacity()) {
+            std::uint64_t word = registry.loadState(handle);
+            if (word & DeviceState::ON) {
+                DeviceTime begin = std::max(from, DeviceState::onSince(word));
+                DeviceTime end = std::min(to, now);
+                if (end > begin) {
+                    total += registry.power(handle) * static_cast<double>(end - begin) /
+                             static_cast<double>(NANOS_PER_HOUR);
+                }
+            }
+        }
+        return total;
+    }
+
+    /**
+     * @brief Энергия всех дескрипторов за [from, to) для выгрузки счетов
+     * @param from Начало (DeviceClock)
+     * @param to Конец (DeviceClock)
+     * @param out Результат: out[handle] - энергия (Вт*ч), размер - capacity()
+     */
+    void energyAll(DeviceTime from, DeviceTime to, std::vector<double>& out,
+                   const DeviceRegistry& registry = DeviceRegistry::instance()) const {
+        out.assign(deviceCapacity, 0.0);
+        for (DeviceHandle handle = 0; handle < deviceCapacity; handle++) {
+            out[handle] = energy(handle, from, to, registry);
+        }
+    }
+
+    std::size_t capacity() const { return deviceCapacity; }
+    DeviceTime getAlignment() const { return alignment; }
+
+    /**
+     * @brief Память на одно устройство (байт)
+     */
+    std::size_t bytesPerDevice() const {
+        std::size_t bytes = 0;
+        for (const Tier& tier : tiers) {
+            bytes += tier.buckets * sizeof(float) + sizeof(std::int64_t);
+        }
+        return bytes;
+    }
+};
+
+#endif // ENERGY_HISTORY_HPP
@@ -0,0 +1,322 @@
+/**
+ * @file fleet_executor.hpp
+ * @brief Планировщик с перехватом работы для операций над всем парком устройств
+ *
+ * @details
+ * FleetExecutor держит пул рабочих потоков, у каждого - своя очередь
+ * (deque) диапазонов дескрипторов. parallelFor() режет диапазон на
+ * порции (grain) с границами, кратными 8 дескрипторам (64 байта колонки
+ * uint64/double), и раздает каждому потоку непрерывный блок порций:
+ * поток проходит колонки DeviceRegistry последовательно. Владелец берет
+ * порции с хвоста своей очереди, простаивающие потоки перехватывают
+ * порции с головы чужих очередей.
+ *
+ * Вызывающий поток участвует в работе как поток 0 и возвращается,
+ * когда все порции выполнены. Исключение из тела цикла передается
+ * вызывающему после завершения остальных порций.
+ *
+ * Помощники parallelForEachDevice() и parallelReduceDevices() работают
+ * поверх DeviceRegistry; свертка объединяет результаты порций в порядке
+ * дескрипторов, поэтому сумма double не зависит от перехватов.
+ *
+ * @note На время параллельного прохода нельзя добавлять и удалять устройства.
+ */
+
+#ifndef FLEET_EXECUTOR_HPP
+#define FLEET_EXECUTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+#include "fleet_kernels.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @class FleetExecutor
+ * @brief Пул потоков с очередями на поток и перехватом работы
+ */
+class FleetExecutor {
+private:
+    /**
+     * @brief Параллельный цикл, к которому относятся порции
+     */
+    struct Job {
+        void (*body)(const void* function, std::size_t begin, std::size_t end, std::size_t worker);
+        const void* function;                   ///< Тело цикла (лямбда вызывающего)
+        std::atomic<std::size_t> remaining;     ///< Невыполненные порции
+        std::mutex errorLock;                   ///< Защищает error
+        std::exception_ptr error;               ///< Первое исключение тела цикла
+    };
+
+    /**
+     * @brief Порция работы: полуинтервал индексов
+     */
+    struct Task {
+        Job* job;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    /**
+     * @brief Очередь потока на отдельной кэш-линии
+     */
+    struct alignas(64) Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;   ///< Очереди; 0 - вызывающий поток
+    std::vector<std::thread> threads;               ///< Рабочие потоки 1..N-1
+    std::mutex sleepLock;                           ///< Для ожидания работы
+    std::condition_variable wake;                   ///< Сигнал о новых порциях
+    std::atomic<std::size_t> queued;                ///< Порции во всех очередях
+    bool stopping;                                  ///< Признак остановки (под sleepLock)
+
+    /**
+     * @brief Взять порцию: своя очередь с хвоста, затем чужие с головы
+     */
+    bool take(std::size_t self, Task& task) {
+        {
+            Worker& own = *workers[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (std::size_t step = 1; step < workers.size(); step++) {
+            Worker& victim = *workers[(self + step) % workers.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(const Task& task, std::size_t self) {
+        Job& job = *task.job;
+        try {
+            job.body(job.function, task.begin, task.end, self);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(job.errorLock);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+        }
+        job.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void run(std::size_t self) {
+        Task task;
+        for (;;) {
+            if (take(self, task)) {
+                execute(task, self);
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleepLock);
+            wake.wait(guard, [this] {
+                return stopping || queued.load(std::memory_order_relaxed) > 0;
+            });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    template <class Function>
+    static void invoke(const void* function, std::size_t begin, std::size_t end, std::size_t worker) {
+        (*static_cast<const Function*>(function))(begin, end, worker);
+    }
+
+public:
+    /**
+     * @brief Размер порции по умолчанию (дескрипторов)
+     */
+    static constexpr std::size_t DEFAULT_GRAIN = 4096;
+
+    /**
+     * @brief Конструктор
+     * @param threadCount Общее число потоков, включая вызывающий
+     *        (0 - по числу аппаратных потоков)
+     */
+    explicit FleetExecutor(std::size_t threadCount = 0) : queued(0), stopping(false) {
+        if (threadCount == 0) {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        for (std::size_t i = 0; i < threadCount; i++) {
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        }
+        for (std::size_t i = 1; i < threadCount; i++) {
+            threads.emplace_back(&FleetExecutor::run, this, i);
+        }
+    }
+
+    ~FleetExecutor() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    FleetExecutor(const FleetExecutor&) = delete;
+    FleetExecutor& operator=(const FleetExecutor&) = delete;
+
+    /**
+     * @brief Общее число потоков, включая вызывающий
+     */
+    std::size_t size() const { return workers.size(); }
+
+    /**
+     * @brief Выполнить тело для всех порций полуинтервала [0, count)
+     * @param count Количество индексов
+     * @param grain Размер порции (округляется вверх до кратного 8)
+     * @param function Тело: function(begin, end, worker), worker < size()
+     * @throws Первое исключение, выброшенное телом
+     */
+    template <class Function>
+    void parallelFor(std::size_t count, std::size_t grain, const Function& function) {
+        if (count == 0) {
+            return;
+        }
+        grain = grain < 8 ? 8 : (grain + 7) & ~static_cast<std::size_t>(7);
+        std::size_t chunks = (count + grain - 1) / grain;
+
+        Job job;
+        job.body = &invoke<Function>;
+        job.function = &function;
+        job.remaining.store(chunks, std::memory_order_relaxed);
+
+        // Каждому потоку - непрерывный блок порций для последовательного доступа
+        std::size_t perWorker = (chunks + workers.size() - 1) / workers.size();
+        for (std::size_t w = 0; w < workers.size(); w++) {
+            std::size_t first = w * perWorker;
+            std::size_t last = std::min(chunks, first + perWorker);
+            if (first >= last) {
+                break;
+            }
+            std::lock_guard<std::mutex> guard(workers[w]->lock);
+            // Владелец берет с хвоста, поэтому кладем блок в обратном порядке
+            for (std::size_t c = last; c > first; c--) {
+                std::size_t begin = (c - 1) * grain;
+                workers[w]->tasks.push_back(Task{&job, begin, std::min(count, begin + grain)});
+            }
+            queued.fetch_add(last - first, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+        }
+        wake.notify_all();
+
+        Task task;
+        while (job.remaining.load(std::memory_order_acquire) > 0) {
+            if (take(0, task)) {
+                execute(task, 0);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+    /**
+     * @brief Свертка по порциям полуинтервала [0, count)
+     * @param identity Нейтральный элемент
+     * @param map Результат порции: map(begin, end) -> T
+     * @param combine Объединение результатов: combine(T, T) -> T
+     * @return Свертка результатов порций в порядке индексов
+     */
+    template <class T, class Map, class Combine>
+    T parallelReduce(std::size_t count, std::size_t grain, T identity,
+                     const Map& map, const Combine& combine) {
+        std::size_t step = grain < 8 ? 8 : (grain + 7) & ~static_cast<std::size_t>(7);
+        std::vector<T> partial((count + step - 1) / step, identity);
+        parallelFor(count, step, [&](std::size_t begin, std::size_t end, std::size_t) {
+            partial[begin / step] = map(begin, end);
+        });
+        T result = identity;
+        for (const T& value : partial) {
+            result = combine(result, value);
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief Выполнить функцию для каждого живого устройства реестра параллельно
+ * @param executor Планировщик
+ * @param function function(SmartDevice&)
+ * @param grain Размер порции в дескрипторах
+ */
+template <class Function>
+void parallelForEachDevice(FleetExecutor& executor, const Function& function,
+                           std::size_t grain = FleetExecutor::DEFAULT_GRAIN) {
+    DeviceRegistry& reg = DeviceRegistry::instance();
+    executor.parallelFor(reg.capacity(), grain, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t handle = begin; handle < end; handle++) {
+            SmartDevice* device = reg.owner(static_cast<DeviceHandle>(handle));
+            if (device) {
+                function(*device);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Параллельная свертка по диапазонам дескрипторов реестра
+ * @param executor Планировщик
+ * @param identity Нейтральный элемент
+ * @param map map(const DeviceRegistry&, DeviceHandle begin, DeviceHandle end) -> T
+ * @param combine combine(T, T) -> T
+ * @param grain Размер порции в дескрипторах
+ * @return Свертка в порядке дескрипторов (детерминирована для double)
+ */
+template <class T, class Map, class Combine>
+T parallelReduceDevices(FleetExecutor& executor, T identity, const Map& map, const Combine& combine,
+                        std::size_t grain = FleetExecutor::DEFAULT_GRAIN) {
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    return executor.parallelReduce(reg.capacity(), grain, identity,
+        [&](std::size_t begin, std::size_t end) {
+            return map(reg, static_cast<DeviceHandle>(begin), static_cast<DeviceHandle>(end));
+        }, combine);
+}
+
+/**
+ * @brief Параллельная сверка энергии парка к моменту now (Вт*ч)
+ * @details Ядро sumEnergyConsumed() на срезах колонок по порциям
+ */
+inline double parallelSumEnergyConsumed(FleetExecutor& executor, DeviceTime now,
+                                        std::size_t grain = FleetExecutor::DEFAULT_GRAIN) {
+    return parallelReduceDevices(executor, 0.0,
+        [now](const DeviceRegistry& reg, DeviceHandle begin, DeviceHandle end) {
+            return sumEnergyConsumed(reg.stateColumn().data() + begin, reg.powerColumn().data() + begin,
+                                     reg.deviceEnergyColumn().data() + begin, end - begin, now);
+        },
+        [](double a, double b) { return a + b; }, grain);
+}
+
+#endif // FLEET_EXECUTOR_HPP
@@ -0,0 +1,336 @@
+/**
+ * @file fleet_kernels.hpp
+ * @brief Пакетные ядра агрегации мощности и энергии по парку устройств
+ *
+ * @details
+ * Ядра работают напрямую с колонками DeviceRegistry и берут один
+ * снимок времени DeviceClock на весь проход, вместо dynamic_cast,
+ * виртуального вызова и чтения часов на каждое устройство.
+ *
+ * Реализации выбираются при компиляции:
+ * - AVX2 (x86-64, -mavx2): по 4 устройства за итерацию, маскированное сложение
+ * - NEON (AArch64): по 2 устройства за итерацию
+ * - Скалярный вариант для остальных платформ и хвостов массивов
+ *
+ * @note Свободные ячейки реестра обнулены и не влияют на результат.
+ * @note При параллельных переключениях результат - приближенный снимок.
+ */
+
+#ifndef FLEET_KERNELS_HPP
+#define FLEET_KERNELS_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "device_registry.hpp"
+
+/**
+ * @brief Вариант ядер, выбранный при компиляции: "avx2", "neon" или "scalar"
+ */
+#if defined(__AVX2__)
+inline constexpr const char* FLEET_KERNELS_ISA = "avx2";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline constexpr const char* FLEET_KERNELS_ISA = "neon";
+#else
+inline constexpr const char* FLEET_KERNELS_ISA = "scalar";
+#endif
+
+/**
+ * @brief Суммарная текущая мощность включенных устройств
+ * @param state Колонка слов состояния (DeviceState)
+ * @param power Колонка номинальной мощности (Вт)
+ * @param count Количество ячеек
+ * @return Сумма power[i] по включенным устройствам (Вт)
+ * @note Реле розеток (DeviceState::OUTLET) не учитывается: вариант для
+ *       однотипных колонок и снимков; по смешанному парку - перегрузка с kinds
+ */
+inline double sumCurrentPower(const std::uint64_t* state, const double* power, std::size_t count) {
+    std::size_t i = 0;
+    double total = 0.0;
+#if defined(__AVX2__)
+    const __m256i onBit = _mm256_set1_epi64x(static_cast<long long>(DeviceState::ON));
+    __m256d acc = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + i));
+        __m256d mask = _mm256_castsi256_pd(
+            _mm256_cmpeq_epi64(_mm256_and_si256(words, onBit), onBit));
+        acc = _mm256_add_pd(acc, _mm256_and_pd(mask, _mm256_loadu_pd(power + i)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t onBit = vdupq_n_u64(DeviceState::ON);
+    float64x2_t acc = vdupq_n_f64(0.0);
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t mask = vtstq_u64(vld1q_u64(state + i), onBit);
+        float64x2_t values = vld1q_f64(power + i);
+        acc = vaddq_f64(acc, vreinterpretq_f64_u64(vandq_u64(mask, vreinterpretq_u64_f64(values))));
+    }
+    total = vaddvq_f64(acc);
+#endif
+    for (; i < count; i++) {
+        if (state[i] & DeviceState::ON) {
+            total += power[i];
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Суммарная текущая мощность с учетом реле розеток
+ * @param state Колонка слов состояния (DeviceState)
+ * @param power Колонка номинальной мощности (Вт)
+ * @param kinds Колонка типов устройств
+ * @param count Количество ячеек
+ * @return Сумма power[i] по включенным устройствам, кроме розеток со
+ *         снятым DeviceState::OUTLET (Вт), как сумма getCurrentPower()
+ */
+inline double sumCurrentPower(const std::uint64_t* state, const double* power, const DeviceKind* kinds,
+                              std::size_t count) {
+    std::size_t i = 0;
+    double total = 0.0;
+#if defined(__AVX2__)
+    const __m256i onBit = _mm256_set1_epi64x(static_cast<long long>(DeviceState::ON));
+    const __m256i outletBit = _mm256_set1_epi64x(static_cast<long long>(DeviceState::OUTLET));
+    const __m256i outletKind = _mm256_set1_epi64x(static_cast<long long>(DeviceKind::SMART_OUTLET));
+    __m256d acc = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + i));
+        std::int32_t packedKinds;
+        std::memcpy(&packedKinds, kinds + i, sizeof(packedKinds));
+        __m256i kind = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packedKinds));
+        __m256i on = _mm256_cmpeq_epi64(_mm256_and_si256(words, onBit), onBit);
+        __m256i relay = _mm256_cmpeq_epi64(_mm256_and_si256(words, outletBit), outletBit);
+        __m256i relayOff = _mm256_andnot_si256(relay, _mm256_cmpeq_epi64(kind, outletKind));
+        __m256d mask = _mm256_castsi256_pd(_mm256_andnot_si256(relayOff, on));
+        acc = _mm256_add_pd(acc, _mm256_and_pd(mask, _mm256_loadu_pd(power + i)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t onBit = vdupq_n_u64(DeviceState::ON);
+    const uint64x2_t outletBit = vdupq_n_u64(DeviceState::OUTLET);
+    const uint64x2_t outletKind = vdupq_n_u64(static_cast<std::uint64_t>(DeviceKind::SMART_OUTLET));
+    float64x2_t acc = vdupq_n_f64(0.0);
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t words = vld1q_u64(state + i);
+        uint64x2_t kind = vsetq_lane_u64(static_cast<std::uint64_t>(kinds[i + 1]),
+                                         vdupq_n_u64(static_cast<std::uint64_t>(kinds[i])), 1);
+        uint64x2_t relayOff = vbicq_u64(vceqq_u64(kind, outletKind), vtstq_u64(words, outletBit));
+        uint64x2_t mask = vbicq_u64(vtstq_u64(words, onBit), relayOff);
+        float64x2_t values = vld1q_f64(power + i);
+        acc = vaddq_f64(acc, vreinterpretq_f64_u64(vandq_u64(mask, vreinterpretq_u64_f64(values))));
+    }
+    total = vaddvq_f64(acc);
+#endif
+    for (; i < count; i++) {
+        if (DeviceRegistry::drawsPower(state[i], kinds[i])) {
+            total += power[i];
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Суммарная энергия, потребленная устройствами к моменту now
+ * @param state Колонка слов состояния (DeviceState)
+ * @param power Колонка номинальной мощности (Вт)
+ * @param energy Колонка энергии закрытых отрезков работы (Вт*ч) или
+ *        nullptr - только энергия текущих сессий
+ * @param count Количество ячеек
+ * @param now Единый снимок DeviceClock::now() для всего прохода
+ * @return Энергия в ватт-часах, как сумма getDeviceEnergyConsumed()
+ * @details Для включенных устройств к учтенной энергии добавляется текущая
+ *          сессия now - onSince по текущей мощности; устройство, включенное
+ *          после снимка now (параллельное переключение), дает сессию 0,
+ *          а не отрицательную
+ */
+inline double sumEnergyConsumed(const std::uint64_t* state, const double* power,
+                                const double* energy, std::size_t count, DeviceTime now) {
+    std::size_t i = 0;
+    double booked = 0.0;
+    double open = 0.0;
+#if defined(__AVX2__)
+    // Перевод неотрицательных int64 в double: старшие и младшие 32 бита
+    // переводятся через магические константы 2^84 и 2^52 и складываются
+    const __m256i magicLo = _mm256_set1_epi64x(0x4330000000000000LL);     // 2^52
+    const __m256i magicHi = _mm256_set1_epi64x(0x4530000000000000LL);     // 2^84
+    const __m256d magicAll = _mm256_set1_pd(19342813118337666422669312.0); // 2^84 + 2^52
+    const __m256i onBit = _mm256_set1_epi64x(static_cast<long long>(DeviceState::ON));
+    const __m256i nowVec = _mm256_set1_epi64x(static_cast<long long>(now));
+    __m256d bookedAcc = _mm256_setzero_pd();
+    __m256d openAcc = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + i));
+        __m256i mask = _mm256_cmpeq_epi64(_mm256_and_si256(words, onBit), onBit);
+        __m256i since = _mm256_srli_epi64(words, DeviceState::TIME_SHIFT);
+        __m256i session = _mm256_sub_epi64(nowVec, since);
+        // Отрицательная сессия обнуляется: перевод ниже верен только для nanos >= 0
+        mask = _mm256_and_si256(mask, _mm256_cmpgt_epi64(session, _mm256_setzero_si256()));
+        __m256i nanos = _mm256_and_si256(mask, session);
+        __m256i hi = _mm256_or_si256(_mm256_srli_epi64(nanos, 32), magicHi);
+        __m256i lo = _mm256_blend_epi32(nanos, magicLo, 0xAA);
+        __m256d nanosPd = _mm256_add_pd(
+            _mm256_sub_pd(_mm256_castsi256_pd(hi), magicAll), _mm256_castsi256_pd(lo));
+        openAcc = _mm256_add_pd(openAcc, _mm256_mul_pd(_mm256_loadu_pd(power + i), nanosPd));
+        if (energy) {
+            bookedAcc = _mm256_add_pd(bookedAcc, _mm256_loadu_pd(energy + i));
+        }
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, openAcc);
+    open = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_store_pd(lanes, bookedAcc);
+    booked = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t onBit = vdupq_n_u64(DeviceState::ON);
+    const int64x2_t nowVec = vdupq_n_s64(static_cast<std::int64_t>(now));
+    float64x2_t bookedAcc = vdupq_n_f64(0.0);
+    float64x2_t openAcc = vdupq_n_f64(0.0);
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t words = vld1q_u64(state + i);
+        int64x2_t mask = vreinterpretq_s64_u64(vtstq_u64(words, onBit));
+        int64x2_t since = vreinterpretq_s64_u64(vshrq_n_u64(words, DeviceState::TIME_SHIFT));
+        int64x2_t session = vsubq_s64(nowVec, since);
+        mask = vandq_s64(mask, vreinterpretq_s64_u64(vcgtq_s64(session, vdupq_n_s64(0))));
+        int64x2_t nanos = vandq_s64(mask, session);
+        openAcc = vfmaq_f64(openAcc, vld1q_f64(power + i), vcvtq_f64_s64(nanos));
+        if (energy) {
+            bookedAcc = vaddq_f64(bookedAcc, vld1q_f64(energy + i));
+        }
+    }
+    open = vaddvq_f64(openAcc);
+    booked = vaddvq_f64(bookedAcc);
+#endif
+    for (; i < count; i++) {
+        booked += energy ? energy[i] : 0.0;
+        if ((state[i] & DeviceState::ON) && now > DeviceState::onSince(state[i])) {
+            open += power[i] * static_cast<double>(now - DeviceState::onSince(state[i]));
+        }
+    }
+    return booked + open / static_cast<double>(NANOS_PER_HOUR);
+}
+
+/**
+ * @brief Количество включенных устройств
+ * @param state Колонка слов состояния (DeviceState)
+ * @param count Количество ячеек
+ * @return Число устройств с флагом DeviceState::ON
+ */
+inline std::size_t countOn(const std::uint64_t* state, std::size_t count) {
+    std::size_t i = 0;
+    std::size_t total = 0;
+#if defined(__AVX2__)
+    const __m256i onBit = _mm256_set1_epi64x(static_cast<long long>(DeviceState::ON));
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + i));
+        acc = _mm256_add_epi64(acc, _mm256_and_si256(words, onBit));
+    }
+    alignas(32) std::uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    total = static_cast<std::size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t onBit = vdupq_n_u64(DeviceState::ON);
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 2 <= count; i += 2) {
+        acc = vaddq_u64(acc, vandq_u64(vld1q_u64(state + i), onBit));
+    }
+    total = static_cast<std::size_t>(vaddvq_u64(acc));
+#endif
+    for (; i < count; i++) {
+        total += (state[i] & DeviceState::ON) ? 1 : 0;
+    }
+    return total;
+}
+
+/**
+ * @brief Сумма мощности устройств, отмеченных битами маски
+ * @param power Колонка мощности с первого дескриптора слова маски
+ * @param mask Бит i отмечает устройство power[i]
+ * @return Сумма power[i] по установленным битам (Вт)
+ * @details AVX2: плотная маска складывается маскированными загрузками по
+ *          4 устройства, неотмеченные ячейки не читаются (маска может
+ *          выходить за конец колонки). Редкая маска и NEON - перебор битов
+ */
+inline double sumMaskedPower(const double* power, std::uint64_t mask) {
+    double total = 0.0;
+#if defined(__AVX2__)
+    if (std::popcount(mask) >= 16) {
+        __m256d acc = _mm256_setzero_pd();
+        for (int k = 0; k < 16; k++) {
+            long long nibble = static_cast<long long>((mask >> (4 * k)) & 15);
+            if (nibble) {
+                __m256i lanes = _mm256_set_epi64x(-((nibble >> 3) & 1), -((nibble >> 2) & 1),
+                                                  -((nibble >> 1) & 1), -(nibble & 1));
+                acc = _mm256_add_pd(acc, _mm256_maskload_pd(power + 4 * k, lanes));
+            }
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#endif
+    for (; mask; mask &= mask - 1) {
+        total += power[std::countr_zero(mask)];
+    }
+    return total;
+}
+
+/**
+ * @brief Суммарная текущая мощность всех устройств реестра
+ * @param registry Реестр устройств
+ * @return Мощность в ваттах, как DeviceRegistry::currentPower()
+ */
+inline double sumCurrentPower(const DeviceRegistry& registry) {
+    return sumCurrentPower(registry.stateColumn().data(), registry.powerColumn().data(),
+                           registry.kindColumn().data(), registry.capacity());
+}
+
+/**
+ * @brief Суммарная энергия живых устройств реестра к моменту now
+ * @param registry Реестр устройств
+ * @param now Снимок DeviceClock::now()
+ * @return Энергия в ватт-часах, как сумма getDeviceEnergyConsumed()
+ * @note Энергия удаленных устройств сюда не входит; итог парка с ними -
+ *       sumFleetEnergy()
+ */
+inline double sumEnergyConsumed(const DeviceRegistry& registry, DeviceTime now) {
+    return sumEnergyConsumed(registry.stateColumn().data(), registry.powerColumn().data(),
+                             registry.deviceEnergyColumn().data(), registry.capacity(), now);
+}
+
+/**
+ * @brief Энергия парка с учетом текущих сессий к моменту now
+ * @param registry Реестр устройств
+ * @param now Снимок DeviceClock::now()
+ * @return DeviceRegistry::energyBooked() (включая удаленные устройства)
+ *         плюс энергия открытых сессий (Вт*ч)
+ */
+inline double sumFleetEnergy(const DeviceRegistry& registry, DeviceTime now) {
+    return registry.energyBooked() +
+           sumEnergyConsumed(registry.stateColumn().data(), registry.powerColumn().data(),
+                             nullptr, registry.capacity(), now);
+}
+
+/**
+ * @brief Количество включенных устройств реестра
+ * @param registry Реестр устройств
+ * @return Число включенных устройств
+ * @details popcount по битовой карте ON реестра, а не проход по словам состояния
+ */
+inline std::size_t countOn(const DeviceRegistry& registry) {
+    return registry.countOnBits(0, static_cast<DeviceHandle>(registry.capacity()));
+}
+
+#endif // FLEET_KERNELS_HPP
@@ -0,0 +1,627 @@
+/**
+ * @file fleet_partition.hpp
+ * @brief Разбиение парка на шарды по согласованному хешированию ID устройства
+ *
+ * @details
+ * HashRing отображает deviceId на один из N шардов: у каждого шарда
+ * VIRTUAL_NODES точек на кольце 64-битных хешей, устройство принадлежит
+ * первой точке по часовой стрелке от хеша своего ID. При добавлении
+ * шарда к нему переходят только устройства с дуг перед его точками -
+ * в среднем 1/N парка; при удалении его устройства расходятся по
+ * остальным шардам. Хеш (FNV-1a + финализатор splitmix64) не зависит от
+ * платформы, поэтому одно и то же кольцо строится на всех узлах.
+ *
+ * FleetPartition маршрутизирует команды в очереди шардов-владельцев и
+ * собирает итоги по схеме scatter-gather: сначала всем шардам отдается
+ * запрос (beginApply()/beginTotals()), затем собираются ответы
+ * (endApply()/endTotals()), так что шарды работают одновременно:
+ * - LocalShard - шард в этом процессе со своим рабочим потоком,
+ *   команды применяет своим CommandBatch
+ * - удаленный узел реализует FleetShard поверх сети: begin* отправляет
+ *   запрос, end* ждет ответа
+ *
+ * @code
+ * FleetPartition fleet;
+ * for (int i = 0; i < 4; i++) {
+ *     fleet.addShard(std::make_unique<LocalShard>());
+ * }
+ * fleet.create<LightBulb>("LB1", "Lampochka", 60);
+ * fleet.submit("LB1", CommandType::TURN_ON);
+ * fleet.apply();
+ * ShardTotals totals = fleet.totals();
+ * @endcode
+ *
+ * @note Статические счетчики SmartDevice и PoweredDevice остаются общими
+ *       для процесса; ShardTotals считает живые устройства шардов.
+ * @note Методы FleetPartition вызываются из одного управляющего потока.
+ */
+
+#ifndef FLEET_PARTITION_HPP
+#define FLEET_PARTITION_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "command_batch.hpp"
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @brief Хеш ID устройства для кольца, одинаковый на всех платформах
+ * @param text ID устройства
+ * @return FNV-1a 64 с финализатором splitmix64
+ */
+inline std::uint64_t partitionHash(std::string_view text) {
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char c : text) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+/**
+ * @class HashRing
+ * @brief Кольцо согласованного хеширования с виртуальными узлами
+ */
+class HashRing {
+public:
+    static constexpr std::size_t DEFAULT_VIRTUAL_NODES = 160;  ///< Точек кольца на шард
+
+private:
+    /**
+     * @brief Точка кольца
+     */
+    struct Point {
+        std::uint64_t position;     ///< Положение на кольце
+        std::uint32_t shard;        ///< Шард-владелец дуги до точки
+
+        bool operator<(const Point& other) const {
+            return position != other.position ? position < other.position : shard < other.shard;
+        }
+    };
+
+    std::vector<Point> points;      ///< Точки, упорядоченные по position
+    std::size_t virtualNodes;       ///< Точек на шард
+    std::size_t shards;             ///< Количество шардов
+
+    static std::uint64_t pointOf(std::uint32_t shard, std::uint32_t replica) {
+        std::uint64_t mixed = (static_cast<std::uint64_t>(shard) << 32 | replica) + 0x9E3779B97F4A7C15ULL;
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+        return mixed ^ (mixed >> 31);
+    }
+
+public:
+    /**
+     * @brief Пустое кольцо
+     * @param virtualNodes Точек на шард (больше - ровнее распределение)
+     * @throws std::invalid_argument если virtualNodes равно 0
+     */
+    explicit HashRing(std::size_t virtualNodes = DEFAULT_VIRTUAL_NODES)
+        : virtualNodes(virtualNodes), shards(0) {
+        if (virtualNodes == 0) {
+            throw std::invalid_argument("Kol'tso: nuzhna khotya by odna tochka na shard");
+        }
+    }
+
+    /**
+     * @brief Добавить шард
+     * @throws std::invalid_argument если шард уже на кольце
+     */
+    void addShard(std::uint32_t shard) {
+        if (contains(shard)) {
+            throw std::invalid_argument("Kol'tso: shard uzhe dobavlen");
+        }
+        for (std::size_t i = 0; i < virtualNodes; i++) {
+            points.push_back(Point{pointOf(shard, static_cast<std::uint32_t>(i)), shard});
+        }
+        std::sort(points.begin(), points.end());
+        shards++;
+    }
+
+    /**
+     * @brief Убрать шард; его дуги переходят к следующим точкам
+     */
+    void removeShard(std::uint32_t shard) {
+        std::size_t before = points.size();
+        points.erase(std::remove_if(points.begin(), points.end(),
+                                    [shard](const Point& point) { return point.shard == shard; }),
+                     points.end());
+        if (points.size() != before) {
+            shards--;
+        }
+    }
+
+    bool contains(std::uint32_t shard) const {
+        return std::any_of(points.begin(), points.end(),
+                           [shard](const Point& point) { return point.shard == shard; });
+    }
+
+    /**
+     * @brief Шард-владелец устройства
+     * @param deviceId ID устройства
+     * @throws std::runtime_error если на кольце нет шардов
+     */
+    std::uint32_t shardOf(std::string_view deviceId) const {
+        if (points.empty()) {
+            throw std::runtime_error("Kol'tso: net shardov");
+        }
+        std::uint64_t hash = partitionHash(deviceId);
+        auto found = std::lower_bound(points.begin(), points.end(), hash,
+                                      [](const Point& point, std::uint64_t value) { return point.position < value; });
+        return found == points.end() ? points.front().shard : found->shard;
+    }
+
+    std::size_t size() const { return shards; }
+    bool empty() const { return shards == 0; }
+};
+
+/**
+ * @struct ShardTotals
+ * @brief Итоги шарда, объединяемые сложением
+ */
+struct ShardTotals {
+    std::size_t devices = 0;            ///< Живых устройств
+    std::size_t devicesOn = 0;          ///< Включенных устройств
+    double currentPower = 0.0;          ///< Текущая мощность (Вт), как getCurrentPower()
+    double energyConsumed = 0.0;        ///< Энергия закрытых отрезков работы (Вт*ч)
+    double energyNow = 0.0;             ///< Энергия с учетом текущих сессий, как getDeviceEnergyConsumed() (Вт*ч)
+
+    ShardTotals& operator+=(const ShardTotals& other) {
+        devices += other.devices;
+        devicesOn += other.devicesOn;
+        currentPower += other.currentPower;
+        energyConsumed += other.energyConsumed;
+        energyNow += other.energyNow;
+        return *this;
+    }
+};
+
+/**
+ * @class FleetShard
+ * @brief Шард парка: владеет частью устройств и применяет их команды
+ * @details Пары begin*()/end*() позволяют FleetPartition опрашивать шарды
+ *          одновременно; между ними у шарда не вызываются другие методы
+ */
+class FleetShard {
+public:
+    virtual ~FleetShard() = default;
+
+    /**
+     * @brief Поставить команду устройства в очередь шарда
+     * @pure
+     */
+    virtual void submit(std::string_view deviceId, CommandType type, std::int32_t argument) = 0;
+
+    /**
+     * @brief Начать применение очереди
+     * @pure
+     */
+    virtual void beginApply() = 0;
+
+    /**
+     * @brief Дождаться применения очереди
+     * @return Результаты в порядке submit(); очередь очищается
+     * @pure
+     */
+    virtual const std::vector<CommandResult>& endApply() = 0;
+
+    /**
+     * @brief Начать подсчет итогов к моменту now
+     * @pure
+     */
+    virtual void beginTotals(DeviceTime now) = 0;
+
+    /**
+     * @brief Дождаться итогов
+     * @pure
+     */
+    virtual ShardTotals endTotals() = 0;
+
+    /**
+     * @brief Принять устройство во владение
+     * @pure
+     */
+    virtual void adopt(std::unique_ptr<SmartDevice> device) = 0;
+
+    /**
+     * @brief Отдать устройство (перенос в другой шард)
+     * @return Устройство или nullptr, если его нет в шарде
+     * @pure
+     */
+    virtual std::unique_ptr<SmartDevice> release(std::string_view deviceId) = 0;
+
+    /**
+     * @brief Собрать ID устройств, которые по кольцу принадлежат не этому шарду
+     * @param ring Кольцо после изменения
+     * @param self Номер этого шарда
+     * @param moved Куда добавить ID
+     * @pure
+     */
+    virtual void collectMoved(const HashRing& ring, std::uint32_t self, std::vector<std::string>& moved) const = 0;
+
+    /**
+     * @brief Количество устройств шарда
+     * @pure
+     */
+    virtual std::size_t size() const = 0;
+};
+
+/**
+ * @class LocalShard
+ * @brief Шард в этом процессе со своим рабочим потоком
+ */
+class LocalShard : public FleetShard {
+private:
+    enum class Job : std::uint8_t {
+        NONE = 0,
+        APPLY = 1,
+        TOTALS = 2,
+        STOP = 3
+    };
+
+    std::vector<std::unique_ptr<SmartDevice>> devices;          ///< Устройства шарда
+    std::vector<DeviceHandle> handles;                          ///< Их дескрипторы (для прохода по колонкам)
+    std::unordered_map<DeviceHandle, std::size_t> positions;    ///< Дескриптор -> индекс в devices
+
+    CommandBatch batch;                     ///< Очередь команд шарда
+    std::vector<CommandResult> applied;     ///< Результаты последнего применения
+    ShardTotals computed;                   ///< Итоги последнего подсчета
+    DeviceTime totalsTime;                  ///< Момент подсчета итогов
+
+    std::mutex lock;                        ///< Защищает job
+    std::condition_variable signal;         ///< Смена job в обе стороны
+    Job job;                                ///< Текущая задача рабочего потока
+    std::thread worker;                     ///< Рабочий поток (если есть)
+
+    void execute(Job task) {
+        if (task == Job::APPLY) {
+            applied = batch.apply();
+            batch.clear();
+        } else if (task == Job::TOTALS) {
+            computed = compute(totalsTime);
+        }
+    }
+
+    ShardTotals compute(DeviceTime now) const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        ShardTotals totals;
+        totals.devices = handles.size();
+        double open = 0.0;
+        for (DeviceHandle h : handles) {
+            std::uint64_t word = reg.loadState(h);
+            double watts = reg.power(h);
+            totals.energyConsumed += reg.deviceEnergy(h);
+            if (word & DeviceState::ON) {
+                totals.devicesOn++;
+                DeviceTime session = now - DeviceState::onSince(word);
+                open += session > 0 ? watts * static_cast<double>(session) : 0.0;
+                bool outletOff = reg.kind(h) == DeviceKind::SMART_OUTLET && !(word & DeviceState::OUTLET);
+                totals.currentPower += outletOff ? 0.0 : watts;
+            }
+        }
+        totals.energyNow = totals.energyConsumed + open / static_cast<double>(NANOS_PER_HOUR);
+        return totals;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            signal.wait(guard, [this] { return job != Job::NONE; });
+            if (job == Job::STOP) {
+                return;
+            }
+            Job task = job;
+            guard.unlock();
+            execute(task);
+            guard.lock();
+            job = Job::NONE;
+            signal.notify_all();
+        }
+    }
+
+    void start(Job task) {
+        if (!worker.joinable()) {
+            execute(task);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        job = task;
+        signal.notify_all();
+    }
+
+    void wait() {
+        if (worker.joinable()) {
+            std::unique_lock<std::mutex> guard(lock);
+            signal.wait(guard, [this] { return job == Job::NONE; });
+        }
+    }
+
+public:
+    /**
+     * @brief Создать шард
+     * @param threaded true - свой рабочий поток, false - работа в вызывающем потоке
+     */
+    explicit LocalShard(bool threaded = true) : totalsTime(0), job(Job::NONE) {
+        if (threaded) {
+            worker = std::thread(&LocalShard::run, this);
+        }
+    }
+
+    LocalShard(const LocalShard&) = delete;
+    LocalShard& operator=(const LocalShard&) = delete;
+
+    /**
+     * @brief Остановить рабочий поток; устройства уничтожаются в вызывающем потоке
+     */
+    virtual ~LocalShard() override {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                job = Job::STOP;
+            }
+            signal.notify_all();
+            worker.join();
+        }
+    }
+
+    virtual void submit(std::string_view deviceId, CommandType type, std::int32_t argument) override {
+        DeviceHandle handle = DeviceRegistry::instance().findHandle(deviceId);
+        if (positions.find(handle) == positions.end()) {
+            handle = INVALID_DEVICE_HANDLE;         // Устройство другого шарда или неизвестно
+        }
+        batch.add(DeviceCommand{handle, type, argument});
+    }
+
+    virtual void beginApply() override { start(Job::APPLY); }
+
+    virtual const std::vector<CommandResult>& endApply() override {
+        wait();
+        return applied;
+    }
+
+    virtual void beginTotals(DeviceTime now) override {
+        totalsTime = now;
+        start(Job::TOTALS);
+    }
+
+    virtual ShardTotals endTotals() override {
+        wait();
+        return computed;
+    }
+
+    virtual void adopt(std::unique_ptr<SmartDevice> device) override {
+        DeviceHandle handle = device->getHandle();
+        positions[handle] = devices.size();
+        handles.push_back(handle);
+        devices.push_back(std::move(device));
+    }
+
+    virtual std::unique_ptr<SmartDevice> release(std::string_view deviceId) override {
+        auto found = positions.find(DeviceRegistry::instance().findHandle(deviceId));
+        if (found == positions.end()) {
+            return nullptr;
+        }
+        std::size_t position = found->second;
+        positions.erase(found);
+        std::unique_ptr<SmartDevice> device = std::move(devices[position]);
+        if (position + 1 != devices.size()) {
+            devices[position] = std::move(devices.back());
+            handles[position] = handles.back();
+            positions[handles[position]] = position;
+        }
+        devices.pop_back();
+        handles.pop_back();
+        return device;
+    }
+
+    virtual void collectMoved(const HashRing& ring, std::uint32_t self,
+                              std::vector<std::string>& moved) const override {
+        for (const std::unique_ptr<SmartDevice>& device : devices) {
+            if (ring.empty() || ring.shardOf(device->getId()) != self) {
+                moved.emplace_back(device->getId());
+            }
+        }
+    }
+
+    virtual std::size_t size() const override { return devices.size(); }
+};
+
+/**
+ * @class FleetPartition
+ * @brief Парк, разбитый на шарды: маршрутизация команд, перебалансировка, сбор итогов
+ */
+class FleetPartition {
+private:
+    /**
+     * @brief Куда ушла команда из submit()
+     */
+    struct Route {
+        std::uint32_t shard;        ///< Шард-владелец
+        std::uint32_t position;     ///< Номер команды в очереди шарда
+    };
+
+    HashRing ring;
+    std::vector<std::unique_ptr<FleetShard>> shards;    ///< По номеру шарда (nullptr - удален)
+    std::vector<std::uint32_t> queued;                  ///< Команд в очереди каждого шарда
+    std::vector<Route> routes;                          ///< Команды в порядке submit()
+    std::vector<const std::vector<CommandResult>*> gathered;
+    std::vector<CommandResult> results;
+
+    /**
+     * @brief Перенести устройства по списку ID из шарда from к владельцам по кольцу
+     */
+    std::size_t moveDevices(std::uint32_t from, const std::vector<std::string>& ids) {
+        for (const std::string& id : ids) {
+            std::unique_ptr<SmartDevice> device = shards[from]->release(id);
+            if (device) {
+                shards[ring.shardOf(id)]->adopt(std::move(device));
+            }
+        }
+        return ids.size();
+    }
+
+public:
+    explicit FleetPartition(std::size_t virtualNodes = HashRing::DEFAULT_VIRTUAL_NODES) : ring(virtualNodes) {}
+
+    FleetPartition(const FleetPartition&) = delete;
+    FleetPartition& operator=(const FleetPartition&) = delete;
+
+    /**
+     * @brief Добавить шард и перенести в него его долю устройств
+     * @param shard Новый шард
+     * @param moved Если не nullptr - количество перенесенных устройств
+     * @return Номер шарда
+     * @details Очередь команд перед переносом применяется (apply())
+     */
+    std::uint32_t addShard(std::unique_ptr<FleetShard> shard, std::size_t* moved = nullptr) {
+        apply();
+        std::uint32_t id = static_cast<std::uint32_t>(shards.size());
+        shards.push_back(std::move(shard));
+        queued.push_back(0);
+        ring.addShard(id);
+        std::size_t count = 0;
+        std::vector<std::string> ids;
+        for (std::uint32_t s = 0; s < id; s++) {
+            if (shards[s]) {
+                ids.clear();
+                shards[s]->collectMoved(ring, s, ids);
+                count += moveDevices(s, ids);
+            }
+        }
+        if (moved) {
+            *moved = count;
+        }
+        return id;
+    }
+
+    /**
+     * @brief Убрать шард; его устройства переходят к новым владельцам по кольцу
+     * @return Количество перенесенных устройств
+     * @throws std::invalid_argument если шарда нет или он последний и не пуст
+     */
+    std::size_t removeShard(std::uint32_t id) {
+        if (id >= shards.size() || !shards[id]) {
+            throw std::invalid_argument("Partitsiya: net takogo sharda");
+        }
+        if (ring.size() == 1 && shards[id]->size() > 0) {
+            throw std::invalid_argument("Partitsiya: nel'zya udalit' posledniy shard s ustroystvami");
+        }
+        apply();
+        ring.removeShard(id);
+        std::vector<std::string> ids;
+        shards[id]->collectMoved(ring, id, ids);
+        std::size_t count = moveDevices(id, ids);
+        shards[id].reset();
+        return count;
+    }
+
+    /**
+     * @brief Количество шардов на кольце
+     */
+    std::size_t shardCount() const { return ring.size(); }
+
+    FleetShard& shard(std::uint32_t id) const { return *shards[id]; }
+
+    /**
+     * @brief Шард-владелец устройства
+     */
+    std::uint32_t ownerOf(std::string_view deviceId) const { return ring.shardOf(deviceId); }
+
+    const HashRing& getRing() const { return ring; }
+
+    /**
+     * @brief Передать устройство шарду-владельцу
+     */
+    void add(std::unique_ptr<SmartDevice> device) {
+        std::uint32_t owner = ring.shardOf(device->getId());
+        shards[owner]->adopt(std::move(device));
+    }
+
+    /**
+     * @brief Создать устройство в шарде-владельце
+     * @tparam T LightBulb, Thermostat, SmartOutlet или другой наследник SmartDevice
+     * @return Ссылка на устройство (владеет шард)
+     */
+    template <class T, class... Args>
+    T& create(Args&&... args) {
+        std::unique_ptr<T> device(new T(std::forward<Args>(args)...));
+        T& result = *device;
+        add(std::move(device));
+        return result;
+    }
+
+    /**
+     * @brief Направить команду в очередь шарда-владельца
+     * @param deviceId ID устройства
+     */
+    void submit(std::string_view deviceId, CommandType type, std::int32_t argument = 0) {
+        std::uint32_t owner = ring.shardOf(deviceId);
+        shards[owner]->submit(deviceId, type, argument);
+        routes.push_back(Route{owner, queued[owner]++});
+    }
+
+    /**
+     * @brief Применить очереди всех шардов одновременно
+     * @return Результаты в порядке submit()
+     */
+    const std::vector<CommandResult>& apply() {
+        results.clear();
+        if (routes.empty()) {
+            return results;
+        }
+        gathered.assign(shards.size(), nullptr);
+        for (std::uint32_t s = 0; s < shards.size(); s++) {
+            if (queued[s] > 0) {
+                shards[s]->beginApply();
+            }
+        }
+        for (std::uint32_t s = 0; s < shards.size(); s++) {
+            if (queued[s] > 0) {
+                gathered[s] = &shards[s]->endApply();
+                queued[s] = 0;
+            }
+        }
+        results.reserve(routes.size());
+        for (const Route& route : routes) {
+            results.push_back((*gathered[route.shard])[route.position]);
+        }
+        routes.clear();
+        return results;
+    }
+
+    /**
+     * @brief Итоги всего парка: запрос всем шардам, затем сложение ответов
+     * @param now Момент для энергии текущих сессий
+     */
+    ShardTotals totals(DeviceTime now = DeviceClock::now()) {
+        for (const std::unique_ptr<FleetShard>& shard : shards) {
+            if (shard) {
+                shard->beginTotals(now);
+            }
+        }
+        ShardTotals merged;
+        for (const std::unique_ptr<FleetShard>& shard : shards) {
+            if (shard) {
+                merged += shard->endTotals();
+            }
+        }
+        return merged;
+    }
+};
+
+#endif // FLEET_PARTITION_HPP
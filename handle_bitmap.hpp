@@ -0,0 +1,321 @@
+/**
+ * @file handle_bitmap.hpp
+ * @brief Сжатое множество дескрипторов устройств по схеме roaring bitmap
+ *
+ * @details
+ * Пространство дескрипторов делится на блоки по 65536. Каждый непустой
+ * блок хранится контейнером одного из двух видов:
+ * - массив - отсортированные младшие 16 бит дескрипторов, пока в блоке
+ *   не больше ARRAY_LIMIT элементов (до 8 КБ)
+ * - битовая карта - 1024 слова по 64 бита (ровно 8 КБ)
+ * Комната из десятка устройств занимает десятки байт, а этаж или дом с
+ * плотными дескрипторами - бит на устройство.
+ *
+ * Проходы идут словами по 64 дескриптора (forEachWord()): номер слова
+ * совпадает с номером слова битовых карт ON/OUTLET DeviceRegistry,
+ * поэтому маска набора накладывается на карты реестра одним AND.
+ *
+ * @note Не потокобезопасно; набор только хранит дескрипторы и не следит
+ *       за удалением устройств из реестра.
+ */
+
+#ifndef HANDLE_BITMAP_HPP
+#define HANDLE_BITMAP_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "device_registry.hpp"
+
+/**
+ * @class HandleBitmap
+ * @brief Множество DeviceHandle с контейнерами-массивами и контейнерами-картами
+ */
+class HandleBitmap {
+public:
+    static constexpr std::size_t CONTAINER_WORDS = 1024;    ///< Слов в блоке (65536 дескрипторов)
+    static constexpr std::size_t ARRAY_LIMIT = 4096;        ///< Наибольший размер контейнера-массива
+
+private:
+    /**
+     * @brief Контейнер блока из 65536 дескрипторов
+     */
+    struct Container {
+        std::uint32_t key;                  ///< Старшие биты дескриптора (handle >> 16)
+        std::uint32_t cardinality;          ///< Элементов в контейнере
+        std::vector<std::uint16_t> values;  ///< Отсортированные младшие 16 бит (массив)
+        std::vector<std::uint64_t> words;   ///< CONTAINER_WORDS слов (карта) или пусто
+
+        bool isBitmap() const { return !words.empty(); }
+    };
+
+    std::vector<Container> containers;      ///< Непустые контейнеры по возрастанию key
+    std::size_t count;                      ///< Элементов во всем множестве
+
+    std::vector<Container>::iterator lowerBound(std::uint32_t key) {
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                                [](const Container& c, std::uint32_t k) { return c.key < k; });
+    }
+
+    const Container* find(std::uint32_t key) const {
+        auto found = std::lower_bound(containers.begin(), containers.end(), key,
+                                      [](const Container& c, std::uint32_t k) { return c.key < k; });
+        return found != containers.end() && found->key == key ? &*found : nullptr;
+    }
+
+    Container& findOrInsert(std::uint32_t key) {
+        auto found = lowerBound(key);
+        if (found == containers.end() || found->key != key) {
+            found = containers.insert(found, Container{key, 0, {}, {}});
+        }
+        return *found;
+    }
+
+    static void toBitmap(Container& container) {
+        container.words.assign(CONTAINER_WORDS, 0);
+        for (std::uint16_t low : container.values) {
+            container.words[low >> 6] |= std::uint64_t(1) << (low & 63);
+        }
+        container.values.clear();
+        container.values.shrink_to_fit();
+    }
+
+    static void toArray(Container& container) {
+        container.values.clear();
+        container.values.reserve(container.cardinality);
+        for (std::size_t w = 0; w < CONTAINER_WORDS; w++) {
+            for (std::uint64_t bits = container.words[w]; bits; bits &= bits - 1) {
+                container.values.push_back(static_cast<std::uint16_t>(w * 64 + std::countr_zero(bits)));
+            }
+        }
+        container.words.clear();
+        container.words.shrink_to_fit();
+    }
+
+public:
+    HandleBitmap() : count(0) {}
+
+    /**
+     * @brief Добавить дескриптор
+     * @return true если дескриптора еще не было
+     */
+    bool add(DeviceHandle handle) {
+        Container& container = findOrInsert(handle >> 16);
+        std::uint16_t low = static_cast<std::uint16_t>(handle);
+        if (container.isBitmap()) {
+            std::uint64_t& word = container.words[low >> 6];
+            std::uint64_t bit = std::uint64_t(1) << (low & 63);
+            if (word & bit) {
+                return false;
+            }
+            word |= bit;
+        } else {
+            auto found = std::lower_bound(container.values.begin(), container.values.end(), low);
+            if (found != container.values.end() && *found == low) {
+                return false;
+            }
+            container.values.insert(found, low);
+            if (container.values.size() > ARRAY_LIMIT) {
+                toBitmap(container);
+            }
+        }
+        container.cardinality++;
+        count++;
+        return true;
+    }
+
+    /**
+     * @brief Убрать дескриптор
+     * @return true если дескриптор был в множестве
+     */
+    bool remove(DeviceHandle handle) {
+        auto found = lowerBound(handle >> 16);
+        if (found == containers.end() || found->key != (handle >> 16)) {
+            return false;
+        }
+        Container& container = *found;
+        std::uint16_t low = static_cast<std::uint16_t>(handle);
+        if (container.isBitmap()) {
+            std::uint64_t& word = container.words[low >> 6];
+            std::uint64_t bit = std::uint64_t(1) << (low & 63);
+            if (!(word & bit)) {
+                return false;
+            }
+            word &= ~bit;
+        } else {
+            auto position = std::lower_bound(container.values.begin(), container.values.end(), low);
+            if (position == container.values.end() || *position != low) {
+                return false;
+            }
+            container.values.erase(position);
+        }
+        container.cardinality--;
+        count--;
+        if (container.cardinality == 0) {
+            containers.erase(found);
+        } else if (container.isBitmap() && container.cardinality < ARRAY_LIMIT / 2) {
+            toArray(container);     // Гистерезис: обратно в массив только при заметном опустении
+        }
+        return true;
+    }
+
+    bool contains(DeviceHandle handle) const {
+        const Container* container = find(handle >> 16);
+        if (!container) {
+            return false;
+        }
+        std::uint16_t low = static_cast<std::uint16_t>(handle);
+        if (container->isBitmap()) {
+            return (container->words[low >> 6] >> (low & 63)) & 1;
+        }
+        return std::binary_search(container->values.begin(), container->values.end(), low);
+    }
+
+    /**
+     * @brief Слово из 64 дескрипторов [64 * index, 64 * index + 64)
+     */
+    std::uint64_t word(std::size_t index) const {
+        const Container* container = find(static_cast<std::uint32_t>(index / CONTAINER_WORDS));
+        if (!container) {
+            return 0;
+        }
+        std::size_t local = index % CONTAINER_WORDS;
+        if (container->isBitmap()) {
+            return container->words[local];
+        }
+        std::uint16_t first = static_cast<std::uint16_t>(local * 64);
+        std::uint64_t bits = 0;
+        for (auto it = std::lower_bound(container->values.begin(), container->values.end(), first);
+             it != container->values.end() && (*it >> 6) == local; ++it) {
+            bits |= std::uint64_t(1) << (*it & 63);
+        }
+        return bits;
+    }
+
+    /**
+     * @brief Добавить все дескрипторы слова
+     * @param index Номер слова (дескрипторы 64 * index + бит)
+     * @param bits Маска дескрипторов
+     */
+    void addWord(std::size_t index, std::uint64_t bits) {
+        if (bits == 0) {
+            return;
+        }
+        Container& container = findOrInsert(static_cast<std::uint32_t>(index / CONTAINER_WORDS));
+        std::size_t local = index % CONTAINER_WORDS;
+        if (!container.isBitmap() && container.values.size() + std::popcount(bits) > ARRAY_LIMIT) {
+            toBitmap(container);
+        }
+        std::size_t before = container.cardinality;
+        if (container.isBitmap()) {
+            std::uint64_t& word = container.words[local];
+            container.cardinality += std::popcount(bits & ~word);
+            word |= bits;
+        } else {
+            for (; bits; bits &= bits - 1) {
+                std::uint16_t low = static_cast<std::uint16_t>(local * 64 + std::countr_zero(bits));
+                auto found = std::lower_bound(container.values.begin(), container.values.end(), low);
+                if (found == container.values.end() || *found != low) {
+                    container.values.insert(found, low);
+                    container.cardinality++;
+                }
+            }
+        }
+        count += container.cardinality - before;
+    }
+
+    /**
+     * @brief Вызвать function(index, bits) для каждого непустого слова по возрастанию index
+     */
+    template <class Function>
+    void forEachWord(Function function) const {
+        for (const Container& container : containers) {
+            std::size_t base = static_cast<std::size_t>(container.key) * CONTAINER_WORDS;
+            if (container.isBitmap()) {
+                for (std::size_t w = 0; w < CONTAINER_WORDS; w++) {
+                    if (container.words[w]) {
+                        function(base + w, container.words[w]);
+                    }
+                }
+                continue;
+            }
+            std::size_t current = 0;
+            std::uint64_t bits = 0;
+            for (std::uint16_t low : container.values) {
+                std::size_t w = low >> 6;
+                if (bits && w != current) {
+                    function(base + current, bits);
+                    bits = 0;
+                }
+                current = w;
+                bits |= std::uint64_t(1) << (low & 63);
+            }
+            if (bits) {
+                function(base + current, bits);
+            }
+        }
+    }
+
+    /**
+     * @brief Вызвать function(handle) для каждого дескриптора по возрастанию
+     */
+    template <class Function>
+    void forEach(Function function) const {
+        forEachWord([&](std::size_t index, std::uint64_t bits) {
+            for (; bits; bits &= bits - 1) {
+                function(static_cast<DeviceHandle>(index * 64 + std::countr_zero(bits)));
+            }
+        });
+    }
+
+    /**
+     * @brief Объединение
+     */
+    HandleBitmap& operator|=(const HandleBitmap& other) {
+        other.forEachWord([this](std::size_t index, std::uint64_t bits) { addWord(index, bits); });
+        return *this;
+    }
+
+    /**
+     * @brief Пересечение
+     */
+    HandleBitmap& operator&=(const HandleBitmap& other) {
+        HandleBitmap result;
+        forEachWord([&](std::size_t index, std::uint64_t bits) { result.addWord(index, bits & other.word(index)); });
+        return *this = std::move(result);
+    }
+
+    /**
+     * @brief Разность: убрать дескрипторы other
+     */
+    HandleBitmap& operator-=(const HandleBitmap& other) {
+        HandleBitmap result;
+        forEachWord([&](std::size_t index, std::uint64_t bits) { result.addWord(index, bits & ~other.word(index)); });
+        return *this = std::move(result);
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void clear() {
+        containers.clear();
+        count = 0;
+    }
+
+    /**
+     * @brief Память контейнеров (байт)
+     */
+    std::size_t bytes() const {
+        std::size_t total = containers.capacity() * sizeof(Container);
+        for (const Container& container : containers) {
+            total += container.values.capacity() * sizeof(std::uint16_t) +
+                     container.words.capacity() * sizeof(std::uint64_t);
+        }
+        return total;
+    }
+};
+
+#endif // HANDLE_BITMAP_HPP
@@ -0,0 +1,974 @@
+/**
+ * @file inventory_loader.hpp
+ * @brief Массовая загрузка устройств из инвентарной выгрузки CSV/JSON
+ *
+ * @details
+ * Форматы:
+ * - CSV: первая строка - заголовок с названиями столбцов, поля через
+ *   запятую, значения в кавычках "..." с удвоенной кавычкой внутри;
+ *   перевод строки внутри кавычек допустим, пробелы вокруг полей
+ *   отбрасываются
+ * - JSON: массив плоских объектов или объекты по одному на строку
+ *   (JSON Lines); значения - строки, числа или null
+ *
+ * Поля (столбцы CSV и ключи JSON): kind (LightBulb, Thermostat,
+ * SmartOutlet, без учета регистра), id, name, power - обязательные;
+ * brightness и color лампочки, temperature термостата, maxCurrent и
+ * location розетки - необязательные, по умолчанию как у конструкторов.
+ * Прочие столбцы и ключи пропускаются.
+ *
+ * Загрузка идет в три прохода:
+ * 1. Границы записей: файл отображается в память и просматривается
+ *    блоками по 64 байта; маски кавычек, разделителей ('\n' для CSV, '}'
+ *    для JSON) и обратных косых черт строятся сравнением SSE2/AVX2
+ *    (скалярный вариант на прочих платформах), признак "внутри строки"
+ *    - префиксный XOR маски кавычек с переносом между блоками.
+ * 2. Разбор и проверка записей - параллельно порциями в FleetExecutor:
+ *    числа через std::from_chars, строки без экранирования - string_view
+ *    в отображение файла. Проверка - по правилам конструкторов
+ *    (PoweredDevice::checkPower(), LightBulb::checkBrightness()) без
+ *    исключений; отклоненная запись попадает в отчет с номером строки.
+ *    Повторы ID (в файле и среди живых устройств) и места для новых
+ *    цветов лампочек в ColorPalette проверяются после параллельной части
+ *    последовательным просмотром.
+ * 3. Создание устройств в DeviceArena за один проход с заранее
+ *    зарезервированными колонками DeviceRegistry.
+ *
+ * @code
+ * DeviceArena arena(1 << 20);
+ * FleetExecutor executor;
+ * InventoryLoader loader(executor);
+ * InventoryReport report = loader.load("inventory.csv", arena);
+ * for (const InventoryReject& reject : report.rejected) {
+ *     std::cerr << reject.line << ": " << inventoryIssueMessage(reject.issue) << "\n";
+ * }
+ * @endcode
+ *
+ * @note Третий проход последовательный: регистрация в реестре и
+ *       интернирование строк не потокобезопасны.
+ */
+
+#ifndef INVENTORY_LOADER_HPP
+#define INVENTORY_LOADER_HPP
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "color_palette.hpp"
+#include "device_arena.hpp"
+#include "device_registry.hpp"
+#include "fleet_executor.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @brief Формат инвентарного файла
+ */
+enum class InventoryFormat : std::uint8_t {
+    AUTO = 0,                   ///< JSON, если файл начинается с '[' или '{', иначе CSV
+    CSV = 1,
+    JSON = 2
+};
+
+/**
+ * @brief Причина отклонения записи
+ */
+enum class InventoryIssue : std::uint8_t {
+    NONE = 0,                   ///< Запись принята
+    SYNTAX,                     ///< Нарушен синтаксис записи
+    UNKNOWN_KIND,               ///< Неизвестный тип устройства
+    MISSING_FIELD,              ///< Нет обязательного поля
+    INVALID_NUMBER,             ///< Значение поля - не число
+    INVALID_POWER,              ///< Мощность не положительна (как у конструктора)
+    INVALID_BRIGHTNESS,         ///< Яркость вне диапазона 0-100 (как у конструктора)
+    PALETTE_FULL,               ///< Нового цвета лампочки нет места в ColorPalette
+    DUPLICATE_ID                ///< ID уже встречался в инвентаре или занят живым устройством
+};
+
+/**
+ * @brief Текст причины отклонения
+ */
+inline const char* inventoryIssueMessage(InventoryIssue issue) {
+    switch (issue) {
+        case InventoryIssue::NONE: return "";
+        case InventoryIssue::SYNTAX: return "Oshibka sintaksisa zapisi";
+        case InventoryIssue::UNKNOWN_KIND: return "Neizvestnyy tip ustroystva";
+        case InventoryIssue::MISSING_FIELD: return "Net obyazatel'nogo polya (kind, id, name, power)";
+        case InventoryIssue::INVALID_NUMBER: return "Znachenie polya ne chislo";
+        case InventoryIssue::INVALID_POWER: return deviceErrorMessage(DeviceError::INVALID_POWER);
+        case InventoryIssue::INVALID_BRIGHTNESS: return deviceErrorMessage(DeviceError::INVALID_BRIGHTNESS);
+        case InventoryIssue::PALETTE_FULL: return deviceErrorMessage(DeviceError::PALETTE_FULL);
+        case InventoryIssue::DUPLICATE_ID: return "Povtornyy ID ustroystva";
+    }
+    return "";
+}
+
+/**
+ * @struct InventoryReject
+ * @brief Отклоненная запись
+ */
+struct InventoryReject {
+    std::size_t line;           ///< Номер строки начала записи (с 1)
+    InventoryIssue issue;       ///< Причина
+};
+
+/**
+ * @struct InventoryReport
+ * @brief Итог загрузки
+ */
+struct InventoryReport {
+    std::size_t loaded = 0;                     ///< Создано устройств
+    std::vector<InventoryReject> rejected;      ///< Отклоненные записи по возрастанию строки
+};
+
+/**
+ * @class InventoryLoader
+ * @brief Параллельный разбор инвентарного файла и создание устройств
+ */
+class InventoryLoader {
+private:
+    /**
+     * @brief Поле записи
+     */
+    enum Field : std::uint8_t {
+        KIND = 0,
+        ID,
+        NAME,
+        POWER,
+        BRIGHTNESS,
+        COLOR,
+        TEMPERATURE,
+        MAX_CURRENT,
+        LOCATION,
+        FIELD_COUNT,
+        IGNORED = 0xFF
+    };
+
+    /**
+     * @brief Разобранная и проверенная запись
+     * @details label - цвет лампочки или расположение розетки,
+     *          parameter - температура термостата или предельный ток розетки
+     */
+    struct Row {
+        std::string_view id;
+        std::string_view name;
+        std::string_view label;
+        double power;
+        double parameter;
+        std::size_t offset;         ///< Смещение начала записи в тексте
+        int brightness;
+        DeviceKind kind;
+        InventoryIssue issue;
+        bool skip;                  ///< Пустая строка CSV или хвост JSON
+    };
+
+    /**
+     * @brief Сырые значения полей одной записи
+     */
+    struct Values {
+        std::string_view text[FIELD_COUNT];
+        std::uint16_t present = 0;
+
+        void set(std::uint8_t field, std::string_view value) {
+            if (field < FIELD_COUNT) {
+                text[field] = value;
+                present |= static_cast<std::uint16_t>(1u << field);
+            }
+        }
+
+        bool has(Field field) const { return present & (1u << field); }
+    };
+
+    typedef std::deque<std::string> Scratch;    ///< Строки после снятия экранирования (адреса стабильны)
+
+    FleetExecutor& executor;
+
+    /**
+     * @brief Маска позиций байта c в блоке из 64 байт
+     */
+    static std::uint64_t maskOf(const char* block, char c) {
+#if defined(__AVX2__)
+        __m256i needle = _mm256_set1_epi8(c);
+        std::uint32_t low = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), needle)));
+        std::uint32_t high = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32)), needle)));
+        return static_cast<std::uint64_t>(low) | (static_cast<std::uint64_t>(high) << 32);
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128i needle = _mm_set1_epi8(c);
+        std::uint64_t mask = 0;
+        for (int part = 0; part < 4; part++) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + part * 16));
+            mask |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(
+                        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle))))
+                    << (part * 16);
+        }
+        return mask;
+#else
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 64; i++) {
+            mask |= static_cast<std::uint64_t>(block[i] == c) << i;
+        }
+        return mask;
+#endif
+    }
+
+    /**
+     * @brief Бит i результата - четность числа единиц в битах 0..i
+     */
+    static std::uint64_t prefixXor(std::uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    /**
+     * @brief Позиции, экранированные обратной косой чертой (JSON)
+     * @param backslashes Маска '\\' блока
+     * @param carry Последний байт предыдущего блока - неснятый '\\'
+     */
+    static std::uint64_t escapedBy(std::uint64_t backslashes, bool& carry) {
+        std::uint64_t escaped = 0;
+        for (int i = 0; i < 64; i++) {
+            if (carry) {
+                escaped |= std::uint64_t(1) << i;
+                carry = false;
+            } else if ((backslashes >> i) & 1) {
+                carry = true;
+            }
+        }
+        return escaped;
+    }
+
+    /**
+     * @brief Проход 1: позиции разделителей записей вне строк
+     */
+    static void findRecordEnds(std::string_view text, bool json, std::vector<std::size_t>& ends) {
+        const char delimiter = json ? '}' : '\n';
+        bool inString = false;
+        bool escapeCarry = false;
+        char padded[64];
+        for (std::size_t position = 0; position < text.size(); position += 64) {
+            const char* block = text.data() + position;
+            if (text.size() - position < 64) {
+                std::memset(padded, ' ', sizeof(padded));
+                std::memcpy(padded, block, text.size() - position);
+                block = padded;
+            }
+            std::uint64_t quotes = maskOf(block, '"');
+            std::uint64_t delimiters = maskOf(block, delimiter);
+            if (json) {
+                std::uint64_t backslashes = maskOf(block, '\\');
+                if (backslashes || escapeCarry) {
+                    quotes &= ~escapedBy(backslashes, escapeCarry);
+                }
+            }
+            std::uint64_t inside = prefixXor(quotes) ^ (inString ? ~std::uint64_t(0) : 0);
+            inString = (inside >> 63) & 1;
+            for (std::uint64_t found = delimiters & ~inside; found; found &= found - 1) {
+                ends.push_back(position + static_cast<std::size_t>(std::countr_zero(found)));
+            }
+        }
+    }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    static bool equalsIgnoreCase(std::string_view text, std::string_view expected) {
+        if (text.size() != expected.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+            if (c != expected[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::uint8_t fieldOf(std::string_view name) {
+        static const char* const names[FIELD_COUNT] = {"kind", "id", "name", "power", "brightness",
+                                                       "color", "temperature", "maxcurrent", "location"};
+        for (std::uint8_t f = 0; f < FIELD_COUNT; f++) {
+            if (equalsIgnoreCase(name, names[f])) {
+                return f;
+            }
+        }
+        return IGNORED;
+    }
+
+    static bool parseDouble(std::string_view text, double& value) {
+        const char* end = text.data() + text.size();
+        std::from_chars_result result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    static bool parseInt(std::string_view text, int& value) {
+        const char* end = text.data() + text.size();
+        std::from_chars_result result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    /**
+     * @brief Собрать запись из значений полей и проверить ее
+     */
+    static void finish(const Values& values, Row& row) {
+        row.issue = InventoryIssue::NONE;
+        if (!values.has(KIND) || !values.has(ID) || !values.has(NAME) || !values.has(POWER) ||
+            values.text[ID].empty() || values.text[POWER].empty()) {
+            row.issue = InventoryIssue::MISSING_FIELD;
+            return;
+        }
+        std::string_view kind = values.text[KIND];
+        if (equalsIgnoreCase(kind, "lightbulb")) {
+            row.kind = DeviceKind::LIGHT_BULB;
+        } else if (equalsIgnoreCase(kind, "thermostat")) {
+            row.kind = DeviceKind::THERMOSTAT;
+        } else if (equalsIgnoreCase(kind, "smartoutlet")) {
+            row.kind = DeviceKind::SMART_OUTLET;
+        } else {
+            row.issue = InventoryIssue::UNKNOWN_KIND;
+            return;
+        }
+        row.id = values.text[ID];
+        row.name = values.text[NAME];
+        if (!parseDouble(values.text[POWER], row.power)) {
+            row.issue = InventoryIssue::INVALID_NUMBER;
+            return;
+        }
+
+        // Необязательные поля по умолчанию - как у конструкторов
+        bool numbers = true;
+        switch (row.kind) {
+            case DeviceKind::LIGHT_BULB:
+                row.brightness = 100;
+                row.label = "teplyy belyy";
+                if (values.has(BRIGHTNESS) && !values.text[BRIGHTNESS].empty()) {
+                    numbers = parseInt(values.text[BRIGHTNESS], row.brightness);
+                }
+                if (values.has(COLOR) && !values.text[COLOR].empty()) {
+                    row.label = values.text[COLOR];
+                }
+                break;
+            case DeviceKind::THERMOSTAT:
+                row.parameter = 20.0;
+                if (values.has(TEMPERATURE) && !values.text[TEMPERATURE].empty()) {
+                    numbers = parseDouble(values.text[TEMPERATURE], row.parameter);
+                }
+                break;
+            default:
+                row.parameter = 16.0;
+                row.label = "gostinaya";
+                if (values.has(MAX_CURRENT) && !values.text[MAX_CURRENT].empty()) {
+                    numbers = parseDouble(values.text[MAX_CURRENT], row.parameter);
+                }
+                if (values.has(LOCATION) && !values.text[LOCATION].empty()) {
+                    row.label = values.text[LOCATION];
+                }
+                break;
+        }
+        if (!numbers) {
+            row.issue = InventoryIssue::INVALID_NUMBER;
+        } else if (PoweredDevice::checkPower(row.power) != DeviceError::NONE) {
+            row.issue = InventoryIssue::INVALID_POWER;
+        } else if (row.kind == DeviceKind::LIGHT_BULB &&
+                   LightBulb::checkBrightness(row.brightness) != DeviceError::NONE) {
+            row.issue = InventoryIssue::INVALID_BRIGHTNESS;
+        }
+    }
+
+    /**
+     * @brief Следующее поле CSV начиная с position
+     * @return false если запись синтаксически неверна
+     * @details Пробелы и табуляции вокруг поля отбрасываются ("LightBulb, L1");
+     *          внутри кавычек сохраняются
+     * @post position - за запятой после поля или text.size()
+     */
+    static bool nextCsvField(std::string_view text, std::size_t& position, std::string_view& value,
+                             Scratch& scratch) {
+        position = skipBlanks(text, position);
+        if (position < text.size() && text[position] == '"') {
+            std::size_t start = ++position;
+            bool doubled = false;
+            for (;;) {
+                std::size_t quote = text.find('"', position);
+                if (quote == std::string_view::npos) {
+                    return false;
+                }
+                if (quote + 1 < text.size() && text[quote + 1] == '"') {
+                    doubled = true;
+                    position = quote + 2;
+                    continue;
+                }
+                value = text.substr(start, quote - start);
+                position = quote + 1;
+                break;
+            }
+            if (doubled) {
+                std::string& unescaped = scratch.emplace_back();
+                for (std::size_t i = 0; i < value.size(); i++) {
+                    unescaped.push_back(value[i]);
+                    if (value[i] == '"') {
+                        i++;
+                    }
+                }
+                value = unescaped;
+            }
+            position = skipBlanks(text, position);
+            if (position < text.size() && text[position] != ',') {
+                return false;
+            }
+        } else {
+            std::size_t comma = text.find(',', position);
+            std::size_t end = comma == std::string_view::npos ? text.size() : comma;
+            value = text.substr(position, end - position);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+                value.remove_suffix(1);
+            }
+            position = end;
+        }
+        if (position < text.size()) {
+            position++;
+        }
+        return true;
+    }
+
+    static std::size_t skipBlanks(std::string_view text, std::size_t position) {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\t')) {
+            position++;
+        }
+        return position;
+    }
+
+    static std::string_view stripLine(std::string_view line) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    static void parseCsvRow(std::string_view line, const std::vector<std::uint8_t>& columns, Row& row,
+                            Scratch& scratch) {
+        line = stripLine(line);
+        if (line.find_first_not_of(" \t") == std::string_view::npos) {
+            row.skip = true;
+            return;
+        }
+        Values values;
+        std::size_t position = 0;
+        for (std::size_t column = 0; column < columns.size() && position < line.size(); column++) {
+            std::string_view value;
+            if (!nextCsvField(line, position, value, scratch)) {
+                row.issue = InventoryIssue::SYNTAX;
+                return;
+            }
+            values.set(columns[column], value);
+        }
+        finish(values, row);
+    }
+
+    static void appendCodePoint(std::string& out, std::uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    static bool parseHex4(std::string_view text, std::size_t position, std::uint32_t& code) {
+        if (position + 4 > text.size()) {
+            return false;
+        }
+        const char* begin = text.data() + position;
+        std::from_chars_result result = std::from_chars(begin, begin + 4, code, 16);
+        return result.ec == std::errc() && result.ptr == begin + 4;
+    }
+
+    /**
+     * @brief Строка JSON, position указывает на открывающую кавычку
+     * @post position - за закрывающей кавычкой
+     */
+    static bool parseJsonString(std::string_view text, std::size_t& position, std::string_view& value,
+                                Scratch& scratch) {
+        std::size_t start = ++position;
+        std::size_t end = start;
+        while (end < text.size() && text[end] != '"' && text[end] != '\\') {
+            end++;
+        }
+        if (end < text.size() && text[end] == '"') {
+            value = text.substr(start, end - start);
+            position = end + 1;
+            return true;
+        }
+        std::string& out = scratch.emplace_back(text.substr(start, end - start));
+        for (position = end; position < text.size(); position++) {
+            char c = text[position];
+            if (c == '"') {
+                value = out;
+                position++;
+                return true;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (++position >= text.size()) {
+                return false;
+            }
+            switch (text[position]) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    std::uint32_t code;
+                    if (!parseHex4(text, position + 1, code)) {
+                        return false;
+                    }
+                    position += 4;
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        std::uint32_t low;
+                        if (position + 2 >= text.size() || text[position + 1] != '\\' || text[position + 2] != 'u' ||
+                            !parseHex4(text, position + 3, low) || low < 0xDC00 || low >= 0xE000) {
+                            return false;
+                        }
+                        position += 6;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendCodePoint(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    static void skipSpaces(std::string_view text, std::size_t& position) {
+        while (position < text.size() && isSpace(text[position])) {
+            position++;
+        }
+    }
+
+    /**
+     * @brief Объект JSON в отрезке text, заканчивающемся '}'
+     * @details Перед '{' допускаются пробелы, запятая и '[' массива
+     */
+    static void parseJsonRecord(std::string_view text, Row& row, Scratch& scratch) {
+        std::size_t position = 0;
+        while (position < text.size() && (isSpace(text[position]) || text[position] == ',' || text[position] == '[')) {
+            position++;
+        }
+        if (position == text.size() || (text[position] == ']' && text.find_first_not_of(" \t\r\n", position + 1) ==
+                                                                     std::string_view::npos)) {
+            row.skip = true;
+            return;
+        }
+        row.offset += position;
+        if (text[position] != '{') {
+            row.issue = InventoryIssue::SYNTAX;
+            return;
+        }
+        position++;
+        Values values;
+        skipSpaces(text, position);
+        if (position < text.size() && text[position] == '}') {
+            finish(values, row);
+            return;
+        }
+        for (;;) {
+            std::string_view key;
+            std::string_view value;
+            skipSpaces(text, position);
+            if (position >= text.size() || text[position] != '"' || !parseJsonString(text, position, key, scratch)) {
+                row.issue = InventoryIssue::SYNTAX;
+                return;
+            }
+            skipSpaces(text, position);
+            if (position >= text.size() || text[position] != ':') {
+                row.issue = InventoryIssue::SYNTAX;
+                return;
+            }
+            position++;
+            skipSpaces(text, position);
+            if (position >= text.size()) {
+                row.issue = InventoryIssue::SYNTAX;
+                return;
+            }
+            bool present = true;
+            if (text[position] == '"') {
+                if (!parseJsonString(text, position, value, scratch)) {
+                    row.issue = InventoryIssue::SYNTAX;
+                    return;
+                }
+            } else if (text[position] == '{' || text[position] == '[') {
+                row.issue = InventoryIssue::SYNTAX;     // Вложенные значения не поддерживаются
+                return;
+            } else {
+                std::size_t start = position;
+                while (position < text.size() && text[position] != ',' && text[position] != '}' &&
+                       !isSpace(text[position])) {
+                    position++;
+                }
+                value = text.substr(start, position - start);
+                present = value != "null";
+            }
+            if (present) {
+                values.set(fieldOf(key), value);
+            }
+            skipSpaces(text, position);
+            if (position < text.size() && text[position] == ',') {
+                position++;
+                continue;
+            }
+            if (position + 1 == text.size() && text[position] == '}') {
+                break;
+            }
+            row.issue = InventoryIssue::SYNTAX;
+            return;
+        }
+        finish(values, row);
+    }
+
+    /**
+     * @brief Отклонить записи с повторным ID
+     * @details Первая запись с ID принимается, следующие отклоняются; ID
+     *          живого устройства из реестра занят для всех записей
+     */
+    static void checkIds(std::vector<Row>& rows) {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        std::unordered_set<std::string_view> seen;
+        for (Row& row : rows) {
+            if (row.skip || row.issue != InventoryIssue::NONE) {
+                continue;
+            }
+            if (reg.findHandle(row.id) != INVALID_DEVICE_HANDLE || !seen.insert(row.id).second) {
+                row.issue = InventoryIssue::DUPLICATE_ID;
+            }
+        }
+    }
+
+    /**
+     * @brief Отклонить лампочки, новым цветам которых не хватит места в ColorPalette
+     * @details Последовательное завершение прохода 2: места считаются по
+     *          всем принятым записям, поэтому проход 3 не бросает на середине
+     */
+    static void checkPalette(std::vector<Row>& rows) {
+        const ColorPalette& palette = ColorPalette::instance();
+        std::unordered_set<std::string_view> fresh;
+        for (Row& row : rows) {
+            if (row.skip || row.issue != InventoryIssue::NONE || row.kind != DeviceKind::LIGHT_BULB ||
+                palette.contains(row.label) || fresh.count(row.label)) {
+                continue;
+            }
+            if (palette.size() + fresh.size() >= ColorPalette::CAPACITY) {
+                row.issue = InventoryIssue::PALETTE_FULL;
+            } else {
+                fresh.insert(row.label);
+            }
+        }
+    }
+
+    /**
+     * @brief Номера строк для отклоненных записей одним проходом по тексту
+     */
+    static void numberLines(std::string_view text, const std::vector<Row>& rows, InventoryReport& report) {
+        std::size_t line = 1;
+        std::size_t scanned = 0;
+        for (const Row& row : rows) {
+            if (row.skip || row.issue == InventoryIssue::NONE) {
+                continue;
+            }
+            line += static_cast<std::size_t>(std::count(text.begin() + scanned, text.begin() + row.offset, '\n'));
+            scanned = row.offset;
+            report.rejected.push_back(InventoryReject{line, row.issue});
+        }
+    }
+
+    /**
+     * @brief Проход 3: создать устройства принятых записей
+     */
+    static std::size_t create(const std::vector<Row>& rows, DeviceArena& arena, std::vector<SmartDevice*>* created) {
+        std::size_t valid = 0;
+        for (const Row& row : rows) {
+            valid += !row.skip && row.issue == InventoryIssue::NONE;
+        }
+        DeviceRegistry::instance().reserve(DeviceRegistry::instance().capacity() + valid);
+        if (created) {
+            created->reserve(created->size() + valid);
+        }
+
+        std::string id;
+        std::string name;
+        std::string label;
+        for (const Row& row : rows) {
+            if (row.skip || row.issue != InventoryIssue::NONE) {
+                continue;
+            }
+            id.assign(row.id);
+            name.assign(row.name);
+            SmartDevice* device;
+            switch (row.kind) {
+                case DeviceKind::LIGHT_BULB:
+                    label.assign(row.label);
+                    device = arena.make<LightBulb>(id, name, row.power, row.brightness, label);
+                    break;
+                case DeviceKind::THERMOSTAT:
+                    device = arena.make<Thermostat>(id, name, row.power, row.parameter);
+                    break;
+                default:
+                    label.assign(row.label);
+                    device = arena.make<SmartOutlet>(id, name, row.power, row.parameter, label);
+                    break;
+            }
+            if (created) {
+                created->push_back(device);
+            }
+        }
+        return valid;
+    }
+
+    /**
+     * @class MappedText
+     * @brief Файл, отображенный в память только для чтения
+     */
+    class MappedText {
+    private:
+#ifdef _WIN32
+        HANDLE file;
+        HANDLE mapping;
+#else
+        int file;
+#endif
+        const char* view;
+        std::size_t viewSize;
+
+    public:
+        explicit MappedText(const std::string& path) : view(nullptr), viewSize(0) {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error("Ne udalos' otkryt' fayl inventarya: " + path);
+            }
+            LARGE_INTEGER existing;
+            GetFileSizeEx(file, &existing);
+            viewSize = static_cast<std::size_t>(existing.QuadPart);
+            mapping = nullptr;
+            if (viewSize == 0) {
+                return;
+            }
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            view = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, viewSize)) : nullptr;
+            if (!view) {
+                if (mapping) {
+                    CloseHandle(mapping);
+                }
+                CloseHandle(file);
+                throw std::runtime_error("Ne udalos' otobrazit' fayl inventarya: " + path);
+            }
+#else
+            file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0) {
+                throw std::runtime_error("Ne udalos' otkryt' fayl inventarya: " + path);
+            }
+            struct stat info;
+            fstat(file, &info);
+            viewSize = static_cast<std::size_t>(info.st_size);
+            if (viewSize == 0) {
+                return;
+            }
+            void* address = mmap(nullptr, viewSize, PROT_READ, MAP_PRIVATE, file, 0);
+            if (address == MAP_FAILED) {
+                ::close(file);
+                throw std::runtime_error("Ne udalos' otobrazit' fayl inventarya: " + path);
+            }
+            madvise(address, viewSize, MADV_SEQUENTIAL);
+            view = static_cast<const char*>(address);
+#endif
+        }
+
+        ~MappedText() {
+#ifdef _WIN32
+            if (view) {
+                UnmapViewOfFile(view);
+            }
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+#else
+            if (view) {
+                munmap(const_cast<char*>(view), viewSize);
+            }
+            ::close(file);
+#endif
+        }
+
+        MappedText(const MappedText&) = delete;
+        MappedText& operator=(const MappedText&) = delete;
+
+        std::string_view text() const { return std::string_view(view, viewSize); }
+    };
+
+public:
+    /**
+     * @param executor Пул потоков для разбора записей
+     */
+    explicit InventoryLoader(FleetExecutor& executor) : executor(executor) {}
+
+    /**
+     * @brief Загрузить инвентарный файл
+     * @param path Путь к файлу
+     * @param arena Арена, которая будет владеть устройствами
+     * @param format Формат файла
+     * @param created Если не nullptr - сюда дописываются созданные устройства в порядке файла
+     * @return Количество созданных устройств и отклоненные записи
+     * @throws std::runtime_error при ошибке ввода-вывода или если в заголовке
+     *         CSV нет обязательного столбца
+     */
+    InventoryReport load(const std::string& path, DeviceArena& arena,
+                         InventoryFormat format = InventoryFormat::AUTO,
+                         std::vector<SmartDevice*>* created = nullptr) {
+        MappedText mapped(path);
+        return loadText(mapped.text(), arena, format, created);
+    }
+
+    /**
+     * @brief Загрузить инвентарь из текста в памяти
+     * @see load()
+     */
+    InventoryReport loadText(std::string_view text, DeviceArena& arena,
+                             InventoryFormat format = InventoryFormat::AUTO,
+                             std::vector<SmartDevice*>* created = nullptr) {
+        InventoryReport report;
+        if (format == InventoryFormat::AUTO) {
+            std::size_t first = text.find_first_not_of(" \t\r\n");
+            format = first != std::string_view::npos && (text[first] == '[' || text[first] == '{')
+                         ? InventoryFormat::JSON
+                         : InventoryFormat::CSV;
+        }
+        bool json = format == InventoryFormat::JSON;
+
+        std::vector<std::size_t> ends;
+        ends.reserve(text.size() / 64 + 1);
+        findRecordEnds(text, json, ends);
+
+        // Отрезки записей: CSV - без '\n', JSON - вместе с '}'
+        std::vector<std::size_t> starts;
+        starts.reserve(ends.size() + 1);
+        starts.push_back(0);
+        for (std::size_t end : ends) {
+            starts.push_back(end + 1);
+        }
+        if (!json || ends.empty() || ends.back() + 1 < text.size()) {
+            ends.push_back(text.size());        // Хвост: строка без '\n' или текст после '}'
+        } else {
+            starts.pop_back();
+        }
+
+        std::vector<std::uint8_t> columns;
+        std::size_t first = 0;
+        if (!json) {
+            if (ends.empty() || starts[0] >= text.size()) {
+                return report;
+            }
+            Scratch header;
+            std::string_view line = stripLine(text.substr(0, ends[0]));
+            std::uint16_t seen = 0;
+            for (std::size_t position = 0; position < line.size();) {
+                std::string_view name;
+                if (!nextCsvField(line, position, name, header)) {
+                    throw std::runtime_error("Oshibka v zagolovke inventarya");
+                }
+                std::uint8_t field = fieldOf(name);
+                columns.push_back(field);
+                if (field < FIELD_COUNT) {
+                    seen |= static_cast<std::uint16_t>(1u << field);
+                }
+            }
+            const char* required[] = {"kind", "id", "name", "power"};
+            for (int f = KIND; f <= POWER; f++) {
+                if (!(seen & (1u << f))) {
+                    throw std::runtime_error(std::string("V zagolovke inventarya net stolbtsa: ") + required[f]);
+                }
+            }
+            first = 1;
+        }
+
+        std::size_t count = ends.size() - first;
+        std::vector<Row> rows(count);
+        std::vector<Scratch> scratch(executor.size());
+        executor.parallelFor(count, 4096, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+            for (std::size_t i = begin; i < end; i++) {
+                std::size_t record = i + first;
+                Row& row = rows[i];
+                row.offset = starts[record];
+                row.issue = InventoryIssue::NONE;
+                row.skip = false;
+                std::size_t length = ends[record] - starts[record] + (json && ends[record] < text.size());
+                std::string_view segment = text.substr(starts[record], length);
+                if (json) {
+                    parseJsonRecord(segment, row, scratch[worker]);
+                } else {
+                    parseCsvRow(segment, columns, row, scratch[worker]);
+                }
+            }
+        });
+
+        checkIds(rows);
+        checkPalette(rows);
+        numberLines(text, rows, report);
+        report.loaded = create(rows, arena, created);
+        return report;
+    }
+};
+
+#endif // INVENTORY_LOADER_HPP
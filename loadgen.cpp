@@ -0,0 +1,443 @@
+/**
+ * @file loadgen.cpp
+ * @brief Неинтерактивный генератор нагрузки на иерархию smart_devices.hpp
+ *
+ * @details
+ * Не использует std::cin и windows.h, собирается отдельно:
+ *
+ *     g++ -std=c++20 -O2 -pthread loadgen.cpp smart_devices.cpp -o loadgen
+ *
+ * Запуск:
+ *
+ *     loadgen [файл-описания] [ключ=значение ...]
+ *     loadgen list
+ *
+ * Описание нагрузки - строки "ключ = значение" (# - комментарий);
+ * аргументы командной строки переопределяют файл:
+ * - devices   - размер парка (по умолчанию 10000)
+ * - mix       - доли лампочек:термостатов:розеток (1:1:1)
+ * - rate      - команд в секунду на все потоки, 0 - без ограничения (100000)
+ * - duty      - доля включений среди команд вкл/выкл, она же доля
+ *               включенных устройств в установившемся режиме (0.5)
+ * - settings  - доля команд-настроек: яркость, температура, розетка (0.2)
+ * - threads   - количество потоков (1)
+ * - duration  - длительность замера, с (5)
+ * - seed      - начальное значение генератора (1)
+ * - scenario  - сценарии demo_scenarios.hpp через запятую, выполняются
+ *               до нагрузки; при devices=0 выполняются только они
+ *
+ * Каждый поток владеет своей частью парка (устройства i % threads) и
+ * выдает команды по расписанию с постоянным интервалом threads / rate.
+ * Ожидание до момента команды - sleep_until() с запасом и досчет в
+ * активном цикле. Задержка отсчитывается от запланированного момента, а
+ * не от фактического начала команды, поэтому отставание генератора
+ * попадает в p99/p999, а не скрывается (coordinated omission); время
+ * выполнения самой команды выводится отдельно.
+ *
+ * @note Гистограммы - логарифмически-линейные, 32 корзины на степень
+ *       двойки наносекунд (относительная ошибка не более 3.2%).
+ */
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "smart_devices.hpp"
+#include "demo_scenarios.hpp"
+#include "device_arena.hpp"
+#include "device_visit.hpp"
+
+/**
+ * @struct WorkloadSpec
+ * @brief Описание нагрузки
+ */
+struct WorkloadSpec {
+    std::size_t devices = 10000;            ///< Размер парка
+    double mix[3] = {1.0, 1.0, 1.0};        ///< Доли лампочек, термостатов, розеток
+    double rate = 100000.0;                 ///< Команд в секунду (0 - без ограничения)
+    double duty = 0.5;                      ///< Доля включений среди команд вкл/выкл
+    double settings = 0.2;                  ///< Доля команд-настроек
+    std::size_t threads = 1;                ///< Потоков
+    double duration = 5.0;                  ///< Длительность замера (с)
+    std::uint64_t seed = 1;                 ///< Начальное значение генератора
+    std::vector<std::string> scenarios;     ///< Сценарии demo_scenarios.hpp
+};
+
+static std::string trim(const std::string& text) {
+    std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+static std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::size_t begin = 0;
+    for (;;) {
+        std::size_t end = text.find(separator, begin);
+        parts.push_back(trim(text.substr(begin, end - begin)));
+        if (end == std::string::npos) {
+            return parts;
+        }
+        begin = end + 1;
+    }
+}
+
+static double parseNumber(const std::string& key, const std::string& value, double low, double high) {
+    std::size_t used = 0;
+    double number = 0.0;
+    try {
+        number = std::stod(value, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != value.size() || number < low || number > high) {
+        throw std::invalid_argument("Nedopustimoe znachenie " + key + "=" + value);
+    }
+    return number;
+}
+
+/**
+ * @brief Применить одну пару ключ=значение
+ * @throws std::invalid_argument если ключ неизвестен или значение недопустимо
+ */
+static void applyOption(WorkloadSpec& spec, const std::string& key, const std::string& value) {
+    if (key == "devices") {
+        spec.devices = static_cast<std::size_t>(parseNumber(key, value, 0, 1e8));
+    } else if (key == "mix") {
+        std::vector<std::string> parts = split(value, ':');
+        if (parts.size() != 3) {
+            throw std::invalid_argument("mix zadaetsya kak lampochki:termostaty:rozetki");
+        }
+        for (std::size_t i = 0; i < 3; i++) {
+            spec.mix[i] = parseNumber(key, parts[i], 0, 1e9);
+        }
+        if (spec.mix[0] + spec.mix[1] + spec.mix[2] <= 0.0) {
+            throw std::invalid_argument("mix ne mozhet byt' nulevym");
+        }
+    } else if (key == "rate") {
+        spec.rate = parseNumber(key, value, 0, 1e10);
+    } else if (key == "duty") {
+        spec.duty = parseNumber(key, value, 0, 1);
+    } else if (key == "settings") {
+        spec.settings = parseNumber(key, value, 0, 1);
+    } else if (key == "threads") {
+        spec.threads = static_cast<std::size_t>(parseNumber(key, value, 1, 1024));
+    } else if (key == "duration") {
+        spec.duration = parseNumber(key, value, 0.001, 1e6);
+    } else if (key == "seed") {
+        spec.seed = static_cast<std::uint64_t>(parseNumber(key, value, 0, 1e18));
+    } else if (key == "scenario") {
+        for (const std::string& name : split(value, ',')) {
+            findDemoScenario(name);
+            spec.scenarios.push_back(name);
+        }
+    } else {
+        throw std::invalid_argument("Neizvestnyy klyuch: " + key);
+    }
+}
+
+static void applyLine(WorkloadSpec& spec, const std::string& line) {
+    std::string text = trim(line.substr(0, line.find('#')));
+    if (text.empty()) {
+        return;
+    }
+    std::size_t equals = text.find('=');
+    if (equals == std::string::npos) {
+        throw std::invalid_argument("Ozhidalos' klyuch=znachenie: " + text);
+    }
+    applyOption(spec, trim(text.substr(0, equals)), trim(text.substr(equals + 1)));
+}
+
+/**
+ * @brief Разобрать файл описания и аргументы командной строки
+ * @throws std::invalid_argument при ошибке в описании
+ * @throws std::runtime_error если файл не открывается
+ */
+static WorkloadSpec parseSpec(int argc, char** argv) {
+    WorkloadSpec spec;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument.find('=') != std::string::npos) {
+            applyLine(spec, argument);
+            continue;
+        }
+        std::ifstream in(argument);
+        if (!in) {
+            throw std::runtime_error("Ne udalos' otkryt' fayl opisaniya: " + argument);
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            applyLine(spec, line);
+        }
+    }
+    return spec;
+}
+
+/**
+ * @class LatencyHistogram
+ * @brief Гистограмма задержек с 32 корзинами на степень двойки
+ */
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr std::size_t SUB_COUNT = std::size_t(1) << SUB_BITS;
+    static constexpr std::size_t BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    std::vector<std::uint64_t> buckets;
+    std::uint64_t count;
+    std::uint64_t maximum;
+
+    static std::size_t bucketOf(std::uint64_t nanos) {
+        if (nanos < SUB_COUNT) {
+            return static_cast<std::size_t>(nanos);
+        }
+        int shift = 63 - std::countl_zero(nanos) - SUB_BITS;
+        return static_cast<std::size_t>(shift + 1) * SUB_COUNT +
+               static_cast<std::size_t>((nanos >> shift) & (SUB_COUNT - 1));
+    }
+
+    static std::uint64_t bucketUpperBound(std::size_t bucket) {
+        if (bucket < SUB_COUNT) {
+            return bucket;
+        }
+        std::size_t shift = bucket / SUB_COUNT - 1;
+        std::uint64_t next = SUB_COUNT + bucket % SUB_COUNT + 1;
+        return (next << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : buckets(BUCKET_COUNT, 0), count(0), maximum(0) {}
+
+    void record(std::uint64_t nanos) {
+        buckets[bucketOf(nanos)]++;
+        count++;
+        maximum = std::max(maximum, nanos);
+    }
+
+    LatencyHistogram& operator+=(const LatencyHistogram& other) {
+        for (std::size_t b = 0; b < BUCKET_COUNT; b++) {
+            buckets[b] += other.buckets[b];
+        }
+        count += other.count;
+        maximum = std::max(maximum, other.maximum);
+        return *this;
+    }
+
+    /**
+     * @brief Квантиль (верхняя граница корзины, не больше максимума), нс
+     * @param quantile Доля от 0 до 1
+     */
+    std::uint64_t percentile(double quantile) const {
+        if (count == 0) {
+            return 0;
+        }
+        std::uint64_t rank = static_cast<std::uint64_t>(quantile * static_cast<double>(count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < BUCKET_COUNT; b++) {
+            seen += buckets[b];
+            if (seen >= rank) {
+                return std::min(bucketUpperBound(b), maximum);
+            }
+        }
+        return maximum;
+    }
+
+    std::uint64_t size() const { return count; }
+    std::uint64_t max() const { return maximum; }
+};
+
+/**
+ * @brief Генератор xorshift64*: дешевле std::mt19937 в цикле команд
+ */
+struct FastRandom {
+    std::uint64_t state;
+
+    explicit FastRandom(std::uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    std::uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+/**
+ * @struct WorkerResult
+ * @brief Итоги одного потока
+ */
+struct WorkerResult {
+    LatencyHistogram latency;               ///< От запланированного момента до завершения
+    LatencyHistogram service;               ///< Выполнение команды
+    std::uint64_t switches = 0;             ///< Команд вкл/выкл
+    std::uint64_t settings = 0;             ///< Команд-настроек
+};
+
+/**
+ * @brief Выполнить одну команду над устройством
+ */
+static void runCommand(SmartDevice& device, const WorkloadSpec& spec, FastRandom& random, WorkerResult& result) {
+    if (random.unit() < spec.settings) {
+        result.settings++;
+        visit(device, overloaded{
+            [&](LightBulb& lamp) { lamp.setBrightness(static_cast<int>(random.next() % 101)); },
+            [&](Thermostat& thermo) { thermo.updateTemperature(15.0 + static_cast<double>(random.next() % 150) / 10); },
+            [&](SmartOutlet& outlet) { outlet.toggleOutlet(); },
+            [](SmartDevice&) {}
+        });
+        return;
+    }
+    result.switches++;
+    if (random.unit() < spec.duty) {
+        device.turnOn();
+    } else {
+        device.turnOff();
+    }
+}
+
+/**
+ * @brief Поток нагрузки: команды по расписанию над своей частью парка
+ */
+static void runWorker(const WorkloadSpec& spec, const std::vector<SmartDevice*>& fleet, std::size_t index,
+                      std::chrono::steady_clock::time_point start, WorkerResult& result) {
+    typedef std::chrono::steady_clock Steady;
+    const std::chrono::nanoseconds spinMargin(50000);
+
+    std::vector<SmartDevice*> own;
+    for (std::size_t i = index; i < fleet.size(); i += spec.threads) {
+        own.push_back(fleet[i]);
+    }
+    if (own.empty()) {
+        return;
+    }
+    FastRandom random(spec.seed + index);
+    bool paced = spec.rate > 0.0;
+    std::chrono::duration<double, std::nano> interval(paced ? 1e9 * static_cast<double>(spec.threads) / spec.rate : 0.0);
+    Steady::time_point end = start + std::chrono::duration_cast<Steady::duration>(
+                                         std::chrono::duration<double>(spec.duration));
+
+    for (std::uint64_t n = 0;; n++) {
+        Steady::time_point scheduled = start + std::chrono::duration_cast<Steady::duration>(interval * static_cast<double>(n));
+        if (scheduled >= end) {
+            break;
+        }
+        Steady::time_point now = Steady::now();
+        if (paced && now < scheduled) {
+            if (scheduled - now > spinMargin) {
+                std::this_thread::sleep_until(scheduled - spinMargin);
+            }
+            while ((now = Steady::now()) < scheduled) {
+            }
+        } else if (!paced && now >= end) {
+            break;
+        }
+
+        runCommand(*own[random.next() % own.size()], spec, random, result);
+
+        Steady::time_point done = Steady::now();
+        std::uint64_t service = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - now).count());
+        result.service.record(service);
+        result.latency.record(paced ? static_cast<std::uint64_t>(
+                                          std::chrono::duration_cast<std::chrono::nanoseconds>(done - scheduled).count())
+                                    : service);
+    }
+}
+
+static void printHistogram(const char* name, const LatencyHistogram& histogram) {
+    std::printf("%-10s p50 %10.3f us  p99 %10.3f us  p999 %10.3f us  max %10.3f us\n", name,
+                histogram.percentile(0.5) / 1e3, histogram.percentile(0.99) / 1e3,
+                histogram.percentile(0.999) / 1e3, histogram.max() / 1e3);
+}
+
+static void listScenarios() {
+    std::size_t count;
+    const DemoScenario* scenarios = demoScenarios(count);
+    for (std::size_t i = 0; i < count; i++) {
+        std::printf("%-20s %s\n", scenarios[i].name, scenarios[i].title);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc == 2 && std::string(argv[1]) == "list") {
+        listScenarios();
+        return 0;
+    }
+
+    WorkloadSpec spec;
+    try {
+        spec = parseSpec(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Oshibka opisaniya nagruzki: " << e.what() << "\n";
+        return 2;
+    }
+
+    for (const std::string& name : spec.scenarios) {
+        findDemoScenario(name).run();
+    }
+    if (spec.devices == 0) {
+        return 0;
+    }
+
+    DeviceArena arena(1 << 20);
+    std::vector<SmartDevice*> fleet;
+    fleet.reserve(spec.devices);
+    double total = spec.mix[0] + spec.mix[1] + spec.mix[2];
+    FastRandom random(spec.seed);
+    for (std::size_t i = 0; i < spec.devices; i++) {
+        std::string id = "LG" + std::to_string(i);
+        double pick = random.unit() * total;
+        if (pick < spec.mix[0]) {
+            fleet.push_back(arena.make<LightBulb>(id, "Lampa", 10.0 + i % 50));
+        } else if (pick < spec.mix[0] + spec.mix[1]) {
+            fleet.push_back(arena.make<Thermostat>(id, "Termostat", 1000.0 + i % 500, 20.0));
+        } else {
+            fleet.push_back(arena.make<SmartOutlet>(id, "Rozetka", 100.0 + i % 20, 16.0, "Komnata"));
+        }
+    }
+
+    std::printf("devices %zu, threads %zu, rate %.0f/s, duty %.2f, settings %.2f, duration %.1f s\n",
+                spec.devices, spec.threads, spec.rate, spec.duty, spec.settings, spec.duration);
+
+    std::vector<WorkerResult> results(spec.threads);
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    for (std::size_t t = 0; t < spec.threads; t++) {
+        workers.emplace_back(runWorker, std::cref(spec), std::cref(fleet), t, start, std::ref(results[t]));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    WorkerResult merged;
+    for (const WorkerResult& result : results) {
+        merged.latency += result.latency;
+        merged.service += result.service;
+        merged.switches += result.switches;
+        merged.settings += result.settings;
+    }
+    const DeviceRegistry& registry = DeviceRegistry::instance();
+    std::printf("commands  %llu (vkl/vykl %llu, nastroyki %llu) za %.3f s: %.0f/s\n",
+                static_cast<unsigned long long>(merged.latency.size()),
+                static_cast<unsigned long long>(merged.switches),
+                static_cast<unsigned long long>(merged.settings), elapsed,
+                static_cast<double>(merged.latency.size()) / elapsed);
+    printHistogram("latency", merged.latency);
+    printHistogram("service", merged.service);
+    std::printf("vklyucheno %zu iz %zu, moshchnost %.3f Vt, energiya %.3f Vt*ch\n", registry.devicesOn(),
+                registry.size(), registry.currentPower(), PoweredDevice::getTotalEnergyConsumedAll());
+    return 0;
+}
@@ -0,0 +1,430 @@
+/**
+ * @file mapped_journal.hpp
+ * @brief Кольцевой журнал событий устройств в файле, отображенном в память
+ *
+ * @details
+ * MappedJournal хранит записи JournalRecord в кольце фиксированной емкости
+ * внутри файла: заголовок (64 байта) и массив записей. Запись с
+ * порядковым номером seq лежит в ячейке seq % capacity.
+ *
+ * Групповая фиксация: append() только складывает запись в буфер,
+ * commit() переносит буфер в отображение, сбрасывает измененные страницы
+ * на диск и лишь затем публикует новый счетчик committed в заголовке.
+ * Поэтому после сбоя видны только целиком зафиксированные группы.
+ * Заполненный буфер (groupSize записей) фиксирует фоновый поток, так что
+ * append() не ждет msync в потоке, переключающем устройство.
+ *
+ * Перезапись кольца: прежде чем группа займет ячейки старейших записей,
+ * в заголовке публикуется и сбрасывается на диск новая граница begin.
+ * Сбой посреди перезаписи оставляет читателю окно [begin, committed),
+ * в котором нет ни одной перезаписываемой ячейки.
+ *
+ * replay() восстанавливает по журналу флаги состояния, яркость,
+ * температуру, totalOnTime, энергию устройств и учтенную энергию парка
+ * (DeviceRegistry::energyBooked). Отрезки записей TURN_OFF и LOAD_CHANGE
+ * учитываются по мощности из записи.
+ *
+ * @note Устройства должны быть созданы заново в той же конфигурации и
+ *       том же порядке, что и при записи: записи ссылаются на DeviceHandle.
+ * @note Кольцо хранит последние capacity записей. Если журнал успел
+ *       перезаписать начало истории, восстанавливается только ее хвост.
+ * @note Сессии, открытые к концу журнала, продолжаются с момента replay():
+ *       время, пока контроллер не работал, не учитывается.
+ */
+
+#ifndef MAPPED_JOURNAL_HPP
+#define MAPPED_JOURNAL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "device_journal.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @class MappedJournal
+ * @brief Файловый приемник записей журнала с групповой фиксацией
+ */
+class MappedJournal : public JournalSink {
+private:
+    static constexpr std::uint64_t MAGIC = 0x4C4E524A45564544ULL;  ///< "DEVEJRNL"
+    static constexpr std::uint32_t VERSION = 2;                   ///< Версия формата
+
+    /**
+     * @brief Заголовок файла журнала
+     */
+    struct Header {
+        std::uint64_t magic;        ///< Сигнатура формата
+        std::uint32_t version;      ///< Версия формата
+        std::uint32_t recordSize;   ///< sizeof(JournalRecord)
+        std::uint64_t capacity;     ///< Емкость кольца в записях
+        std::uint64_t committed;    ///< Количество зафиксированных записей за все время
+        std::uint64_t begin;        ///< Первая читаемая запись (0 в файлах до ее появления)
+        std::uint8_t reserved[24];  ///< Резерв до 64 байт
+    };
+
+    static_assert(sizeof(Header) == 64, "Header must stay 64 bytes");
+
+#ifdef _WIN32
+    HANDLE file;                    ///< Файл журнала
+    HANDLE mapping;                 ///< Объект отображения
+#else
+    int file;                       ///< Дескриптор файла журнала
+#endif
+    unsigned char* view;            ///< Начало отображения
+    std::size_t viewSize;           ///< Размер отображения в байтах
+    std::size_t groupSize;          ///< Порог автоматической фиксации
+
+    std::mutex stageLock;           ///< Защищает pending, flushRequested и stopping
+    mutable std::mutex commitLock;  ///< Упорядочивает фиксации и чтение заголовка
+    std::vector<JournalRecord> pending;  ///< Записи, ожидающие фиксации
+    std::vector<JournalRecord> batch;    ///< Фиксируемая группа (переиспользуется)
+
+    std::condition_variable flushSignal; ///< Будит flusher
+    bool flushRequested;            ///< Группа заполнена и ждет фиксации
+    bool stopping;                  ///< Деструктор останавливает flusher
+    std::thread flusher;            ///< Фоновая фиксация заполненных групп
+
+    Header& header() const { return *reinterpret_cast<Header*>(view); }
+
+    JournalRecord* records() const {
+        return reinterpret_cast<JournalRecord*>(view + sizeof(Header));
+    }
+
+    /**
+     * @brief Сбросить участок отображения на диск
+     */
+    void flush(const void* address, std::size_t bytes) {
+#ifdef _WIN32
+        FlushViewOfFile(address, bytes);
+#else
+        // msync требует адрес, выровненный по странице
+        std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(address) & ~(page - 1);
+        std::uintptr_t end = reinterpret_cast<std::uintptr_t>(address) + bytes;
+        msync(reinterpret_cast<void*>(begin), end - begin, MS_SYNC);
+#endif
+    }
+
+    void finishFlush() {
+#ifdef _WIN32
+        FlushFileBuffers(file);
+#endif
+    }
+
+    /**
+     * @brief Открыть файл и отобразить его в память
+     * @return true если файл был пустым и требует инициализации
+     */
+    bool open(const std::string& path, std::size_t bytes) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                           nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Ne udalos' otkryt' zhurnal: " + path);
+        }
+        LARGE_INTEGER existing;
+        GetFileSizeEx(file, &existing);
+        bool fresh = existing.QuadPart == 0;
+        if (!fresh) {
+            bytes = static_cast<std::size_t>(existing.QuadPart);
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                     static_cast<DWORD>(static_cast<std::uint64_t>(bytes) >> 32),
+                                     static_cast<DWORD>(bytes & 0xFFFFFFFFu), nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            throw std::runtime_error("Ne udalos' otobrazit' zhurnal: " + path);
+        }
+        view = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Ne udalos' otobrazit' zhurnal: " + path);
+        }
+#else
+        file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (file < 0) {
+            throw std::runtime_error("Ne udalos' otkryt' zhurnal: " + path);
+        }
+        struct stat info;
+        fstat(file, &info);
+        bool fresh = info.st_size == 0;
+        if (!fresh) {
+            bytes = static_cast<std::size_t>(info.st_size);
+        } else if (ftruncate(file, static_cast<off_t>(bytes)) != 0) {
+            ::close(file);
+            throw std::runtime_error("Ne udalos' rasshirit' zhurnal: " + path);
+        }
+        void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (address == MAP_FAILED) {
+            ::close(file);
+            throw std::runtime_error("Ne udalos' otobrazit' zhurnal: " + path);
+        }
+        view = static_cast<unsigned char*>(address);
+#endif
+        viewSize = bytes;
+        return fresh;
+    }
+
+    /**
+     * @brief Цикл фонового потока: фиксировать группы по запросу append()
+     */
+    void runFlusher() {
+        std::unique_lock<std::mutex> guard(stageLock);
+        for (;;) {
+            flushSignal.wait(guard, [this] { return flushRequested || stopping; });
+            if (!flushRequested) {
+                return;
+            }
+            flushRequested = false;
+            guard.unlock();
+            commit();
+            guard.lock();
+        }
+    }
+
+    /**
+     * @brief Первая читаемая запись при committed записей в кольце
+     */
+    std::uint64_t firstReadable(std::uint64_t committed) const {
+        std::uint64_t capacity = header().capacity;
+        std::uint64_t begin = committed > capacity ? committed - capacity : 0;
+        return header().begin > begin ? header().begin : begin;
+    }
+
+    void close() {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        munmap(view, viewSize);
+        ::close(file);
+#endif
+        view = nullptr;
+    }
+
+public:
+    /**
+     * @brief Открыть или создать журнал
+     * @param path Путь к файлу журнала
+     * @param capacity Емкость кольца в записях (для нового файла)
+     * @param groupSize Количество записей в группе фиксации
+     * @throws std::invalid_argument если capacity или groupSize равны 0
+     * @throws std::runtime_error при ошибке ввода-вывода или чужом формате файла
+     */
+    explicit MappedJournal(const std::string& path, std::size_t capacity = 1 << 20,
+                           std::size_t groupSize = 256)
+        : view(nullptr), viewSize(0), groupSize(groupSize), flushRequested(false), stopping(false) {
+        if (capacity == 0 || groupSize == 0) {
+            throw std::invalid_argument("Emkost' zhurnala i razmer gruppy dolzhny byt' polozhitel'nymi");
+        }
+        bool fresh = open(path, sizeof(Header) + capacity * sizeof(JournalRecord));
+        Header& head = header();
+        if (fresh) {
+            std::memset(&head, 0, sizeof(Header));
+            head.magic = MAGIC;
+            head.version = VERSION;
+            head.recordSize = sizeof(JournalRecord);
+            head.capacity = capacity;
+            flush(&head, sizeof(Header));
+            finishFlush();
+        } else if (viewSize < sizeof(Header) || head.magic != MAGIC || head.version != VERSION ||
+                   head.recordSize != sizeof(JournalRecord) ||
+                   sizeof(Header) + head.capacity * sizeof(JournalRecord) > viewSize) {
+            close();
+            throw std::runtime_error("Neizvestnyy format zhurnala: " + path);
+        }
+        pending.reserve(groupSize);
+        batch.reserve(groupSize);
+        flusher = std::thread(&MappedJournal::runFlusher, this);
+    }
+
+    /**
+     * @brief Деструктор
+     * @post Фоновый поток остановлен, ожидающие записи зафиксированы, файл закрыт
+     */
+    ~MappedJournal() override {
+        {
+            std::lock_guard<std::mutex> guard(stageLock);
+            stopping = true;
+        }
+        flushSignal.notify_one();
+        flusher.join();
+        commit();
+        close();
+    }
+
+    MappedJournal(const MappedJournal&) = delete;
+    MappedJournal& operator=(const MappedJournal&) = delete;
+
+    /**
+     * @brief Добавить запись в текущую группу
+     * @param record Запись журнала
+     * @post При заполнении группы ее фиксация поручена фоновому потоку
+     */
+    virtual void append(const JournalRecord& record) override {
+        bool full;
+        {
+            std::lock_guard<std::mutex> guard(stageLock);
+            pending.push_back(record);
+            full = pending.size() >= groupSize && !flushRequested;
+            flushRequested = flushRequested || full;
+        }
+        if (full) {
+            flushSignal.notify_one();
+        }
+    }
+
+    /**
+     * @brief Зафиксировать ожидающие записи в вызывающем потоке
+     * @post Записи сброшены на диск и учтены в заголовке
+     */
+    void commit() {
+        std::lock_guard<std::mutex> order(commitLock);
+        {
+            std::lock_guard<std::mutex> guard(stageLock);
+            batch.swap(pending);
+        }
+        if (batch.empty()) {
+            return;
+        }
+
+        Header& head = header();
+        std::uint64_t capacity = head.capacity;
+        std::uint64_t sequence = head.committed;
+        std::uint64_t end = sequence + batch.size();
+        if (end > capacity && end - capacity > head.begin) {
+            // Ячейки старейших записей выходят из окна чтения до перезаписи
+            head.begin = end - capacity;
+            flush(&head, sizeof(Header));
+            finishFlush();
+        }
+        std::size_t written = 0;
+        while (written < batch.size()) {
+            // Группа может перейти через конец кольца - пишем по сегментам
+            std::size_t position = static_cast<std::size_t>((sequence + written) % capacity);
+            std::size_t count = batch.size() - written;
+            if (count > capacity - position) {
+                count = static_cast<std::size_t>(capacity - position);
+            }
+            std::memcpy(records() + position, batch.data() + written, count * sizeof(JournalRecord));
+            flush(records() + position, count * sizeof(JournalRecord));
+            written += count;
+        }
+        finishFlush();
+
+        // Счетчик публикуется только после того, как записи на диске
+        head.committed = end;
+        flush(&head, sizeof(Header));
+        finishFlush();
+        batch.clear();
+    }
+
+    /**
+     * @brief Емкость кольца в записях
+     */
+    std::size_t capacity() const { return static_cast<std::size_t>(header().capacity); }
+
+    /**
+     * @brief Количество зафиксированных записей за все время
+     */
+    std::uint64_t committed() const {
+        std::lock_guard<std::mutex> order(commitLock);
+        return header().committed;
+    }
+
+    /**
+     * @brief Количество записей, доступных для чтения
+     */
+    std::size_t size() const {
+        std::lock_guard<std::mutex> order(commitLock);
+        std::uint64_t end = header().committed;
+        std::uint64_t begin = firstReadable(end);
+        return static_cast<std::size_t>(begin < end ? end - begin : 0);
+    }
+
+    /**
+     * @brief Обойти сохраненные записи от старых к новым
+     * @param visit Функция, вызываемая для каждой записи
+     * @note Фиксация групп ждет конца обхода; visit может вызывать append()
+     */
+    template <class Visitor>
+    void forEach(Visitor visit) const {
+        std::lock_guard<std::mutex> order(commitLock);
+        std::uint64_t capacity = header().capacity;
+        std::uint64_t end = header().committed;
+        std::uint64_t begin = firstReadable(end);
+        const JournalRecord* ring = records();
+        for (std::uint64_t sequence = begin; sequence < end; sequence++) {
+            visit(ring[sequence % capacity]);
+        }
+    }
+
+    /**
+     * @brief Восстановить состояние устройств по журналу
+     * @return Количество примененных записей
+     * @pre Устройства созданы в той же конфигурации, что и при записи
+     * @post totalOnTime, энергия устройств и парка дополнены закрытыми отрезками
+     */
+    std::size_t replay() {
+        commit();
+        DeviceRegistry& reg = DeviceRegistry::instance();
+        DeviceTime now = DeviceClock::now();
+        std::size_t applied = 0;
+        forEach([&](const JournalRecord& record) {
+            DeviceHandle handle = record.handle;
+            if (handle >= reg.capacity() || !reg.owner(handle)) {
+                return;
+            }
+            switch (static_cast<JournalOp>(record.opcode)) {
+                case JournalOp::TURN_OFF:
+                case JournalOp::LOAD_CHANGE:
+                    reg.bookSegment(handle, record.power, static_cast<DeviceTime>(record.value));
+                    break;
+                case JournalOp::SET_BRIGHTNESS:
+                    reg.bright(handle) = static_cast<std::uint8_t>(record.value);
+                    break;
+                case JournalOp::UPDATE_TEMPERATURE:
+                    reg.temp(handle) = record.value;
+                    break;
+                case JournalOp::SET_TARGET_TEMPERATURE:
+                    reg.target(handle) = record.value;
+                    break;
+                case JournalOp::TURN_ON:
+                case JournalOp::TOGGLE_OUTLET:
+                case JournalOp::SET_MODE:
+                    break;
+                default:
+                    return;
+            }
+            std::uint64_t flags = record.flags & DeviceState::FLAG_MASK;
+            reg.restoreState(handle, DeviceState::pack(flags, (flags & DeviceState::ON) ? now : 0));
+            if (reg.kind(handle) == DeviceKind::THERMOSTAT) {
+                // Нагрузка термостата зависит от текущей и целевой температуры
+                static_cast<Thermostat*>(reg.owner(handle))->refreshLoad();
+            }
+            applied++;
+        });
+        return applied;
+    }
+};
+
+#endif // MAPPED_JOURNAL_HPP
@@ -0,0 +1,493 @@
+/**
+ * @file rule_engine.hpp
+ * @brief Правила автоматизации с инкрементальной проверкой условий
+ *
+ * @details
+ * Правило - конъюнкция условий над полями устройств и парка и список
+ * действий:
+ * - "если температура TH1 > 25, выключить розетку SO1"
+ * - "если мощность парка > лимита, убавить яркость всех лампочек"
+ *
+ * Правила не опрашиваются на каждом такте. RuleEngine подключается как
+ * приемник DeviceJournal и по коду операции каждой записи определяет
+ * измененные поля устройства (RuleField). При добавлении правила его
+ * условия раскладываются в индекс зависимостей "дескриптор -> правила и
+ * поля", поэтому updateTemperature() термостата помечает только правила,
+ * читающие температуру этого термостата; изменение мощности любого
+ * устройства дополнительно помечает правила над мощностью парка.
+ * evaluate() проверяет только помеченные правила (и правила над энергией
+ * парка, которая растет со временем) и ставит действия сработавших правил
+ * в один CommandBatch.
+ *
+ * Правило срабатывает по фронту: когда его условия становятся истинными.
+ * Повторно оно сработает только после того, как условия станут ложными.
+ *
+ * @code
+ * RuleEngine rules(&journal);         // записи пересылаются дальше в journal
+ * DeviceJournal::attach(rules);
+ * rules.add(Rule("zhara")
+ *               .when(RuleCondition::temperature(th1, RuleCompare::GREATER, 25.0))
+ *               .then(RuleAction(CommandType::TURN_OFF, so1)));
+ * ...
+ * rules.evaluate();                   // на каждом такте
+ * @endcode
+ *
+ * @note Изменения, сделанные действиями правил, видны правилам на
+ *       следующем вызове evaluate(): цепочки правил не зацикливаются
+ *       внутри одного такта.
+ * @note Изменения без записи в журнал (setPowerConsumption(), прямая
+ *       запись в DeviceRegistry) нужно сообщать через touch().
+ * @note append() потокобезопасен; add(), remove(), touch() и evaluate()
+ *       вызываются из одного потока. Правила нужно удалять до уничтожения
+ *       устройств, на которые они ссылаются.
+ */
+
+#ifndef RULE_ENGINE_HPP
+#define RULE_ENGINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "command_batch.hpp"
+#include "device_clock.hpp"
+#include "device_journal.hpp"
+#include "device_registry.hpp"
+#include "fleet_kernels.hpp"
+#include "handle_bitmap.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @brief Поле, которое читает условие правила
+ */
+enum class RuleField : std::uint8_t {
+    TEMPERATURE = 0,            ///< getCurrentTemperature() термостата (°C)
+    POWER = 1,                  ///< getCurrentPower() устройства (Вт)
+    IS_ON = 2,                  ///< getIsOn() устройства (1 или 0)
+    FLEET_POWER = 3,            ///< Текущая мощность всех устройств (Вт)
+    FLEET_ENERGY = 4            ///< Энергия парка с текущими сессиями, как sumFleetEnergy() (Вт*ч)
+};
+
+/**
+ * @brief Сравнение значения поля с порогом
+ */
+enum class RuleCompare : std::uint8_t {
+    LESS = 0,
+    LESS_EQUAL = 1,
+    GREATER = 2,
+    GREATER_EQUAL = 3,
+    EQUAL = 4,
+    NOT_EQUAL = 5
+};
+
+/**
+ * @struct RuleCondition
+ * @brief Условие "поле сравнение порог"
+ */
+struct RuleCondition {
+    RuleField field;            ///< Читаемое поле
+    RuleCompare compare;        ///< Сравнение
+    DeviceHandle handle;        ///< Устройство (для полей парка не используется)
+    double threshold;           ///< Порог
+
+    /**
+     * @brief Проверить значение
+     */
+    bool holds(double value) const {
+        switch (compare) {
+            case RuleCompare::LESS: return value < threshold;
+            case RuleCompare::LESS_EQUAL: return value <= threshold;
+            case RuleCompare::GREATER: return value > threshold;
+            case RuleCompare::GREATER_EQUAL: return value >= threshold;
+            case RuleCompare::EQUAL: return value == threshold;
+            case RuleCompare::NOT_EQUAL: return value != threshold;
+        }
+        return false;
+    }
+
+    static RuleCondition temperature(const Thermostat& thermostat, RuleCompare compare, double threshold) {
+        return RuleCondition{RuleField::TEMPERATURE, compare, thermostat.getHandle(), threshold};
+    }
+
+    static RuleCondition power(const SmartDevice& device, RuleCompare compare, double threshold) {
+        return RuleCondition{RuleField::POWER, compare, device.getHandle(), threshold};
+    }
+
+    static RuleCondition isOn(const SmartDevice& device, bool on = true) {
+        return RuleCondition{RuleField::IS_ON, RuleCompare::EQUAL, device.getHandle(), on ? 1.0 : 0.0};
+    }
+
+    static RuleCondition fleetPower(RuleCompare compare, double threshold) {
+        return RuleCondition{RuleField::FLEET_POWER, compare, INVALID_DEVICE_HANDLE, threshold};
+    }
+
+    static RuleCondition fleetEnergy(RuleCompare compare, double threshold) {
+        return RuleCondition{RuleField::FLEET_ENERGY, compare, INVALID_DEVICE_HANDLE, threshold};
+    }
+};
+
+/**
+ * @struct RuleAction
+ * @brief Команда CommandBatch для одного устройства или множества устройств
+ */
+struct RuleAction {
+    CommandType type;           ///< Тип команды
+    std::int32_t argument;      ///< Аргумент (яркость или режим)
+    HandleBitmap targets;       ///< Устройства, к которым применяется команда
+
+    RuleAction(CommandType type, const SmartDevice& device, int argument = 0)
+        : type(type), argument(argument) {
+        targets.add(device.getHandle());
+    }
+
+    /**
+     * @param targets Множество дескрипторов (например, DeviceSet::ofKind()), копируется
+     */
+    RuleAction(CommandType type, const HandleBitmap& targets, int argument = 0)
+        : type(type), argument(argument), targets(targets) {}
+};
+
+/**
+ * @struct Rule
+ * @brief Именованное правило: все условия истинны -> все действия
+ */
+struct Rule {
+    std::string name;
+    std::vector<RuleCondition> conditions;
+    std::vector<RuleAction> actions;
+
+    explicit Rule(std::string name) : name(std::move(name)) {}
+
+    Rule& when(const RuleCondition& condition) {
+        conditions.push_back(condition);
+        return *this;
+    }
+
+    Rule& then(RuleAction action) {
+        actions.push_back(std::move(action));
+        return *this;
+    }
+};
+
+/**
+ * @brief Идентификатор правила в RuleEngine
+ */
+using RuleId = std::uint32_t;
+
+/**
+ * @class RuleEngine
+ * @brief Индекс зависимостей правил и их проверка по изменившимся полям
+ */
+class RuleEngine : public JournalSink {
+private:
+    /**
+     * @brief Правило с состоянием проверки
+     */
+    struct Entry {
+        Rule rule;
+        bool live;              ///< Правило не удалено
+        bool matched;           ///< Условия были истинны при последней проверке
+        std::uint64_t queued;   ///< Номер evaluate(), в который правило помечено
+    };
+
+    /**
+     * @brief Правило, читающее поля устройства
+     */
+    struct Dependent {
+        RuleId rule;
+        std::uint8_t fields;    ///< Маска бит 1 << RuleField
+    };
+
+    /**
+     * @brief Изменение полей устройства из журнала
+     */
+    struct Change {
+        DeviceHandle handle;
+        std::uint8_t fields;
+    };
+
+    static constexpr std::uint8_t bit(RuleField field) {
+        return static_cast<std::uint8_t>(1u << static_cast<unsigned>(field));
+    }
+
+    std::vector<Entry> rules;
+    std::vector<RuleId> freeIds;
+    std::vector<std::vector<Dependent>> byHandle;   ///< Дескриптор -> правила над его полями
+    std::vector<RuleId> fleetPowerRules;
+    std::vector<RuleId> fleetEnergyRules;
+
+    std::mutex mutex;                               ///< Защищает pending
+    std::vector<Change> pending;                    ///< Изменения из append()
+    std::vector<Change> draining;                   ///< Изменения текущего evaluate()
+    std::vector<RuleId> dirty;                      ///< Правила к проверке
+    std::uint64_t round;                            ///< Номер вызова evaluate()
+    std::size_t lastEvaluated;                      ///< Правил проверено в последнем evaluate()
+
+    JournalSink* next;
+    CommandBatch batch;
+
+    void queue(RuleId id) {
+        if (rules[id].queued != round) {
+            rules[id].queued = round;
+            dirty.push_back(id);
+        }
+    }
+
+    void queueChanges(std::uint8_t fields, DeviceHandle handle) {
+        if (handle < byHandle.size()) {
+            for (const Dependent& dependent : byHandle[handle]) {
+                if (dependent.fields & fields) {
+                    queue(dependent.rule);
+                }
+            }
+        }
+        if (fields & bit(RuleField::POWER)) {
+            for (RuleId id : fleetPowerRules) {
+                queue(id);
+            }
+        }
+    }
+
+    static double read(const DeviceRegistry& reg, const RuleCondition& condition, double fleetEnergy) {
+        switch (condition.field) {
+            case RuleField::TEMPERATURE:
+                return reg.temp(condition.handle);
+            case RuleField::POWER: {
+                const SmartDevice* device = reg.owner(condition.handle);
+                return device ? device->getCurrentPower() : 0.0;
+            }
+            case RuleField::IS_ON:
+                return (reg.loadState(condition.handle) & DeviceState::ON) ? 1.0 : 0.0;
+            case RuleField::FLEET_POWER:
+                return reg.currentPower();
+            case RuleField::FLEET_ENERGY:
+                return fleetEnergy;
+        }
+        return 0.0;
+    }
+
+    static void unlink(std::vector<RuleId>& ids, RuleId id) {
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    }
+
+public:
+    /**
+     * @param next Приемник, которому пересылаются все записи (или nullptr)
+     */
+    explicit RuleEngine(JournalSink* next = nullptr) : round(1), lastEvaluated(0), next(next) {}
+
+    RuleEngine(const RuleEngine&) = delete;
+    RuleEngine& operator=(const RuleEngine&) = delete;
+
+    /**
+     * @brief Поля устройства, которые меняет операция журнала
+     * @return Маска бит 1 << RuleField
+     */
+    static std::uint8_t fieldsOf(JournalOp op) {
+        switch (op) {
+            case JournalOp::TURN_ON:
+            case JournalOp::TURN_OFF:
+                return bit(RuleField::IS_ON) | bit(RuleField::POWER);
+            case JournalOp::UPDATE_TEMPERATURE:
+                return bit(RuleField::TEMPERATURE) | bit(RuleField::POWER);
+            case JournalOp::TOGGLE_OUTLET:
+            case JournalOp::SET_TARGET_TEMPERATURE:
+            case JournalOp::LOAD_CHANGE:
+                return bit(RuleField::POWER);
+            case JournalOp::SET_BRIGHTNESS:
+            case JournalOp::SET_MODE:
+                return 0;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Принять запись журнала: запомнить изменившиеся поля
+     */
+    void append(const JournalRecord& record) override {
+        if (next) {
+            next->append(record);
+        }
+        std::uint8_t fields = fieldsOf(static_cast<JournalOp>(record.opcode));
+        if (fields) {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(Change{record.handle, fields});
+        }
+    }
+
+    /**
+     * @brief Сообщить об изменении устройства в обход журнала
+     * @details Помечает все правила, читающие поля устройства
+     */
+    void touch(const SmartDevice& device) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(Change{device.getHandle(), 0xFF});
+    }
+
+    /**
+     * @brief Добавить правило
+     * @param rule Правило
+     * @return Идентификатор для remove()
+     * @throws std::invalid_argument если у правила нет условий или действий,
+     *         условие ссылается на удаленное устройство или температура
+     *         читается не у термостата
+     * @note Новое правило проверяется на ближайшем evaluate()
+     */
+    RuleId add(Rule rule) {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        if (rule.conditions.empty() || rule.actions.empty()) {
+            throw std::invalid_argument("Pravilo bez usloviy ili deystviy: " + rule.name);
+        }
+        for (const RuleCondition& condition : rule.conditions) {
+            if (condition.field == RuleField::FLEET_POWER || condition.field == RuleField::FLEET_ENERGY) {
+                continue;
+            }
+            if (condition.handle >= reg.capacity() || !reg.owner(condition.handle)) {
+                throw std::invalid_argument("Uslovie ssylaetsya na nesushchestvuyushchee ustroystvo: " + rule.name);
+            }
+            if (condition.field == RuleField::TEMPERATURE && reg.kind(condition.handle) != DeviceKind::THERMOSTAT) {
+                throw std::invalid_argument("Temperatura dostupna tol'ko u termostata: " + rule.name);
+            }
+        }
+
+        RuleId id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+            rules[id] = Entry{std::move(rule), true, false, 0};
+        } else {
+            id = static_cast<RuleId>(rules.size());
+            rules.push_back(Entry{std::move(rule), true, false, 0});
+        }
+
+        for (const RuleCondition& condition : rules[id].rule.conditions) {
+            if (condition.field == RuleField::FLEET_POWER) {
+                fleetPowerRules.push_back(id);
+                continue;
+            }
+            if (condition.field == RuleField::FLEET_ENERGY) {
+                fleetEnergyRules.push_back(id);
+                continue;
+            }
+            if (condition.handle >= byHandle.size()) {
+                byHandle.resize(condition.handle + 1);
+            }
+            std::vector<Dependent>& dependents = byHandle[condition.handle];
+            auto found = std::find_if(dependents.begin(), dependents.end(),
+                                      [id](const Dependent& d) { return d.rule == id; });
+            if (found != dependents.end()) {
+                found->fields |= bit(condition.field);
+            } else {
+                dependents.push_back(Dependent{id, bit(condition.field)});
+            }
+        }
+        queue(id);
+        return id;
+    }
+
+    /**
+     * @brief Удалить правило
+     * @param id Идентификатор из add()
+     * @return false если правила нет
+     */
+    bool remove(RuleId id) {
+        if (id >= rules.size() || !rules[id].live) {
+            return false;
+        }
+        for (const RuleCondition& condition : rules[id].rule.conditions) {
+            if (condition.field == RuleField::FLEET_POWER) {
+                unlink(fleetPowerRules, id);
+            } else if (condition.field == RuleField::FLEET_ENERGY) {
+                unlink(fleetEnergyRules, id);
+            } else {
+                std::vector<Dependent>& dependents = byHandle[condition.handle];
+                dependents.erase(std::remove_if(dependents.begin(), dependents.end(),
+                                                [id](const Dependent& d) { return d.rule == id; }),
+                                 dependents.end());
+            }
+        }
+        unlink(dirty, id);
+        rules[id].live = false;
+        rules[id].rule = Rule(std::string());
+        freeIds.push_back(id);
+        return true;
+    }
+
+    /**
+     * @brief Проверить правила, поля которых изменились, и применить действия
+     * @param statusOut Поток для строк статуса CommandBatch или nullptr
+     * @return Количество сработавших правил
+     * @details Действия всех сработавших правил применяются одним
+     *          CommandBatch::apply() в порядке идентификаторов правил
+     */
+    std::size_t evaluate(std::ostream* statusOut = nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            draining.swap(pending);
+        }
+        for (const Change& change : draining) {
+            queueChanges(change.fields, change.handle);
+        }
+        draining.clear();
+        for (RuleId id : fleetEnergyRules) {
+            queue(id);
+        }
+
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        double fleetEnergy = fleetEnergyRules.empty() ? 0.0 : sumFleetEnergy(reg, DeviceClock::now());
+        std::sort(dirty.begin(), dirty.end());
+        lastEvaluated = dirty.size();
+
+        batch.clear();
+        std::size_t fired = 0;
+        for (RuleId id : dirty) {
+            Entry& entry = rules[id];
+            bool holds = true;
+            for (const RuleCondition& condition : entry.rule.conditions) {
+                if (!condition.holds(read(reg, condition, fleetEnergy))) {
+                    holds = false;
+                    break;
+                }
+            }
+            if (holds && !entry.matched) {
+                for (const RuleAction& action : entry.rule.actions) {
+                    action.targets.forEach([&](DeviceHandle h) {
+                        batch.add(DeviceCommand{h, action.type, action.argument});
+                    });
+                }
+                fired++;
+            }
+            entry.matched = holds;
+        }
+        dirty.clear();
+        round++;
+
+        if (batch.size() > 0) {
+            batch.apply(statusOut);
+        }
+        return fired;
+    }
+
+    /**
+     * @brief Пакет команд последнего evaluate() и его результаты
+     */
+    const CommandBatch& lastBatch() const { return batch; }
+
+    /**
+     * @brief Количество правил, проверенных последним evaluate()
+     */
+    std::size_t evaluatedCount() const { return lastEvaluated; }
+
+    /**
+     * @brief Количество действующих правил
+     */
+    std::size_t size() const { return rules.size() - freeIds.size(); }
+};
+
+#endif // RULE_ENGINE_HPP
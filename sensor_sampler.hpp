@@ -0,0 +1,381 @@
+/**
+ * @file sensor_sampler.hpp
+ * @brief Периодический опрос датчиков ISensor в кольцевые временные ряды
+ *
+ * @details
+ * SensorSampler с заданным периодом опрашивает зарегистрированные датчики
+ * и складывает отсчеты (время, значение) в SampleRing - кольцевой буфер
+ * одного производителя и одного потребителя (SPSC) без блокировок.
+ * Кольцо из capacity ячеек (степень двойки) отдает последние capacity - 1
+ * отсчетов: ячейку следующей записи читатель не получает. 8 часов при
+ * 10 Гц - это 288000 отсчетов, кольцо на 524288 ячеек (8.4 МБ) на датчик.
+ *
+ * Потребитель читает окна без копирования: SampleWindow - это два
+ * std::span поверх памяти кольца (второй непуст, если окно переходит
+ * через конец буфера). Производитель не ждет потребителя и перезаписывает
+ * самые старые отсчеты, поэтому после обработки окна потребитель
+ * проверяет intact(): false означает, что начало окна перезаписывается
+ * или уже перезаписано и результат нужно пересчитать (как при seqlock).
+ *
+ * @note Датчики регистрируются до start() и должны пережить опрос.
+ */
+
+#ifndef SENSOR_SAMPLER_HPP
+#define SENSOR_SAMPLER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @struct SensorSample
+ * @brief Один отсчет датчика
+ */
+struct SensorSample {
+    DeviceTime timestamp;       ///< Время отсчета по DeviceClock (нс)
+    double value;               ///< Показание датчика
+};
+
+class SampleRing;
+
+/**
+ * @struct SampleWindow
+ * @brief Окно отсчетов в кольце без копирования
+ */
+struct SampleWindow {
+    std::span<const SensorSample> first;    ///< Начало окна (более старые отсчеты)
+    std::span<const SensorSample> second;   ///< Продолжение после конца буфера
+    const SampleRing* ring;                 ///< Кольцо, из которого взято окно
+    std::uint64_t start;                    ///< Порядковый номер первого отсчета
+
+    /**
+     * @brief Количество отсчетов в окне
+     */
+    std::size_t size() const { return first.size() + second.size(); }
+
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Отсчет окна по номеру (0 - самый старый)
+     */
+    const SensorSample& operator[](std::size_t index) const {
+        return index < first.size() ? first[index] : second[index - first.size()];
+    }
+
+    /**
+     * @brief Проверить, что производитель не перезаписал окно
+     * @return true если все отсчеты окна по-прежнему действительны
+     * @note Вызывается после чтения отсчетов окна: проверка упорядочена
+     *       после этих чтений
+     */
+    bool intact() const;
+};
+
+/**
+ * @class SampleRing
+ * @brief Кольцевой SPSC-буфер отсчетов с перезаписью старых данных
+ */
+class SampleRing {
+private:
+    std::unique_ptr<SensorSample[]> samples;    ///< Память кольца
+    std::size_t ringCapacity;                   ///< Емкость (степень двойки)
+    std::size_t mask;                           ///< ringCapacity - 1
+    alignas(64) std::atomic<std::uint64_t> head;    ///< Количество записанных отсчетов
+
+    const SensorSample& at(std::uint64_t sequence) const {
+        return samples[static_cast<std::size_t>(sequence) & mask];
+    }
+
+    /**
+     * @brief Первый номер в [begin, end) с временем не раньше time
+     */
+    std::uint64_t lowerBound(std::uint64_t begin, std::uint64_t end, DeviceTime time) const {
+        while (begin < end) {
+            std::uint64_t middle = begin + (end - begin) / 2;
+            if (at(middle).timestamp < time) {
+                begin = middle + 1;
+            } else {
+                end = middle;
+            }
+        }
+        return begin;
+    }
+
+    SampleWindow makeWindow(std::uint64_t begin, std::uint64_t end) const {
+        std::size_t offset = static_cast<std::size_t>(begin) & mask;
+        std::size_t count = static_cast<std::size_t>(end - begin);
+        std::size_t head = count < ringCapacity - offset ? count : ringCapacity - offset;
+        return SampleWindow{std::span<const SensorSample>(samples.get() + offset, head),
+                            std::span<const SensorSample>(samples.get(), count - head),
+                            this, begin};
+    }
+
+public:
+    /**
+     * @brief Конструктор
+     * @param minCapacity Сколько последних отсчетов должно быть доступно
+     *        (ячеек - следующая степень двойки больше minCapacity)
+     * @throws std::invalid_argument если minCapacity == 0
+     */
+    explicit SampleRing(std::size_t minCapacity) : ringCapacity(1), head(0) {
+        if (minCapacity == 0) {
+            throw std::invalid_argument("Emkost' bufera dolzhna byt' polozhitel'noy");
+        }
+        while (ringCapacity <= minCapacity) {
+            ringCapacity <<= 1;
+        }
+        mask = ringCapacity - 1;
+        samples.reset(new SensorSample[ringCapacity]);
+    }
+
+    SampleRing(const SampleRing&) = delete;
+    SampleRing& operator=(const SampleRing&) = delete;
+
+    /**
+     * @brief Добавить отсчет (только поток-производитель)
+     * @param sample Отсчет с неубывающим временем
+     */
+    void push(const SensorSample& sample) {
+        std::uint64_t sequence = head.load(std::memory_order_relaxed);
+        samples[static_cast<std::size_t>(sequence) & mask] = sample;
+        head.store(sequence + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Емкость кольца в ячейках
+     * @note Доступно не больше capacity() - 1 отсчетов
+     */
+    std::size_t capacity() const { return ringCapacity; }
+
+    /**
+     * @brief Количество отсчетов, записанных за все время
+     */
+    std::uint64_t written() const { return head.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Количество доступных отсчетов
+     */
+    std::size_t size() const {
+        std::uint64_t count = written();
+        return count < mask ? static_cast<std::size_t>(count) : mask;
+    }
+
+    /**
+     * @brief Последние count отсчетов
+     * @param count Желаемое количество (ограничивается size())
+     */
+    SampleWindow latest(std::size_t count) const {
+        std::uint64_t end = written();
+        std::uint64_t available = end < mask ? end : mask;
+        if (count > available) {
+            count = static_cast<std::size_t>(available);
+        }
+        return makeWindow(end - count, end);
+    }
+
+    /**
+     * @brief Отсчеты с временем в полуинтервале [from, to)
+     * @param from Начало интервала (нс DeviceClock)
+     * @param to Конец интервала
+     * @details Поиск границ - двоичный по времени, O(log capacity)
+     */
+    SampleWindow window(DeviceTime from, DeviceTime to) const {
+        std::uint64_t end = written();
+        std::uint64_t begin = end > mask ? end - mask : 0;
+        std::uint64_t first = lowerBound(begin, end, from);
+        std::uint64_t last = lowerBound(first, end, to);
+        return makeWindow(first, last);
+    }
+};
+
+inline bool SampleWindow::intact() const {
+    if (!ring) {
+        return true;
+    }
+    // Как в seqlock: head перечитывается после чтения отсчетов окна.
+    // Ячейку start производитель перезаписывает, пока head == start + capacity
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return ring->written() < start + ring->capacity();
+}
+
+/**
+ * @class SensorSampler
+ * @brief Движок периодического опроса датчиков
+ */
+class SensorSampler {
+public:
+    /**
+     * @brief Метод датчика, возвращающий показание
+     */
+    typedef double (ISensor::*SensorRead)() const;
+
+private:
+    /**
+     * @brief Канал опроса: датчик, метод чтения и его кольцо
+     */
+    struct Channel {
+        const ISensor* sensor;
+        SensorRead read;
+        SampleRing ring;
+
+        Channel(const ISensor& sensor, SensorRead read, std::size_t history)
+            : sensor(&sensor), read(read), ring(history) {}
+    };
+
+    std::vector<std::unique_ptr<Channel>> channels;     ///< Каналы в порядке регистрации
+    DeviceTime period;                                  ///< Период опроса (нс)
+    std::size_t history;                                ///< Емкость кольца канала
+    std::atomic<bool> running;                          ///< Флаг работы потока опроса
+    std::thread worker;                                 ///< Поток опроса
+
+    void run() {
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds step(period);
+        while (running.load(std::memory_order_relaxed)) {
+            sampleOnce(DeviceClock::now());
+            next += step;
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (next < now) {
+                // Опрос не успел за периодом: пропускаем тики, а не догоняем их
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+public:
+    /**
+     * @brief Конструктор
+     * @param period Период опроса в наносекундах (по умолчанию 10 Гц)
+     * @param history Емкость истории канала в отсчетах (по умолчанию 8 часов при 10 Гц)
+     * @throws std::invalid_argument если period <= 0 или history == 0
+     */
+    explicit SensorSampler(DeviceTime period = NANOS_PER_SECOND / 10,
+                           std::size_t history = 8 * 3600 * 10)
+        : period(period), history(history), running(false) {
+        if (period <= 0 || history == 0) {
+            throw std::invalid_argument("Period oprosa i emkost' istorii dolzhny byt' polozhitel'nymi");
+        }
+    }
+
+    ~SensorSampler() {
+        stop();
+    }
+
+    SensorSampler(const SensorSampler&) = delete;
+    SensorSampler& operator=(const SensorSampler&) = delete;
+
+    /**
+     * @brief Зарегистрировать датчик
+     * @param sensor Датчик
+     * @param read Метод чтения (по умолчанию getCurrentPower)
+     * @return Номер канала
+     * @throws std::logic_error если опрос уже запущен
+     */
+    std::size_t add(const ISensor& sensor, SensorRead read = &ISensor::getCurrentPower) {
+        if (running.load(std::memory_order_relaxed)) {
+            throw std::logic_error("Nel'zya dobavlyat' datchiki vo vremya oprosa");
+        }
+        channels.push_back(std::unique_ptr<Channel>(new Channel(sensor, read, history)));
+        return channels.size() - 1;
+    }
+
+    /**
+     * @brief Зарегистрировать все датчики из DeviceRegistry
+     * @param read Метод чтения
+     * @return Количество добавленных каналов
+     */
+    std::size_t addAll(SensorRead read = &ISensor::getCurrentPower) {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        std::size_t added = 0;
+        for (DeviceHandle handle = 0; handle < reg.capacity(); handle++) {
+            SmartDevice* device = reg.owner(handle);
+            if (!device) {
+                continue;
+            }
+            // Тег типа избавляет от RTTI для устройств библиотеки
+            const ISensor* sensor = nullptr;
+            if (reg.kind(handle) == DeviceKind::SMART_OUTLET) {
+                sensor = static_cast<const SmartOutlet*>(device);
+            } else if (reg.kind(handle) == DeviceKind::NONE) {
+                sensor = dynamic_cast<const ISensor*>(device);
+            }
+            if (sensor) {
+                add(*sensor, read);
+                added++;
+            }
+        }
+        return added;
+    }
+
+    /**
+     * @brief Опросить все каналы один раз
+     * @param now Время отсчета (одно для всех каналов)
+     * @note Вызывается потоком опроса; напрямую - только при остановленном опросе
+     */
+    void sampleOnce(DeviceTime now) {
+        for (std::unique_ptr<Channel>& channel : channels) {
+            channel->ring.push(SensorSample{now, (channel->sensor->*channel->read)()});
+        }
+    }
+
+    /**
+     * @brief Запустить поток опроса
+     */
+    void start() {
+        if (running.exchange(true)) {
+            return;
+        }
+        worker = std::thread(&SensorSampler::run, this);
+    }
+
+    /**
+     * @brief Остановить поток опроса
+     */
+    void stop() {
+        if (!running.exchange(false)) {
+            return;
+        }
+        worker.join();
+    }
+
+    /**
+     * @brief Количество каналов
+     */
+    std::size_t size() const { return channels.size(); }
+
+    /**
+     * @brief Кольцо канала по номеру
+     */
+    const SampleRing& ring(std::size_t channel) const { return channels[channel]->ring; }
+
+    /**
+     * @brief Датчик канала по номеру
+     */
+    const ISensor& sensor(std::size_t channel) const { return *channels[channel]->sensor; }
+
+    /**
+     * @brief Найти кольцо датчика
+     * @return Кольцо первого канала датчика или nullptr
+     */
+    const SampleRing* find(const ISensor& sensor) const {
+        for (const std::unique_ptr<Channel>& channel : channels) {
+            if (channel->sensor == &sensor) {
+                return &channel->ring;
+            }
+        }
+        return nullptr;
+    }
+};
+
+#endif // SENSOR_SAMPLER_HPP
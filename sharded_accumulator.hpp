@@ -0,0 +1,81 @@
+/**
+ * @file sharded_accumulator.hpp
+ * @brief Шардированный сумматор для общих счетчиков под конкурентной записью
+ *
+ * @details
+ * Каждый поток при первом обращении получает свой шард (по кругу),
+ * поэтому параллельные add() почти не конкурируют за одну кэш-линию.
+ * Шарды сводятся в итог только при чтении через sum().
+ */
+
+#ifndef SHARDED_ACCUMULATOR_HPP
+#define SHARDED_ACCUMULATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class ShardedAccumulator
+ * @brief Потокобезопасная сумма значений типа double без глобальной блокировки
+ */
+class ShardedAccumulator {
+public:
+    static constexpr std::size_t SHARD_COUNT = 64;  ///< Количество шардов (степень двойки)
+
+private:
+    /**
+     * @brief Шард, занимающий отдельную кэш-линию
+     */
+    struct alignas(64) Shard {
+        std::atomic<double> value{0.0};
+    };
+
+    Shard shards[SHARD_COUNT];
+
+    /**
+     * @brief Номер шарда текущего потока
+     * @return Индекс, закрепленный за потоком при первом вызове
+     */
+    static std::size_t threadShard() {
+        static std::atomic<std::size_t> nextShard{0};
+        thread_local std::size_t shard =
+            nextShard.fetch_add(1, std::memory_order_relaxed) & (SHARD_COUNT - 1);
+        return shard;
+    }
+
+public:
+    ShardedAccumulator() = default;
+    ShardedAccumulator(const ShardedAccumulator&) = delete;
+    ShardedAccumulator& operator=(const ShardedAccumulator&) = delete;
+
+    /**
+     * @brief Добавить значение в шард текущего потока
+     * @param delta Прибавляемое значение
+     */
+    void add(double delta) {
+        shards[threadShard()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Свести все шарды в итоговую сумму
+     * @return Сумма всех добавленных значений
+     */
+    double sum() const {
+        double total = 0.0;
+        for (std::size_t i = 0; i < SHARD_COUNT; i++) {
+            total += shards[i].value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Обнулить все шарды
+     */
+    void reset() {
+        for (std::size_t i = 0; i < SHARD_COUNT; i++) {
+            shards[i].value.store(0.0, std::memory_order_relaxed);
+        }
+    }
+};
+
+#endif // SHARDED_ACCUMULATOR_HPP
@@ -0,0 +1,471 @@
+/**
+ * @file smart_devices.cpp
+ * @brief Реализация иерархии устройств из smart_devices.hpp
+ *
+ * @details
+ * Единица трансляции библиотеки: статические члены, конструкторы,
+ * виртуальные методы и форматирование. Заголовок можно включать в
+ * любое число единиц трансляции; короткие методы горячего пути
+ * (геттеры колонок реестра, switchOnAt()/switchOffAt()) остаются в нем
+ * встраиваемыми.
+ */
+
+#include "smart_devices.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Инициализация статических переменных
+
+std::atomic<int> SmartDevice::totalDevicesCreated(0);
+
+// Реализация методов PoweredDevice
+
+PoweredDevice::PoweredDevice(const std::string& id, const std::string& name, double power)
+    : PoweredDevice(id, name, power, DeviceKind::NONE) {
+}
+
+PoweredDevice::PoweredDevice(const std::string& id, const std::string& name, double power,
+                             DeviceKind kind)
+    : SmartDevice(id, name, kind) {
+    DeviceError error = checkPower(power);
+    if (error != DeviceError::NONE) {
+        DEVICE_METRICS_COUNT(kind, CREATE_REJECTED);
+        throw std::invalid_argument(deviceErrorMessage(error));
+    }
+    registry().setPower(handle, power);
+}
+
+PoweredDevice::PoweredDevice(const PoweredDevice& other)
+    : PoweredDevice(other, intern(other.deviceId, "_copy"), intern(other.deviceName, " (copy)")) {
+}
+
+PoweredDevice::PoweredDevice(const PoweredDevice& other, InternedString id, InternedString name)
+    : SmartDevice(other, id, name) {
+    // Статистика времени не копируется: ячейка реестра уже обнулена
+    registry().setPower(handle, other.getPowerConsumption());
+}
+
+PoweredDevice& PoweredDevice::operator=(const PoweredDevice& other) {
+    if (this != &other) {
+        SmartDevice::operator=(other);
+        DeviceRegistry& reg = registry();
+        reg.setPower(handle, other.getPowerConsumption());
+        // Статистика начинается заново: открытая сессия отсчитывается с этого момента
+        std::uint64_t word = reg.loadState(handle);
+        reg.restoreState(handle, DeviceState::pack(word, (word & DeviceState::ON) ? DeviceClock::now() : 0));
+        reg.onTime(handle) = 0;
+        reg.deviceEnergy(handle) = 0.0;
+    }
+    return *this;
+}
+
+bool PoweredDevice::switchOn(std::uint64_t extraFlags) {
+    return switchOnAt(handle, extraFlags, DeviceClock::now());
+}
+
+bool PoweredDevice::switchOff(std::uint64_t clearFlags) {
+    return switchOffAt(handle, clearFlags, DeviceClock::now());
+}
+
+void PoweredDevice::changeLoad(double watts) {
+    DeviceRegistry& reg = registry();
+    double previous = reg.power(handle);
+    if (watts == previous) {
+        return;
+    }
+    DeviceTime now = DeviceClock::now();
+    std::atomic_ref<std::uint64_t> state = reg.stateRef(handle);
+    std::uint64_t current = state.load(std::memory_order_relaxed);
+    while ((current & DeviceState::ON) &&
+           !state.compare_exchange_weak(current, DeviceState::pack(current, now),
+                                        std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    }
+    if (current & DeviceState::ON) {
+        // Отрезок сессии до now учитывается по прежней мощности
+        DeviceTime segment = now - DeviceState::onSince(current);
+        if (segment < 0) {
+            segment = 0;
+        }
+        EnergyHistory::book(handle, now - segment, now, previous);
+        reg.bookSegment(handle, previous, segment);
+        DeviceJournal::record(handle, JournalOp::LOAD_CHANGE, current, static_cast<double>(segment), now, previous);
+    }
+    reg.setPower(handle, watts);
+}
+
+void PoweredDevice::turnOn() {
+    DEVICE_METRICS_TIME(getKind(), TURN_ON);
+    switchOn();
+}
+
+void PoweredDevice::turnOff() {
+    DEVICE_METRICS_TIME(getKind(), TURN_OFF);
+    switchOff();
+}
+
+double PoweredDevice::getTotalOnTime() const {
+    const DeviceRegistry& reg = registry();
+    std::uint64_t state = reg.loadState(handle);
+    if (state & DeviceState::ON) {
+        return toSeconds(reg.onTime(handle) + (DeviceClock::now() - DeviceState::onSince(state)));
+    }
+    return toSeconds(reg.onTime(handle));
+}
+
+double PoweredDevice::getCurrentSessionTime() const {
+    std::uint64_t state = registry().loadState(handle);
+    if (state & DeviceState::ON) {
+        return toSeconds(DeviceClock::now() - DeviceState::onSince(state));
+    }
+    return 0.0;
+}
+
+double PoweredDevice::getDeviceEnergyConsumed() const {
+    // Закрытые отрезки учтены по своей мощности, открытый - по текущей
+    const DeviceRegistry& reg = registry();
+    double energy = reg.deviceEnergy(handle);
+    std::uint64_t state = reg.loadState(handle);
+    if (state & DeviceState::ON) {
+        DeviceTime session = DeviceClock::now() - DeviceState::onSince(state);
+        if (session > 0) {
+            energy += (reg.power(handle) * static_cast<double>(session)) / static_cast<double>(NANOS_PER_HOUR);
+        }
+    }
+    return energy;
+}
+
+void PoweredDevice::resetEnergyConsumption() {
+    registry().resetEnergy();
+}
+
+void PoweredDevice::addRecoveredEnergy(double energy) {
+    registry().bookEnergy(energy);
+}
+
+std::string PoweredDevice::getFormattedOnTime() const {
+    double totalSeconds = getTotalOnTime();
+    int hours = static_cast<int>(totalSeconds) / 3600;
+    int minutes = (static_cast<int>(totalSeconds) % 3600) / 60;
+    int seconds = static_cast<int>(totalSeconds) % 60;
+    
+    std::ostringstream oss;
+    oss << std::setw(2) << std::setfill('0') << hours << ":"
+        << std::setw(2) << std::setfill('0') << minutes << ":"
+        << std::setw(2) << std::setfill('0') << seconds;
+    return oss.str();
+}
+
+double PoweredDevice::getOnTimeInHours() const {
+    return getTotalOnTime() / 3600.0;
+}
+
+// Реализация методов LightBulb
+
+LightBulb::LightBulb(const std::string& id, const std::string& name, 
+                     double power, int brightness, const std::string& color)
+    : PoweredDevice(id, name, power, KIND) {
+    DeviceError error = checkBrightness(brightness);
+    if (error == DeviceError::NONE) {
+        error = checkColor(color);
+    }
+    if (error != DeviceError::NONE) {
+        DEVICE_METRICS_COUNT(KIND, CREATE_REJECTED);
+        throw std::invalid_argument(deviceErrorMessage(error));
+    }
+    registry().bright(handle) = static_cast<std::uint8_t>(brightness);
+    registry().color(handle) = ColorPalette::instance().add(color);
+}
+
+LightBulb::LightBulb(const LightBulb& other)
+    : LightBulb(other, intern(other.deviceId, "_copy"), intern(other.deviceName, " (copy)")) {
+}
+
+LightBulb::LightBulb(const LightBulb& other, InternedString id, InternedString name)
+    : PoweredDevice(other, id, name) {
+    registry().bright(handle) = registry().bright(other.handle);
+    registry().color(handle) = registry().color(other.handle);
+}
+
+LightBulb& LightBulb::operator=(const LightBulb& other) {
+    if (this != &other) {
+        PoweredDevice::operator=(other);
+        registry().bright(handle) = registry().bright(other.handle);
+        registry().color(handle) = registry().color(other.handle);
+    }
+    return *this;
+}
+
+void LightBulb::writeStatus(StatusWriter& out) const {
+    out.append("Sostoyanie: ");
+    out.append(getIsOn() ? "vklyuchena" : "viklyuchena");
+    out.append(", Yarkost: ");
+    out.appendInt(getBrightness());
+    out.append("%, Tsvet: ");
+    out.append(getColor());
+}
+
+void LightBulb::writeDeviceInfo(StatusWriter& out) const {
+    out.append("Lampochka: ");
+    out.append(deviceName);
+    out.append(" (ID: ");
+    out.append(deviceId);
+    out.append(", Moshchnost: ");
+    out.appendGeneral(getPowerConsumption());
+    out.append(" Vt, Yarkost: ");
+    out.appendInt(getBrightness());
+    out.append("%, Tsvet: ");
+    out.append(getColor());
+    out.append(")");
+}
+
+void LightBulb::setBrightness(int level) {
+    DeviceError error = trySetBrightness(level);
+    if (error != DeviceError::NONE) {
+        throw std::invalid_argument(deviceErrorMessage(error));
+    }
+}
+
+DeviceError LightBulb::trySetBrightness(int level) {
+    DeviceError error = checkBrightness(level);
+    if (error != DeviceError::NONE) {
+        DEVICE_METRICS_COUNT(KIND, BRIGHTNESS_REJECTED);
+        return error;
+    }
+    registry().bright(handle) = static_cast<std::uint8_t>(level);
+    DeviceJournal::record(handle, JournalOp::SET_BRIGHTNESS, registry().loadState(handle), level);
+    return DeviceError::NONE;
+}
+
+void LightBulb::setColor(const std::string& newColor) {
+    registry().color(handle) = ColorPalette::instance().add(newColor);
+}
+
+void LightBulb::displayInfo() const {
+    std::cout << getDeviceInfo() << "\n";
+    std::cout << getStatus() << "\n";
+    std::cout << "Obshchee vremya raboty: " << getFormattedOnTime() << "\n";
+    std::cout << "Potreblennaya energiya: " << getDeviceEnergyConsumed() << " Vt*ch\n";
+}
+
+// Реализация методов Thermostat
+
+Thermostat::Thermostat(const std::string& id, const std::string& name, 
+                       double power, double initialTemp)
+    : PoweredDevice(id, name, power, KIND), ratedPower(power) {
+    registry().temp(handle) = initialTemp;
+    registry().target(handle) = initialTemp;
+    refreshLoad();
+}
+
+Thermostat::Thermostat(const Thermostat& other)
+    : Thermostat(other, intern(other.deviceId, "_copy"), intern(other.deviceName, " (copy)")) {
+}
+
+Thermostat::Thermostat(const Thermostat& other, InternedString id, InternedString name)
+    : PoweredDevice(other, id, name), ratedPower(other.ratedPower) {
+    registry().temp(handle) = other.getCurrentTemperature();
+    registry().target(handle) = other.getTargetTemperature();
+    if (other.hasFlags(DeviceState::MONITORING)) {
+        registry().restoreState(handle, registry().loadState(handle) | DeviceState::MONITORING);
+    }
+    refreshLoad();
+}
+
+Thermostat& Thermostat::operator=(const Thermostat& other) {
+    if (this != &other) {
+        PoweredDevice::operator=(other);
+        ratedPower = other.ratedPower;
+        registry().temp(handle) = other.getCurrentTemperature();
+        registry().target(handle) = other.getTargetTemperature();
+        std::uint64_t word = registry().loadState(handle);
+        registry().restoreState(handle, other.hasFlags(DeviceState::MONITORING) ? (word | DeviceState::MONITORING)
+                                                                                : (word & ~DeviceState::MONITORING));
+        refreshLoad();
+    }
+    return *this;
+}
+
+void Thermostat::turnOn() {
+    DEVICE_METRICS_TIME(KIND, TURN_ON);
+    switchOn(DeviceState::MONITORING);
+}
+
+void Thermostat::turnOff() {
+    DEVICE_METRICS_TIME(KIND, TURN_OFF);
+    switchOff(DeviceState::MONITORING);
+}
+
+void Thermostat::writeStatus(StatusWriter& out) const {
+    out.append("Sostoyanie: ");
+    out.append(getIsOn() ? "vklyuchen" : "viklyuchen");
+    out.append(", Temperatura: ");
+    out.appendFixed(getCurrentTemperature(), 1);
+    out.append("°C, Rezhim: ");
+    out.append(hasFlags(DeviceState::MONITORING) ? "monitoring" : "display");
+}
+
+void Thermostat::writeDeviceInfo(StatusWriter& out) const {
+    out.append("Termostat: ");
+    out.append(deviceName);
+    out.append(" (ID: ");
+    out.append(deviceId);
+    out.append(", Moshchnost: ");
+    out.appendGeneral(ratedPower);
+    out.append(" Vt, Tekushchaya temp: ");
+    out.appendFixed(getCurrentTemperature(), 1);
+    out.append("°C)");
+}
+
+void Thermostat::updateTemperature(double newTemp) {
+    registry().temp(handle) = newTemp;
+    refreshLoad();
+    DeviceJournal::record(handle, JournalOp::UPDATE_TEMPERATURE, registry().loadState(handle), newTemp);
+}
+
+void Thermostat::setTargetTemperature(double temp) {
+    registry().target(handle) = temp;
+    refreshLoad();
+    DeviceJournal::record(handle, JournalOp::SET_TARGET_TEMPERATURE, registry().loadState(handle), temp);
+    if (!getIsOn() && temp != getCurrentTemperature()) {
+        turnOn();
+    }
+}
+
+void Thermostat::setMode(const std::string& newMode) {
+    DeviceError error = trySetMode(newMode);
+    if (error != DeviceError::NONE) {
+        throw std::invalid_argument(deviceErrorMessage(error));
+    }
+}
+
+DeviceError Thermostat::trySetMode(std::string_view newMode) {
+    ThermostatMode mode;
+    if (!parseMode(newMode, mode)) {
+        DEVICE_METRICS_COUNT(KIND, MODE_REJECTED);
+        return DeviceError::INVALID_MODE;
+    }
+    setMode(mode);
+    return DeviceError::NONE;
+}
+
+void Thermostat::setMode(ThermostatMode newMode) {
+    bool monitoring = newMode == ThermostatMode::MONITORING;
+    if (monitoring) {
+        changeFlags(DeviceState::MONITORING, 0);
+    } else {
+        changeFlags(0, DeviceState::MONITORING);
+    }
+    DeviceJournal::record(handle, JournalOp::SET_MODE, registry().loadState(handle), monitoring ? 1.0 : 0.0);
+}
+
+std::string Thermostat::getMode() const {
+    return modeName(getModeValue());
+}
+
+void Thermostat::displayInfo() const {
+    std::cout << getDeviceInfo() << "\n";
+    std::cout << getStatus() << "\n";
+    std::cout << "Obshchee vremya raboty: " << getFormattedOnTime() << "\n";
+    std::cout << "Potreblennaya energiya: " << getDeviceEnergyConsumed() << " Vt*ch\n";
+}
+
+// Реализация методов SmartOutlet
+
+SmartOutlet::SmartOutlet(const std::string& id, const std::string& name, double power,
+                         double maxCurrent, const std::string& location)
+    : PoweredDevice(id, name, power, KIND), maxCurrent(maxCurrent), location(intern(location)),
+      sensorCounter(0) {
+}
+
+SmartOutlet::SmartOutlet(const SmartOutlet& other)
+    : SmartOutlet(other, intern(other.deviceId, "_copy"), intern(other.deviceName, " (copy)")) {
+}
+
+SmartOutlet::SmartOutlet(const SmartOutlet& other, InternedString id, InternedString name)
+    : PoweredDevice(other, id, name), ISensor(), maxCurrent(other.maxCurrent),
+      location(other.location), sensorCounter(other.sensorCounter) {
+    if (other.hasFlags(DeviceState::OUTLET)) {
+        registry().restoreState(handle, registry().loadState(handle) | DeviceState::OUTLET);
+    }
+}
+
+SmartOutlet& SmartOutlet::operator=(const SmartOutlet& other) {
+    if (this != &other) {
+        PoweredDevice::operator=(other);
+        maxCurrent = other.maxCurrent;
+        location = other.location;
+        sensorCounter = other.sensorCounter;
+        std::uint64_t word = registry().loadState(handle);
+        registry().restoreState(handle, other.hasFlags(DeviceState::OUTLET) ? (word | DeviceState::OUTLET)
+                                                                            : (word & ~DeviceState::OUTLET));
+    }
+    return *this;
+}
+
+double SmartOutlet::getCurrentVoltage() const {
+    std::uint32_t reading = std::atomic_ref<std::uint32_t>(sensorCounter).fetch_add(1, std::memory_order_relaxed) + 1;
+    // Шум 0.00-0.99 В из дескриптора и номера чтения (splitmix64) вместо std::rand()
+    std::uint64_t mixed = (static_cast<std::uint64_t>(handle) << 32 | reading) + 0x9E3779B97F4A7C15ULL;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    mixed ^= mixed >> 31;
+    return NOMINAL_VOLTAGE + std::sin(reading * 0.1) * 2.0 + static_cast<double>(mixed % 100) / 100.0;
+}
+
+void SmartOutlet::turnOn() {
+    DEVICE_METRICS_TIME(KIND, TURN_ON);
+    switchOn();
+}
+
+void SmartOutlet::turnOff() {
+    DEVICE_METRICS_TIME(KIND, TURN_OFF);
+    switchOff(DeviceState::OUTLET);
+}
+
+void SmartOutlet::writeStatus(StatusWriter& out) const {
+    out.append("Sostoyanie: ");
+    out.append(getIsOn() ? "vklyuchena" : "viklyuchena");
+    out.append(", Rozetka: ");
+    out.append(hasFlags(DeviceState::OUTLET) ? "vklyuchena" : "viklyuchena");
+    out.append(", Moshchnost: ");
+    out.appendFixed(getCurrentPower(), 1);
+    out.append(" Vt");
+}
+
+void SmartOutlet::writeDeviceInfo(StatusWriter& out) const {
+    out.append("Rozetka: ");
+    out.append(deviceName);
+    out.append(" (ID: ");
+    out.append(deviceId);
+    out.append(", Moshchnost: ");
+    out.appendGeneral(getPowerConsumption());
+    out.append(" Vt)");
+}
+
+void SmartOutlet::toggleOutlet() {
+    std::atomic_ref<std::uint64_t> state = registry().stateRef(handle);
+    std::uint64_t current = state.load(std::memory_order_relaxed);
+    do {
+        if (!(current & DeviceState::ON)) {
+            DEVICE_METRICS_COUNT(KIND, OUTLET_TOGGLE_REJECTED);
+            return;
+        }
+    } while (!state.compare_exchange_weak(current, current ^ DeviceState::OUTLET,
+                                          std::memory_order_acq_rel, std::memory_order_relaxed));
+    std::uint64_t toggled = current ^ DeviceState::OUTLET;
+    registry().noteTransition(handle, current, toggled);
+    DEVICE_METRICS_COUNT(KIND, OUTLET_TOGGLE);
+    DeviceJournal::record(handle, JournalOp::TOGGLE_OUTLET, toggled,
+                          (toggled & DeviceState::OUTLET) ? 1.0 : 0.0);
+}
+
+void SmartOutlet::displayInfo() const {
+    std::cout << getDeviceInfo() << "\n";
+    std::cout << getStatus() << "\n";
+    std::cout << "Tip datchika: " << getSensorType() << "\n";
+    std::cout << "Obshchee vremya raboty: " << getFormattedOnTime() << "\n";
+    std::cout << "Potreblennaya energiya: " << getDeviceEnergyConsumed() << " Vt*ch\n";
+}
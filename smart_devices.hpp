@@ -23,12 +23,22 @@
 #ifndef SMART_DEVICES_HPP
 #define SMART_DEVICES_HPP
 
-#include <iostream>
+#include <atomic>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <stdexcept>
-#include <ctime>
-#include <sstream>
-#include <iomanip>
+#include <utility>
+
+#include "color_palette.hpp"
+#include "device_clock.hpp"
+#include "device_error.hpp"
+#include "device_journal.hpp"
+#include "device_metrics.hpp"
+#include "device_registry.hpp"
+#include "energy_history.hpp"
+#include "status_writer.hpp"
+#include "string_pool.hpp"
 
 /**
  * @class ISensor
@@ -56,6 +66,13 @@ public:
      */
     virtual double getCurrentPower() const = 0;
     
+    /**
+     * @brief Получить текущее напряжение сети
+     * @return Напряжение в вольтах
+     * @pure
+     */
+    virtual double getCurrentVoltage() const = 0;
+    
     /**
      * @brief Получить тип датчика
      * @return Строка с описанием типа датчика
@@ -73,12 +90,132 @@ public:
  * - Идентификатор и имя устройства
  * - Состояние (включено/выключено)
  * - Статистика создания устройств
+ *
+ * @note turnOn()/turnOff() и смена флагов состояния потокобезопасны:
+ *       они выполняются CAS-операцией над словом состояния в DeviceRegistry.
+ * @note Идентификатор и имя интернированы в StringPool, а устройство
+ *       связано со своим ID в индексе DeviceRegistry::findById(). При
+ *       повторе ID индекс указывает на первое из живых устройств с этим ID.
  */
 class SmartDevice {
 protected:
-    std::string deviceId;       ///< Уникальный идентификатор устройства
-    std::string deviceName;     ///< Имя устройства
-    bool isOn;                  ///< Состояние устройства (true = включено)
+    InternedString deviceId;    ///< Уникальный идентификатор устройства (StringPool)
+    InternedString deviceName;  ///< Имя устройства (StringPool)
+    DeviceHandle handle;        ///< Ячейка горячего состояния в DeviceRegistry
+    DeviceKind kind;            ///< Конкретный тип устройства (тег для visit())
+    std::uint16_t generation;   ///< Поколение полей объекта (ID, имя), меняется присваиванием
+    
+    /**
+     * @brief Получить реестр, хранящий горячее состояние устройств
+     * @return Ссылка на общий DeviceRegistry
+     */
+    static DeviceRegistry& registry() { return DeviceRegistry::instance(); }
+    
+    /**
+     * @brief Интернировать строку в общей таблице
+     * @param text Строка
+     * @return Интернированная строка
+     */
+    static InternedString intern(std::string_view text) {
+        return StringPool::instance().intern(text);
+    }
+    
+    /**
+     * @brief Интернировать строку с суффиксом
+     * @param base Основа ("LB1")
+     * @param suffix Суффикс ("_copy")
+     * @return Интернированная строка base + suffix
+     */
+    static InternedString intern(std::string_view base, std::string_view suffix) {
+        // Короткие строки склеиваются на стеке: копия уже
+        // интернированного ID не выделяет память
+        char buffer[128];
+        if (base.size() + suffix.size() <= sizeof(buffer)) {
+            std::memcpy(buffer, base.data(), base.size());
+            std::memcpy(buffer + base.size(), suffix.data(), suffix.size());
+            return intern(std::string_view(buffer, base.size() + suffix.size()));
+        }
+        std::string text;
+        text.reserve(base.size() + suffix.size());
+        text.append(base).append(suffix);
+        return intern(text);
+    }
+    
+    /**
+     * @brief Установить состояние устройства в реестре
+     * @param on true = включено
+     * @note Без синхронизации: только для конструкторов и присваивания
+     */
+    void setOnState(bool on) {
+        std::uint64_t word = registry().loadState(handle);
+        if (static_cast<bool>(word & DeviceState::ON) == on) {
+            return;
+        }
+        // Новая сессия начинается сейчас, а не с нулевого времени
+        registry().restoreState(handle, on ? DeviceState::pack(word | DeviceState::ON, DeviceClock::now())
+                                           : DeviceState::pack(word & ~DeviceState::ON, 0));
+    }
+    
+    /**
+     * @brief Атомарно изменить флаги слова состояния
+     * @param setMask Устанавливаемые флаги DeviceState
+     * @param clearMask Сбрасываемые флаги DeviceState
+     * @param requiredMask Флаги, без которых изменение не применяется
+     * @return true если изменение применено
+     */
+    bool changeFlags(std::uint64_t setMask, std::uint64_t clearMask,
+                     std::uint64_t requiredMask = 0) {
+        std::atomic_ref<std::uint64_t> state = registry().stateRef(handle);
+        std::uint64_t current = state.load(std::memory_order_relaxed);
+        std::uint64_t desired;
+        do {
+            if ((current & requiredMask) != requiredMask) {
+                return false;
+            }
+            desired = (current | setMask) & ~clearMask;
+        } while (!state.compare_exchange_weak(current, desired, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed));
+        return true;
+    }
+    
+    /**
+     * @brief Проверить флаги слова состояния
+     * @param mask Проверяемые флаги DeviceState
+     * @return true если все флаги установлены
+     */
+    bool hasFlags(std::uint64_t mask) const {
+        return (registry().loadState(handle) & mask) == mask;
+    }
+    
+    /**
+     * @brief Конструктор с тегом конкретного типа
+     * @param id Уникальный идентификатор устройства
+     * @param name Имя устройства для отображения
+     * @param kind Тег типа, передаваемый конкретным классом (T::KIND)
+     */
+    SmartDevice(const std::string& id, const std::string& name, DeviceKind kind)
+        : deviceId(intern(id)), deviceName(intern(name)), handle(registry().acquire(this)), kind(kind),
+          generation(0) {
+        registry().bindId(handle, deviceId);
+        registry().kind(handle) = kind;
+        totalDevicesCreated.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Конструктор клона с готовыми интернированными ID и именем
+     * @param other Устройство-образец
+     * @param id Интернированный ID нового устройства
+     * @param name Интернированное имя (строки пула разделяются, не копируются)
+     * @post Регистрирует новое устройство с тем же состоянием вкл/выкл
+     */
+    SmartDevice(const SmartDevice& other, InternedString id, InternedString name)
+        : deviceId(id), deviceName(name), handle(registry().acquire(this)), kind(other.kind),
+          generation(0) {
+        registry().bindId(handle, deviceId);
+        registry().kind(handle) = kind;
+        setOnState(other.getIsOn());
+        totalDevicesCreated.fetch_add(1, std::memory_order_relaxed);
+    }
     
 public:
     /**
@@ -86,12 +223,10 @@ public:
      * @param id Уникальный идентификатор устройства
      * @param name Имя устройства для отображения
      * @post Увеличивает счетчик totalDevicesCreated на 1
-     * @post Устанавливает isOn = false
+     * @post Регистрирует устройство в DeviceRegistry в выключенном состоянии
      */
     SmartDevice(const std::string& id, const std::string& name)
-        : deviceId(id), deviceName(name), isOn(false) {
-        totalDevicesCreated++;
-    }
+        : SmartDevice(id, name, DeviceKind::NONE) {}
     
     /**
      * @brief Копирующий конструктор
@@ -100,17 +235,35 @@ public:
      * @post Увеличивает счетчик totalDevicesCreated на 1
      */
     SmartDevice(const SmartDevice& other)
-        : deviceId(other.deviceId + "_copy"), 
-          deviceName(other.deviceName + " (copy)"), 
-          isOn(other.isOn) {
-        totalDevicesCreated++;
+        : SmartDevice(other, intern(other.deviceId, "_copy"), intern(other.deviceName, " (copy)")) {}
+    
+    /**
+     * @brief Перемещающий конструктор
+     * @param other Перемещаемое устройство
+     * @post Ячейка реестра, ID и статистика переходят к новому объекту без копирования
+     * @post other можно только уничтожить или присвоить ему перемещением;
+     *       ссылки на other (например, в SensorSampler) нужно обновить
+     */
+    SmartDevice(SmartDevice&& other) noexcept
+        : deviceId(other.deviceId), deviceName(other.deviceName), handle(other.handle), kind(other.kind),
+          generation(other.generation) {
+        other.handle = INVALID_DEVICE_HANDLE;
+        if (handle != INVALID_DEVICE_HANDLE) {
+            registry().adopt(handle, this);
+        }
     }
     
     /**
      * @brief Виртуальный деструктор
      * @details Гарантирует корректное удаление объектов производных классов
+     * @post Освобождает ячейку устройства в DeviceRegistry и стирает ее EnergyHistory
      */
-    virtual ~SmartDevice() = default;
+    virtual ~SmartDevice() {
+        if (handle != INVALID_DEVICE_HANDLE) {
+            EnergyHistory::forgetDevice(handle);
+            registry().release(handle);
+        }
+    }
     
     /**
      * @brief Оператор присваивания
@@ -120,9 +273,36 @@ public:
      */
     SmartDevice& operator=(const SmartDevice& other) {
         if (this != &other) {
-            deviceId = other.deviceId + "_assigned";
-            deviceName = other.deviceName + " (assigned)";
-            isOn = other.isOn;
+            deviceId = intern(other.deviceId, "_assigned");
+            deviceName = intern(other.deviceName, " (assigned)");
+            registry().bindId(handle, deviceId);
+            setOnState(other.getIsOn());
+            generation++;
+        }
+        return *this;
+    }
+    
+    /**
+     * @brief Перемещающее присваивание
+     * @param other Перемещаемое устройство
+     * @return Ссылка на текущий объект
+     * @details Объекты обмениваются ячейками реестра: прежнее устройство
+     *          этого объекта освобождается вместе с other
+     */
+    SmartDevice& operator=(SmartDevice&& other) noexcept {
+        if (this != &other) {
+            std::swap(deviceId, other.deviceId);
+            std::swap(deviceName, other.deviceName);
+            std::swap(handle, other.handle);
+            std::swap(kind, other.kind);
+            generation++;
+            other.generation++;
+            if (handle != INVALID_DEVICE_HANDLE) {
+                registry().adopt(handle, this);
+            }
+            if (other.handle != INVALID_DEVICE_HANDLE) {
+                registry().adopt(other.handle, &other);
+            }
         }
         return *this;
     }
@@ -139,20 +319,86 @@ public:
      */
     virtual void turnOff() = 0;
     
+    /**
+     * @brief Записать текущий статус устройства
+     * @param out Приемник текста
+     * @pure
+     */
+    virtual void writeStatus(StatusWriter& out) const = 0;
+    
+    /**
+     * @brief Записать информацию об устройстве
+     * @param out Приемник текста
+     * @details Формат: "Ustroystvo: [имя] (ID: [идентификатор])"
+     */
+    virtual void writeDeviceInfo(StatusWriter& out) const {
+        out.append("Ustroystvo: ");
+        out.append(deviceName);
+        out.append(" (ID: ");
+        out.append(deviceId);
+        out.append(")");
+    }
+    
     /**
      * @brief Получить текущий статус устройства
      * @return Строка с описанием статуса
-     * @pure
      */
-    virtual std::string getStatus() const = 0;
+    std::string getStatus() const {
+        std::string status;
+        appendStatus(status);
+        return status;
+    }
+    
+    /**
+     * @brief Дописать статус устройства в конец строки
+     * @param out Строка-приемник; при достаточной емкости память не выделяется
+     */
+    void appendStatus(std::string& out) const {
+        StatusWriter writer(out);
+        writeStatus(writer);
+    }
+    
+    /**
+     * @brief Записать статус устройства в буфер вызывающего кода
+     * @param buf Буфер
+     * @param cap Размер буфера в байтах
+     * @return Полная длина статуса (как у snprintf)
+     */
+    std::size_t formatStatus(char* buf, std::size_t cap) const {
+        StatusWriter writer(buf, cap);
+        writeStatus(writer);
+        return writer.size();
+    }
     
     /**
      * @brief Получить информацию об устройстве
      * @return Строка с основной информацией об устройстве
-     * @details Формат: "Ustroystvo: [имя] (ID: [идентификатор])"
      */
-    virtual std::string getDeviceInfo() const {
-        return "Ustroystvo: " + deviceName + " (ID: " + deviceId + ")";
+    std::string getDeviceInfo() const {
+        std::string info;
+        appendDeviceInfo(info);
+        return info;
+    }
+    
+    /**
+     * @brief Дописать информацию об устройстве в конец строки
+     * @param out Строка-приемник
+     */
+    void appendDeviceInfo(std::string& out) const {
+        StatusWriter writer(out);
+        writeDeviceInfo(writer);
+    }
+    
+    /**
+     * @brief Записать информацию об устройстве в буфер вызывающего кода
+     * @param buf Буфер
+     * @param cap Размер буфера в байтах
+     * @return Полная длина текста (как у snprintf)
+     */
+    std::size_t formatDeviceInfo(char* buf, std::size_t cap) const {
+        StatusWriter writer(buf, cap);
+        writeDeviceInfo(writer);
+        return writer.size();
     }
     
     /**
@@ -168,25 +414,50 @@ public:
      * @brief Проверить, включено ли устройство
      * @return true если устройство включено, false в противном случае
      */
-    bool getIsOn() const { return isOn; }
+    bool getIsOn() const { return hasFlags(DeviceState::ON); }
     
     /**
      * @brief Получить идентификатор устройства
-     * @return Уникальный идентификатор устройства
+     * @return Уникальный идентификатор устройства (без копирования)
      */
-    std::string getId() const { return deviceId; }
+    std::string_view getId() const { return deviceId; }
     
     /**
      * @brief Получить имя устройства
-     * @return Имя устройства для отображения
+     * @return Имя устройства для отображения (без копирования)
      */
-    std::string getName() const { return deviceName; }
+    std::string_view getName() const { return deviceName; }
+    
+    /**
+     * @brief Получить интернированный идентификатор
+     * @return Ссылка на строку в StringPool; сравнение - по номеру
+     */
+    InternedString getInternedId() const { return deviceId; }
+    
+    /**
+     * @brief Получить дескриптор устройства в DeviceRegistry
+     * @return Индекс ячейки в колонках реестра
+     */
+    DeviceHandle getHandle() const { return handle; }
+    
+    /**
+     * @brief Получить конкретный тип устройства
+     * @return Тег типа (DeviceKind::NONE для типов вне библиотеки)
+     */
+    DeviceKind getKind() const { return kind; }
+    
+    /**
+     * @brief Поколение полей, которые хранит сам объект, а не DeviceRegistry
+     * @details Меняется при копирующем и перемещающем присваивании (ID, имя,
+     *          номинальная мощность термостата); используется StatusCache
+     */
+    std::uint16_t getGeneration() const { return generation; }
     
     /**
      * @brief Счетчик созданных устройств
-     * @details Увеличивается при создании любого устройства
+     * @details Увеличивается при создании любого устройства (атомарно)
      */
-    static int totalDevicesCreated;
+    static std::atomic<int> totalDevicesCreated;
     
     /**
      * @brief Получить общее количество созданных устройств
@@ -195,11 +466,9 @@ public:
     static int getTotalDevicesCreated();
 };
 
-// Инициализация статических переменных
-int SmartDevice::totalDevicesCreated = 0;
-
-int SmartDevice::getTotalDevicesCreated() {
-    return totalDevicesCreated;
+// Встраиваемые методы SmartDevice
+inline int SmartDevice::getTotalDevicesCreated() {
+    return totalDevicesCreated.load(std::memory_order_relaxed);
 }
 
 /**
@@ -213,18 +482,74 @@ int SmartDevice::getTotalDevicesCreated() {
  * - Сбора статистики по потреблению энергии
  * 
  * @note Используется как базовый класс для всех энергопотребляющих устройств
+ * @note Время сессий берется из DeviceClock с наносекундным разрешением
  */
 class PoweredDevice : public SmartDevice {
 protected:
-    double powerConsumption;    ///< Потребляемая мощность (в ваттах)
-    time_t lastTurnOnTime;      ///< Время последнего включения (timestamp)
-    time_t totalOnTime;         ///< Общее время работы (в секундах)
+    // Потребляемая мощность, время последнего включения и общее время
+    // работы хранятся в DeviceRegistry (power, слово состояния, onTime)
+    
+    // Общее потребление энергии всеми устройствами ведет DeviceRegistry
+    // (energyBooked), вместе с текущей нагрузкой парка
+    
+    /**
+     * @brief Изменить фактическую мощность устройства
+     * @param watts Новая мощность (Вт)
+     * @post Открытая сессия закрыта по прежней мощности (время и энергия
+     *       учтены) и продолжается с текущего момента по новой
+     */
+    void changeLoad(double watts);
+    
+    /**
+     * @brief Атомарно включить устройство
+     * @param extraFlags Дополнительные флаги DeviceState, устанавливаемые вместе с ON
+     * @return true если устройство было включено именно этим вызовом
+     * @post Запоминает время включения в слове состояния
+     */
+    bool switchOn(std::uint64_t extraFlags = 0);
+    
+    /**
+     * @brief Атомарно выключить устройство
+     * @param clearFlags Дополнительные флаги DeviceState, сбрасываемые вместе с ON
+     * @return true если устройство было выключено именно этим вызовом
+     * @post Добавляет время сессии и энергию в статистику
+     */
+    bool switchOff(std::uint64_t clearFlags = 0);
+    
+    /**
+     * @brief Атомарно включить устройство по дескриптору в заданный момент
+     * @param handle Дескриптор устройства
+     * @param extraFlags Дополнительные флаги DeviceState
+     * @param now Время включения (одно на пакет команд)
+     * @return true если устройство было включено именно этим вызовом
+     */
+    static bool switchOnAt(DeviceHandle handle, std::uint64_t extraFlags, DeviceTime now);
+    
+    /**
+     * @brief Атомарно выключить устройство по дескриптору в заданный момент
+     * @param handle Дескриптор устройства
+     * @param clearFlags Дополнительные флаги DeviceState
+     * @param now Время выключения (одно на пакет команд)
+     * @return true если устройство было выключено именно этим вызовом
+     */
+    static bool switchOffAt(DeviceHandle handle, std::uint64_t clearFlags, DeviceTime now);
+    
+    /**
+     * @brief Конструктор с тегом конкретного типа
+     * @param kind Тег типа, передаваемый конкретным классом (T::KIND)
+     * @throws std::invalid_argument если power <= 0
+     */
+    PoweredDevice(const std::string& id, const std::string& name, double power, DeviceKind kind);
     
     /**
-     * @brief Общее потребление энергии всеми устройствами
-     * @details Измеряется в ватт-часах
+     * @brief Конструктор клона
+     * @see SmartDevice(const SmartDevice&, InternedString, InternedString)
      */
-    static double totalEnergyConsumedAll;
+    PoweredDevice(const PoweredDevice& other, InternedString id, InternedString name);
+    
+    friend class CommandBatch;
+    template <class Traits> friend class DeviceGroup;
+    friend class DeviceSet;
     
 public:
     /**
@@ -237,6 +562,26 @@ public:
      */
     PoweredDevice(const std::string& id, const std::string& name, double power);
     
+    /**
+     * @brief Проверить мощность без исключений
+     * @return DeviceError::INVALID_POWER если power <= 0
+     */
+    static DeviceError checkPower(double power) {
+        return power > 0 ? DeviceError::NONE : DeviceError::INVALID_POWER;
+    }
+    
+    /**
+     * @brief Проверить параметры конструктора без исключений
+     * @details Используется tryCreate<T>(); наследники с дополнительными
+     *          параметрами объявляют свою validate() с той же сигнатурой,
+     *          что и у конструктора
+     */
+    static DeviceError validate(const std::string& id, const std::string& name, double power) {
+        (void)id;
+        (void)name;
+        return checkPower(power);
+    }
+    
     /**
      * @brief Копирующий конструктор
      * @param other Устройство для копирования
@@ -244,6 +589,12 @@ public:
      */
     PoweredDevice(const PoweredDevice& other);
     
+    /**
+     * @brief Перемещающий конструктор
+     * @post Статистика времени остается в ячейке реестра и переходит вместе с ней
+     */
+    PoweredDevice(PoweredDevice&& other) noexcept = default;
+    
     /**
      * @brief Виртуальный деструктор
      */
@@ -256,6 +607,11 @@ public:
      */
     PoweredDevice& operator=(const PoweredDevice& other);
     
+    /**
+     * @brief Перемещающее присваивание (обмен ячейками реестра)
+     */
+    PoweredDevice& operator=(PoweredDevice&& other) noexcept = default;
+    
     /**
      * @brief Включить устройство
      * @override
@@ -274,17 +630,30 @@ public:
     /**
      * @brief Получить текущее энергопотребление
      * @return Потребляемая мощность в ваттах
+     * @note Совпадает с getCurrentPower(): розетка переопределяет оба
+     *       метода и учитывает реле
      */
     virtual double getPowerUsage() const {
-        return isOn ? powerConsumption : 0.0; // Используем реальную мощность устройства
+        return getIsOn() ? getPowerConsumption() : 0.0; // Используем реальную мощность устройства
     }
     
     /**
-     * @brief Получить статус устройства
-     * @return Строка с описанием статуса
+     * @brief Получить текущую мощность
+     * @override
+     * @return Мощность (для термостата - фактическая нагрузка), если устройство включено
+     * @details Общая реализация для LightBulb и Thermostat; невиртуальный
+     *          вариант для однотипных контейнеров - Device<Traits> (static_devices.hpp)
+     */
+    virtual double getCurrentPower() const override {
+        return getIsOn() ? getPowerConsumption() : 0.0;
+    }
+    
+    /**
+     * @brief Записать статус устройства
+     * @param out Приемник текста
      * @pure
      */
-    virtual std::string getStatus() const override = 0;
+    virtual void writeStatus(StatusWriter& out) const override = 0;
     
     /**
      * @brief Получить общее время работы
@@ -302,6 +671,9 @@ public:
     /**
      * @brief Получить общую потребленную энергию
      * @return Потребленная энергия в ватт-часах
+     * @details Закрытые отрезки работы - по мощности, действовавшей на
+     *          каждом из них (DeviceRegistry::bookSegment()), открытая
+     *          сессия - по текущей мощности
      */
     double getDeviceEnergyConsumed() const;
     
@@ -313,10 +685,16 @@ public:
     
     /**
      * @brief Сбросить статистику потребления энергии
-     * @post totalEnergyConsumedAll = 0
+     * @post DeviceRegistry::energyBooked() = 0
      */
     static void resetEnergyConsumption();
     
+    /**
+     * @brief Добавить восстановленную энергию к общей статистике
+     * @param energy Энергия в ватт-часах (например, из журнала MappedJournal)
+     */
+    static void addRecoveredEnergy(double energy);
+    
     /**
      * @brief Получить отформатированное время работы
      * @return Строка в формате "ЧЧ:ММ:СС"
@@ -333,103 +711,63 @@ public:
      * @brief Получить мощность потребления
      * @return Потребляемая мощность в ваттах
      */
-    double getPowerConsumption() const;
-};
-
-// Инициализация статических переменных PoweredDevice
-double PoweredDevice::totalEnergyConsumedAll = 0.0;
-
-// Реализация методов PoweredDevice
-PoweredDevice::PoweredDevice(const std::string& id, const std::string& name, double power)
-    : SmartDevice(id, name), powerConsumption(power), lastTurnOnTime(0), totalOnTime(0) {
-    if (power <= 0) {
-        throw std::invalid_argument("Moschnost' dolznha byt' polozhitel'noy");
-    }
-}
-
-PoweredDevice::PoweredDevice(const PoweredDevice& other)
-    : SmartDevice(other), 
-      powerConsumption(other.powerConsumption),
-      lastTurnOnTime(0),
-      totalOnTime(0) {
-}
-
-PoweredDevice& PoweredDevice::operator=(const PoweredDevice& other) {
-    if (this != &other) {
-        SmartDevice::operator=(other);
-        powerConsumption = other.powerConsumption;
-        lastTurnOnTime = 0;
-        totalOnTime = 0;
-    }
-    return *this;
-}
-
-void PoweredDevice::turnOn() {
-    if (!isOn) {
-        isOn = true;
-        lastTurnOnTime = time(nullptr);
-    }
-}
-
-void PoweredDevice::turnOff() {
-    if (isOn) {
-        isOn = false;
-        time_t currentTime = time(nullptr);
-        time_t sessionTime = currentTime - lastTurnOnTime;
-        totalOnTime += sessionTime;
-        
-        // Рассчитываем потребленную энергию и добавляем к общей статистике
-        double energy = (powerConsumption * sessionTime) / 3600.0; // Используем реальную мощность
-        totalEnergyConsumedAll += energy;
+    double getPowerConsumption() const {
+        return registry().power(handle);
     }
-}
+};
 
-double PoweredDevice::getTotalOnTime() const {
-    if (isOn) {
-        return totalOnTime + (time(nullptr) - lastTurnOnTime);
-    }
-    return totalOnTime;
+// Встраиваемые методы PoweredDevice
+inline bool PoweredDevice::switchOnAt(DeviceHandle handle, std::uint64_t extraFlags, DeviceTime now) {
+    std::atomic_ref<std::uint64_t> state = registry().stateRef(handle);
+    std::uint64_t current = state.load(std::memory_order_relaxed);
+    std::uint64_t desired;
+    do {
+        if (current & DeviceState::ON) {
+            DEVICE_METRICS_COUNT(registry().kind(handle), TURN_ON_REJECTED);
+            return false;
+        }
+        desired = DeviceState::pack(current | DeviceState::ON | extraFlags, now);
+    } while (!state.compare_exchange_weak(current, desired, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed));
+    registry().noteTransition(handle, current, desired);
+    DEVICE_METRICS_COUNT(registry().kind(handle), TURN_ON);
+    DeviceJournal::record(handle, JournalOp::TURN_ON, desired, 0.0, now);
+    return true;
 }
 
-double PoweredDevice::getCurrentSessionTime() const {
-    if (isOn) {
-        return time(nullptr) - lastTurnOnTime;
+inline bool PoweredDevice::switchOffAt(DeviceHandle handle, std::uint64_t clearFlags, DeviceTime now) {
+    DeviceRegistry& reg = registry();
+    std::atomic_ref<std::uint64_t> state = reg.stateRef(handle);
+    std::uint64_t current = state.load(std::memory_order_relaxed);
+    std::uint64_t desired;
+    do {
+        if (!(current & DeviceState::ON)) {
+            DEVICE_METRICS_COUNT(reg.kind(handle), TURN_OFF_REJECTED);
+            return false;
+        }
+        desired = DeviceState::pack(current & ~(DeviceState::ON | clearFlags), 0);
+    } while (!state.compare_exchange_weak(current, desired, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed));
+    
+    // Сессию закрыл именно этот вызов, поэтому учитываем ее ровно один раз.
+    // Время снято до CAS: если сессию успели открыть позже, она нулевая
+    DeviceTime sessionTime = now - DeviceState::onSince(current);
+    if (sessionTime < 0) {
+        sessionTime = 0;
     }
-    return 0.0;
-}
-
-double PoweredDevice::getDeviceEnergyConsumed() const {
-    double totalTime = getTotalOnTime();
-    return (powerConsumption * totalTime) / 3600.0; // Используем реальную мощность
-}
-
-double PoweredDevice::getTotalEnergyConsumedAll() {
-    return totalEnergyConsumedAll;
+    double watts = reg.power(handle);
+    EnergyHistory::book(handle, now - sessionTime, now, watts);
+    
+    // Время, энергия устройства и итоги парка - по реальной мощности
+    reg.bookSegment(handle, watts, sessionTime);
+    reg.noteTransition(handle, current, desired);
+    DEVICE_METRICS_COUNT(reg.kind(handle), TURN_OFF);
+    DeviceJournal::record(handle, JournalOp::TURN_OFF, desired, static_cast<double>(sessionTime), now, watts);
+    return true;
 }
 
-void PoweredDevice::resetEnergyConsumption() {
-    totalEnergyConsumedAll = 0.0;
-}
-
-std::string PoweredDevice::getFormattedOnTime() const {
-    double totalSeconds = getTotalOnTime();
-    int hours = static_cast<int>(totalSeconds) / 3600;
-    int minutes = (static_cast<int>(totalSeconds) % 3600) / 60;
-    int seconds = static_cast<int>(totalSeconds) % 60;
-    
-    std::ostringstream oss;
-    oss << std::setw(2) << std::setfill('0') << hours << ":"
-        << std::setw(2) << std::setfill('0') << minutes << ":"
-        << std::setw(2) << std::setfill('0') << seconds;
-    return oss.str();
-}
-
-double PoweredDevice::getOnTimeInHours() const {
-    return getTotalOnTime() / 3600.0;
-}
-
-double PoweredDevice::getPowerConsumption() const {
-    return powerConsumption;
+inline double PoweredDevice::getTotalEnergyConsumedAll() {
+    return registry().energyBooked();
 }
 
 /**
@@ -444,8 +782,17 @@ double PoweredDevice::getPowerConsumption() const {
  */
 class LightBulb : public PoweredDevice {
 private:
-    int brightness;             ///< Текущая яркость (0-100%)
-    std::string color;          ///< Цвет свечения
+    // Яркость и номер цвета в ColorPalette хранятся в DeviceRegistry
+    
+public:
+    static constexpr DeviceKind KIND = DeviceKind::LIGHT_BULB;  ///< Тег типа для visit()
+    
+protected:
+    /**
+     * @brief Конструктор клона
+     * @see SmartDevice(const SmartDevice&, InternedString, InternedString)
+     */
+    LightBulb(const LightBulb& other, InternedString id, InternedString name);
     
 public:
     /**
@@ -456,16 +803,51 @@ public:
      * @param brightness Начальная яркость (0-100%)
      * @param color Начальный цвет свечения
      * @throws std::invalid_argument если brightness не в диапазоне 0-100
+     *         или нового цвета нет места в ColorPalette
      */
     LightBulb(const std::string& id, const std::string& name, 
               double power, int brightness = 100, const std::string& color = "teplyy belyy");
     
+    /**
+     * @brief Проверить яркость без исключений
+     * @return DeviceError::INVALID_BRIGHTNESS если level не в диапазоне 0-100
+     */
+    static DeviceError checkBrightness(int level) {
+        return level >= 0 && level <= 100 ? DeviceError::NONE : DeviceError::INVALID_BRIGHTNESS;
+    }
+    
+    /**
+     * @brief Проверить цвет без исключений
+     * @return DeviceError::PALETTE_FULL если цвета нет в заполненной ColorPalette
+     */
+    static DeviceError checkColor(std::string_view color) {
+        return ColorPalette::instance().canAdd(color) ? DeviceError::NONE : DeviceError::PALETTE_FULL;
+    }
+    
+    /**
+     * @brief Проверить параметры конструктора без исключений
+     */
+    static DeviceError validate(const std::string& id, const std::string& name,
+                                double power, int brightness = 100,
+                                const std::string& color = "teplyy belyy") {
+        DeviceError error = PoweredDevice::validate(id, name, power);
+        if (error == DeviceError::NONE) {
+            error = checkBrightness(brightness);
+        }
+        return error != DeviceError::NONE ? error : checkColor(color);
+    }
+    
     /**
      * @brief Копирующий конструктор
      * @param other Лампочка для копирования
      */
     LightBulb(const LightBulb& other);
     
+    /**
+     * @brief Перемещающий конструктор (без выделения памяти)
+     */
+    LightBulb(LightBulb&& other) noexcept = default;
+    
     /**
      * @brief Оператор присваивания
      * @param other Лампочка для копирования
@@ -474,28 +856,36 @@ public:
     LightBulb& operator=(const LightBulb& other);
     
     /**
-     * @brief Получить текущую мощность
-     * @override
-     * @return мощность устройства
+     * @brief Перемещающее присваивание (обмен ячейками реестра)
      */
-    virtual double getCurrentPower() const override {
-        return isOn ? powerConsumption : 0.0;
+    LightBulb& operator=(LightBulb&& other) noexcept {
+        PoweredDevice::operator=(std::move(other));
+        return *this;
     }
     
     /**
-     * @brief Получить статус лампочки
+     * @brief Создать лампочку с той же конфигурацией и новым ID
+     * @param newId ID нового устройства
+     * @return Новое устройство; имя и цвет разделяют строки пула с образцом
+     */
+    LightBulb clone(std::string_view newId) const {
+        return LightBulb(*this, intern(newId), deviceName);
+    }
+    
+    /**
+     * @brief Записать статус лампочки
      * @override
-     * @return Строка с полным описанием состояния
+     * @param out Приемник текста
      * @details Формат: "Состояние: [вкл/выкл], Яркость: X%, Цвет: Y"
      */
-    virtual std::string getStatus() const override;
+    virtual void writeStatus(StatusWriter& out) const override;
     
     /**
-     * @brief Получить информацию об устройстве
+     * @brief Записать информацию об устройстве
      * @override
-     * @return Строка с расширенной информацией
+     * @param out Приемник текста
      */
-    virtual std::string getDeviceInfo() const override;
+    virtual void writeDeviceInfo(StatusWriter& out) const override;
     
     /**
      * @brief Установить яркость лампочки
@@ -504,9 +894,17 @@ public:
      */
     void setBrightness(int level);
     
+    /**
+     * @brief Установить яркость без исключений
+     * @param level Уровень яркости (0-100%)
+     * @return DeviceError::NONE или причина отказа; при отказе яркость не меняется
+     */
+    DeviceError trySetBrightness(int level);
+    
     /**
      * @brief Установить цвет свечения
      * @param newColor Новый цвет
+     * @throws std::invalid_argument если палитра цветов заполнена
      */
     void setColor(const std::string& newColor);
     
@@ -520,7 +918,12 @@ public:
      * @brief Получить текущий цвет
      * @return Цвет свечения
      */
-    std::string getColor() const;
+    std::string_view getColor() const;
+    
+    /**
+     * @brief Получить номер цвета в ColorPalette
+     */
+    std::uint16_t getColorIndex() const { return registry().color(handle); }
     
     /**
      * @brief Отобразить полную информацию о лампочке
@@ -529,70 +932,23 @@ public:
     void displayInfo() const;
 };
 
-// Реализация методов LightBulb
-LightBulb::LightBulb(const std::string& id, const std::string& name, 
-                     double power, int brightness, const std::string& color)
-    : PoweredDevice(id, name, power), brightness(brightness), color(color) {
-    if (brightness < 0 || brightness > 100) {
-        throw std::invalid_argument("Yarkost' dolznha bit 0-100");
-    }
-}
-
-LightBulb::LightBulb(const LightBulb& other)
-    : PoweredDevice(other), brightness(other.brightness), color(other.color) {
-}
-
-LightBulb& LightBulb::operator=(const LightBulb& other) {
-    if (this != &other) {
-        PoweredDevice::operator=(other);
-        brightness = other.brightness;
-        color = other.color;
-    }
-    return *this;
+// Встраиваемые методы LightBulb
+inline int LightBulb::getBrightness() const {
+    return registry().bright(handle);
 }
 
-std::string LightBulb::getStatus() const {
-    std::ostringstream oss;
-    oss << "Sostoyanie: " << (isOn ? "vklyuchena" : "viklyuchena")
-        << ", Yarkost: " << brightness << "%, Tsvet: " << color;
-    return oss.str();
+inline std::string_view LightBulb::getColor() const {
+    return ColorPalette::instance().get(registry().color(handle));
 }
 
-std::string LightBulb::getDeviceInfo() const {
-    std::ostringstream oss;
-    oss << "Lampochka: " << deviceName 
-        << " (ID: " << deviceId 
-        << ", Moshchnost: " << powerConsumption
-        << " Vt, Yarkost: " << brightness 
-        << "%, Tsvet: " << color << ")";
-    return oss.str();
-}
-
-void LightBulb::setBrightness(int level) {
-    if (level < 0 || level > 100) {
-        throw std::invalid_argument("Yarkost' dolznha bit 0-100");
-    }
-    brightness = level;
-}
-
-void LightBulb::setColor(const std::string& newColor) {
-    color = newColor;
-}
-
-int LightBulb::getBrightness() const {
-    return brightness;
-}
-
-std::string LightBulb::getColor() const {
-    return color;
-}
-
-void LightBulb::displayInfo() const {
-    std::cout << getDeviceInfo() << "\n";
-    std::cout << getStatus() << "\n";
-    std::cout << "Obshchee vremya raboty: " << getFormattedOnTime() << "\n";
-    std::cout << "Potreblennaya energiya: " << getDeviceEnergyConsumed() << " Vt*ch\n";
-}
+/**
+ * @enum ThermostatMode
+ * @brief Режим работы термостата (значение флага DeviceState::MONITORING)
+ */
+enum class ThermostatMode : std::uint8_t {
+    DISPLAY = 0,                ///< "display" - только отображение температуры
+    MONITORING = 1              ///< "monitoring" - мониторинг
+};
 
 /**
  * @class Thermostat
@@ -604,27 +960,64 @@ void LightBulb::displayInfo() const {
  * - Режимы работы (отображение/мониторинг)
  */
 class Thermostat : public PoweredDevice {
-private:
-    double currentTemperature;  ///< Текущая температура (°C)
-    std::string mode;           ///< Режим работы
+    // Температура хранится в DeviceRegistry, режим - флагом
+    // DeviceState::MONITORING в слове состояния ("display" если сброшен).
+    // Колонка power реестра хранит фактическую нагрузку (loadFor())
+    double ratedPower;          ///< Номинальная мощность (Вт)
+    
+public:
+    static constexpr DeviceKind KIND = DeviceKind::THERMOSTAT;  ///< Тег типа для visit()
+    
+protected:
+    /**
+     * @brief Конструктор клона
+     * @see SmartDevice(const SmartDevice&, InternedString, InternedString)
+     */
+    Thermostat(const Thermostat& other, InternedString id, InternedString name);
     
 public:
     /**
      * @brief Конструктор термостата
      * @param id Уникальный идентификатор
      * @param name Имя устройства
-     * @param power Потребляемая мощность (Вт)
-     * @param initialTemp Начальная температура
+     * @param power Номинальная мощность (Вт)
+     * @param initialTemp Начальная и целевая температура
      */
     Thermostat(const std::string& id, const std::string& name, 
                double power, double initialTemp = 20.0);
     
+    /**
+     * @brief Фактическая нагрузка термостата
+     * @param rated Номинальная мощность (Вт)
+     * @param current Текущая температура (°C)
+     * @param target Целевая температура (°C)
+     * @return rated * (0.5 + |target - current| / 10)
+     */
+    static double loadFor(double rated, double current, double target) {
+        double difference = target - current;
+        return rated * (0.5 + (difference < 0 ? -difference : difference) / 10.0);
+    }
+    
+    /**
+     * @brief Проверить параметры конструктора без исключений
+     */
+    static DeviceError validate(const std::string& id, const std::string& name,
+                                double power, double initialTemp = 20.0) {
+        (void)initialTemp;
+        return PoweredDevice::validate(id, name, power);
+    }
+    
     /**
      * @brief Копирующий конструктор
      * @param other Термостат для копирования
      */
     Thermostat(const Thermostat& other);
     
+    /**
+     * @brief Перемещающий конструктор (без выделения памяти)
+     */
+    Thermostat(Thermostat&& other) noexcept = default;
+    
     /**
      * @brief Оператор присваивания
      * @param other Термостат для копирования
@@ -633,12 +1026,21 @@ public:
     Thermostat& operator=(const Thermostat& other);
     
     /**
-     * @brief Получить текущую мощность
-     * @override
-     * @return мощность устройства
+     * @brief Перемещающее присваивание (обмен ячейками реестра)
      */
-    virtual double getCurrentPower() const override {
-        return isOn ? powerConsumption : 0.0;
+    Thermostat& operator=(Thermostat&& other) noexcept {
+        PoweredDevice::operator=(std::move(other));
+        std::swap(ratedPower, other.ratedPower);
+        return *this;
+    }
+    
+    /**
+     * @brief Создать термостат с той же конфигурацией и новым ID
+     * @param newId ID нового устройства
+     * @return Новое устройство; имя разделяет строку пула с образцом
+     */
+    Thermostat clone(std::string_view newId) const {
+        return Thermostat(*this, intern(newId), deviceName);
     }
     
     /**
@@ -656,31 +1058,105 @@ public:
     virtual void turnOff() override;
     
     /**
-     * @brief Получить статус термостата
+     * @brief Записать статус термостата
      * @override
-     * @return Строка с полным описанием состояния
+     * @param out Приемник текста
      */
-    virtual std::string getStatus() const override;
+    virtual void writeStatus(StatusWriter& out) const override;
     
     /**
-     * @brief Получить информацию об устройстве
+     * @brief Записать информацию об устройстве
      * @override
-     * @return Строка с расширенной информацией
+     * @param out Приемник текста
      */
-    virtual std::string getDeviceInfo() const override;
+    virtual void writeDeviceInfo(StatusWriter& out) const override;
     
     /**
      * @brief Обновить текущую температуру
      * @param newTemp Новая текущая температура
+     * @post Нагрузка пересчитана по разнице с целевой температурой
      */
     void updateTemperature(double newTemp);
     
+    /**
+     * @brief Установить целевую температуру
+     * @param temp Целевая температура (°C)
+     * @post Выключенный термостат включается, если temp отличается от текущей
+     */
+    void setTargetTemperature(double temp);
+    
+    /**
+     * @brief Получить целевую температуру
+     * @return Целевая температура (°C)
+     */
+    double getTargetTemperature() const { return registry().target(handle); }
+    
+    /**
+     * @brief Получить номинальную мощность
+     * @return Мощность из конструктора (Вт); getPowerConsumption() - фактическая
+     */
+    double getRatedPower() const { return ratedPower; }
+    
+    /**
+     * @brief Пересчитать нагрузку по колонкам температуры реестра
+     * @details Для кода, который пишет temperature/targetTemperature
+     *          напрямую (восстановление журнала и снимка, симуляция)
+     */
+    void refreshLoad() {
+        changeLoad(loadFor(ratedPower, getCurrentTemperature(), getTargetTemperature()));
+    }
+    
     /**
      * @brief Установить режим работы
      * @param newMode Новый режим ("display"/"monitoring")
+     * @throws std::invalid_argument если режим не "display" и не "monitoring"
      */
     void setMode(const std::string& newMode);
     
+    /**
+     * @brief Установить режим работы без исключений
+     * @param newMode Новый режим ("display"/"monitoring")
+     * @return DeviceError::NONE или DeviceError::INVALID_MODE
+     */
+    DeviceError trySetMode(std::string_view newMode);
+    
+    /**
+     * @brief Установить режим работы без разбора строки
+     * @param newMode Новый режим
+     */
+    void setMode(ThermostatMode newMode);
+    
+    /**
+     * @brief Получить режим работы без построения строки
+     */
+    ThermostatMode getModeValue() const {
+        return hasFlags(DeviceState::MONITORING) ? ThermostatMode::MONITORING : ThermostatMode::DISPLAY;
+    }
+    
+    /**
+     * @brief Название режима ("display"/"monitoring")
+     */
+    static const char* modeName(ThermostatMode mode) {
+        return mode == ThermostatMode::MONITORING ? "monitoring" : "display";
+    }
+    
+    /**
+     * @brief Разобрать название режима
+     * @param text "display" или "monitoring"
+     * @param mode Результат разбора
+     * @return false если название неизвестно
+     */
+    static bool parseMode(std::string_view text, ThermostatMode& mode) {
+        if (text == "monitoring") {
+            mode = ThermostatMode::MONITORING;
+        } else if (text == "display") {
+            mode = ThermostatMode::DISPLAY;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    
     /**
      * @brief Получить текущую температуру
      * @return Текущая температура (°C)
@@ -699,82 +1175,9 @@ public:
     void displayInfo() const;
 };
 
-// Реализация методов Thermostat
-Thermostat::Thermostat(const std::string& id, const std::string& name, 
-                       double power, double initialTemp)
-    : PoweredDevice(id, name, power), currentTemperature(initialTemp), mode("display") {
-}
-
-Thermostat::Thermostat(const Thermostat& other)
-    : PoweredDevice(other), currentTemperature(other.currentTemperature), mode(other.mode) {
-}
-
-Thermostat& Thermostat::operator=(const Thermostat& other) {
-    if (this != &other) {
-        PoweredDevice::operator=(other);
-        currentTemperature = other.currentTemperature;
-        mode = other.mode;
-    }
-    return *this;
-}
-
-void Thermostat::turnOn() {
-    if (!isOn) {
-        isOn = true;
-        lastTurnOnTime = time(nullptr);
-        mode = "monitoring";
-    }
-}
-
-void Thermostat::turnOff() {
-    if (isOn) {
-        PoweredDevice::turnOff();
-        mode = "display";
-    }
-}
-
-std::string Thermostat::getStatus() const {
-    std::ostringstream oss;
-    oss << "Sostoyanie: " << (isOn ? "vklyuchen" : "viklyuchen")
-        << ", Temperatura: " << std::fixed << std::setprecision(1) << currentTemperature 
-        << "°C, Rezhim: " << mode;
-    return oss.str();
-}
-
-std::string Thermostat::getDeviceInfo() const {
-    std::ostringstream oss;
-    oss << "Termostat: " << deviceName 
-        << " (ID: " << deviceId 
-        << ", Moshchnost: " << powerConsumption
-        << " Vt, Tekushchaya temp: " << std::fixed << std::setprecision(1) << currentTemperature 
-        << "°C)";
-    return oss.str();
-}
-
-void Thermostat::updateTemperature(double newTemp) {
-    currentTemperature = newTemp;
-}
-
-void Thermostat::setMode(const std::string& newMode) {
-    if (newMode != "display" && newMode != "monitoring") {
-        throw std::invalid_argument("Rezhim dolzhen byt' ili monitoring ili display");
-    }
-    mode = newMode;
-}
-
-double Thermostat::getCurrentTemperature() const {
-    return currentTemperature;
-}
-
-std::string Thermostat::getMode() const {
-    return mode;
-}
-
-void Thermostat::displayInfo() const {
-    std::cout << getDeviceInfo() << "\n";
-    std::cout << getStatus() << "\n";
-    std::cout << "Obshchee vremya raboty: " << getFormattedOnTime() << "\n";
-    std::cout << "Potreblennaya energiya: " << getDeviceEnergyConsumed() << " Vt*ch\n";
+// Встраиваемые методы Thermostat
+inline double Thermostat::getCurrentTemperature() const {
+    return registry().temp(handle);
 }
 
 /**
@@ -788,8 +1191,21 @@ void Thermostat::displayInfo() const {
  * - Мониторинг мощности
  */
 class SmartOutlet : public PoweredDevice, public ISensor {
-private:
-    bool outletOn;              ///< Состояние розетки (включена/выключена)
+    // Состояние розетки хранится флагом DeviceState::OUTLET в слове состояния
+    double maxCurrent;              ///< Допустимый ток (А)
+    InternedString location;        ///< Место установки
+    mutable std::uint32_t sensorCounter;  ///< Номер чтения датчика (через atomic_ref)
+    
+public:
+    static constexpr DeviceKind KIND = DeviceKind::SMART_OUTLET; ///< Тег типа для visit()
+    static constexpr double NOMINAL_VOLTAGE = 220.0;             ///< Напряжение сети (В)
+    
+protected:
+    /**
+     * @brief Конструктор клона
+     * @see SmartDevice(const SmartDevice&, InternedString, InternedString)
+     */
+    SmartOutlet(const SmartOutlet& other, InternedString id, InternedString name);
     
 public:
     /**
@@ -797,9 +1213,21 @@ public:
      * @param id Уникальный идентификатор
      * @param name Имя устройства
      * @param power Потребляемая мощность самой розетки (Вт)
+     * @param maxCurrent Допустимый ток (А)
+     * @param location Место установки
      */
     SmartOutlet(const std::string& id, const std::string& name, 
-                double power);
+                double power, double maxCurrent = 16.0, const std::string& location = "gostinaya");
+    
+    /**
+     * @brief Проверить параметры конструктора без исключений
+     */
+    static DeviceError validate(const std::string& id, const std::string& name, double power,
+                                double maxCurrent = 16.0, const std::string& location = "gostinaya") {
+        (void)maxCurrent;
+        (void)location;
+        return PoweredDevice::validate(id, name, power);
+    }
     
     /**
      * @brief Копирующий конструктор
@@ -807,6 +1235,11 @@ public:
      */
     SmartOutlet(const SmartOutlet& other);
     
+    /**
+     * @brief Перемещающий конструктор (без выделения памяти)
+     */
+    SmartOutlet(SmartOutlet&& other) noexcept = default;
+    
     /**
      * @brief Оператор присваивания
      * @param other Розетка для копирования
@@ -814,13 +1247,42 @@ public:
      */
     SmartOutlet& operator=(const SmartOutlet& other);
     
+    /**
+     * @brief Перемещающее присваивание (обмен ячейками реестра)
+     */
+    SmartOutlet& operator=(SmartOutlet&& other) noexcept {
+        PoweredDevice::operator=(std::move(other));
+        std::swap(maxCurrent, other.maxCurrent);
+        std::swap(location, other.location);
+        std::swap(sensorCounter, other.sensorCounter);
+        return *this;
+    }
+    
+    /**
+     * @brief Создать розетку с той же конфигурацией и новым ID
+     * @param newId ID нового устройства
+     * @return Новое устройство; имя разделяет строку пула с образцом
+     */
+    SmartOutlet clone(std::string_view newId) const {
+        return SmartOutlet(*this, intern(newId), deviceName);
+    }
+    
     /**
      * @brief Получить текущую мощность
      * @override
-     * @return Текущая мощность в ваттах
+     * @return Мощность в ваттах, если розетка включена и реле подает питание
      */
     virtual double getCurrentPower() const override {
-        return (isOn && outletOn) ? powerConsumption : 0.0;
+        return hasFlags(DeviceState::ON | DeviceState::OUTLET) ? getPowerConsumption() : 0.0;
+    }
+    
+    /**
+     * @brief Получить текущее энергопотребление
+     * @override
+     * @return То же, что getCurrentPower(): при выключенном реле 0
+     */
+    virtual double getPowerUsage() const override {
+        return getCurrentPower();
     }
     
     /**
@@ -832,6 +1294,27 @@ public:
         return "Datchik Protechki";
     }
     
+    /**
+     * @brief Получить текущее напряжение сети
+     * @override
+     * @return NOMINAL_VOLTAGE с медленным колебанием и шумом
+     * @note Потокобезопасно: номер чтения увеличивается атомарно, шум
+     *       детерминированно вычисляется из дескриптора и номера чтения
+     */
+    virtual double getCurrentVoltage() const override;
+    
+    /**
+     * @brief Получить допустимый ток
+     * @return Ток в амперах
+     */
+    double getMaxCurrent() const { return maxCurrent; }
+    
+    /**
+     * @brief Получить место установки
+     * @return Место установки (строка пула)
+     */
+    std::string_view getLocation() const { return location; }
+    
     /**
      * @brief Включить умную розетку
      * @override
@@ -847,18 +1330,18 @@ public:
     virtual void turnOff() override;
     
     /**
-     * @brief Получить статус розетки
+     * @brief Записать статус розетки
      * @override
-     * @return Строка с полным описанием состояния
+     * @param out Приемник текста
      */
-    virtual std::string getStatus() const override;
+    virtual void writeStatus(StatusWriter& out) const override;
     
     /**
-     * @brief Получить информацию об устройстве
+     * @brief Записать информацию об устройстве
      * @override
-     * @return Строка с расширенной информацией
+     * @param out Приемник текста
      */
-    virtual std::string getDeviceInfo() const override;
+    virtual void writeDeviceInfo(StatusWriter& out) const override;
     
     /**
      * @brief Переключить состояние розетки
@@ -878,69 +1361,26 @@ public:
     void displayInfo() const;
 };
 
-// Реализация методов SmartOutlet
-SmartOutlet::SmartOutlet(const std::string& id, const std::string& name, double power)
-    : PoweredDevice(id, name, power), outletOn(false) {
-}
-
-SmartOutlet::SmartOutlet(const SmartOutlet& other)
-    : PoweredDevice(other), ISensor(), outletOn(other.outletOn) {
-}
-
-SmartOutlet& SmartOutlet::operator=(const SmartOutlet& other) {
-    if (this != &other) {
-        PoweredDevice::operator=(other);
-        outletOn = other.outletOn;
-    }
-    return *this;
-}
-
-void SmartOutlet::turnOn() {
-    if (!isOn) {
-        PoweredDevice::turnOn();
-    }
+// Встраиваемые методы SmartOutlet
+inline bool SmartOutlet::isOutletOn() const {
+    return hasFlags(DeviceState::ON | DeviceState::OUTLET);
 }
 
-void SmartOutlet::turnOff() {
-    if (isOn) {
-        PoweredDevice::turnOff();
-        outletOn = false;
-    }
-}
-
-std::string SmartOutlet::getStatus() const {
-    std::ostringstream oss;
-    oss << "Sostoyanie: " << (isOn ? "vklyuchena" : "viklyuchena")
-        << ", Rozetka: " << (outletOn ? "vklyuchena" : "viklyuchena")
-        << ", Moshchnost: " << std::fixed << std::setprecision(1) << getCurrentPower() << " Vt";
-    return oss.str();
-}
-
-std::string SmartOutlet::getDeviceInfo() const {
-    std::ostringstream oss;
-    oss << "Rozetka: " << deviceName 
-        << " (ID: " << deviceId 
-        << ", Moshchnost: " << powerConsumption 
-        << " Vt)";
-    return oss.str();
-}
-
-void SmartOutlet::toggleOutlet() {
-    if (isOn) {
-        outletOn = !outletOn;
+/**
+ * @brief Создать устройство, проверив параметры без исключений
+ * @tparam T Тип устройства с T::validate() по сигнатуре конструктора
+ * @param args Аргументы конструктора T
+ * @return Владеющий указатель или код ошибки проверки
+ * @note std::bad_alloc по-прежнему выбрасывается
+ */
+template <class T, class... Args>
+DeviceExpected<std::unique_ptr<T>> tryCreate(Args&&... args) {
+    DeviceError error = T::validate(args...);
+    if (error != DeviceError::NONE) {
+        DEVICE_METRICS_COUNT(T::KIND, CREATE_REJECTED);
+        return error;
     }
-}
-
-bool SmartOutlet::isOutletOn() const {
-    return outletOn && isOn;
-}
-
-void SmartOutlet::displayInfo() const {
-    std::cout << getDeviceInfo() << "\n";
-    std::cout << getStatus() << "\n";
-    std::cout << "Tip datchika: " << getSensorType() << "\n";
-    std::cout << "Obshchee vremya raboty: " << getFormattedOnTime() << "\n";
-    std::cout << "Potreblennaya energiya: " << getDeviceEnergyConsumed() << " Vt*ch\n";
+    return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
 #endif
\ No newline at end of file
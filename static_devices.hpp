@@ -0,0 +1,275 @@
+/**
+ * @file static_devices.hpp
+ * @brief Статический полиморфизм для однотипных наборов устройств
+ *
+ * @details
+ * Виртуальная иерархия SmartDevice остается для разнородных наборов.
+ * Когда тип известен при компиляции (контроллер освещения владеет
+ * только лампочками), виртуальные вызовы лишние:
+ * - LightBulbTraits, ThermostatTraits, SmartOutletTraits описывают тип:
+ *   тег DeviceKind, флаги, при которых устройство потребляет мощность,
+ *   и флаги, которые ставят turnOn() и снимают turnOff()
+ * - Device<Traits> - невиртуальное представление одного устройства:
+ *   геттеры читают колонки реестра, а turnOn()/writeStatus() вызываются
+ *   с квалификацией Type:: и встраиваются компилятором
+ * - DeviceGroup<Traits> - однотипный набор дескрипторов; проходы по нему
+ *   - плоские циклы без ветвлений по типу, а для непрерывного диапазона
+ *   дескрипторов - ядра fleet_kernels.hpp (AVX2/NEON) и popcount по
+ *   битовой карте ON реестра
+ *
+ * @code
+ * DeviceGroup<LightBulbTraits> lights;
+ * for (LightBulb* bulb : bulbs) {
+ *     lights.add(*bulb);
+ * }
+ * lights.turnOnAll();
+ * double watts = lights.sumCurrentPower();
+ * @endcode
+ *
+ * @note Как и ядра fleet_kernels.hpp, при параллельных переключениях
+ *       суммы по группе - приближенный снимок.
+ */
+
+#ifndef STATIC_DEVICES_HPP
+#define STATIC_DEVICES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fleet_kernels.hpp"
+#include "smart_devices.hpp"
+
+/**
+ * @struct LightBulbTraits
+ * @brief Описание типа LightBulb для Device<Traits> и DeviceGroup<Traits>
+ */
+struct LightBulbTraits {
+    typedef LightBulb Type;
+    static constexpr DeviceKind KIND = DeviceKind::LIGHT_BULB;        ///< Тег типа
+    static constexpr std::uint64_t ACTIVE_FLAGS = DeviceState::ON;      ///< Флаги потребления мощности
+    static constexpr std::uint64_t ON_FLAGS = 0;                        ///< Ставит turnOn() вместе с ON
+    static constexpr std::uint64_t OFF_FLAGS = 0;                       ///< Снимает turnOff() вместе с ON
+};
+
+/**
+ * @struct ThermostatTraits
+ * @brief Описание типа Thermostat (turnOn() включает мониторинг)
+ */
+struct ThermostatTraits {
+    typedef Thermostat Type;
+    static constexpr DeviceKind KIND = DeviceKind::THERMOSTAT;
+    static constexpr std::uint64_t ACTIVE_FLAGS = DeviceState::ON;
+    static constexpr std::uint64_t ON_FLAGS = DeviceState::MONITORING;
+    static constexpr std::uint64_t OFF_FLAGS = DeviceState::MONITORING;
+};
+
+/**
+ * @struct SmartOutletTraits
+ * @brief Описание типа SmartOutlet (мощность - только при поданном питании)
+ */
+struct SmartOutletTraits {
+    typedef SmartOutlet Type;
+    static constexpr DeviceKind KIND = DeviceKind::SMART_OUTLET;
+    static constexpr std::uint64_t ACTIVE_FLAGS = DeviceState::ON | DeviceState::OUTLET;
+    static constexpr std::uint64_t ON_FLAGS = 0;
+    static constexpr std::uint64_t OFF_FLAGS = DeviceState::OUTLET;
+};
+
+/**
+ * @brief Текущая мощность по слову состояния и колонке мощности
+ * @tparam Traits Описание типа
+ * @param word Слово состояния (DeviceState)
+ * @param watts Значение колонки мощности (Вт)
+ */
+template <class Traits>
+inline double staticCurrentPower(std::uint64_t word, double watts) {
+    return (word & Traits::ACTIVE_FLAGS) == Traits::ACTIVE_FLAGS ? watts : 0.0;
+}
+
+/**
+ * @class Device
+ * @brief Невиртуальное представление устройства известного типа
+ * @tparam Traits LightBulbTraits, ThermostatTraits или SmartOutletTraits
+ */
+template <class Traits>
+class Device {
+public:
+    typedef typename Traits::Type Type;
+
+private:
+    Type* device;               ///< Представляемое устройство (не владеет)
+
+public:
+    explicit Device(Type& device) : device(&device) {}
+
+    Type& get() const { return *device; }
+    DeviceHandle handle() const { return device->getHandle(); }
+
+    bool isOn() const {
+        return (DeviceRegistry::instance().loadState(handle()) & DeviceState::ON) != 0;
+    }
+
+    /**
+     * @brief Текущая мощность, как Type::getCurrentPower(), без виртуального вызова
+     */
+    double currentPower() const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        return staticCurrentPower<Traits>(reg.loadState(handle()), reg.power(handle()));
+    }
+
+    /**
+     * @brief Потребление, как Type::getPowerUsage(), без виртуального вызова
+     */
+    double powerUsage() const {
+        return currentPower();
+    }
+
+    void turnOn() { device->Type::turnOn(); }
+    void turnOff() { device->Type::turnOff(); }
+
+    void writeStatus(StatusWriter& out) const { device->Type::writeStatus(out); }
+
+    std::string getStatus() const {
+        std::string status;
+        StatusWriter writer(status);
+        writeStatus(writer);
+        return status;
+    }
+};
+
+/**
+ * @class DeviceGroup
+ * @brief Однотипный набор устройств с проходами без виртуальных вызовов
+ * @tparam Traits LightBulbTraits, ThermostatTraits или SmartOutletTraits
+ * @note Не владеет устройствами: они должны пережить группу или быть из нее убраны
+ */
+template <class Traits>
+class DeviceGroup {
+public:
+    typedef typename Traits::Type Type;
+
+private:
+    std::vector<DeviceHandle> handles;  ///< Дескрипторы устройств в порядке добавления
+    bool contiguous = true;             ///< handles[i] == handles[0] + i
+
+public:
+    /**
+     * @brief Добавить устройство
+     * @param device Устройство типа Traits::Type
+     */
+    void add(Type& device) {
+        DeviceHandle h = device.getHandle();
+        if (!handles.empty() && h != handles.back() + 1) {
+            contiguous = false;
+        }
+        handles.push_back(h);
+    }
+
+    void reserve(std::size_t count) { handles.reserve(count); }
+
+    void clear() {
+        handles.clear();
+        contiguous = true;
+    }
+
+    std::size_t size() const { return handles.size(); }
+
+    /**
+     * @brief Непрерывен ли диапазон дескрипторов группы (проходы через ядра AVX2/NEON)
+     */
+    bool isContiguous() const { return contiguous; }
+
+    const std::vector<DeviceHandle>& handleColumn() const { return handles; }
+
+    Device<Traits> operator[](std::size_t index) const {
+        return Device<Traits>(get(index));
+    }
+
+    Type& get(std::size_t index) const {
+        return *static_cast<Type*>(DeviceRegistry::instance().owner(handles[index]));
+    }
+
+    /**
+     * @brief Суммарная текущая мощность группы (Вт)
+     */
+    double sumCurrentPower() const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        const std::uint64_t* state = reg.stateColumn().data();
+        const double* power = reg.powerColumn().data();
+        if (handles.empty()) {
+            return 0.0;
+        }
+        if (contiguous && Traits::ACTIVE_FLAGS == DeviceState::ON) {
+            return ::sumCurrentPower(state + handles[0], power + handles[0], handles.size());
+        }
+        double total = 0.0;
+        for (DeviceHandle h : handles) {
+            total += staticCurrentPower<Traits>(state[h], power[h]);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Количество включенных устройств группы
+     */
+    std::size_t countOn() const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        const std::uint64_t* state = reg.stateColumn().data();
+        if (handles.empty()) {
+            return 0;
+        }
+        if (contiguous) {
+            DeviceHandle first = handles[0];
+            return reg.countOnBits(first, first + static_cast<DeviceHandle>(handles.size()));
+        }
+        std::size_t total = 0;
+        for (DeviceHandle h : handles) {
+            total += (state[h] & DeviceState::ON) ? 1 : 0;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Включить все устройства группы с одним снимком времени
+     * @return Количество устройств, включенных этим вызовом
+     * @details Те же переходы, что и Type::turnOn(), через PoweredDevice::switchOnAt()
+     */
+    std::size_t turnOnAll() {
+        DeviceTime now = DeviceClock::now();
+        std::size_t changed = 0;
+        for (DeviceHandle h : handles) {
+            changed += PoweredDevice::switchOnAt(h, Traits::ON_FLAGS, now) ? 1 : 0;
+        }
+        return changed;
+    }
+
+    /**
+     * @brief Выключить все устройства группы с одним снимком времени
+     * @return Количество устройств, выключенных этим вызовом
+     */
+    std::size_t turnOffAll() {
+        DeviceTime now = DeviceClock::now();
+        std::size_t changed = 0;
+        for (DeviceHandle h : handles) {
+            changed += PoweredDevice::switchOffAt(h, Traits::OFF_FLAGS, now) ? 1 : 0;
+        }
+        return changed;
+    }
+
+    /**
+     * @brief Вызвать function(Type&) для каждого устройства группы
+     * @details Вызовы методов с квалификацией Type:: внутри function
+     *          связываются статически
+     */
+    template <class Function>
+    void forEach(Function function) const {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        for (DeviceHandle h : handles) {
+            function(*static_cast<Type*>(reg.owner(h)));
+        }
+    }
+};
+
+#endif // STATIC_DEVICES_HPP
@@ -0,0 +1,160 @@
+/**
+ * @file status_cache.hpp
+ * @brief Кэш строк getStatus()/getDeviceInfo() для частого чтения
+ *
+ * @details
+ * Интерфейс и журнал читают статус одних и тех же устройств намного чаще,
+ * чем он меняется. StatusCache хранит по дескриптору отрисованные строки
+ * статуса и информации вместе с ключом - снимком всего, из чего строка
+ * собирается:
+ * - устройство: адрес, тип, ID и имя (адреса строк StringPool) и
+ *   поколение SmartDevice::getGeneration(), которое меняют присваивания
+ * - флаги состояния, яркость и номер цвета, температура и мощность из
+ *   колонок DeviceRegistry
+ *
+ * Повторное чтение без изменений - сравнение ключа (несколько загрузок из
+ * реестра) и string_view на готовую строку. Ключ снимается по данным, а
+ * не по счетчику в сеттерах, поэтому кэш видит и изменения в обход
+ * методов устройства: CommandBatch, Scene, DeviceGroup, восстановление
+ * из журнала и снимка.
+ *
+ * @code
+ * StatusCache cache;
+ * for (SmartDevice* device : fleet) {
+ *     log << device->getName() << ": " << cache.status(*device) << "\n";
+ * }
+ * @endcode
+ *
+ * @note Кэш не потокобезопасен: каждому читающему потоку - свой кэш.
+ *       Переключения устройств из других потоков допустимы.
+ * @note Устройства с DeviceKind::NONE (типы вне библиотеки) хранят
+ *       состояние вне реестра и отрисовываются при каждом чтении.
+ */
+
+#ifndef STATUS_CACHE_HPP
+#define STATUS_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "device_registry.hpp"
+#include "smart_devices.hpp"
+#include "status_writer.hpp"
+
+/**
+ * @class StatusCache
+ * @brief Строки статуса и информации по дескриптору с проверкой по ключу
+ */
+class StatusCache {
+private:
+    /**
+     * @brief Снимок входных данных строки
+     */
+    struct Key {
+        const SmartDevice* owner;   ///< Устройство (nullptr - строка пуста)
+        const char* id;             ///< Строка ID в StringPool
+        const char* name;           ///< Строка имени в StringPool
+        std::uint64_t word;         ///< Флаги | яркость << 8 | цвет << 16 | поколение << 32 | тип << 48
+        double temperature;         ///< Текущая температура
+        double power;               ///< Колонка мощности
+
+        bool operator==(const Key& other) const {
+            return owner == other.owner && id == other.id && name == other.name && word == other.word &&
+                   temperature == other.temperature && power == other.power;
+        }
+    };
+
+    /**
+     * @brief Закэшированная строка
+     */
+    struct Entry {
+        Key key;
+        std::string text;
+    };
+
+    std::vector<Entry> statuses;    ///< Дескриптор -> строка getStatus()
+    std::vector<Entry> infos;       ///< Дескриптор -> строка getDeviceInfo()
+    std::size_t hitCount;
+    std::size_t missCount;
+
+    static Key keyOf(const SmartDevice& device) {
+        const DeviceRegistry& reg = DeviceRegistry::instance();
+        DeviceHandle h = device.getHandle();
+        std::uint64_t word = (reg.loadState(h) & DeviceState::FLAG_MASK) |
+                             (static_cast<std::uint64_t>(reg.bright(h)) << 8) |
+                             (static_cast<std::uint64_t>(reg.color(h)) << 16) |
+                             (static_cast<std::uint64_t>(device.getGeneration()) << 32) |
+                             (static_cast<std::uint64_t>(device.getKind()) << 48);
+        return Key{&device, device.getId().data(), device.getName().data(), word, reg.temp(h),
+                   reg.powerColumn()[h]};
+    }
+
+    template <class Render>
+    std::string_view lookup(std::vector<Entry>& entries, const SmartDevice& device, Render render) {
+        DeviceHandle h = device.getHandle();
+        if (h >= entries.size()) {
+            entries.resize(DeviceRegistry::instance().capacity(),
+                           Entry{Key{nullptr, nullptr, nullptr, 0, 0.0, 0.0}, {}});
+        }
+        Entry& entry = entries[h];
+        // Ключ снимается до отрисовки: изменение во время отрисовки
+        // даст промах при следующем чтении, а не устаревшую строку
+        Key key = keyOf(device);
+        if (device.getKind() != DeviceKind::NONE && entry.key == key) {
+            hitCount++;
+            return entry.text;
+        }
+        missCount++;
+        entry.text.clear();
+        StatusWriter writer(entry.text);
+        render(writer);
+        entry.key = key;
+        return entry.text;
+    }
+
+public:
+    StatusCache() : hitCount(0), missCount(0) {}
+
+    /**
+     * @brief Статус устройства, как getStatus()
+     * @return Строка, действительная до следующего чтения этого устройства
+     *         или clear()
+     */
+    std::string_view status(const SmartDevice& device) {
+        return lookup(statuses, device, [&](StatusWriter& writer) { device.writeStatus(writer); });
+    }
+
+    /**
+     * @brief Информация об устройстве, как getDeviceInfo()
+     * @return Строка, действительная до следующего чтения этого устройства
+     *         или clear()
+     */
+    std::string_view info(const SmartDevice& device) {
+        return lookup(infos, device, [&](StatusWriter& writer) { device.writeDeviceInfo(writer); });
+    }
+
+    /**
+     * @brief Забыть все строки (память освобождается)
+     */
+    void clear() {
+        statuses.clear();
+        statuses.shrink_to_fit();
+        infos.clear();
+        infos.shrink_to_fit();
+    }
+
+    /**
+     * @brief Чтений, обслуженных из кэша
+     */
+    std::size_t hits() const { return hitCount; }
+
+    /**
+     * @brief Чтений с отрисовкой строки
+     */
+    std::size_t misses() const { return missCount; }
+};
+
+#endif // STATUS_CACHE_HPP
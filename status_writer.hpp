@@ -0,0 +1,118 @@
+/**
+ * @file status_writer.hpp
+ * @brief Форматирование строк статуса без выделения памяти
+ *
+ * @details
+ * StatusWriter пишет текст либо в буфер вызывающего кода (char*, cap),
+ * либо в конец переданной строки std::string. Числа форматируются
+ * через std::to_chars в том же виде, что и std::ostream:
+ * - appendGeneral() - как вывод double по умолчанию (%g, 6 знаков)
+ * - appendFixed() - как std::fixed << std::setprecision(n)
+ *
+ * @note Режим буфера ведет себя как snprintf: записывает не более cap - 1
+ *       символов, завершает строку нулем и считает полную длину текста.
+ */
+
+#ifndef STATUS_WRITER_HPP
+#define STATUS_WRITER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/**
+ * @class StatusWriter
+ * @brief Приемник текста для writeStatus()/writeDeviceInfo()
+ */
+class StatusWriter {
+private:
+    std::string* target;        ///< Строка-приемник (режим дописывания)
+    char* buffer;               ///< Буфер вызывающего кода (режим буфера)
+    std::size_t capacity;       ///< Размер буфера вместе с завершающим нулем
+    std::size_t length;         ///< Полная длина записанного текста
+
+    /**
+     * @brief Максимальная длина double в формате fixed (309 цифр, знак, точка, дробь)
+     */
+    static constexpr std::size_t NUMBER_BUFFER = 352;
+
+public:
+    /**
+     * @brief Режим дописывания в конец строки
+     * @param target Строка-приемник; при достаточной емкости память не выделяется
+     */
+    explicit StatusWriter(std::string& target)
+        : target(&target), buffer(nullptr), capacity(0), length(0) {}
+
+    /**
+     * @brief Режим записи в буфер фиксированного размера
+     * @param buffer Буфер вызывающего кода (может быть nullptr при cap == 0)
+     * @param cap Размер буфера в байтах
+     */
+    StatusWriter(char* buffer, std::size_t cap)
+        : target(nullptr), buffer(buffer), capacity(cap), length(0) {
+        if (capacity > 0) {
+            buffer[0] = '\0';
+        }
+    }
+
+    StatusWriter(const StatusWriter&) = delete;
+    StatusWriter& operator=(const StatusWriter&) = delete;
+
+    /**
+     * @brief Дописать фрагмент текста
+     * @param text Фрагмент (литерал или строка)
+     */
+    void append(std::string_view text) {
+        if (target) {
+            target->append(text.data(), text.size());
+        } else if (length + 1 < capacity) {
+            std::size_t room = capacity - 1 - length;
+            std::size_t count = text.size() < room ? text.size() : room;
+            std::memcpy(buffer + length, text.data(), count);
+            buffer[length + count] = '\0';
+        }
+        length += text.size();
+    }
+
+    /**
+     * @brief Дописать целое число
+     */
+    void appendInt(long long value) {
+        char digits[24];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view(digits, result.ptr - digits));
+    }
+
+    /**
+     * @brief Дописать число с фиксированным количеством знаков после точки
+     * @param value Число
+     * @param precision Количество знаков после точки
+     */
+    void appendFixed(double value, int precision) {
+        char digits[NUMBER_BUFFER];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value,
+                                                    std::chars_format::fixed, precision);
+        append(std::string_view(digits, result.ptr - digits));
+    }
+
+    /**
+     * @brief Дописать число в формате std::ostream по умолчанию
+     */
+    void appendGeneral(double value) {
+        char digits[NUMBER_BUFFER];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value,
+                                                    std::chars_format::general, 6);
+        append(std::string_view(digits, result.ptr - digits));
+    }
+
+    /**
+     * @brief Полная длина записанного текста
+     * @return Длина без учета усечения буфером
+     */
+    std::size_t size() const { return length; }
+};
+
+#endif // STATUS_WRITER_HPP
@@ -0,0 +1,203 @@
+/**
+ * @file string_pool.hpp
+ * @brief Таблица интернированных строк для идентификаторов и имен устройств
+ *
+ * @details
+ * Каждая уникальная строка хранится в StringPool ровно один раз, в
+ * непрерывных блоках памяти со стабильными адресами. Устройства держат
+ * только InternedString - указатель, длину и плотный номер строки,
+ * поэтому getId()/getName() возвращают std::string_view без копирования,
+ * а сравнение двух интернированных строк - это сравнение номеров.
+ *
+ * Поиск выполняется по хеш-таблице с открытой адресацией (линейное
+ * пробирование, плоский массив номеров, заполнение не более 1/2).
+ *
+ * @note Строки не удаляются из таблицы до завершения процесса.
+ * @note Интернирование не потокобезопасно (как и создание устройств).
+ */
+
+#ifndef STRING_POOL_HPP
+#define STRING_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class InternedString
+ * @brief Ссылка на строку из StringPool
+ */
+class InternedString {
+public:
+    static constexpr std::uint32_t INVALID = static_cast<std::uint32_t>(-1); ///< Номер пустой строки
+
+private:
+    const char* text;           ///< Символы строки (стабильный адрес, завершены нулем)
+    std::uint32_t length;       ///< Длина строки
+    std::uint32_t number;       ///< Плотный номер строки в таблице
+
+public:
+    /**
+     * @brief Пустая строка вне таблицы
+     */
+    InternedString() : text(""), length(0), number(INVALID) {}
+
+    InternedString(const char* text, std::uint32_t length, std::uint32_t number)
+        : text(text), length(length), number(number) {}
+
+    /**
+     * @brief Представление строки без копирования
+     */
+    std::string_view view() const { return std::string_view(text, length); }
+    operator std::string_view() const { return view(); }
+
+    /**
+     * @brief Строка с завершающим нулем
+     */
+    const char* c_str() const { return text; }
+
+    /**
+     * @brief Плотный номер строки в таблице
+     */
+    std::uint32_t id() const { return number; }
+
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    bool operator==(const InternedString& other) const { return number == other.number; }
+    bool operator!=(const InternedString& other) const { return number != other.number; }
+};
+
+/**
+ * @class StringPool
+ * @brief Хеш-таблица интернированных строк с открытой адресацией
+ */
+class StringPool {
+private:
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;    ///< Размер блока хранения символов
+
+    /**
+     * @brief Описание строки в таблице
+     */
+    struct Entry {
+        const char* text;
+        std::uint32_t length;
+        std::size_t hash;
+    };
+
+    std::vector<std::unique_ptr<char[]>> chunks;        ///< Блоки хранения символов
+    std::size_t chunkUsed;                              ///< Занято байт в последнем блоке
+    std::size_t chunkCapacity;                          ///< Размер последнего блока
+    std::vector<Entry> entries;                         ///< Строки по номерам
+    std::vector<std::uint32_t> slots;                   ///< Номер строки + 1 (0 = пусто)
+
+    static std::size_t hashOf(std::string_view text) {
+        return std::hash<std::string_view>()(text);
+    }
+
+    /**
+     * @brief Найти слот строки или первый пустой слот
+     */
+    std::size_t probe(std::string_view text, std::size_t hash) const {
+        std::size_t mask = slots.size() - 1;
+        std::size_t slot = hash & mask;
+        while (slots[slot] != 0) {
+            const Entry& entry = entries[slots[slot] - 1];
+            if (entry.hash == hash && std::string_view(entry.text, entry.length) == text) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void grow() {
+        std::vector<std::uint32_t> bigger(slots.empty() ? 64 : slots.size() * 2, 0);
+        std::size_t mask = bigger.size() - 1;
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            std::size_t slot = entries[i].hash & mask;
+            while (bigger[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            bigger[slot] = static_cast<std::uint32_t>(i + 1);
+        }
+        slots.swap(bigger);
+    }
+
+    const char* store(std::string_view text) {
+        std::size_t bytes = text.size() + 1;
+        if (chunks.empty() || chunkUsed + bytes > chunkCapacity) {
+            chunkCapacity = bytes > CHUNK_SIZE ? bytes : CHUNK_SIZE;
+            chunks.push_back(std::unique_ptr<char[]>(new char[chunkCapacity]));
+            chunkUsed = 0;
+        }
+        char* destination = chunks.back().get() + chunkUsed;
+        std::memcpy(destination, text.data(), text.size());
+        destination[text.size()] = '\0';
+        chunkUsed += bytes;
+        return destination;
+    }
+
+public:
+    StringPool() : chunkUsed(0), chunkCapacity(0) {}
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /**
+     * @brief Получить общую таблицу строк процесса
+     */
+    static StringPool& instance() {
+        static StringPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Интернировать строку
+     * @param text Строка
+     * @return Ссылка на единственную копию строки в таблице
+     */
+    InternedString intern(std::string_view text) {
+        if ((entries.size() + 1) * 2 > slots.size()) {
+            grow();
+        }
+        std::size_t hash = hashOf(text);
+        std::size_t slot = probe(text, hash);
+        if (slots[slot] == 0) {
+            entries.push_back(Entry{store(text), static_cast<std::uint32_t>(text.size()), hash});
+            slots[slot] = static_cast<std::uint32_t>(entries.size());
+        }
+        std::uint32_t number = slots[slot] - 1;
+        return InternedString(entries[number].text, entries[number].length, number);
+    }
+
+    /**
+     * @brief Найти строку без добавления
+     * @param text Строка
+     * @param result Найденная ссылка
+     * @return true если строка уже интернирована
+     */
+    bool find(std::string_view text, InternedString& result) const {
+        if (slots.empty()) {
+            return false;
+        }
+        std::size_t slot = probe(text, hashOf(text));
+        if (slots[slot] == 0) {
+            return false;
+        }
+        std::uint32_t number = slots[slot] - 1;
+        result = InternedString(entries[number].text, entries[number].length, number);
+        return true;
+    }
+
+    /**
+     * @brief Количество интернированных строк
+     */
+    std::size_t size() const { return entries.size(); }
+};
+
+#endif // STRING_POOL_HPP
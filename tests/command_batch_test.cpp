@@ -0,0 +1,94 @@
+/**
+ * @file command_batch_test.cpp
+ * @brief Порядок применения и результаты CommandBatch
+ *
+ *     g++ -std=c++20 -pthread -I. tests/command_batch_test.cpp smart_devices.cpp -o command_batch_test
+ */
+
+#include <vector>
+
+#include "command_batch.hpp"
+#include "device_arena.hpp"
+#include "device_journal.hpp"
+#include "smart_devices.hpp"
+#include "test_check.hpp"
+
+/**
+ * @brief Приемник журнала, запоминающий порядок записей
+ */
+class RecordingSink : public JournalSink {
+public:
+    std::vector<JournalRecord> records;
+
+    virtual void append(const JournalRecord& record) override { records.push_back(record); }
+};
+
+void testGroupOrder() {
+    DeviceArena arena(1 << 16);
+    std::vector<LightBulb*> bulbs;
+    for (int i = 0; i < 5; i++) {
+        bulbs.push_back(arena.make<LightBulb>("CB" + std::to_string(i), "Lampa", 10.0));
+    }
+
+    RecordingSink sink;
+    DeviceJournal::attach(sink);
+    CommandBatch batch;
+    batch.turnOn(*bulbs[4]).turnOn(*bulbs[1]).turnOn(*bulbs[3]).turnOff(*bulbs[1]).turnOn(*bulbs[0]);
+    const std::vector<CommandResult>& results = batch.apply();
+    DeviceJournal::detach();
+
+    // Результаты - в порядке постановки
+    CHECK(results.size() == 5);
+    for (CommandResult result : results) {
+        CHECK(result == CommandResult::APPLIED);
+    }
+
+    // Внутри группы - по возрастанию дескриптора, выключение - после всех включений
+    CHECK(sink.records.size() == 5);
+    if (sink.records.size() == 5) {
+        CHECK(sink.records[0].handle == bulbs[0]->getHandle());
+        CHECK(sink.records[1].handle == bulbs[1]->getHandle());
+        CHECK(sink.records[2].handle == bulbs[3]->getHandle());
+        CHECK(sink.records[3].handle == bulbs[4]->getHandle());
+        CHECK(sink.records[4].handle == bulbs[1]->getHandle());
+        CHECK(sink.records[4].opcode == static_cast<std::uint16_t>(JournalOp::TURN_OFF));
+    }
+    CHECK(bulbs[0]->getIsOn() && !bulbs[1]->getIsOn() && bulbs[3]->getIsOn() && bulbs[4]->getIsOn());
+    CHECK(!bulbs[2]->getIsOn());
+}
+
+void testResults() {
+    DeviceArena arena(1 << 16);
+    LightBulb* bulb = arena.make<LightBulb>("CBR1", "Lampa", 10.0);
+    Thermostat* thermostat = arena.make<Thermostat>("CBR2", "Termostat", 1000.0);
+    SmartOutlet* outlet = arena.make<SmartOutlet>("CBR3", "Rozetka", 2000.0);
+
+    CommandBatch batch;
+    batch.setBrightness(*bulb, 40)
+        .setBrightness(*bulb, 140)
+        .setBrightness(*thermostat, 40)
+        .turnOn(*outlet)
+        .toggleOutlet(*outlet)
+        .turnOff(*thermostat)
+        .add(DeviceCommand{INVALID_DEVICE_HANDLE, CommandType::TURN_ON, 0});
+    const std::vector<CommandResult>& results = batch.apply();
+    CHECK(results.size() == 7);
+    if (results.size() == 7) {
+        CHECK(results[0] == CommandResult::APPLIED);
+        CHECK(results[1] == CommandResult::INVALID_ARGUMENT);
+        CHECK(results[2] == CommandResult::UNSUPPORTED);
+        CHECK(results[3] == CommandResult::APPLIED);
+        CHECK(results[4] == CommandResult::APPLIED);
+        CHECK(results[5] == CommandResult::UNCHANGED);
+        CHECK(results[6] == CommandResult::INVALID_DEVICE);
+    }
+    CHECK(bulb->getBrightness() == 40);
+    CHECK(outlet->getIsOn() && outlet->isOutletOn());
+    outlet->turnOff();
+}
+
+int main() {
+    testGroupOrder();
+    testResults();
+    return testResult("command_batch_test");
+}
@@ -0,0 +1,76 @@
+/**
+ * @file device_io_test.cpp
+ * @brief Ответы, отказы и тайм-ауты команд DeviceEventLoop
+ *
+ *     g++ -std=c++20 -pthread -I. tests/device_io_test.cpp smart_devices.cpp -o device_io_test
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "device_arena.hpp"
+#include "device_io.hpp"
+#include "smart_devices.hpp"
+#include "test_check.hpp"
+
+DeviceTask<void> switchOnOff(DeviceLink& link, LightBulb& lamp, std::vector<CommandResult>& results) {
+    results.push_back(co_await link.turnOn(lamp));
+    results.push_back(co_await link.turnOff(lamp));
+}
+
+DeviceTask<CommandResult> await(DeviceCommandAwaiter command) {
+    co_return co_await command;
+}
+
+void testAckCancelsTimeout() {
+    DeviceArena arena(1 << 16);
+    std::vector<LightBulb*> lamps;
+    for (int i = 0; i < 64; i++) {
+        lamps.push_back(arena.make<LightBulb>("IO" + std::to_string(i), "Lampa", 60.0));
+    }
+    DeviceEventLoop loop;
+    SimulatedTransport transport(loop, std::chrono::microseconds(100));
+    DeviceLink link(loop, transport, std::chrono::hours(1));
+    std::vector<CommandResult> results;
+    for (LightBulb* lamp : lamps) {
+        loop.spawn(switchOnOff(link, *lamp, results));
+    }
+    loop.run();
+
+    CHECK(results.size() == 128);
+    bool applied = true;
+    for (CommandResult result : results) {
+        applied = applied && result == CommandResult::APPLIED;
+    }
+    CHECK(applied);
+    CHECK(loop.getStats().acknowledged == 128);
+    CHECK(loop.inFlight() == 0);
+    CHECK(loop.pendingTimers() == 0);           // Часовые сроки ответа сняты подтверждениями
+}
+
+void testTimeoutAndReject() {
+    DeviceArena arena(1 << 16);
+    LightBulb* dropped = arena.make<LightBulb>("IO-drop", "Lampa", 60.0);
+    LightBulb* refused = arena.make<LightBulb>("IO-reject", "Lampa", 60.0);
+    DeviceEventLoop loop;
+    SimulatedTransport silent(loop, std::chrono::microseconds(100), 0, 1);
+    SimulatedTransport rejecting(loop, std::chrono::microseconds(100), 1, 0);
+    DeviceLink slow(loop, silent, std::chrono::milliseconds(5));
+    DeviceLink link(loop, rejecting, std::chrono::hours(1));
+
+    CHECK(loop.run(await(slow.turnOn(*dropped))) == CommandResult::DEVICE_TIMEOUT);
+    CHECK(!dropped->getIsOn());
+    CHECK(loop.getStats().timedOut == 1);
+    CHECK(loop.run(await(link.turnOn(*refused))) == CommandResult::DEVICE_REJECTED);
+    CHECK(!refused->getIsOn());
+    CHECK(loop.getStats().rejected == 1);
+    CHECK(loop.inFlight() == 0);
+    CHECK(loop.pendingTimers() == 0);
+}
+
+int main() {
+    testAckCancelsTimeout();
+    testTimeoutAndReject();
+    return testResult("device_io_test");
+}
@@ -0,0 +1,199 @@
+/**
+ * @file device_registry_test.cpp
+ * @brief Инкрементальные итоги DeviceRegistry против прямого пересчета
+ *
+ *     g++ -std=c++20 -pthread -I. tests/device_registry_test.cpp smart_devices.cpp -o device_registry_test
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "command_batch.hpp"
+#include "device_arena.hpp"
+#include "device_registry.hpp"
+#include "device_scene.hpp"
+#include "fleet_kernels.hpp"
+#include "smart_devices.hpp"
+#include "static_devices.hpp"
+#include "test_check.hpp"
+
+/**
+ * @brief Сравнить итоги реестра с суммой getCurrentPower() по устройствам
+ */
+void checkTotals(const std::vector<SmartDevice*>& fleet) {
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    double power = 0.0;
+    std::size_t on = 0;
+    for (const SmartDevice* device : fleet) {
+        power += device->getCurrentPower();
+        on += device->getIsOn() ? 1 : 0;
+    }
+    CHECK_NEAR(reg.currentPower(), power, 1e-6);
+    CHECK_NEAR(sumCurrentPower(reg), power, 1e-6);
+    CHECK(reg.devicesOn() == on);
+    CHECK(countOn(reg) == on);
+}
+
+void testOutletGate() {
+    DeviceArena arena(1 << 16);
+    SmartOutlet* outlet = arena.make<SmartOutlet>("RT1", "Rozetka", 2000.0);
+    LightBulb* bulb = arena.make<LightBulb>("RT2", "Lampa", 60.0);
+    std::vector<SmartDevice*> fleet = {outlet, bulb};
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    double base = reg.currentPower();
+
+    outlet->turnOn();
+    CHECK_NEAR(reg.currentPower() - base, 0.0, 1e-9);    // Реле еще выключено
+    CHECK(outlet->getPowerUsage() == 0.0 && outlet->getCurrentPower() == 0.0);
+    CHECK(Device<SmartOutletTraits>(*outlet).powerUsage() == 0.0);
+    outlet->toggleOutlet();
+    CHECK_NEAR(reg.currentPower() - base, 2000.0, 1e-9);
+    CHECK(outlet->getPowerUsage() == 2000.0 && outlet->getCurrentPower() == 2000.0);
+    bulb->turnOn();
+    checkTotals(fleet);
+    outlet->toggleOutlet();
+    CHECK_NEAR(reg.currentPower() - base, 60.0, 1e-9);
+    outlet->toggleOutlet();
+    outlet->turnOff();                                    // Выключение снимает и реле
+    CHECK_NEAR(reg.currentPower() - base, 60.0, 1e-9);
+    checkTotals(fleet);
+    bulb->turnOff();
+}
+
+void testMixedOperations() {
+    DeviceArena arena(1 << 16);
+    std::vector<SmartDevice*> fleet;
+    std::vector<SmartOutlet*> outlets;
+    std::vector<Thermostat*> thermostats;
+    DeviceSet all;
+    for (int i = 0; i < 40; i++) {
+        std::string id = "RM" + std::to_string(i);
+        switch (i % 3) {
+            case 0: fleet.push_back(arena.make<LightBulb>(id, "Lampa", 10.0 + i)); break;
+            case 1:
+                thermostats.push_back(arena.make<Thermostat>(id, "Termostat", 1000.0 + i));
+                fleet.push_back(thermostats.back());
+                break;
+            default:
+                outlets.push_back(arena.make<SmartOutlet>(id, "Rozetka", 100.0 + i));
+                fleet.push_back(outlets.back());
+                break;
+        }
+        all.add(*fleet.back());
+    }
+    checkTotals(fleet);
+
+    all.turnOnAll();
+    checkTotals(fleet);
+
+    CommandBatch batch;
+    for (std::size_t i = 0; i < outlets.size(); i += 2) {
+        batch.toggleOutlet(*outlets[i]);
+    }
+    batch.turnOff(*fleet[0]);
+    batch.apply();
+    checkTotals(fleet);
+
+    for (Thermostat* thermostat : thermostats) {
+        thermostat->updateTemperature(15.0);    // Мощность термостата зависит от температуры
+    }
+    checkTotals(fleet);
+
+    SceneAction relayOn;
+    relayOn.outlet = true;
+    Scene scene("rozetki");
+    scene.add(all, relayOn);
+    scene.activate();
+    checkTotals(fleet);
+
+    {
+        SmartOutlet copy(*outlets[0]);      // Копия включенной розетки с реле
+        std::vector<SmartDevice*> withCopy = fleet;
+        withCopy.push_back(&copy);
+        checkTotals(withCopy);
+    }
+    checkTotals(fleet);
+
+    all.turnOffAll();
+    checkTotals(fleet);
+}
+
+void testLoadChangeEnergy() {
+    ManualClock clock(NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    double bookedBefore = reg.energyBooked();
+    double kernelBefore = sumEnergyConsumed(reg, DeviceClock::now());
+    {
+        DeviceArena arena(1 << 16);
+        Thermostat* thermostat = arena.make<Thermostat>("RE1", "Termostat", 2000.0);
+        thermostat->turnOn();
+        thermostat->updateTemperature(15.0);
+        double first = thermostat->getCurrentPower();
+        clock.advance(NANOS_PER_HOUR);
+        thermostat->updateTemperature(21.0);    // Отрезок закрыт по прежней мощности
+        double second = thermostat->getCurrentPower();
+        CHECK(first != second);
+        clock.advance(NANOS_PER_HOUR);
+
+        double expected = first + second;
+        CHECK_NEAR(thermostat->getDeviceEnergyConsumed(), expected, 1e-6);
+        CHECK_NEAR(sumEnergyConsumed(reg, DeviceClock::now()) - kernelBefore, expected, 1e-6);
+        CHECK_NEAR(reg.energyBooked() - bookedBefore, first, 1e-6);
+
+        thermostat->turnOff();
+        CHECK_NEAR(thermostat->getDeviceEnergyConsumed(), expected, 1e-6);
+        CHECK_NEAR(reg.energyBooked() - bookedBefore, expected, 1e-6);
+        CHECK_NEAR(sumEnergyConsumed(reg, DeviceClock::now()) - kernelBefore, expected, 1e-6);
+    }
+    DeviceClock::reset();
+}
+
+void testRemovedDeviceEnergy() {
+    ManualClock clock(NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    double fleetBefore = sumFleetEnergy(reg, DeviceClock::now());
+    double liveBefore = sumEnergyConsumed(reg, DeviceClock::now());
+    DeviceArena arena(1 << 16);
+    LightBulb* kept = arena.make<LightBulb>("RX1", "Lampa", 40.0);
+    {
+        DeviceArena removed(1 << 16);
+        LightBulb* bulb = removed.make<LightBulb>("RX2", "Lampa", 100.0);
+        bulb->turnOn();
+        clock.advance(NANOS_PER_HOUR);
+        bulb->turnOff();
+    }
+    kept->turnOn();
+    clock.advance(NANOS_PER_HOUR);
+
+    // Энергия удаленной лампочки остается в итогах парка
+    CHECK_NEAR(sumFleetEnergy(reg, DeviceClock::now()) - fleetBefore, 140.0, 1e-6);
+    CHECK_NEAR(sumEnergyConsumed(reg, DeviceClock::now()) - liveBefore, 40.0, 1e-6);
+    kept->turnOff();
+    DeviceClock::reset();
+}
+
+void testDuplicateId() {
+    DeviceRegistry& reg = DeviceRegistry::instance();
+    DeviceArena arena(1 << 16);
+    LightBulb* first = arena.make<LightBulb>("RD1", "Lampa", 60.0);
+    {
+        DeviceArena other(1 << 16);
+        LightBulb* second = other.make<LightBulb>("RD1", "Lampa", 40.0);
+        CHECK(reg.findById("RD1") == first);        // Первое устройство сохраняет ID
+        CHECK(!reg.bindId(second->getHandle(), StringPool::instance().intern("RD1")));
+        CHECK(reg.findById("RD1") == first);
+    }
+    CHECK(reg.findById("RD1") == first);            // Удаление дубликата не стирает индекс
+    CHECK(reg.bindId(first->getHandle(), StringPool::instance().intern("RD1")));
+}
+
+int main() {
+    testOutletGate();
+    testMixedOperations();
+    testLoadChangeEnergy();
+    testRemovedDeviceEnergy();
+    testDuplicateId();
+    return testResult("device_registry_test");
+}
@@ -0,0 +1,138 @@
+/**
+ * @file device_snapshot_test.cpp
+ * @brief Сохранение и восстановление снимка DeviceSnapshot
+ *
+ *     g++ -std=c++20 -pthread -I. tests/device_snapshot_test.cpp smart_devices.cpp -o device_snapshot_test
+ */
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "device_arena.hpp"
+#include "device_clock.hpp"
+#include "device_registry.hpp"
+#include "device_snapshot.hpp"
+#include "device_visit.hpp"
+#include "smart_devices.hpp"
+#include "test_check.hpp"
+
+static const char* SNAPSHOT_PATH = "device_snapshot_test.bin";
+
+/**
+ * @brief Найти живое устройство по ID
+ */
+template <class T>
+T* findDevice(std::string_view id) {
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    for (DeviceHandle h = 0; h < reg.capacity(); h++) {
+        SmartDevice* device = reg.owner(h);
+        if (device && device->getId() == id) {
+            return deviceCast<T>(device);
+        }
+    }
+    return nullptr;
+}
+
+void testRoundTrip() {
+    ManualClock clock(10 * NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    DeviceRegistry& reg = DeviceRegistry::instance();
+    double energyBefore = reg.energyBooked();
+    double bookedAtSave = 0.0;
+    bool heating = false;
+    {
+        DeviceArena arena(1 << 16);
+        LightBulb* bulb = arena.make<LightBulb>("SN1", "Lampa", 60.0, 40, "warm");
+        Thermostat* thermostat = arena.make<Thermostat>("SN2", "Termostat", 1500.0, 18.0);
+        SmartOutlet* outlet = arena.make<SmartOutlet>("SN3", "Rozetka", 2000.0, 10.0, "kukhnya");
+
+        bulb->turnOn();
+        clock.advance(NANOS_PER_HOUR);
+        bulb->turnOff();                        // Закрытая сессия: 1 ч
+        bulb->turnOn();                         // Открытая сессия: 2 ч к сохранению
+        thermostat->setTargetTemperature(22.0);
+        outlet->turnOn();
+        outlet->toggleOutlet();
+        clock.advance(2 * NANOS_PER_HOUR);
+
+        heating = thermostat->getIsOn();        // Термостат сам включает нагрев
+        bookedAtSave = reg.energyBooked();
+        CHECK(DeviceSnapshot::save(SNAPSHOT_PATH) >= 3);
+        bulb->turnOff();
+        thermostat->turnOff();
+        outlet->turnOff();
+    }
+
+    // Новый процесс: часы идут дальше, сессии продолжаются с момента загрузки
+    clock.advance(5 * NANOS_PER_HOUR);
+    DeviceArena restored(1 << 16);
+    SnapshotView view(SNAPSHOT_PATH);
+    CHECK_NEAR(view.energyBooked(), bookedAtSave, 1e-9);
+    double booked = reg.energyBooked();
+    view.restore(restored);
+    CHECK_NEAR(reg.energyBooked() - booked, bookedAtSave, 1e-9);
+    CHECK(bookedAtSave > energyBefore);
+
+    LightBulb* bulb = findDevice<LightBulb>("SN1");
+    Thermostat* thermostat = findDevice<Thermostat>("SN2");
+    SmartOutlet* outlet = findDevice<SmartOutlet>("SN3");
+    CHECK(bulb && thermostat && outlet);
+    if (!bulb || !thermostat || !outlet) {
+        return;
+    }
+    CHECK(bulb->getIsOn());
+    CHECK(bulb->getBrightness() == 40);
+    CHECK(bulb->getColor() == "warm");
+    CHECK_NEAR(bulb->getCurrentSessionTime(), 2 * 3600.0, 1e-6);
+    CHECK_NEAR(bulb->getTotalOnTime(), 3 * 3600.0, 1e-6);
+    CHECK_NEAR(bulb->getDeviceEnergyConsumed(), 3 * 60.0, 1e-6);   // Закрытый 1 ч и открытые 2 ч
+    CHECK_NEAR(thermostat->getTargetTemperature(), 22.0, 1e-9);
+    CHECK_NEAR(thermostat->getCurrentTemperature(), 18.0, 1e-9);
+    CHECK(thermostat->getIsOn() == heating);
+    CHECK(outlet->getIsOn() && outlet->isOutletOn());
+    CHECK_NEAR(outlet->getMaxCurrent(), 10.0, 1e-9);
+    CHECK(outlet->getLocation() == "kukhnya");
+    bulb->turnOff();
+    thermostat->turnOff();
+    outlet->turnOff();
+    DeviceClock::reset();
+}
+
+void testSessionLongerThanUptime() {
+    ManualClock clock(NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    {
+        DeviceArena arena(1 << 16);
+        LightBulb* bulb = arena.make<LightBulb>("SN4", "Lampa", 100.0);
+        bulb->turnOn();
+        clock.set(10 * NANOS_PER_HOUR);         // Сессия 9 ч к сохранению
+        DeviceSnapshot::save(SNAPSHOT_PATH);
+        bulb->turnOff();
+    }
+
+    // Часы нового процесса начались заново и не дошли до длины сессии
+    clock.set(2 * NANOS_PER_HOUR);
+    DeviceArena restored(1 << 16);
+    SnapshotView(SNAPSHOT_PATH).restore(restored);
+    LightBulb* bulb = findDevice<LightBulb>("SN4");
+    CHECK(bulb != nullptr);
+    if (!bulb) {
+        return;
+    }
+    CHECK(bulb->getIsOn());
+    CHECK_NEAR(bulb->getCurrentSessionTime(), 2 * 3600.0, 1e-6);   // С нуля часов
+    CHECK(bulb->getCurrentSessionTime() >= 0.0);
+    CHECK(bulb->getTotalOnTime() <= 2 * 3600.0 + 1e-6);
+    clock.advance(NANOS_PER_HOUR);
+    bulb->turnOff();
+    CHECK_NEAR(bulb->getTotalOnTime(), 3 * 3600.0, 1e-6);
+    DeviceClock::reset();
+}
+
+int main() {
+    testRoundTrip();
+    testSessionLongerThanUptime();
+    std::remove(SNAPSHOT_PATH);
+    return testResult("device_snapshot_test");
+}
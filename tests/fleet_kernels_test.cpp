@@ -0,0 +1,64 @@
+/**
+ * @file fleet_kernels_test.cpp
+ * @brief Ядра fleet_kernels против скалярного расчета
+ *
+ * Проверяется и векторный путь, поэтому стоит собрать дважды:
+ *
+ *     g++ -std=c++20 -pthread -I. tests/fleet_kernels_test.cpp smart_devices.cpp -o fleet_kernels_test
+ *     g++ -std=c++20 -mavx2 -pthread -I. tests/fleet_kernels_test.cpp smart_devices.cpp -o fleet_kernels_test
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "fleet_kernels.hpp"
+#include "test_check.hpp"
+
+void testSums() {
+    // 11 ячеек: полные векторы и хвост
+    std::vector<std::uint64_t> state;
+    std::vector<double> power;
+    std::vector<double> energy;
+    double expectedPower = 0.0;
+    double expectedEnergy = 0.0;
+    double expectedSessions = 0.0;
+    const DeviceTime now = 10 * NANOS_PER_HOUR;
+    for (int i = 0; i < 11; i++) {
+        bool on = i % 3 != 0;
+        DeviceTime since = now - (i + 1) * NANOS_PER_SECOND;
+        state.push_back(DeviceState::pack(on ? DeviceState::ON : 0, on ? since : 0));
+        power.push_back(10.0 * (i + 1));
+        energy.push_back(1.5 * i);
+        expectedPower += on ? power.back() : 0.0;
+        expectedSessions += power.back() * static_cast<double>(on ? now - since : 0) /
+                            static_cast<double>(NANOS_PER_HOUR);
+        expectedEnergy = expectedSessions;
+    }
+    for (double booked : energy) {
+        expectedEnergy += booked;
+    }
+    CHECK_NEAR(sumCurrentPower(state.data(), power.data(), state.size()), expectedPower, 1e-9);
+    CHECK_NEAR(sumEnergyConsumed(state.data(), power.data(), energy.data(), state.size(), now),
+               expectedEnergy, 1e-9);
+    CHECK_NEAR(sumEnergyConsumed(state.data(), power.data(), nullptr, state.size(), now),
+               expectedSessions, 1e-9);
+    CHECK(countOn(state.data(), state.size()) == 7);
+}
+
+void testTurnedOnAfterSnapshot() {
+    // Устройства включены после снимка now: текущая сессия не отрицательна
+    const DeviceTime now = 5 * NANOS_PER_SECOND;
+    std::vector<std::uint64_t> state(4, DeviceState::pack(DeviceState::ON, now + 7));
+    std::vector<double> power(4, 100.0);
+    std::vector<double> energy(4, 0.0);
+    CHECK(sumEnergyConsumed(state.data(), power.data(), energy.data(), state.size(), now) == 0.0);
+
+    energy.assign(4, 100.0);
+    CHECK_NEAR(sumEnergyConsumed(state.data(), power.data(), energy.data(), state.size(), now), 400.0, 1e-9);
+}
+
+int main() {
+    testSums();
+    testTurnedOnAfterSnapshot();
+    return testResult("fleet_kernels_test");
+}
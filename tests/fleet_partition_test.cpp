@@ -0,0 +1,155 @@
+/**
+ * @file fleet_partition_test.cpp
+ * @brief Переносы устройств HashRing и FleetPartition при смене шардов
+ *
+ *     g++ -std=c++20 -pthread -I. tests/fleet_partition_test.cpp smart_devices.cpp -o fleet_partition_test
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fleet_partition.hpp"
+#include "smart_devices.hpp"
+#include "test_check.hpp"
+
+std::vector<std::string> makeIds(std::size_t count) {
+    std::vector<std::string> ids;
+    for (std::size_t i = 0; i < count; i++) {
+        ids.push_back("HR" + std::to_string(i));
+    }
+    return ids;
+}
+
+std::vector<std::uint32_t> ownersOf(const HashRing& ring, const std::vector<std::string>& ids) {
+    std::vector<std::uint32_t> owners;
+    for (const std::string& id : ids) {
+        owners.push_back(ring.shardOf(id));
+    }
+    return owners;
+}
+
+void testRingMoves() {
+    HashRing ring;
+    for (std::uint32_t s = 0; s < 4; s++) {
+        ring.addShard(s);
+    }
+    std::vector<std::string> ids = makeIds(20000);
+    std::vector<std::uint32_t> before = ownersOf(ring, ids);
+    CHECK(ownersOf(ring, ids) == before);                   // Детерминированность
+
+    // Новый шард забирает около 1/5 устройств и только себе
+    ring.addShard(4);
+    std::vector<std::uint32_t> grown = ownersOf(ring, ids);
+    std::size_t moved = 0;
+    bool onlyToNew = true;
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        if (grown[i] != before[i]) {
+            moved++;
+            onlyToNew = onlyToNew && grown[i] == 4;
+        }
+    }
+    CHECK(onlyToNew);
+    CHECK(moved > ids.size() / 10 && moved < ids.size() * 3 / 10);
+
+    // Удаление возвращает устройства прежним владельцам
+    ring.removeShard(4);
+    CHECK(ownersOf(ring, ids) == before);
+
+    // Уходят только устройства удаленного шарда
+    ring.removeShard(1);
+    CHECK(ring.size() == 3 && !ring.contains(1));
+    std::vector<std::uint32_t> shrunk = ownersOf(ring, ids);
+    bool onlyFromRemoved = true;
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        onlyFromRemoved = onlyFromRemoved && shrunk[i] != 1 && (before[i] == 1 || shrunk[i] == before[i]);
+    }
+    CHECK(onlyFromRemoved);
+}
+
+void checkSameTotals(const ShardTotals& actual, const ShardTotals& expected) {
+    CHECK(actual.devices == expected.devices);
+    CHECK(actual.devicesOn == expected.devicesOn);
+    CHECK_NEAR(actual.currentPower, expected.currentPower, 1e-6);
+    CHECK_NEAR(actual.energyConsumed, expected.energyConsumed, 1e-6);
+    CHECK_NEAR(actual.energyNow, expected.energyNow, 1e-6);
+}
+
+void testPartitionRebalance() {
+    ManualClock clock(NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    FleetPartition fleet;
+    for (int i = 0; i < 3; i++) {
+        fleet.addShard(std::make_unique<LocalShard>(i != 0));
+    }
+    std::vector<std::string> ids = makeIds(300);
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        fleet.create<LightBulb>(ids[i], "Lampa", 10.0 + static_cast<double>(i % 7));
+        if (i % 3 == 0) {
+            fleet.submit(ids[i], CommandType::TURN_ON);
+        }
+    }
+    const std::vector<CommandResult>& started = fleet.apply();
+    CHECK(started.size() == 100);
+    bool allApplied = true;
+    for (CommandResult result : started) {
+        allApplied = allApplied && result == CommandResult::APPLIED;
+    }
+    CHECK(allApplied);
+    clock.advance(NANOS_PER_HOUR);
+    for (std::size_t i = 0; i < ids.size(); i += 6) {
+        fleet.submit(ids[i], CommandType::TURN_OFF);    // Закрытые отрезки
+    }
+    fleet.apply();
+    ShardTotals initial = fleet.totals();
+    CHECK(initial.devices == 300 && initial.devicesOn == 50);
+    double energy = 0.0;
+    for (std::size_t i = 0; i < ids.size(); i += 3) {
+        energy += 10.0 + static_cast<double>(i % 7);
+    }
+    CHECK_NEAR(initial.energyNow, energy, 1e-6);
+    CHECK(initial.energyConsumed > 0.0 && initial.energyConsumed < energy);
+
+    // Перенос при добавлении: ровно устройства, сменившие владельца
+    std::vector<std::uint32_t> before = ownersOf(fleet.getRing(), ids);
+    std::size_t moved = 0;
+    std::uint32_t added = fleet.addShard(std::make_unique<LocalShard>(), &moved);
+    std::size_t changed = 0;
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        changed += fleet.ownerOf(ids[i]) != before[i];
+    }
+    CHECK(moved == changed && moved > 0);
+    CHECK(fleet.shard(added).size() == moved);
+    checkSameTotals(fleet.totals(), initial);
+
+    // Команды после переноса находят устройства в новых шардах
+    for (const std::string& id : ids) {
+        fleet.submit(id, CommandType::SET_BRIGHTNESS, 50);
+    }
+    bool routed = true;
+    for (CommandResult result : fleet.apply()) {
+        routed = routed && result != CommandResult::INVALID_DEVICE;
+    }
+    CHECK(routed);
+
+    std::size_t returned = fleet.removeShard(added);
+    CHECK(returned == moved);
+    CHECK(fleet.shardCount() == 3);
+    checkSameTotals(fleet.totals(), initial);
+    CHECK(fleet.removeShard(0) > 0);
+    checkSameTotals(fleet.totals(), initial);
+
+    for (const std::string& id : ids) {
+        fleet.submit(id, CommandType::TURN_OFF);
+    }
+    fleet.apply();
+    CHECK(fleet.totals().devicesOn == 0);
+    DeviceClock::reset();
+}
+
+int main() {
+    testRingMoves();
+    testPartitionRebalance();
+    return testResult("fleet_partition_test");
+}
@@ -0,0 +1,234 @@
+/**
+ * @file inventory_loader_test.cpp
+ * @brief Разбор и проверка инвентаря InventoryLoader
+ *
+ *     g++ -std=c++20 -pthread -I. tests/inventory_loader_test.cpp smart_devices.cpp -o inventory_loader_test
+ */
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "color_palette.hpp"
+#include "device_arena.hpp"
+#include "device_visit.hpp"
+#include "fleet_executor.hpp"
+#include "inventory_loader.hpp"
+#include "smart_devices.hpp"
+#include "test_check.hpp"
+
+/**
+ * @brief Загрузить текст и вернуть созданные устройства
+ */
+std::vector<SmartDevice*> loadAll(std::string_view text, DeviceArena& arena, InventoryReport& report,
+                                  InventoryFormat format = InventoryFormat::AUTO) {
+    static FleetExecutor executor(2);
+    InventoryLoader loader(executor);
+    std::vector<SmartDevice*> created;
+    report = loader.loadText(text, arena, format, &created);
+    return created;
+}
+
+void testCsvQuoteCarry() {
+    const std::string header = "kind,id,name,power\n";
+    // Удвоенная кавычка, запятая и перевод строки внутри кавычек
+    // проходят через каждую позицию границы 64-байтного блока
+    for (std::size_t shift = 0; shift < 64; shift++) {
+        std::string filler(shift, 'x');
+        std::string text = header + "LightBulb,Q1,\"" + filler + "a\"\"b,c\nd\",60\n" +
+                           "Thermostat,Q2,Termostat,1500\n";
+        DeviceArena arena(1 << 16);
+        InventoryReport report;
+        std::vector<SmartDevice*> created = loadAll(text, arena, report);
+        CHECK(report.loaded == 2);
+        CHECK(report.rejected.empty());
+        if (created.size() == 2) {
+            CHECK(created[0]->getName() == filler + "a\"b,c\nd");
+            CHECK(created[1]->getId() == "Q2");
+        }
+    }
+}
+
+void testJsonEscapeCarry() {
+    // Экранированные кавычка и обратная черта, '}' внутри строки -
+    // на каждой позиции границы блока
+    for (std::size_t shift = 0; shift < 64; shift++) {
+        std::string filler(shift, 'y');
+        std::string text = "[{\"kind\": \"LightBulb\", \"id\": \"J1\", \"name\": \"" + filler +
+                           "\\\\\\\"}\\n\", \"power\": 60},\n"
+                           "{\"kind\": \"SmartOutlet\", \"id\": \"J2\", \"name\": \"R\\\\\", \"power\": 2000}]\n";
+        DeviceArena arena(1 << 16);
+        InventoryReport report;
+        std::vector<SmartDevice*> created = loadAll(text, arena, report);
+        CHECK(report.loaded == 2);
+        CHECK(report.rejected.empty());
+        if (created.size() == 2) {
+            CHECK(created[0]->getName() == filler + "\\\"}\n");
+            CHECK(created[1]->getName() == "R\\");
+        }
+    }
+}
+
+void testCsvCrlf() {
+    DeviceArena arena(1 << 16);
+    InventoryReport report;
+    std::vector<SmartDevice*> created = loadAll(
+        "kind,id,name,power,brightness\r\n"
+        "LightBulb,CR1,Lampa,60,70\r\n"
+        "\r\n"
+        "LightBulb,CR2,\"Dve\r\nstroki\",40,abc\r\n"
+        "LightBulb,CR3,Lampa,-5\r\n"
+        "Thermostat,CR4,Termostat,1500",
+        arena, report);
+    CHECK(report.loaded == 2);
+    CHECK(created.size() == 2);
+    if (created.size() == 2) {
+        CHECK(created[0]->getName() == "Lampa");
+        CHECK(deviceCast<LightBulb>(created[0])->getBrightness() == 70);
+        CHECK(created[1]->getId() == "CR4");
+    }
+    // Номер строки - физический: перевод строки в кавычках тоже считается
+    CHECK(report.rejected.size() == 2);
+    if (report.rejected.size() == 2) {
+        CHECK(report.rejected[0].line == 4);
+        CHECK(report.rejected[0].issue == InventoryIssue::INVALID_NUMBER);
+        CHECK(report.rejected[1].line == 6);
+        CHECK(report.rejected[1].issue == InventoryIssue::INVALID_POWER);
+    }
+}
+
+void testCsvEmbeddedNewline() {
+    DeviceArena arena(1 << 16);
+    InventoryReport report;
+    std::vector<SmartDevice*> created = loadAll(
+        "kind,id,name,power,location,maxCurrent\n"
+        "SmartOutlet,EN1,\"Rozetka\nna kukhne\",2000,\"kukhnya, u okna\",10\n"
+        "SmartOutlet,EN2,\"\",1000\n"
+        "SmartOutlet,EN3,\"nezakrytaya,1000\n",
+        arena, report, InventoryFormat::CSV);
+    CHECK(report.loaded == 2);
+    if (created.size() == 2) {
+        const SmartOutlet* outlet = deviceCast<SmartOutlet>(created[0]);
+        CHECK(created[0]->getName() == "Rozetka\nna kukhne");
+        CHECK(outlet && outlet->getLocation() == "kukhnya, u okna");
+        CHECK(outlet && outlet->getMaxCurrent() == 10.0);
+        CHECK(created[1]->getName().empty());
+    }
+    CHECK(report.rejected.size() == 1);
+    if (report.rejected.size() == 1) {
+        CHECK(report.rejected[0].line == 5);
+        CHECK(report.rejected[0].issue == InventoryIssue::SYNTAX);
+    }
+}
+
+void testCsvTrim() {
+    DeviceArena arena(1 << 16);
+    InventoryReport report;
+    std::vector<SmartDevice*> created = loadAll(
+        "kind, id, name, power ,\tcolor\n"
+        "LightBulb, L1, Lamp, 60\n"
+        "LightBulb,\tL2 , \" s probelami \" , 40 , siniy\t\n"
+        "LightBulb, L3, \"Lamp\" x, 60\n",
+        arena, report);
+    CHECK(report.loaded == 2);
+    if (created.size() == 2) {
+        CHECK(created[0]->getId() == "L1");
+        CHECK(created[0]->getName() == "Lamp");
+        CHECK(created[1]->getId() == "L2");
+        CHECK(created[1]->getName() == " s probelami ");
+        CHECK(deviceCast<LightBulb>(created[1])->getColor() == "siniy");
+        CHECK(deviceCast<PoweredDevice>(created[1])->getPowerConsumption() == 40.0);
+    }
+    CHECK(report.rejected.size() == 1);
+    if (report.rejected.size() == 1) {
+        CHECK(report.rejected[0].line == 4);
+        CHECK(report.rejected[0].issue == InventoryIssue::SYNTAX);
+    }
+}
+
+void testDuplicateId() {
+    DeviceArena arena(1 << 16);
+    LightBulb* existing = arena.make<LightBulb>("DI0", "Lampa", 60.0);
+    InventoryReport report;
+    std::vector<SmartDevice*> created = loadAll(
+        "kind,id,name,power\n"
+        "LightBulb,DI1,Lampa,60\n"
+        "Thermostat,DI2,Termostat,1500\n"
+        "SmartOutlet,DI1,Rozetka,2000\n"        // Повтор в файле
+        "LightBulb,DI0,Lampa,40\n"              // ID живого устройства
+        "LightBulb,DI3,Lampa,100\n",
+        arena, report);
+    CHECK(report.loaded == 3);
+    CHECK(created.size() == 3);
+    CHECK(report.rejected.size() == 2);
+    if (report.rejected.size() == 2) {
+        CHECK(report.rejected[0].line == 4);
+        CHECK(report.rejected[0].issue == InventoryIssue::DUPLICATE_ID);
+        CHECK(report.rejected[1].line == 5);
+        CHECK(report.rejected[1].issue == InventoryIssue::DUPLICATE_ID);
+    }
+    const DeviceRegistry& reg = DeviceRegistry::instance();
+    CHECK(reg.findById("DI0") == existing);
+    CHECK(reg.findById("DI1") && reg.findById("DI1")->getKind() == DeviceKind::LIGHT_BULB);
+    CHECK(reg.findById("DI3") != nullptr);
+}
+
+/**
+ * @note Заполняет общую палитру процесса, поэтому выполняется последним
+ */
+void testPaletteFull() {
+    ColorPalette& palette = ColorPalette::instance();
+    palette.add("tsvet-0");
+    for (std::size_t i = 1; palette.size() < ColorPalette::CAPACITY - 1; i++) {
+        palette.add("tsvet-" + std::to_string(i));
+    }
+    CHECK(palette.canAdd("posledniy"));
+
+    DeviceArena arena(1 << 16);
+    FleetExecutor executor(2);
+    InventoryLoader loader(executor);
+    std::vector<SmartDevice*> created;
+    InventoryReport report = loader.loadText(
+        "kind,id,name,power,brightness,color\n"
+        "LightBulb,PF1,Lampa,60,50,posledniy\n"     // Занимает последнее место
+        "LightBulb,PF2,Lampa,60,50,lishniy\n"       // Места нет
+        "LightBulb,PF3,Lampa,60,50,posledniy\n"
+        "LightBulb,PF4,Lampa,60,50,tsvet-0\n"
+        "Thermostat,PF5,Termostat,1500,21\n",
+        arena, InventoryFormat::CSV, &created);
+    CHECK(report.loaded == 4);
+    CHECK(created.size() == 4);
+    CHECK(report.rejected.size() == 1);
+    if (report.rejected.size() == 1) {
+        CHECK(report.rejected[0].line == 3);
+        CHECK(report.rejected[0].issue == InventoryIssue::PALETTE_FULL);
+    }
+    CHECK(palette.size() == ColorPalette::CAPACITY);
+    CHECK(!palette.canAdd("lishniy"));
+    CHECK(palette.canAdd("tsvet-0"));
+
+    CHECK(LightBulb::validate("PF6", "Lampa", 60.0, 50, "lishniy") == DeviceError::PALETTE_FULL);
+    DeviceExpected<LightBulb*> rejected = arena.tryMake<LightBulb>("PF6", "Lampa", 60.0, 50, "lishniy");
+    CHECK(!rejected && rejected.error() == DeviceError::PALETTE_FULL);
+    DeviceExpected<LightBulb*> accepted = arena.tryMake<LightBulb>("PF7", "Lampa", 60.0, 50, "posledniy");
+    CHECK(accepted && (*accepted)->getColor() == "posledniy");
+    bool threw = false;
+    try {
+        arena.make<LightBulb>("PF8", "Lampa", 60.0, 50, "lishniy");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main() {
+    testCsvQuoteCarry();
+    testJsonEscapeCarry();
+    testCsvCrlf();
+    testCsvEmbeddedNewline();
+    testCsvTrim();
+    testDuplicateId();
+    testPaletteFull();
+    return testResult("inventory_loader_test");
+}
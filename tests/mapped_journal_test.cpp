@@ -0,0 +1,193 @@
+/**
+ * @file mapped_journal_test.cpp
+ * @brief Фиксация, перезапись кольца и восстановление MappedJournal
+ *
+ *     g++ -std=c++20 -pthread -I. tests/mapped_journal_test.cpp smart_devices.cpp -o mapped_journal_test
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "device_arena.hpp"
+#include "device_clock.hpp"
+#include "device_journal.hpp"
+#include "mapped_journal.hpp"
+#include "smart_devices.hpp"
+#include "test_check.hpp"
+
+static const char* JOURNAL_PATH = "mapped_journal_test.bin";
+
+JournalRecord recordOf(std::uint64_t sequence) {
+    return JournalRecord{static_cast<DeviceTime>(sequence), static_cast<double>(sequence), 0,
+                         static_cast<std::uint16_t>(JournalOp::SET_BRIGHTNESS), 0, 0.0};
+}
+
+std::vector<double> valuesOf(const MappedJournal& journal) {
+    std::vector<double> values;
+    journal.forEach([&](const JournalRecord& record) { values.push_back(record.value); });
+    return values;
+}
+
+void testBackgroundFlush() {
+    std::remove(JOURNAL_PATH);
+    MappedJournal journal(JOURNAL_PATH, 64, 4);
+    for (std::uint64_t i = 0; i < 4; i++) {
+        journal.append(recordOf(i));
+    }
+    // Заполненную группу фиксирует фоновый поток, без commit() в этом потоке
+    for (int wait = 0; wait < 2000 && journal.committed() < 4; wait++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(journal.committed() == 4);
+    journal.append(recordOf(4));
+    journal.commit();
+    CHECK(journal.committed() == 5);
+    CHECK((valuesOf(journal) == std::vector<double>{0, 1, 2, 3, 4}));
+}
+
+void testRingWrap() {
+    std::remove(JOURNAL_PATH);
+    {
+        MappedJournal journal(JOURNAL_PATH, 8, 64);
+        for (std::uint64_t i = 0; i < 20; i++) {
+            journal.append(recordOf(i));
+            if (i % 3 == 2) {
+                journal.commit();
+            }
+        }
+    }
+    MappedJournal reopened(JOURNAL_PATH);
+    CHECK(reopened.committed() == 20);
+    CHECK(reopened.size() == 8);
+    CHECK((valuesOf(reopened) == std::vector<double>{12, 13, 14, 15, 16, 17, 18, 19}));
+}
+
+void testTornOverwrite() {
+    std::remove(JOURNAL_PATH);
+    {
+        MappedJournal journal(JOURNAL_PATH, 8, 64);
+        for (std::uint64_t i = 0; i < 8; i++) {
+            journal.append(recordOf(i));
+        }
+    }
+    // Сбой посреди фиксации записей 8-10: граница begin уже на диске,
+    // ячейки 0-2 перезаписаны, committed еще прежний
+    {
+        std::fstream file(JOURNAL_PATH, std::ios::binary | std::ios::in | std::ios::out);
+        std::uint64_t begin = 3;
+        file.seekp(32);
+        file.write(reinterpret_cast<const char*>(&begin), sizeof(begin));
+        for (std::uint64_t i = 8; i < 11; i++) {
+            JournalRecord record = recordOf(i);
+            file.seekp(static_cast<std::streamoff>(64 + (i % 8) * sizeof(JournalRecord)));
+            file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+    }
+    MappedJournal reopened(JOURNAL_PATH);
+    CHECK(reopened.committed() == 8);
+    CHECK(reopened.size() == 5);
+    CHECK((valuesOf(reopened) == std::vector<double>{3, 4, 5, 6, 7}));
+    reopened.append(recordOf(8));
+    reopened.commit();
+    CHECK((valuesOf(reopened) == std::vector<double>{3, 4, 5, 6, 7, 8}));
+}
+
+void testReplay() {
+    ManualClock clock(NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    std::remove(JOURNAL_PATH);
+    double energyBefore = PoweredDevice::getTotalEnergyConsumedAll();
+    {
+        MappedJournal journal(JOURNAL_PATH, 1024, 16);
+        DeviceJournal::attach(journal);
+        DeviceArena arena(1 << 16);
+        LightBulb* bulb = arena.make<LightBulb>("MJ1", "Lampa", 100.0);
+        SmartOutlet* outlet = arena.make<SmartOutlet>("MJ2", "Rozetka", 1000.0);
+        bulb->turnOn();
+        bulb->setBrightness(30);
+        clock.advance(2 * NANOS_PER_HOUR);
+        bulb->turnOff();                    // 2 ч по 100 Вт
+        outlet->turnOn();
+        outlet->toggleOutlet();
+        clock.advance(NANOS_PER_HOUR);
+        bulb->turnOn();                     // Открыта к концу журнала
+        DeviceJournal::detach();
+        bulb->turnOff();
+        outlet->turnOff();
+    }
+
+    // Новый запуск: те же устройства в том же порядке
+    DeviceArena arena(1 << 16);
+    LightBulb* bulb = arena.make<LightBulb>("MJ1", "Lampa", 100.0);
+    SmartOutlet* outlet = arena.make<SmartOutlet>("MJ2", "Rozetka", 1000.0);
+    double booked = PoweredDevice::getTotalEnergyConsumedAll();
+    std::size_t applied = 0;
+    {
+        MappedJournal journal(JOURNAL_PATH);
+        applied = journal.replay();
+    }
+    CHECK(applied == 6);
+    CHECK(bulb->getIsOn());
+    CHECK(bulb->getBrightness() == 30);
+    CHECK_NEAR(bulb->getCurrentSessionTime(), 0.0, 1e-9);
+    CHECK_NEAR(bulb->getTotalOnTime(), 2 * 3600.0, 1e-6);
+    CHECK(outlet->getIsOn() && outlet->isOutletOn());
+    CHECK_NEAR(PoweredDevice::getTotalEnergyConsumedAll() - booked, 200.0, 1e-6);
+    CHECK(booked >= energyBefore);
+    bulb->turnOff();
+    outlet->turnOff();
+    DeviceClock::reset();
+}
+
+void testReplayLoadChange() {
+    ManualClock clock(NANOS_PER_HOUR);
+    DeviceClock::set(clock);
+    std::remove(JOURNAL_PATH);
+    double expected = 0.0;
+    {
+        MappedJournal journal(JOURNAL_PATH, 1024, 16);
+        DeviceJournal::attach(journal);
+        DeviceArena arena(1 << 16);
+        Thermostat* thermostat = arena.make<Thermostat>("MJ3", "Termostat", 2000.0, 18.0);
+        thermostat->turnOn();
+        for (double temperature : {15.0, 21.0, 19.0}) {
+            expected += thermostat->getCurrentPower();
+            clock.advance(NANOS_PER_HOUR);
+            thermostat->updateTemperature(temperature);     // Отрезок по прежней нагрузке
+        }
+        CHECK_NEAR(thermostat->getDeviceEnergyConsumed(), expected, 1e-6);
+        expected += thermostat->getCurrentPower();
+        clock.advance(NANOS_PER_HOUR);
+        thermostat->turnOff();
+        CHECK_NEAR(thermostat->getDeviceEnergyConsumed(), expected, 1e-6);
+        DeviceJournal::detach();
+    }
+
+    DeviceArena arena(1 << 16);
+    Thermostat* thermostat = arena.make<Thermostat>("MJ3", "Termostat", 2000.0, 18.0);
+    double booked = PoweredDevice::getTotalEnergyConsumedAll();
+    {
+        MappedJournal journal(JOURNAL_PATH);
+        journal.replay();
+    }
+    CHECK(!thermostat->getIsOn());
+    CHECK_NEAR(thermostat->getCurrentTemperature(), 19.0, 1e-9);
+    CHECK_NEAR(thermostat->getTotalOnTime(), 4 * 3600.0, 1e-6);
+    CHECK_NEAR(thermostat->getDeviceEnergyConsumed(), expected, 1e-6);
+    CHECK_NEAR(PoweredDevice::getTotalEnergyConsumedAll() - booked, expected, 1e-6);
+    DeviceClock::reset();
+}
+
+int main() {
+    testBackgroundFlush();
+    testRingWrap();
+    testTornOverwrite();
+    testReplay();
+    testReplayLoadChange();
+    std::remove(JOURNAL_PATH);
+    return testResult("mapped_journal_test");
+}
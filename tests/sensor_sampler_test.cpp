@@ -0,0 +1,71 @@
+/**
+ * @file sensor_sampler_test.cpp
+ * @brief Окна SampleRing на границе перезаписи кольца
+ *
+ *     g++ -std=c++20 -pthread -I. tests/sensor_sampler_test.cpp smart_devices.cpp -o sensor_sampler_test
+ */
+
+#include <cstdint>
+
+#include "sensor_sampler.hpp"
+#include "test_check.hpp"
+
+void pushSamples(SampleRing& ring, std::uint64_t from, std::uint64_t to) {
+    for (std::uint64_t i = from; i < to; i++) {
+        ring.push(SensorSample{static_cast<DeviceTime>(i), static_cast<double>(i)});
+    }
+}
+
+void testCapacity() {
+    SampleRing exact(8);
+    CHECK(exact.capacity() == 16);              // 8 отсчетов и ячейка записи
+    SampleRing ring(7);
+    CHECK(ring.capacity() == 8);
+    CHECK(SampleRing(288000).capacity() == 524288);
+}
+
+void testWrapPoint() {
+    SampleRing ring(7);
+    pushSamples(ring, 0, 7);
+    SampleWindow full = ring.latest(ring.capacity());
+    CHECK(full.size() == 7);
+    CHECK(full.start == 0);
+    CHECK(full.intact());
+
+    // Следующий push пишет в ячейку начала окна
+    pushSamples(ring, 7, 8);
+    CHECK(!full.intact());
+
+    // Новые окна не включают ячейку, которую производитель пишет следующей
+    SampleWindow latest = ring.latest(ring.capacity());
+    CHECK(ring.size() == 7);
+    CHECK(latest.size() == 7);
+    CHECK(latest.start == 1);
+    CHECK(latest.intact());
+    CHECK(latest[0].value == 1.0 && latest[6].value == 7.0);
+    SampleWindow span = ring.window(0, 100);
+    CHECK(span.start == 1 && span.size() == 7);
+    CHECK(span.intact());
+    pushSamples(ring, 8, 9);
+    CHECK(!latest.intact() && !span.intact());
+}
+
+void testWindowAcrossEnd() {
+    SampleRing ring(7);
+    pushSamples(ring, 0, 13);
+    CHECK(ring.window(0, 100).start == 6);      // Старейший доступный отсчет
+    SampleWindow window = ring.window(6, 10);
+    CHECK(window.size() == 4);
+    CHECK(window.first.size() == 2 && window.second.size() == 2);
+    CHECK(window[0].value == 6.0 && window[3].value == 9.0);
+    CHECK(window.intact());
+    pushSamples(ring, 13, 14);                  // Следующая запись - в ячейку отсчета 6
+    CHECK(!window.intact());
+}
+
+int main() {
+    testCapacity();
+    testWrapPoint();
+    testWindowAcrossEnd();
+    return testResult("sensor_sampler_test");
+}
@@ -0,0 +1,57 @@
+/**
+ * @file test_check.hpp
+ * @brief Минимальные проверки для тестов каталога tests/
+ *
+ * @details
+ * Каждый тест - отдельная программа без сторонних зависимостей,
+ * собирается из корня репозитория:
+ *
+ *     g++ -std=c++20 -pthread -I. tests/command_batch_test.cpp smart_devices.cpp -o command_batch_test
+ *
+ * Упавшая проверка печатается с файлом и строкой, выполнение продолжается;
+ * код возврата testResult() - 0, если все проверки прошли.
+ */
+
+#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+#include <cmath>
+#include <iostream>
+
+/**
+ * @brief Счетчик упавших проверок
+ */
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+/**
+ * @brief Отметить упавшую проверку
+ */
+inline void testFail(const char* file, int line, const char* expression) {
+    testFailures()++;
+    std::cerr << file << ":" << line << ": proverka ne proshla: " << expression << "\n";
+}
+
+/**
+ * @brief Итог теста для return из main()
+ * @param name Название теста
+ */
+inline int testResult(const char* name) {
+    if (testFailures() == 0) {
+        std::cout << name << ": OK\n";
+        return 0;
+    }
+    std::cout << name << ": " << testFailures() << " proverok ne proshli\n";
+    return 1;
+}
+
+#define CHECK(expression) \
+    ((expression) ? (void)0 : testFail(__FILE__, __LINE__, #expression))
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    (std::fabs((actual) - (expected)) <= (tolerance) ? (void)0 \
+                                                     : testFail(__FILE__, __LINE__, #actual " ~ " #expected))
+
+#endif // TEST_CHECK_HPP
@@ -0,0 +1,313 @@
+/**
+ * @file thermal_simulation.hpp
+ * @brief Пакетная тепловая модель термостатов и прогноз нагрузки парка
+ *
+ * @details
+ * Модель одного дома за шаг dt часов:
+ * - нагрузка включенного термостата - Thermostat::loadFor():
+ *   ratedPower * (0.5 + |target - temperature| / 10)
+ * - нагрев к целевой температуре со скоростью heatingPerHour °C/ч
+ *   при коэффициенте нагрузки 1.0, без перескока через цель
+ * - остывание к температуре улицы: разница умножается на
+ *   exp(-lossPerHour * dt) (точное решение, устойчиво при любом шаге)
+ *
+ * ThermalSimulation собирает термостаты реестра в собственные плотные
+ * колонки (temperature, target, ratedPower, power, active, energy),
+ * ядро stepThermostats() проходит по ним без ветвлений:
+ * - AVX2 (x86-64, -mavx2): по 4 дома за итерацию
+ * - NEON (AArch64): по 2 дома за итерацию
+ * - Скалярный вариант для остальных платформ и хвостов массивов
+ *
+ * forecast() считает кривую нагрузки на копии колонок блоками по
+ * FORECAST_BLOCK домов на все шаги сразу, чтобы блок оставался в L1;
+ * живые устройства при этом не меняются. advance() двигает модель на
+ * реальный интервал и переносит результат в реестр через
+ * Thermostat::refreshLoad(), который закрывает отрезок сессии по прежней
+ * нагрузке, - энергия устройств и парка учитывается как обычно.
+ *
+ * @note Включение и выключение термостатов модель не меняет: флаг ON
+ *       фиксируется в capture().
+ * @note capture() и advance() не потокобезопасны относительно
+ *       добавления и удаления устройств, как и сам DeviceRegistry.
+ */
+
+#ifndef THERMAL_SIMULATION_HPP
+#define THERMAL_SIMULATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "smart_devices.hpp"
+
+/**
+ * @struct ThermalModel
+ * @brief Параметры тепловой модели, общие для всех домов
+ */
+struct ThermalModel {
+    double ambient = 5.0;           ///< Температура улицы (°C)
+    double lossPerHour = 0.1;       ///< Доля разницы с улицей, теряемая за час (1/ч)
+    double heatingPerHour = 4.0;    ///< Скорость нагрева при номинальной нагрузке (°C/ч)
+};
+
+/**
+ * @struct ThermalStep
+ * @brief Константы одного шага, общие для всего прохода ядра
+ */
+struct ThermalStep {
+    double ambient;     ///< Температура улицы (°C)
+    double retain;      ///< exp(-lossPerHour * hours) - сохраняемая доля разницы с улицей
+    double gain;        ///< heatingPerHour * hours - нагрев за шаг при коэффициенте 1.0 (°C)
+    double hours;       ///< Длина шага (ч)
+
+    ThermalStep(const ThermalModel& model, double stepHours)
+        : ambient(model.ambient), retain(std::exp(-model.lossPerHour * stepHours)),
+          gain(model.heatingPerHour * stepHours), hours(stepHours) {}
+};
+
+/**
+ * @brief Сдвинуть count домов на один шаг модели
+ * @param temperature Колонка текущих температур (°C), обновляется
+ * @param target Колонка целевых температур (°C)
+ * @param rated Колонка номинальных мощностей (Вт)
+ * @param active Колонка флагов включения (1.0 - включен, 0.0 - выключен)
+ * @param power Колонка нагрузки (Вт), обновляется по новой температуре
+ * @param energy Колонка накопленной энергии (Вт*ч), дополняется
+ * @param count Количество домов
+ * @param step Константы шага
+ * @return Энергия всех домов за шаг (Вт*ч)
+ * @details Энергия шага считается по нагрузке на его начало.
+ *          power[i] - Thermostat::loadFor(rated, temperature, target)
+ *          с точностью до округления, как и колонка мощности реестра
+ */
+inline double stepThermostats(double* temperature, const double* target, const double* rated,
+                              const double* active, double* power, double* energy,
+                              std::size_t count, const ThermalStep& step) {
+    std::size_t i = 0;
+    double total = 0.0;
+#if defined(__AVX2__)
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d tenth = _mm256_set1_pd(0.1);
+    const __m256d ambient = _mm256_set1_pd(step.ambient);
+    const __m256d retain = _mm256_set1_pd(step.retain);
+    const __m256d gain = _mm256_set1_pd(step.gain);
+    const __m256d hours = _mm256_set1_pd(step.hours);
+    __m256d acc = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        __m256d temp = _mm256_loadu_pd(temperature + i);
+        __m256d goal = _mm256_loadu_pd(target + i);
+        __m256d watts = _mm256_loadu_pd(rated + i);
+        __m256d on = _mm256_loadu_pd(active + i);
+        __m256d diff = _mm256_sub_pd(goal, temp);
+        __m256d distance = _mm256_andnot_pd(signBit, diff);
+        __m256d factor = _mm256_mul_pd(on, _mm256_add_pd(half, _mm256_mul_pd(distance, tenth)));
+        __m256d spent = _mm256_mul_pd(_mm256_mul_pd(watts, factor), hours);
+        acc = _mm256_add_pd(acc, spent);
+        _mm256_storeu_pd(energy + i, _mm256_add_pd(_mm256_loadu_pd(energy + i), spent));
+        __m256d heat = _mm256_min_pd(_mm256_mul_pd(factor, gain), distance);
+        temp = _mm256_add_pd(temp, _mm256_or_pd(_mm256_and_pd(signBit, diff), heat));
+        temp = _mm256_add_pd(ambient, _mm256_mul_pd(_mm256_sub_pd(temp, ambient), retain));
+        _mm256_storeu_pd(temperature + i, temp);
+        distance = _mm256_andnot_pd(signBit, _mm256_sub_pd(goal, temp));
+        _mm256_storeu_pd(power + i, _mm256_mul_pd(watts, _mm256_add_pd(half, _mm256_mul_pd(distance, tenth))));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t signBit = vreinterpretq_u64_f64(vdupq_n_f64(-0.0));
+    const float64x2_t half = vdupq_n_f64(0.5);
+    const float64x2_t tenth = vdupq_n_f64(0.1);
+    const float64x2_t ambient = vdupq_n_f64(step.ambient);
+    const float64x2_t retain = vdupq_n_f64(step.retain);
+    const float64x2_t gain = vdupq_n_f64(step.gain);
+    const float64x2_t hours = vdupq_n_f64(step.hours);
+    float64x2_t acc = vdupq_n_f64(0.0);
+    for (; i + 2 <= count; i += 2) {
+        float64x2_t temp = vld1q_f64(temperature + i);
+        float64x2_t goal = vld1q_f64(target + i);
+        float64x2_t watts = vld1q_f64(rated + i);
+        float64x2_t diff = vsubq_f64(goal, temp);
+        float64x2_t distance = vabsq_f64(diff);
+        float64x2_t factor = vmulq_f64(vld1q_f64(active + i), vaddq_f64(half, vmulq_f64(distance, tenth)));
+        float64x2_t spent = vmulq_f64(vmulq_f64(watts, factor), hours);
+        acc = vaddq_f64(acc, spent);
+        vst1q_f64(energy + i, vaddq_f64(vld1q_f64(energy + i), spent));
+        float64x2_t heat = vminq_f64(vmulq_f64(factor, gain), distance);
+        temp = vaddq_f64(temp, vbslq_f64(signBit, diff, heat));
+        temp = vaddq_f64(ambient, vmulq_f64(vsubq_f64(temp, ambient), retain));
+        vst1q_f64(temperature + i, temp);
+        distance = vabsq_f64(vsubq_f64(goal, temp));
+        vst1q_f64(power + i, vmulq_f64(watts, vaddq_f64(half, vmulq_f64(distance, tenth))));
+    }
+    total = vaddvq_f64(acc);
+#endif
+    for (; i < count; i++) {
+        double temp = temperature[i];
+        double diff = target[i] - temp;
+        double distance = std::fabs(diff);
+        double factor = active[i] * (0.5 + distance * 0.1);
+        double spent = rated[i] * factor * step.hours;
+        total += spent;
+        energy[i] += spent;
+        temp += std::copysign(std::min(factor * step.gain, distance), diff);
+        temp = step.ambient + (temp - step.ambient) * step.retain;
+        temperature[i] = temp;
+        power[i] = rated[i] * (0.5 + std::fabs(target[i] - temp) * 0.1);
+    }
+    return total;
+}
+
+/**
+ * @struct ThermalForecast
+ * @brief Прогноз нагрузки парка термостатов
+ */
+struct ThermalForecast {
+    std::vector<double> load;   ///< Средняя мощность парка на каждом шаге (Вт)
+    double energy = 0.0;        ///< Энергия за весь горизонт (Вт*ч)
+    double peakLoad = 0.0;      ///< Максимум load (Вт)
+};
+
+/**
+ * @class ThermalSimulation
+ * @brief Тепловая модель термостатов реестра в плотных колонках
+ */
+class ThermalSimulation {
+public:
+    static constexpr std::size_t FORECAST_BLOCK = 512;  ///< Домов в блоке forecast() (6 колонок в L1)
+
+private:
+    ThermalModel model;                     ///< Параметры модели
+    std::vector<DeviceHandle> handles;      ///< Дескрипторы термостатов в реестре
+    std::vector<double> temperature;        ///< Текущая температура (°C)
+    std::vector<double> target;             ///< Целевая температура (°C)
+    std::vector<double> rated;              ///< Номинальная мощность (Вт)
+    std::vector<double> active;             ///< 1.0 - включен, 0.0 - выключен
+    std::vector<double> power;              ///< Нагрузка loadFor() (Вт)
+    std::vector<double> energy;             ///< Энергия с capture()/resetEnergy() (Вт*ч)
+
+public:
+    explicit ThermalSimulation(const ThermalModel& model = ThermalModel()) : model(model) {}
+
+    /**
+     * @brief Собрать все термостаты реестра в колонки модели
+     * @param registry Реестр устройств
+     * @return Количество термостатов
+     * @post Колонка энергии обнулена
+     */
+    std::size_t capture(const DeviceRegistry& registry = DeviceRegistry::instance()) {
+        handles.clear();
+        temperature.clear();
+        target.clear();
+        rated.clear();
+        active.clear();
+        power.clear();
+        for (DeviceHandle h = 0; h < registry.capacity(); h++) {
+            if (registry.owner(h) && registry.kind(h) == DeviceKind::THERMOSTAT) {
+                const Thermostat* thermostat = static_cast<const Thermostat*>(registry.owner(h));
+                handles.push_back(h);
+                temperature.push_back(registry.temp(h));
+                target.push_back(registry.target(h));
+                rated.push_back(thermostat->getRatedPower());
+                active.push_back((registry.loadState(h) & DeviceState::ON) ? 1.0 : 0.0);
+                power.push_back(registry.power(h));
+            }
+        }
+        energy.assign(handles.size(), 0.0);
+        return handles.size();
+    }
+
+    /**
+     * @brief Сдвинуть модель на один шаг (без изменения реестра)
+     * @param hours Длина шага (ч)
+     * @return Энергия всех домов за шаг (Вт*ч)
+     */
+    double step(double hours) {
+        return stepThermostats(temperature.data(), target.data(), rated.data(), active.data(),
+                               power.data(), energy.data(), size(), ThermalStep(model, hours));
+    }
+
+    /**
+     * @brief Прогноз нагрузки на steps шагов вперед
+     * @param steps Количество шагов
+     * @param hours Длина шага (ч)
+     * @return Кривая средней мощности по шагам и энергия за горизонт
+     * @details Считается на копии колонок: модель и реестр не меняются
+     */
+    ThermalForecast forecast(std::size_t steps, double hours) const {
+        ThermalForecast result;
+        result.load.assign(steps, 0.0);
+        ThermalStep constants(model, hours);
+        double blockTemperature[FORECAST_BLOCK];
+        double blockPower[FORECAST_BLOCK];
+        double blockEnergy[FORECAST_BLOCK];
+        for (std::size_t begin = 0; begin < size(); begin += FORECAST_BLOCK) {
+            std::size_t count = std::min(FORECAST_BLOCK, size() - begin);
+            std::copy_n(temperature.data() + begin, count, blockTemperature);
+            std::fill_n(blockEnergy, count, 0.0);
+            for (std::size_t s = 0; s < steps; s++) {
+                result.load[s] += stepThermostats(blockTemperature, target.data() + begin, rated.data() + begin,
+                                                  active.data() + begin, blockPower, blockEnergy, count,
+                                                  constants);
+            }
+        }
+        for (double& load : result.load) {
+            result.energy += load;
+            load /= hours;
+            result.peakLoad = std::max(result.peakLoad, load);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Сдвинуть модель на прошедший реальный интервал и перенести результат в реестр
+     * @param hours Прошедшее время (ч)
+     * @param registry Реестр, из которого собраны термостаты
+     * @return Энергия всех домов за шаг по модели (Вт*ч)
+     * @details Температуры записываются в реестр, нагрузка пересчитывается
+     *          Thermostat::refreshLoad(): отрезок текущей сессии до этого
+     *          момента учитывается по прежней нагрузке, дальше - по новой.
+     *          Удаленные после capture() устройства пропускаются
+     */
+    double advance(double hours, DeviceRegistry& registry = DeviceRegistry::instance()) {
+        double spent = step(hours);
+        for (std::size_t i = 0; i < size(); i++) {
+            DeviceHandle h = handles[i];
+            if (!registry.owner(h) || registry.kind(h) != DeviceKind::THERMOSTAT) {
+                continue;
+            }
+            registry.temp(h) = temperature[i];
+            static_cast<Thermostat*>(registry.owner(h))->refreshLoad();
+        }
+        return spent;
+    }
+
+    /**
+     * @brief Обнулить колонку энергии модели
+     */
+    void resetEnergy() { std::fill(energy.begin(), energy.end(), 0.0); }
+
+    std::size_t size() const { return handles.size(); }
+    const ThermalModel& getModel() const { return model; }
+
+    /**
+     * @name Колонки модели (size() элементов, порядок capture())
+     * @{
+     */
+    const std::vector<DeviceHandle>& handleColumn() const { return handles; }
+    const std::vector<double>& temperatureColumn() const { return temperature; }
+    const std::vector<double>& powerColumn() const { return power; }
+    const std::vector<double>& energyColumn() const { return energy; }
+    /** @} */
+};
+
+#endif // THERMAL_SIMULATION_HPP